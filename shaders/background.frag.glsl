@@ -12,8 +12,178 @@ uniform vec2 resolution;
 uniform float time;
 uniform float warp;
 
+/* procedural mode draws the whole grid with one fullscreen quad
+ * instead of texturing the grid geometry background_draw() sends */
+uniform int procedural;
+uniform float grid_clock;
+uniform vec3 grid_rotate;
+uniform float bloom;
+uniform vec4 minor_color;
+uniform vec4 hmajor_color;
+uniform vec4 vmajor_color;
+
+#define TAU 6.283185307179586
+
+/* same as background.vert.glsl */
+#define SCALE_FACTOR_HIGH 0.075
+#define SCALE_FACTOR_LOW  0.125
+
+#define nsin(x) ((sin(x) + 1.0) / 2.0)
+
+/* tan(fovy / 2) of the camera in background_resize() */
+#define CAMERA_TAN_HALF_FOVY 0.41421356
+
+/* bg_grid.png holds two major cells of 4 minor cells in 75px */
+#define MAJOR_SIZE      37.5
+#define MINOR_PER_MAJOR 4.0
+#define MAJOR_WIDTH     2.25
+#define MINOR_WIDTH     1.75
+
+#define BLOOM_RADIUS   6.0
+#define BLOOM_STRENGTH 0.35
+
+#define WARP_ITERATIONS 4
+
+/* has to match the BACKGROUND_DRIFT_* values in background.c */
+#define DRIFT_SPEED  30.0
+#define DRIFT_TURN1  (TAU / 40.0)
+#define DRIFT_TURN2  (-TAU / 17.0)
+#define DRIFT_PHASE2 1.3
+#define DRIFT_MIX2   0.45
+
+/* two circles of different speed and direction added together,
+ * so the grid keeps drifting while its direction slowly wanders */
+vec2 drift(float c)
+{
+    float a1 = DRIFT_TURN1 * c;
+    float a2 = DRIFT_TURN2 * c + DRIFT_PHASE2;
+
+    return DRIFT_SPEED * ((vec2(sin(a1), -cos(a1)) / DRIFT_TURN1) +
+                          (DRIFT_MIX2 * vec2(sin(a2), -cos(a2)) / DRIFT_TURN2));
+}
+
+vec3 rotate_x(vec3 v, float a)
+{
+    float c = cos(a);
+    float s = sin(a);
+    return vec3(v.x, (c * v.y) - (s * v.z), (s * v.y) + (c * v.z));
+}
+
+vec3 rotate_y(vec3 v, float a)
+{
+    float c = cos(a);
+    float s = sin(a);
+    return vec3((c * v.x) + (s * v.z), v.y, (c * v.z) - (s * v.x));
+}
+
+vec3 rotate_z(vec3 v, float a)
+{
+    float c = cos(a);
+    float s = sin(a);
+    return vec3((c * v.x) - (s * v.y), (s * v.x) + (c * v.y), v.z);
+}
+
+/* undoes the rotations background_begin_3d() applies after
+ * moving the grid's origin */
+vec3 undo_tilt(vec3 v)
+{
+    return rotate_y(rotate_x(v, -grid_rotate.x), -grid_rotate.y);
+}
+
+/* how far background.vert.glsl pulls a vertex towards the camera */
+float warp_height(vec2 pos)
+{
+    float scale_factor_rate = nsin(time * 0.753);
+    float scale_factor_mult = mix(SCALE_FACTOR_HIGH, SCALE_FACTOR_LOW, scale_factor_rate);
+    float scale = scale_factor_mult * resolution.x;
+
+    float cent_dist = length(pos - (resolution / 2.0)) / scale;
+
+    return pow(cent_dist, 2.0) * warp;
+}
+
+float line_coverage(float coord, float spacing, float width, float fw)
+{
+    float dist = abs(fract((coord / spacing) + 0.5) - 0.5) * spacing;
+    float cov = clamp((((0.5 * width) - dist) / max(fw, 0.0001)) + 0.5, 0.0, 1.0);
+
+    /* lines closer together than a pixel average out instead of aliasing */
+    return mix(cov, width / spacing, smoothstep(0.25 * spacing, 0.5 * spacing, fw));
+}
+
+float line_glow(float coord, float spacing, float width)
+{
+    float dist = abs(fract((coord / spacing) + 0.5) - 0.5) * spacing;
+    return exp(-max(dist - (0.5 * width), 0.0) / BLOOM_RADIUS);
+}
+
+vec4 procedural_grid()
+{
+    vec2 halfres = resolution / 2.0;
+    vec2 px = fragTexCoord * resolution;
+    float aspect = resolution.x / resolution.y;
+    float dist = min(resolution.x, resolution.y);
+
+    /* the camera looks along +z with +y up, so its right is -x */
+    vec2 ndc = (px - halfres) / halfres;
+    vec3 ray_dir = vec3(-ndc.x * CAMERA_TAN_HALF_FOVY * aspect,
+                        -ndc.y * CAMERA_TAN_HALF_FOVY,
+                        1.0);
+    vec3 eye = vec3(0.0, 0.0, -dist);
+
+    /* into the grid's own space, where it lies in z = 0 */
+    vec3 o = undo_tilt(rotate_z(eye - vec3(halfres, 0.0), -grid_rotate.z) + vec3(resolution, 0.0));
+    vec3 d = undo_tilt(rotate_z(ray_dir, -grid_rotate.z));
+
+    if (d.z <= 0.0) {
+        return vec4(0.0, 0.0, 0.0, 1.0);
+    }
+
+    float t = -o.z / d.z;
+    vec3 pos = o + (t * d);
+    for (int i = 0; i < WARP_ITERATIONS; i++) {
+        t = (-warp_height(pos.xy) - o.z) / d.z;
+        pos = o + (t * d);
+    }
+
+    if (t <= 0.0) {
+        return vec4(0.0, 0.0, 0.0, 1.0);
+    }
+
+    /* background.vert.glsl stretches the grid to the window's aspect */
+    vec2 stretch = (resolution.y < resolution.x)
+        ? vec2(resolution.x / resolution.y, 1.0)
+        : vec2(1.0, resolution.y / resolution.x);
+
+    vec2 grid = (pos.xy / stretch) - drift(grid_clock);
+    vec2 fw = fwidth(grid);
+
+    float minor_size = MAJOR_SIZE / MINOR_PER_MAJOR;
+    float minor = max(line_coverage(grid.x, minor_size, MINOR_WIDTH, fw.x),
+                      line_coverage(grid.y, minor_size, MINOR_WIDTH, fw.y));
+    float vmajor = line_coverage(grid.x, MAJOR_SIZE, MAJOR_WIDTH, fw.x);
+    float hmajor = line_coverage(grid.y, MAJOR_SIZE, MAJOR_WIDTH, fw.y);
+
+    /* same order as the line-drawing mode in background_draw() */
+    vec3 color = vec3(0.0);
+    color = mix(color, minor_color.rgb,  minor_color.a  * minor);
+    color = mix(color, vmajor_color.rgb, vmajor_color.a * vmajor);
+    color = mix(color, hmajor_color.rgb, hmajor_color.a * hmajor);
+
+    float glow = bloom * BLOOM_STRENGTH;
+    color += glow * line_glow(grid.x, MAJOR_SIZE, MAJOR_WIDTH) * vmajor_color.rgb;
+    color += glow * line_glow(grid.y, MAJOR_SIZE, MAJOR_WIDTH) * hmajor_color.rgb;
+
+    return vec4(color, 1.0);
+}
+
 void main()
 {
+    if (procedural != 0) {
+        finalColor = procedural_grid()*colDiffuse;
+        return;
+    }
+
     vec4 texelColor = texture(texture0, fragTexCoord);
     finalColor = texelColor*colDiffuse*fragColor;
 }
@@ -12,6 +12,11 @@ uniform vec4 effect_amount2;
 uniform float time;
 uniform vec2 resolution;
 
+// Below full quality the blur was already done at a reduced
+// resolution by postprocessing_blur.frag.glsl
+uniform int reduced;
+uniform sampler2D bloom_texture;
+
 // Output fragment color
 out vec4 finalColor;
 
@@ -123,17 +128,28 @@ void main()
     vec4 source = get_texel(uv);
 
     const int range = 3;            // should be = (samples - 1)/2;
+    const float taps = float((2*range + 1)*(2*range + 1));
+
+    vec4 blur;
 
-    for (int x = -range; x <= range; x++)
+    if (reduced != 0)
+    {
+        // an average of the same taps, so scale it like the sum below
+        blur = texture(bloom_texture, uv) * (taps/(samples*samples));
+    }
+    else
     {
-        for (int y = -range; y <= range; y++)
+        for (int x = -range; x <= range; x++)
         {
-            vec2 coord = uv + vec2(x, y)*sizeFactor;
-            sum += get_texel(coord);
+            for (int y = -range; y <= range; y++)
+            {
+                vec2 coord = uv + vec2(x, y)*sizeFactor;
+                sum += get_texel(coord);
+            }
         }
-    }
 
-    vec4 blur = sum/(samples*samples);
+        blur = sum/(samples*samples);
+    }
 
     blur = pow(blur, vec4(2.0));
 
@@ -0,0 +1,29 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform vec2 blur_step;
+
+// Output fragment color
+out vec4 finalColor;
+
+// one axis of the box blur in postprocessing.frag.glsl; running it
+// once per axis gives the same result for 7+7 taps instead of 7x7
+const int range = 3;
+
+void main()
+{
+    vec4 sum = vec4(0);
+
+    for (int i = -range; i <= range; i++)
+    {
+        sum += texture(texture0, fragTexCoord + float(i)*blur_step);
+    }
+
+    finalColor = sum/float(2*range + 1);
+}
@@ -0,0 +1,51 @@
+#version 330
+
+/* template tile mesh */
+in vec2 vertexPosition;
+in float vertexPart;
+
+/* one per tile */
+in vec3 instanceTransform;
+in vec4 instanceFlags;
+in vec4 instancePath0;
+in vec4 instancePath1;
+in vec4 instancePath2;
+in vec4 instancePath3;
+in vec4 instancePath4;
+in vec4 instancePath5;
+
+out vec4 fragColor;
+
+uniform mat4 mvp;
+uniform vec4 bgColor;
+uniform vec4 bgHoverColor;
+uniform vec4 centerColor;
+
+/* must match tile_instance_part_t */
+#define PART_BG     0
+#define PART_PATH0  1
+#define PART_CENTER 7
+
+void main()
+{
+    vec4 path[6] = vec4[6](instancePath0, instancePath1, instancePath2,
+                           instancePath3, instancePath4, instancePath5);
+
+    int part = int(vertexPart + 0.5);
+
+    if (part == PART_BG) {
+        fragColor = mix(bgColor, bgHoverColor, instanceFlags.z) * instanceFlags.x;
+    } else if (part == PART_CENTER) {
+        fragColor = centerColor * instanceFlags.y;
+    } else {
+        fragColor = path[part - PART_PATH0];
+    }
+
+    float c = cos(instanceTransform.z);
+    float s = sin(instanceTransform.z);
+    vec2 pos = vec2((vertexPosition.x * c) - (vertexPosition.y * s),
+                    (vertexPosition.x * s) + (vertexPosition.y * c));
+    pos += instanceTransform.xy;
+
+    gl_Position = mvp * vec4(pos, 0.0, 1.0);
+}
@@ -0,0 +1,112 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;   // position relative to the tile center
+in vec4 fragColor;      // packed tile data, see tile_sdf.c
+
+// Input uniform values
+uniform float tile_size;
+uniform float line_width;
+uniform float border_width;
+uniform float highlight_width;
+uniform float center_radius;
+uniform vec2 arm_end[6];
+
+uniform vec4 bg_color;
+uniform vec4 edge_color;
+uniform vec4 center_color;
+
+// indexed by path type; must have PATH_TYPE_COUNT entries
+uniform vec4 path_color[5];
+uniform vec4 highlight_color[5];
+
+// Output fragment color
+out vec4 finalColor;
+
+#define FLAG_FIXED  64
+#define FLAG_CENTER 128
+
+float px;
+
+/* premultiplied "over" */
+vec4 over(vec4 dst, vec4 color, float dist)
+{
+    float coverage = clamp(0.5 - (dist / px), 0.0, 1.0);
+    float a = color.a * coverage;
+    return vec4((color.rgb * a) + (dst.rgb * (1.0 - a)),
+                a + (dst.a * (1.0 - a)));
+}
+
+/* flat top and bottom, corners on the x axis like DrawPoly() */
+float sd_hex(vec2 p, float inner_radius)
+{
+    const vec3 k = vec3(-0.866025404, 0.5, 0.577350269);
+    p = abs(p);
+    p -= 2.0 * min(dot(k.xy, p), 0.0) * k.xy;
+    p -= vec2(clamp(p.x, -k.z * inner_radius, k.z * inner_radius), inner_radius);
+    return length(p) * sign(p.y);
+}
+
+/* a DrawLineEx() strip; p.x runs along the arm and p.y across it */
+float sd_strip(vec2 p, float start, float end, float offset, float width)
+{
+    return max(max(start - p.x, p.x - end), abs(p.y - offset) - (0.5 * width));
+}
+
+void main()
+{
+    vec2 p = fragTexCoord;
+    px = max(max(fwidth(p.x), fwidth(p.y)), 0.0001);
+
+    ivec4 data = ivec4((fragColor * 255.0) + 0.5);
+
+    int path[6] = int[6](data.r & 15, data.r >> 4,
+                         data.g & 15, data.g >> 4,
+                         data.b & 15, data.b >> 4);
+    int highlight = data.a & 63;
+    bool is_fixed = (data.a & FLAG_FIXED) != 0;
+    bool center   = (data.a & FLAG_CENTER) != 0;
+
+    float hex = sd_hex(p, tile_size * 0.866025404);
+
+    vec4 color = vec4(0.0);
+
+    if (!is_fixed) {
+        color = over(color, bg_color, hex);
+    }
+
+    for (int dir = 0; dir < 6; dir++) {
+        if (path[dir] != 0) {
+            float len = length(arm_end[dir]);
+            vec2 u = arm_end[dir] / len;
+            vec2 q = vec2(dot(p, u), dot(p, vec2(u.y, -u.x)));
+            color = over(color, path_color[path[dir]], sd_strip(q, 0.0, len, 0.0, line_width));
+        }
+    }
+
+    for (int dir = 0; dir < 6; dir++) {
+        if ((highlight & (1 << dir)) != 0) {
+            float len = length(arm_end[dir]);
+            vec2 u = arm_end[dir] / len;
+            vec2 q = vec2(dot(p, u), dot(p, vec2(u.y, -u.x)));
+            float start = min(center_radius, len);
+            float d = min(sd_strip(q, start, len,  0.5 * line_width, highlight_width),
+                          sd_strip(q, start, len, -0.5 * line_width, highlight_width));
+            color = over(color, highlight_color[path[dir]], d);
+        }
+    }
+
+    if (!is_fixed) {
+        color = over(color, edge_color, max(hex, -(hex + border_width)));
+    }
+
+    if (center) {
+        color = over(color, center_color, length(p) - center_radius);
+    }
+
+    if (color.a <= 0.0) {
+        discard;
+    }
+
+    finalColor = vec4(color.rgb / color.a, color.a);
+}
@@ -0,0 +1,134 @@
+/****************************************************************************
+ *                                                                          *
+ * arena.c                                                                  *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "arena.h"
+
+static arena_chunk_t *create_arena_chunk(arena_t *arena, size_t size)
+{
+    arena_chunk_t *chunk = malloc(sizeof(arena_chunk_t) + size);
+    if (!chunk) {
+        DIE("out of memory allocating an arena chunk");
+    }
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    if (arena->last) {
+        arena->last->next = chunk;
+    } else {
+        arena->chunks = chunk;
+    }
+    arena->last = chunk;
+
+    arena->chunk_count++;
+    arena->bytes_reserved += size;
+
+    return chunk;
+}
+
+arena_t *create_arena(size_t chunk_size, size_t max_chunk_size)
+{
+    arena_t *arena = calloc(1, sizeof(arena_t));
+
+    arena->chunk_size     = ARENA_ALIGN(chunk_size);
+    arena->max_chunk_size = MAX(arena->chunk_size, ARENA_ALIGN(max_chunk_size));
+
+    arena->chunks  = NULL;
+    arena->current = NULL;
+    arena->last    = NULL;
+
+    arena->current = create_arena_chunk(arena, arena->chunk_size);
+
+    return arena;
+}
+
+void destroy_arena(arena_t *arena)
+{
+    if (!arena) {
+        return;
+    }
+
+    arena_chunk_t *chunk = arena->chunks;
+    while (chunk) {
+        arena_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    SAFEFREE(arena);
+}
+
+void arena_reset(arena_t *arena)
+{
+    assert_not_null(arena);
+
+    for (arena_chunk_t *chunk = arena->chunks; chunk; chunk = chunk->next) {
+        chunk->used = 0;
+    }
+
+    arena->current     = arena->chunks;
+    arena->alloc_count = 0;
+    arena->bytes_used  = 0;
+}
+
+void *arena_alloc(arena_t *arena, size_t size)
+{
+    assert_not_null(arena);
+
+    size = ARENA_ALIGN(size);
+
+    /* chunks past current are left over from before the last
+     * arena_reset(), so try reusing them before asking for more */
+    arena_chunk_t *chunk = arena->current;
+    while (chunk && ((chunk->size - chunk->used) < size)) {
+        chunk = chunk->next;
+    }
+
+    if (!chunk) {
+        size_t chunk_size = arena->last
+            ? MIN(arena->last->size * 2, arena->max_chunk_size)
+            : arena->chunk_size;
+        chunk = create_arena_chunk(arena, MAX(chunk_size, size));
+    }
+
+    arena->current = chunk;
+
+    void *ptr = &(chunk->data[chunk->used]);
+    chunk->used += size;
+
+    arena->alloc_count++;
+    arena->bytes_used += size;
+
+    return ptr;
+}
+
+void *arena_calloc(arena_t *arena, size_t nmemb, size_t size)
+{
+    size_t total = nmemb * size;
+    void *ptr = arena_alloc(arena, total);
+
+    /* reused chunks still hold old data */
+    memset(ptr, 0, total);
+
+    return ptr;
+}
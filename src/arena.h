@@ -0,0 +1,71 @@
+/****************************************************************************
+ *                                                                          *
+ * arena.h                                                                  *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+ * A simple chunked bump allocator. Allocations are never freed
+ * individually; the whole arena is either rewound with arena_reset()
+ * (keeping its chunks for reuse) or released with destroy_arena().
+ *
+ * The first chunk is chunk_size bytes and each chunk added after it
+ * is twice the size of the one before, up to max_chunk_size, so a
+ * rarely used arena stays small.
+ */
+
+/* every allocation is rounded up to this */
+#define ARENA_ALIGNMENT 16
+#define ARENA_ALIGN(x) (((x) + (ARENA_ALIGNMENT - 1)) & ~((size_t)(ARENA_ALIGNMENT - 1)))
+
+struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;
+    size_t used;
+    unsigned char data[];
+};
+typedef struct arena_chunk arena_chunk_t;
+
+struct arena {
+    arena_chunk_t *chunks;
+    arena_chunk_t *current;
+    arena_chunk_t *last;
+
+    size_t chunk_size;
+    size_t max_chunk_size;
+
+    /* statistics */
+    int    chunk_count;
+    int    alloc_count;
+    size_t bytes_used;
+    size_t bytes_reserved;
+};
+typedef struct arena arena_t;
+
+arena_t *create_arena(size_t chunk_size, size_t max_chunk_size);
+void destroy_arena(arena_t *arena);
+void arena_reset(arena_t *arena);
+
+void *arena_alloc(arena_t *arena, size_t size);
+void *arena_calloc(arena_t *arena, size_t nmemb, size_t size);
+
+#endif /*ARENA_H*/
+
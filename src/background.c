@@ -27,11 +27,25 @@
 #include "win_anim.h"
 #include "background.h"
 #include "shader.h"
+#include "quality_governor.h"
+#include "redraw.h"
 
 //#define DEBUG_DRAW_LABELS
 
 #define USE_BG_TEXTURE
 
+/* the procedural grid's drift, which has to match drift() in
+ * background.frag.glsl; both turn rates repeat after the period */
+#define BACKGROUND_DRIFT_TURN1  (TAU / 40.0f)
+#define BACKGROUND_DRIFT_TURN2  (-TAU / 17.0f)
+#define BACKGROUND_DRIFT_PHASE2 1.3f
+#define BACKGROUND_DRIFT_MIX2   0.45f
+#define BACKGROUND_DRIFT_PERIOD (40.0f * 17.0f)
+
+float limit_rot_x = 0.0f;
+float limit_rot_y = 0.0f;
+float limit_rot_z = 0.0f;
+
 extern Texture2D bg_grid_texture;
 extern float bloom_amount;
 
@@ -77,6 +91,81 @@ void background_resize(background_t *bg)
     bg->camera.projection = CAMERA_PERSPECTIVE;
 }
 
+bool background_procedural_available(void)
+{
+    static int ready = -1;
+    if (ready < 0) {
+        ready = (background_shader.id > 0)
+            && (background_shader.id != rlGetShaderIdDefault())
+            && (background_shader_loc.procedural >= 0);
+        if (!ready) {
+            warnmsg("the background shader can't draw the grid by itself; drawing it with textured quads");
+        }
+    }
+
+    return options->procedural_bg && ready;
+}
+
+/* direction of drift() in background.frag.glsl at this clock */
+static Vector2 background_drift_dir(float clock)
+{
+    float a1 = BACKGROUND_DRIFT_TURN1 * clock;
+    float a2 = (BACKGROUND_DRIFT_TURN2 * clock) + BACKGROUND_DRIFT_PHASE2;
+
+    Vector2 dir = {
+        .x = cosf(a1) + (BACKGROUND_DRIFT_MIX2 * cosf(a2)),
+        .y = sinf(a1) + (BACKGROUND_DRIFT_MIX2 * sinf(a2))
+    };
+
+    return Vector2Normalize(dir);
+}
+
+static void set_color_uniform(int loc, Color color)
+{
+    Vector4 v = ColorNormalize(color);
+    SetShaderValue(background_shader, loc, &v, SHADER_UNIFORM_VEC4);
+}
+
+/* the grid, its warp and its glow all come from the shader, so
+ * this is one fullscreen quad */
+static void background_draw_procedural(background_t *bg, float bloom)
+{
+    background_shader_loc_t *loc = &background_shader_loc;
+
+    Vector3 rotate = {
+        .x = limit_rot_x,
+        .y = limit_rot_y,
+        .z = TO_RADIANS(limit_rot_z)
+    };
+
+    SetShaderValue(background_shader, loc->grid_clock,  &bg->clock, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(background_shader, loc->grid_rotate, &rotate,    SHADER_UNIFORM_VEC3);
+    SetShaderValue(background_shader, loc->bloom,       &bloom,     SHADER_UNIFORM_FLOAT);
+
+    set_color_uniform(loc->minor_color,  bg->minor_color);
+    set_color_uniform(loc->hmajor_color, bg->hmajor_color);
+    set_color_uniform(loc->vmajor_color, bg->vmajor_color);
+
+    rlBegin(RL_QUADS);
+    {
+        rlColor4ub(255, 255, 255, 255);
+
+        /* same corner order as DrawRectanglePro() */
+        rlTexCoord2f(0.0f, 0.0f);
+        rlVertex2f(0.0f, 0.0f);
+
+        rlTexCoord2f(0.0f, 1.0f);
+        rlVertex2f(0.0f, window_sizef.y);
+
+        rlTexCoord2f(1.0f, 1.0f);
+        rlVertex2f(window_sizef.x, window_sizef.y);
+
+        rlTexCoord2f(1.0f, 0.0f);
+        rlVertex2f(window_sizef.x, 0.0f);
+    }
+    rlEnd();
+}
+
 float smooth_change(float current, float target, float step)
 {
     if (current < target) {
@@ -92,10 +181,6 @@ float smooth_change(float current, float target, float step)
     }
 }
 
-float limit_rot_x = 0.0f;
-float limit_rot_y = 0.0f;
-float limit_rot_z = 0.0f;
-
 void background_begin_3d(background_t *bg, float amount)
 {
     rlPushMatrix();
@@ -133,7 +218,15 @@ void bg_end_3d(void)
 
 void background_draw(background_t *bg)
 {
-    bool animate_bg = !options->wait_events && options->animate_bg;
+    background_detail_t detail = quality_governor_background_detail();
+    bool animate_bg = !options->wait_events
+        && options->animate_bg
+        && (detail < BACKGROUND_DETAIL_STATIC);
+    bool procedural = background_procedural_available();
+
+    if (animate_bg) {
+        redraw_ambient();
+    }
 
     static float fade = 0.0f;
     float fade_target = 0.0f;
@@ -174,6 +267,9 @@ void background_draw(background_t *bg)
 
     SetShaderValue(background_shader, background_shader_loc.warp, &bgwarp, SHADER_UNIFORM_FLOAT);
 
+    int procedural_uniform = procedural ? 1 : 0;
+    SetShaderValue(background_shader, background_shader_loc.procedural, &procedural_uniform, SHADER_UNIFORM_INT);
+
 #define cart_bg_normal_speed   1.0
 #define cart_bg_finished_speed 3.5
 #define cart_bg_delta_speed ((cart_bg_finished_speed) - (cart_bg_normal_speed))
@@ -218,28 +314,34 @@ void background_draw(background_t *bg)
                                 : cart_bg_normal_speed,
                                 cart_bg_delta_speed_per_frame);
 
-        if (0 == change_counter) {
-            prev_angle = next_angle;
-            next_angle += 0.5 * normal_rng();
-            next_angle = fmodf(next_angle, TAU);
-            //printf("next_angle = %f\n", next_angle);
-            change_fract = 0.0f;
-            change_counter = bg->change_counter_frames;
-            //float angle_dist = prev_angle < angle ? (TAU - angle + prev_angle) : (prev_angle - angle);
-            //rot_direction = angle_dist < TAU / 2.0 ? -1.0 : 1.0;
+        if (procedural) {
+            bg->clock += bg->amp * GetFrameTime();
+            bg->clock = fmodf(bg->clock, BACKGROUND_DRIFT_PERIOD);
+            dir = background_drift_dir(bg->clock);
         } else {
-            change_counter--;
+            if (0 == change_counter) {
+                prev_angle = next_angle;
+                next_angle += 0.5 * normal_rng();
+                next_angle = fmodf(next_angle, TAU);
+                //printf("next_angle = %f\n", next_angle);
+                change_fract = 0.0f;
+                change_counter = bg->change_counter_frames;
+                //float angle_dist = prev_angle < angle ? (TAU - angle + prev_angle) : (prev_angle - angle);
+                //rot_direction = angle_dist < TAU / 2.0 ? -1.0 : 1.0;
+            } else {
+                change_counter--;
+            }
+
+            change_fract += bg->change_per_frame;
+            float eased_change_fract = ease_quartic_inout(change_fract);
+            angle = Lerp(prev_angle, next_angle, eased_change_fract);
+
+            //printf("fract = %f, angle = %f\n", change_fract, angle);
+
+            dir = Vector2Rotate((Vector2) { .x = 0.0f, .y = 1.0f }, angle);
+            dir = Vector2Scale(dir, speed);
         }
 
-        change_fract += bg->change_per_frame;
-        float eased_change_fract = ease_quartic_inout(change_fract);
-        angle = Lerp(prev_angle, next_angle, eased_change_fract);
-
-        //printf("fract = %f, angle = %f\n", change_fract, angle);
-
-        dir = Vector2Rotate((Vector2) { .x = 0.0f, .y = 1.0f }, angle);
-        dir = Vector2Scale(dir, speed);
-
         float bloom_fade_target = 0.5 * bloom_amount;
         bloom_fade_target += 0.5;
         bloom_fade = smooth_change(bloom_fade,
@@ -286,15 +388,22 @@ void background_draw(background_t *bg)
         limit_rot_y = slew_limit(limit_rot_y, rot_y, turn_limit);
         limit_rot_z = slew_limit(limit_rot_z, rot_z, turn_limit);
 
-        background_begin_3d(bg, 1.0f);
+        if (!procedural) {
+            background_begin_3d(bg, 1.0f);
 
-        off = Vector2Add(off, Vector2Scale(dir, speed * bg->amp));
-        off.x = fmodf(off.x, wrap_size);
-        off.y = fmodf(off.y, wrap_size);
+            off = Vector2Add(off, Vector2Scale(dir, speed * bg->amp));
+            off.x = fmodf(off.x, wrap_size);
+            off.y = fmodf(off.y, wrap_size);
+        }
 
         //printf("off=(%4f,%4f)\n", off.x, off.y);
     }
 
+    if (procedural) {
+        background_draw_procedural(bg, (detail < BACKGROUND_DETAIL_NO_GLOW) ? bloom_fade : 0.0f);
+        return;
+    }
+
 #ifdef USE_BG_TEXTURE
 /*
  * TEXTURE MODE
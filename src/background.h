@@ -27,6 +27,9 @@ struct background {
     int change_counter_frames;
     float change_per_frame;
 
+    /* drives the procedural grid's drift; runs faster when amp does */
+    float clock;
+
     Camera camera;
 
     Color  minor_color;
@@ -40,6 +43,7 @@ background_t *create_background(void);
 void destroy_background(background_t *bg);
 
 void background_resize(background_t *bg);
+bool background_procedural_available(void);
 void background_draw(background_t *bg);
 
 void background_begin_3d(background_t *bg, float amount);
@@ -0,0 +1,158 @@
+/****************************************************************************
+ *                                                                          *
+ * binary_io.c                                                              *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "binary_io.h"
+
+/*** encoding ***/
+
+void binary_writer_reserve(binary_writer_t *w, size_t n)
+{
+    if ((w->len + n) > w->size) {
+        size_t new_size = w->size ? w->size : 256;
+        while ((w->len + n) > new_size) {
+            new_size *= 2;
+        }
+        w->buf = realloc(w->buf, new_size);
+        w->size = new_size;
+    }
+}
+
+void binary_put_u8(binary_writer_t *w, uint8_t value)
+{
+    binary_writer_reserve(w, 1);
+    w->buf[w->len++] = value;
+}
+
+void binary_put_u16(binary_writer_t *w, uint16_t value)
+{
+    binary_put_u8(w, value & 0xff);
+    binary_put_u8(w, (value >> 8) & 0xff);
+}
+
+void binary_put_u32(binary_writer_t *w, uint32_t value)
+{
+    binary_put_u16(w, value & 0xffff);
+    binary_put_u16(w, (value >> 16) & 0xffff);
+}
+
+void binary_put_u64(binary_writer_t *w, uint64_t value)
+{
+    binary_put_u32(w, value & 0xffffffff);
+    binary_put_u32(w, (value >> 32) & 0xffffffff);
+}
+
+void binary_put_str(binary_writer_t *w, const char *str)
+{
+    size_t n = strlen(str);
+    if (n > UINT16_MAX) {
+        n = UINT16_MAX;
+    }
+
+    binary_put_u16(w, n);
+    binary_put_bytes(w, str, n);
+}
+
+void binary_put_bytes(binary_writer_t *w, const void *data, size_t n)
+{
+    binary_writer_reserve(w, n);
+    if (n > 0) {
+        memcpy(&w->buf[w->len], data, n);
+    }
+    w->len += n;
+}
+
+/*** decoding ***/
+
+bool binary_reader_has(binary_reader_t *r, size_t n)
+{
+    if (r->ok && ((r->pos + n) > r->len)) {
+        r->ok = false;
+    }
+    return r->ok;
+}
+
+uint8_t binary_get_u8(binary_reader_t *r)
+{
+    if (!binary_reader_has(r, 1)) {
+        return 0;
+    }
+    return r->buf[r->pos++];
+}
+
+uint16_t binary_get_u16(binary_reader_t *r)
+{
+    uint16_t lo = binary_get_u8(r);
+    uint16_t hi = binary_get_u8(r);
+    return lo | (hi << 8);
+}
+
+uint32_t binary_get_u32(binary_reader_t *r)
+{
+    uint32_t lo = binary_get_u16(r);
+    uint32_t hi = binary_get_u16(r);
+    return lo | (hi << 16);
+}
+
+uint64_t binary_get_u64(binary_reader_t *r)
+{
+    uint64_t lo = binary_get_u32(r);
+    uint64_t hi = binary_get_u32(r);
+    return lo | (hi << 32);
+}
+
+void binary_get_str(binary_reader_t *r, char *dst, size_t dst_size)
+{
+    size_t n = binary_get_u16(r);
+    if (!binary_reader_has(r, n)) {
+        dst[0] = '\0';
+        return;
+    }
+
+    size_t copy_len = MIN(n, dst_size - 1);
+    memcpy(dst, &r->buf[r->pos], copy_len);
+    dst[copy_len] = '\0';
+    r->pos += n;
+}
+
+char *binary_get_strdup(binary_reader_t *r)
+{
+    size_t n = binary_get_u16(r);
+    if (!binary_reader_has(r, n)) {
+        return NULL;
+    }
+
+    char *str = strndup((const char *)&r->buf[r->pos], n);
+    r->pos += n;
+    return str;
+}
+
+/* returns a pointer into the reader's buffer */
+const unsigned char *binary_get_bytes(binary_reader_t *r, size_t n)
+{
+    if (!binary_reader_has(r, n)) {
+        return NULL;
+    }
+
+    const unsigned char *p = &r->buf[r->pos];
+    r->pos += n;
+    return p;
+}
@@ -0,0 +1,67 @@
+/****************************************************************************
+ *                                                                          *
+ * binary_io.h                                                              *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+/*
+ * Little-endian encoding helpers for the binary file formats (level
+ * packs, directory caches). Strings are stored as a u16 length
+ * followed by the bytes, without a terminating NUL.
+ *
+ * A reader that runs past the end of its buffer clears its ok flag
+ * and returns zeros from then on, so a parser can check r.ok once at
+ * the end instead of after every field.
+ */
+
+struct binary_writer {
+    unsigned char *buf;
+    size_t len;
+    size_t size;
+};
+typedef struct binary_writer binary_writer_t;
+
+struct binary_reader {
+    const unsigned char *buf;
+    size_t len;
+    size_t pos;
+    bool ok;
+};
+typedef struct binary_reader binary_reader_t;
+
+void binary_writer_reserve(binary_writer_t *w, size_t n);
+void binary_put_u8(binary_writer_t *w, uint8_t value);
+void binary_put_u16(binary_writer_t *w, uint16_t value);
+void binary_put_u32(binary_writer_t *w, uint32_t value);
+void binary_put_u64(binary_writer_t *w, uint64_t value);
+void binary_put_str(binary_writer_t *w, const char *str);
+void binary_put_bytes(binary_writer_t *w, const void *data, size_t n);
+
+bool binary_reader_has(binary_reader_t *r, size_t n);
+uint8_t binary_get_u8(binary_reader_t *r);
+uint16_t binary_get_u16(binary_reader_t *r);
+uint32_t binary_get_u32(binary_reader_t *r);
+uint64_t binary_get_u64(binary_reader_t *r);
+void binary_get_str(binary_reader_t *r, char *dst, size_t dst_size);
+char *binary_get_strdup(binary_reader_t *r);
+const unsigned char *binary_get_bytes(binary_reader_t *r, size_t n);
+
+#endif /*BINARY_IO_H*/
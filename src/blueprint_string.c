@@ -473,6 +473,12 @@ static bool deserialize_tile_radius(const char **strp, generate_level_param_t *p
     str++;
     bool ret = deserialize_get_hex_number(str, &param->tile_radius);
 
+    if (ret && ((param->tile_radius < LEVEL_MIN_RADIUS) ||
+                (param->tile_radius > LEVEL_MAX_RADIUS))) {
+        deserial_error(*strp, field_length, 1, "tile_radius", "radius out of range");
+        ret = false;
+    }
+
     *strp += field_length;
 
     return ret;
@@ -0,0 +1,176 @@
+/****************************************************************************
+ *                                                                          *
+ * board_bench.c                                                            *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "options.h"
+#include "game_mode.h"
+#include "level.h"
+#include "level_draw.h"
+#include "hex_grid.h"
+#include "generate_level.h"
+#include "board_bench.h"
+
+#define BOARD_BENCH_GENERATE_COUNT 5
+#define BOARD_BENCH_FRAME_COUNT    240
+#define BOARD_BENCH_RADIUS_STEP    4
+
+static level_t *bench_generate(int radius, uint64_t seed)
+{
+    generate_level_param_t param = {
+        .mode = GENERATE_LEVEL_RANDOM,
+        .seed = seed,
+        .tile_radius = radius,
+        .color = { 0, true, true, true, true },
+        .color_count = 4,
+        .fixed  = { 0, 0 },
+        .hidden = { 0, 0 },
+        .symmetry_mode = SYMMETRY_MODE_NONE,
+        .path_density = options->create_level_minimum_path_density
+    };
+
+    return generate_random_level(&param, "board benchmark");
+}
+
+static double bench_generation(int radius, level_t **last)
+{
+    double total = 0.0;
+
+    for (int i=0; i<BOARD_BENCH_GENERATE_COUNT; i++) {
+        double start = GetTime();
+        level_t *level = bench_generate(radius, i + 1);
+        total += GetTime() - start;
+
+        if (i + 1 < BOARD_BENCH_GENERATE_COUNT) {
+            destroy_level(level);
+        } else {
+            *last = level;
+        }
+    }
+
+    return total / BOARD_BENCH_GENERATE_COUNT;
+}
+
+/*
+ * Time is measured from the start of the update to the point where
+ * the GPU has finished the frame, so vsync does not hide the cost.
+ * Run with LIBGL_ALWAYS_SOFTWARE=1 to measure a software (llvmpipe)
+ * renderer.
+ *
+ * With idle set the mouse stays on one tile, like a player thinking
+ * about their next move.
+ */
+static void bench_frames(level_t *level, bool batch_tile_draw, bool cache_board, bool idle, double *avg, double *worst)
+{
+    game_mode_t save_game_mode = game_mode;
+    game_mode = GAME_MODE_PLAY_LEVEL;
+
+    bool save_batch_tile_draw = options->batch_tile_draw;
+    bool save_cache_board = options->cache_board;
+    options->batch_tile_draw = batch_tile_draw;
+    options->cache_board = cache_board;
+
+    level_use_unsolved_tile_pos(level);
+    level_resize(level);
+
+    double total = 0.0;
+    *worst = 0.0;
+
+    for (int i=0; i<BOARD_BENCH_FRAME_COUNT; i++) {
+        /* sweep the mouse around the board to exercise hover lookup */
+        float theta = idle ? 0.0f : TAU * ((float)i / (float)BOARD_BENCH_FRAME_COUNT);
+        float r = MIN(window_size.x, window_size.y) * 0.4f;
+        IVector2 mouse = {
+            .x = window_center.x + (r * cosf(theta)),
+            .y = window_center.y + (r * sinf(theta))
+        };
+
+        double start = GetTime();
+
+        level_set_hover(level, mouse);
+        level_check(level);
+        level_draw_prepare(level, false);
+
+        BeginDrawing();
+        ClearBackground(BLACK);
+        level_draw(level, false);
+        rlDrawRenderBatchActive();
+        glFinish();
+
+        double elapsed = GetTime() - start;
+        EndDrawing();
+
+        total += elapsed;
+        *worst = MAX(*worst, elapsed);
+    }
+
+    *avg = total / BOARD_BENCH_FRAME_COUNT;
+
+    options->batch_tile_draw = save_batch_tile_draw;
+    options->cache_board = save_cache_board;
+    game_mode = save_game_mode;
+}
+
+void run_board_benchmark(void)
+{
+    infomsg("BENCHMARK: board size (%d generated levels, %d frames per radius)",
+            BOARD_BENCH_GENERATE_COUNT, BOARD_BENCH_FRAME_COUNT);
+    /* the frame times mean little without knowing what drew them */
+    infomsg("BENCHMARK: renderer: %s (%s), window %dx%d",
+            (const char *)glGetString(GL_RENDERER),
+            (const char *)glGetString(GL_VERSION),
+            GetScreenWidth(), GetScreenHeight());
+
+    for (int radius = LEVEL_DEFAULT_GRID_RADIUS; radius <= LEVEL_MAX_RADIUS; radius += BOARD_BENCH_RADIUS_STEP) {
+        level_t *level = NULL;
+
+        double generate = bench_generation(radius, &level);
+
+        double frame_avg, frame_worst;
+        double batch_avg, batch_worst;
+        double idle_avg, idle_worst;
+        double cached_avg, cached_worst;
+        bench_frames(level, false, false, false, &frame_avg,  &frame_worst);
+        bench_frames(level, true,  false, false, &batch_avg,  &batch_worst);
+        bench_frames(level, true,  false, true,  &idle_avg,   &idle_worst);
+        bench_frames(level, true,  true,  true,  &cached_avg, &cached_worst);
+
+        infomsg("BENCHMARK: radius %2d: %3d tiles (grid %dx%d), generate %8.3f ms, frame avg %6.3f ms, worst %6.3f ms",
+                radius,
+                level->enabled_tile_count,
+                level->grid->width, level->grid->width,
+                generate * 1000.0,
+                frame_avg * 1000.0,
+                frame_worst * 1000.0);
+        infomsg("BENCHMARK: radius %2d: batched tile draw: frame avg %6.3f ms, worst %6.3f ms (%.2fx)",
+                radius,
+                batch_avg * 1000.0,
+                batch_worst * 1000.0,
+                frame_avg / batch_avg);
+        infomsg("BENCHMARK: radius %2d: idle, board cache: frame avg %6.3f ms, worst %6.3f ms (%.2fx vs %6.3f ms uncached)",
+                radius,
+                cached_avg * 1000.0,
+                cached_worst * 1000.0,
+                idle_avg / cached_avg,
+                idle_avg * 1000.0);
+
+        destroy_level(level);
+    }
+}
@@ -0,0 +1,31 @@
+/****************************************************************************
+ *                                                                          *
+ * board_bench.h                                                            *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef BOARD_BENCH_H
+#define BOARD_BENCH_H
+
+/*
+ * Times level generation and per-frame update/draw cost at a few
+ * board radii (--benchmark-board). Needs an open window.
+ */
+void run_board_benchmark(void);
+
+#endif /*BOARD_BENCH_H*/
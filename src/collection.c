@@ -27,6 +27,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <ctype.h>
+#include <limits.h>
 
 #include "cJSON/cJSON.h"
 
@@ -35,6 +37,11 @@
 #include "options.h"
 #include "raylib_helper.h"
 #include "collection.h"
+#include "collection_pack.h"
+#include "thread_pool.h"
+#include "dir_cache.h"
+#include "json_reader.h"
+#include "level_index.h"
 #include "fonts.h"
 
 #define COLLECTION_JSON_VERSION 1
@@ -110,11 +117,132 @@ void collection_clear_levels(collection_t *collection)
         destroy_level(collection->levels);
         collection->levels = NULL;
     }
+    collection->last_level = NULL;
+
+    destroy_level_index(collection->level_index);
+    collection->level_index = NULL;
+}
+
+struct level_file_list {
+    char **paths;
+    int count;
+    int alloc_count;
+    level_file_header_t *headers;
+
+    dir_cache_t *cache;
+    dir_cache_entry_t **cached;
+};
+typedef struct level_file_list level_file_list_t;
+
+static void level_file_list_add(level_file_list_t *list, const char *path)
+{
+    if (list->count >= list->alloc_count) {
+        list->alloc_count = list->alloc_count ? (2 * list->alloc_count) : INITIAL_LEVEL_NAME_COUNT;
+        list->paths = realloc(list->paths, list->alloc_count * sizeof(char *));
+    }
+    list->paths[list->count++] = strdup(path);
+}
+
+static void level_file_list_free(level_file_list_t *list)
+{
+    for (int i = 0; i < list->count; i++) {
+        free(list->paths[i]);
+        if (list->headers && list->headers[i].data) {
+            MemFree(list->headers[i].data);
+        }
+    }
+    SAFEFREE(list->paths);
+    SAFEFREE(list->headers);
+    SAFEFREE(list->cached);
+    destroy_dir_cache(list->cache);
+    list->cache = NULL;
+}
+
+/* the dir_cache key: the path relative to the collection's directory */
+static const char *level_file_list_key(collection_t *collection, const char *path)
+{
+    size_t len = strlen(collection->dirpath);
+    if ((0 == strncmp(path, collection->dirpath, len)) && is_dir_separator(path[len])) {
+        return path + len + 1;
+    }
+    return path;
+}
+
+/* also used by --pack, before raylib's timer exists */
+static double load_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static void read_level_file_list_header(void *data, int index)
+{
+    level_file_list_t *list = data;
+
+    if (list->cache) {
+        dir_cache_read_level_file(list->cached[index], list->paths[index], &list->headers[index]);
+    } else {
+        read_level_file_header(list->paths[index], &list->headers[index]);
+    }
+}
+
+/*
+ * The files are read and parsed on the thread pool, skipping any that
+ * the directory's dir_cache already knows about. The levels are then
+ * created and added on this thread in list order, so the result
+ * doesn't depend on which file happened to finish first.
+ */
+static bool collection_add_level_file_list(collection_t *collection, level_file_list_t *list)
+{
+    list->headers = calloc(MAX(list->count, 1), sizeof(level_file_header_t));
+
+    double start_time = load_time();
+
+    list->cache = load_dir_cache(collection->dirpath);
+    if (list->cache) {
+        list->cached = calloc(MAX(list->count, 1), sizeof(dir_cache_entry_t *));
+        for (int i = 0; i < list->count; i++) {
+            list->cached[i] = dir_cache_find(list->cache, level_file_list_key(collection, list->paths[i]));
+        }
+    }
+
+    thread_pool_for(read_level_file_list_header, list, list->count);
+
+    int cache_hits = 0;
+    if (list->cache) {
+        for (int i = 0; i < list->count; i++) {
+            if (list->headers[i].from_cache) {
+                cache_hits++;
+            }
+            dir_cache_update(list->cache, list->cached[i],
+                             level_file_list_key(collection, list->paths[i]), &list->headers[i]);
+        }
+        dir_cache_save(list->cache);
+    }
+
+    if (options->verbose) {
+        infomsg("Read %d level files from \"%s\" in %.1f ms (%d cached, %d threads)",
+                list->count, collection->dirpath,
+                (load_time() - start_time) * 1000.0, cache_hits, thread_pool_size());
+    }
+
+    for (int i = 0; i < list->count; i++) {
+        level_t *level = create_level_file_stub(list->paths[i], &list->headers[i]);
+        if (!level) {
+            errmsg("cannot load level file \"%s\" into collection \"%s\"",
+                   list->paths[i], collection_name(collection));
+            return false;
+        }
+        collection_add_level(collection, level);
+    }
+
+    return true;
 }
 
 static bool collection_scan_index_file(collection_t *collection, const char *index_file)
 {
-    bool ret = true;
+    level_file_list_t list = {0};
 
     char *index_str = LoadFileText(index_file);
 
@@ -123,11 +251,7 @@ static bool collection_scan_index_file(collection_t *collection, const char *ind
     while (*p) {
         if (*p == '\n') {
             *p = '\0';
-            const char *filepath = concat_dir_and_filename(collection->dirpath, filename);
-            if (!collection_add_level_file(collection, filepath)) {
-                ret = false;
-                goto scan_index_file_cleanup;
-            }
+            level_file_list_add(&list, concat_dir_and_filename(collection->dirpath, filename));
             p++;
             filename = p;
         } else {
@@ -135,36 +259,78 @@ static bool collection_scan_index_file(collection_t *collection, const char *ind
         }
     }
     if ((*p != '\0') && (*p != '\n')) {
-        const char *filepath = concat_dir_and_filename(collection->dirpath, filename);
-        if (!collection_add_level_file(collection, filepath)) {
-            ret = false;
-            goto scan_index_file_cleanup;
-        }
+        level_file_list_add(&list, concat_dir_and_filename(collection->dirpath, filename));
     }
 
-  scan_index_file_cleanup:
     free(index_str);
+
+    bool ret = collection_add_level_file_list(collection, &list);
+    level_file_list_free(&list);
     return ret;
 }
 
-static bool collection_scan_dir_by_file_ext(collection_t *collection)
+/* compares runs of digits by value, so "level-1000" sorts after "level-999" */
+static int compare_natural(const char *a, const char *b)
 {
-    FilePathList list = LoadDirectoryFilesEx(collection->dirpath, "." LEVEL_FILENAME_EXT, false);
+    while (*a && *b) {
+        if (isdigit((unsigned char)*a) && isdigit((unsigned char)*b)) {
+            while (*a == '0') { a++; }
+            while (*b == '0') { b++; }
+
+            size_t alen = 0, blen = 0;
+            while (isdigit((unsigned char)a[alen])) { alen++; }
+            while (isdigit((unsigned char)b[blen])) { blen++; }
+
+            if (alen != blen) {
+                return (alen < blen) ? -1 : 1;
+            }
 
-    for (int i=0; i < (int)list.count; i++) {
-        char *filename = list.paths[i];
-        if (FileExists(filename)) {
-            if (!collection_add_level_file(collection, filename)) {
-                return false;
+            int cmp = strncmp(a, b, alen);
+            if (cmp) {
+                return cmp;
             }
+
+            a += alen;
+            b += blen;
         } else {
-            return false;
+            if (*a != *b) {
+                return (unsigned char)*a - (unsigned char)*b;
+            }
+            a++;
+            b++;
         }
     }
 
-    UnloadDirectoryFiles(list);
+    return (unsigned char)*a - (unsigned char)*b;
+}
 
-    return true;
+static int compare_path_strings(const void *p1, const void *p2)
+{
+    const char *s1 = *(char * const *)p1;
+    const char *s2 = *(char * const *)p2;
+
+    int cmp = compare_natural(s1, s2);
+    return cmp ? cmp : strcmp(s1, s2);
+}
+
+static bool collection_scan_dir_by_file_ext(collection_t *collection)
+{
+    level_file_list_t list = {0};
+
+    FilePathList files = LoadDirectoryFilesEx(collection->dirpath, "." LEVEL_FILENAME_EXT, false);
+    for (int i=0; i < (int)files.count; i++) {
+        level_file_list_add(&list, files.paths[i]);
+    }
+    UnloadDirectoryFiles(files);
+
+    /* directory order depends on the filesystem */
+    if (list.count > 1) {
+        qsort(list.paths, list.count, sizeof(char *), compare_path_strings);
+    }
+
+    bool ret = collection_add_level_file_list(collection, &list);
+    level_file_list_free(&list);
+    return ret;
 }
 
 bool collection_scan_dir(collection_t *collection)
@@ -273,7 +439,10 @@ bool collection_from_json(collection_t *collection, cJSON *json)
             return false;
         }
 
-        level_t *level = load_level_json(level_json->string, level_json, true);
+        level_t *level = load_level_json_stub(level_json->string, level_json);
+        if (!level) {
+            return false;
+        }
         level->stored_in_collection = true;
         collection_add_level(collection, level);
     }
@@ -281,12 +450,117 @@ bool collection_from_json(collection_t *collection, cJSON *json)
     return true;
 }
 
+/*
+ * collection_from_json() straight from the pack's JSON text. Each
+ * level becomes a stub holding its own slice of the text. Only valid
+ * packs with the header fields before "levels" are accepted, and
+ * nothing is added to the collection unless the whole pack is read;
+ * otherwise this returns false without a message and the caller
+ * parses the pack with cJSON.
+ */
+bool collection_read_json(collection_t *collection, const char *str)
+{
+    bool rv = false;
+    bool have_version   = false;
+    bool have_unique_id = false;
+    bool have_id        = false;
+    bool have_levels    = false;
+    int version = 0;
+    unique_id_t unique_id;
+    char id[COLLECTION_ID_LENGTH];
+    const char *key;
+
+    level_t **levels = NULL;
+    int level_count = 0;
+    int levels_size = 0;
+
+    json_reader_t r;
+    init_json_reader(&r, str);
+
+    if (!json_reader_begin_object(&r)) {
+        goto cleanup;
+    }
+
+    while (json_reader_next_key(&r, &key)) {
+        if (!have_version && (0 == strcasecmp(key, "version"))) {
+            have_version = json_reader_int(&r, &version);
+        } else if (!have_unique_id && (0 == strcasecmp(key, "unique_id"))) {
+            const char *value = json_reader_string(&r);
+            if (value) {
+                snprintf(unique_id, UNIQUE_ID_LENGTH, "%s", value);
+                have_unique_id = true;
+            }
+        } else if (!have_id && (0 == strcasecmp(key, "id"))) {
+            const char *value = json_reader_string(&r);
+            if (value) {
+                snprintf(id, COLLECTION_ID_LENGTH, "%s", value);
+                have_id = true;
+            }
+        } else if (!have_levels && (0 == strcasecmp(key, "levels"))) {
+            have_levels = true;
+
+            if (!have_version || (version != COLLECTION_JSON_VERSION) ||
+                !have_unique_id || !have_id) {
+                goto cleanup;
+            }
+
+            if (!json_reader_begin_object(&r)) {
+                goto cleanup;
+            }
+            while (json_reader_next_key(&r, &key)) {
+                char *filename = strdup(key);
+                level_t *level = read_level_json_stub(filename, &r);
+                free(filename);
+
+                if (!level) {
+                    goto cleanup;
+                }
+
+                if (level_count >= levels_size) {
+                    levels_size = levels_size ? (levels_size * 2) : 64;
+                    levels = realloc(levels, levels_size * sizeof(level_t *));
+                }
+                levels[level_count++] = level;
+            }
+        } else {
+            json_reader_skip(&r);
+        }
+    }
+
+    if (!r.ok || !have_levels) {
+        goto cleanup;
+    }
+
+    snprintf(collection->unique_id, UNIQUE_ID_LENGTH, "%s", unique_id);
+    snprintf(collection->id, COLLECTION_ID_LENGTH, "%s", id);
+
+    for (int i=0; i<level_count; i++) {
+        collection_add_level(collection, levels[i]);
+    }
+    level_count = 0;
+
+    rv = true;
+
+  cleanup:
+    for (int i=0; i<level_count; i++) {
+        destroy_level(levels[i]);
+    }
+    SAFEFREE(levels);
+    cleanup_json_reader(&r);
+
+    return rv;
+}
+
 collection_t *load_collection_pack_compressed_data(const char *filename, unsigned char *compressed, int compsize)
 {
     assert_not_null(filename);
     assert_not_null(compressed);
     assert(compsize > 0);
 
+    if (collection_pack_data_is_indexed(compressed, compsize)) {
+        return load_collection_pack_index_data(filename, compressed, compsize);
+    }
+
     int pack_str_size = 0;
     unsigned char *pack_str_data = DecompressData(compressed, compsize, &pack_str_size);
     char *pack_str = (char *)pack_str_data;
@@ -299,18 +573,23 @@ collection_t *load_collection_pack_compressed_data(const char *filename, unsigne
         goto cleanup_pack_str;
     }
 
-    json = cJSON_Parse(pack_str);
-    if (NULL == json) {
-        errmsg("Error parsing " COLLECTION_FILENAME_EXT " \"%s\" as JSON", filename);
-        goto cleanup_pack_str;
-    }
-
     collection_t *collection = create_collection();
     collection->filename = strdup(filename);
     collection->is_pack = true;
 
-    if (collection_from_json(collection, json)) {
+    if (collection_read_json(collection, pack_str)) {
         rv = collection;
+    } else {
+        json = cJSON_Parse(pack_str);
+        if (NULL == json) {
+            errmsg("Error parsing " COLLECTION_FILENAME_EXT " \"%s\" as JSON", filename);
+            destroy_collection(collection);
+            goto cleanup_pack_str;
+        }
+
+        if (collection_from_json(collection, json)) {
+            rv = collection;
+        }
     }
 
     collection_update_level_names(collection);
@@ -328,6 +607,10 @@ collection_t *load_collection_pack_file(const char *filename)
 {
     assert_not_null(filename);
 
+    if (collection_pack_file_is_indexed(filename)) {
+        return load_collection_pack_index(filename);
+    }
+
     int compsize = 0;
     unsigned char *compressed = LoadFileData(filename, &compsize);
 
@@ -396,6 +679,9 @@ void destroy_collection(collection_t *collection)
             destroy_level(collection->levels);
         }
 
+        destroy_level_index(collection->level_index);
+        collection->level_index = NULL;
+
         SAFEFREE(collection->loadpath);
         SAFEFREE(collection->dirpath);
         SAFEFREE(collection->filename);
@@ -427,19 +713,35 @@ const char *collection_name(collection_t *collection)
     }
 }
 
+static level_index_t *collection_get_level_index(collection_t *collection)
+{
+    if (!collection->level_index) {
+        collection->level_index = create_level_index();
+        SGLIB_DL_LIST_MAP_ON_ELEMENTS(level_t, collection->levels, level, prev, next, {
+                level_index_add(collection->level_index, level);
+            });
+    }
+
+    return collection->level_index;
+}
+
+/* called whenever one of the keys in level_index_key_t changes */
+void collection_reindex_level(collection_t *collection, level_t *level)
+{
+    assert_not_null(collection);
+    assert_not_null(level);
+
+    if (collection->level_index) {
+        level_index_add(collection->level_index, level);
+    }
+}
+
 static bool collection_level_filename_exists_in_collection(collection_t *collection, const char *name)
 {
     assert_not_null(collection);
     assert_not_null(name);
-    SGLIB_DL_LIST_MAP_ON_ELEMENTS(level_t, collection->levels, level, prev, next, {
-            if (level->filename) {
-                if (0 == strcmp(level->filename, name)) {
-                    return true;
-                }
-            }
-        });
 
-    return false;
+    return NULL != level_index_find(collection_get_level_index(collection), LEVEL_INDEX_FILENAME, name);
 }
 
 #if defined(PLATFORM_DESKTOP)
@@ -465,6 +767,34 @@ static bool collection_level_filename_exists(collection_t *collection, const cha
         || collection_level_filename_exists_as_existing_file(collection, name);
 }
 
+/* keeps filename_seq past the generated filenames already in the collection,
+ * so generating the next one doesn't have to probe all of them */
+static void collection_skip_generated_filename(collection_t *collection, const char *filename)
+{
+    const char *prefix = COLLECTION_DEFAULT_FILENAME_PREFIX;
+    const char *suffix = COLLECTION_DEFAULT_FILENAME_SUFFIX;
+    size_t prefix_len = strlen(prefix);
+
+    if (strncmp(filename, prefix, prefix_len)) {
+        return;
+    }
+
+    const char *p = filename + prefix_len;
+    if (!isdigit((unsigned char)*p)) {
+        return;
+    }
+
+    char *end;
+    long n = strtol(p, &end, 10);
+    if (strcmp(end, suffix) || (n >= INT_MAX)) {
+        return;
+    }
+
+    if (n >= collection->filename_seq) {
+        collection->filename_seq = n + 1;
+    }
+}
+
 static void collection_generate_level_filename(collection_t *collection, level_t *level)
 {
     assert_not_null(collection);
@@ -477,20 +807,25 @@ static void collection_generate_level_filename(collection_t *collection, level_t
     char *prefix = COLLECTION_DEFAULT_FILENAME_PREFIX;
     char *suffix = COLLECTION_DEFAULT_FILENAME_SUFFIX;
 
-    for (int n=collection->filename_seq; n<1000; n++) {
+    /* past 999 the number just gets wider; directory scans sort
+     * level filenames numerically (see compare_path_strings()) */
+    for (int n=collection->filename_seq; ; n++) {
         char *tmp;
         safe_asprintf(&tmp, "%s%03d%s", prefix, n, suffix);
-        if (!collection_level_filename_exists(collection, tmp)) {
+        bool exists = collection_level_filename_exists(collection, tmp);
+        if (!exists) {
             collection->filename_seq = n + 1;
             level_set_file_path(level, tmp);
+        }
+        free(tmp);
+
+        if (!exists) {
             if (options->verbose) {
                 infomsg("Generated filename: \"%s\"", level->filename);
             }
             return;
         }
     }
-
-    DIE("Only 999 level filenames are supported; sorry!");
 }
 
 void collection_show_level_names(collection_t *collection)
@@ -558,13 +893,7 @@ bool collection_level_name_exists(collection_t *collection, const char *name)
     assert_not_null(collection);
     assert_not_null(name);
 
-    SGLIB_DL_LIST_MAP_ON_ELEMENTS(level_t, collection->levels, level, prev, next, {
-            if (0 == strcmp(level->name, name)) {
-                return true;
-            }
-        });
-
-    return false;
+    return NULL != level_index_find(collection_get_level_index(collection), LEVEL_INDEX_NAME, name);
 }
 
 void collection_add_level(collection_t *collection, level_t *level)
@@ -572,17 +901,22 @@ void collection_add_level(collection_t *collection, level_t *level)
     assert_not_null(collection);
     assert_not_null(level);
 
-    if (!level->filename) {
+    if (level->filename) {
+        collection_skip_generated_filename(collection, level->filename);
+    } else {
         collection_generate_level_filename(collection, level);
     }
 
     if (collection->levels) {
-        level_t *last;
-        SGLIB_DL_LIST_GET_LAST(level_t, collection->levels, prev, next, last);
+        level_t *last = collection->last_level ? collection->last_level : collection->levels;
+        while (last->next) {
+            last = last->next;
+        }
         SGLIB_DL_LIST_ADD_AFTER(level_t, last, level, prev, next);
     } else {
         collection->levels = level;
     }
+    collection->last_level = level;
 
     collection->level_count++;
 
@@ -593,7 +927,7 @@ void collection_add_level(collection_t *collection, level_t *level)
         collection->level_name_count *= 2;
         collection_alloc_level_names(collection);
 
-        memcpy(collection->level_names, old_ptr, old_count);
+        memcpy(collection->level_names, old_ptr, old_count * sizeof(char *));
         free(old_ptr);
     }
 
@@ -602,6 +936,9 @@ void collection_add_level(collection_t *collection, level_t *level)
     }
 
     level->collection = collection;
+    level->in_collection = true;
+
+    /* also adds the level to the level_index */
     level_update_id(level);
 }
 
@@ -610,7 +947,7 @@ bool collection_add_level_file(collection_t *collection, const char *filename)
     assert_not_null(collection);
     assert_not_null(filename);
 
-    level_t *level = load_level_file(filename);
+    level_t *level = load_level_file_stub(filename);
     if (level) {
         collection_add_level(collection, level);
         return true;
@@ -633,36 +970,14 @@ level_t *collection_find_level_by_id(collection_t *collection, const char *id)
 {
     assert_not_null(collection);
 
-    level_t *level = collection->levels;
-    while (level) {
-        if (level->id) {
-            if (0 == strcmp(id, level->id)) {
-                return level;
-            }
-        }
-
-        level = level->next;
-    }
-
-    return NULL;
+    return level_index_find(collection_get_level_index(collection), LEVEL_INDEX_ID, id);
 }
 
 level_t *collection_find_level_by_unique_id(collection_t *collection, const char *unique_id)
 {
     assert_not_null(collection);
 
-    level_t *level = collection->levels;
-    while (level) {
-        if (level->id) {
-            if (0 == strcmp(unique_id, level->unique_id)) {
-                return level;
-            }
-        }
-
-        level = level->next;
-    }
-
-    return NULL;
+    return level_index_find(collection_get_level_index(collection), LEVEL_INDEX_UNIQUE_ID, unique_id);
 }
 
 level_t *collection_find_level_by_filename(collection_t *collection, const char *filepath)
@@ -672,18 +987,7 @@ level_t *collection_find_level_by_filename(collection_t *collection, const char
 
     const char *filename = GetFileName(filepath);
 
-    level_t *level = collection->levels;
-    while (level) {
-        if (level->filename) {
-            if (0 == strcmp(filename, level->filename)) {
-                return level;
-            }
-        }
-
-        level = level->next;
-    }
-
-    return NULL;
+    return level_index_find(collection_get_level_index(collection), LEVEL_INDEX_FILENAME, filename);
 }
 
 #if defined(PLATFORM_DESKTOP)
@@ -737,78 +1041,15 @@ void collection_save_dir(collection_t *collection, const char *dirpath, bool cha
 }
 #endif
 
-cJSON *collection_to_json(collection_t *collection)
-{
-    cJSON *json = cJSON_CreateObject();
-
-    if (cJSON_AddNumberToObject(json, "version", COLLECTION_JSON_VERSION) == NULL) {
-        goto json_err;
-    }
-
-    if (cJSON_AddStringToObject(json, "unique_id", collection->unique_id) == NULL) {
-        goto json_err;
-    }
-
-    if (cJSON_AddStringToObject(json, "id", collection->id) == NULL) {
-        goto json_err;
-    }
-
-    cJSON *levels_json = cJSON_AddObjectToObject(json, "levels");
-    if (levels_json == NULL) {
-        goto json_err;
-    }
-
-    level_t *level = collection->levels;
-    while (level) {
-        assert_not_null(level->filename);
-
-        cJSON *level_json = level_to_json(level);
-        if (level_json == NULL) {
-            goto json_err;
-        }
-
-        cJSON_AddItemToObject(levels_json, level->filename, level_json);
-
-        level = level->next;
-    }
-
-    return json;
-
-  json_err:
-    cJSON_Delete(json);
-    return NULL;
-}
-
 #if defined(PLATFORM_DESKTOP)
 void collection_save_pack(collection_t *collection, const char *filename)
 {
     assert_not_null(collection);
     assert_not_null(filename);
 
-    char *tmpname;
-    safe_asprintf(&tmpname, "%s.tmp", filename);
-
-    if (options->verbose) {
-        infomsg("Writing level collection to \"%s\"", tmpname);
+    if (!collection_pack_save(collection, filename)) {
+        errmsg("Error saving level collection \"%s\"", filename);
     }
-
-    cJSON *json = collection_to_json(collection);
-    char *json_str = cJSON_PrintUnformatted(json);
-
-    int newsize = 0;
-    unsigned char *compressed = CompressData((const unsigned char *)json_str, strlen(json_str) + 1, &newsize);
-    SaveFileData(tmpname, compressed, newsize);
-    MemFree(compressed);
-
-    free(json_str);
-    cJSON_Delete(json);
-
-    if (-1 == rename(tmpname, filename)) {
-        errmsg("Error trying to rename \"%s\" to \"%s\" - ",
-               tmpname, filename);
-    }
-
-    free(tmpname);
 }
 #endif
 
@@ -29,6 +29,8 @@
 
 #include "level.h"
 
+struct level_index;
+
 struct collection {
     unique_id_t unique_id;
     char id[COLLECTION_ID_LENGTH];
@@ -47,6 +49,13 @@ struct collection {
     level_t *levels;
     int level_count;
 
+    /* the list is only appended to, so this is usually its tail;
+     * reordering levels can leave it pointing earlier in the list */
+    level_t *last_level;
+
+    /* built by the first lookup, see collection_reindex_level() */
+    struct level_index *level_index;
+
     const char **level_names;
     int level_name_count;
 
@@ -65,6 +74,9 @@ extern collection_t *current_collection;
 collection_t *create_collection(void);
 void collection_set_id(collection_t *collection, const char *new_id);
 
+bool collection_from_json(collection_t *collection, cJSON *json);
+bool collection_read_json(collection_t *collection, const char *str);
+
 collection_t *load_collection_dir(const char *dirpath);
 collection_t *load_collection_level_file(const char *filename);
 collection_t *load_collection_pack_compressed_data(const char *name, unsigned char *compressed, int compsize);
@@ -91,6 +103,7 @@ level_t *collection_find_level_by_id(collection_t *collection, const char *id);
 level_t *collection_find_level_by_unique_id(collection_t *collection, const char *unique_id);
 level_t *collection_find_level_by_filename(collection_t *collection, const char *filename);
 void collection_update_level_names(collection_t *collection);
+void collection_reindex_level(collection_t *collection, level_t *level);
 
 void collection_draw(collection_t *collection);
 
@@ -0,0 +1,487 @@
+/****************************************************************************
+ *                                                                          *
+ * collection_pack.c                                                        *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include "cJSON/cJSON.h"
+
+#include "options.h"
+#include "save_queue.h"
+#include "binary_io.h"
+#include "level.h"
+#include "collection.h"
+#include "collection_pack.h"
+
+/* magic, u8 version, 3 reserved bytes, u32 level_count, u32 index_size */
+#define COLLECTION_PACK_HEADER_SIZE 16
+
+/*** file access ***/
+
+static bool read_exact(FILE *f, void *buf, size_t n)
+{
+    return (n == 0) || (fread(buf, 1, n, f) == n);
+}
+
+/* returns a MemAlloc()ed copy of size bytes at offset in filename */
+static unsigned char *read_file_range(const char *filename, uint32_t offset, uint32_t size)
+{
+    /* the byte ranges are only valid once a queued save has landed */
+    save_queue_wait_for_path(filename);
+
+    FILE *f = fopen(filename, "rb");
+    if (NULL == f) {
+        errmsg("Could not open \"%s\": %s", filename, strerror(errno));
+        return NULL;
+    }
+
+    unsigned char *data = MemAlloc(MAX(size, 1));
+
+    if ((-1 == fseek(f, offset, SEEK_SET)) || !read_exact(f, data, size)) {
+        errmsg("Error reading %u bytes at offset %u in \"%s\"",
+               size, offset, filename);
+        MemFree(data);
+        data = NULL;
+    }
+
+    fclose(f);
+    return data;
+}
+
+bool collection_pack_file_is_indexed(const char *filename)
+{
+    assert_not_null(filename);
+
+    save_queue_wait_for_path(filename);
+
+    FILE *f = fopen(filename, "rb");
+    if (NULL == f) {
+        return false;
+    }
+
+    char magic[COLLECTION_PACK_MAGIC_SIZE];
+    bool rv = read_exact(f, magic, COLLECTION_PACK_MAGIC_SIZE)
+        && (0 == memcmp(magic, COLLECTION_PACK_MAGIC, COLLECTION_PACK_MAGIC_SIZE));
+
+    fclose(f);
+    return rv;
+}
+
+/*** loading ***/
+
+struct pack_header {
+    uint32_t level_count;
+    uint32_t index_size;
+};
+
+static bool parse_header(const char *filename, const unsigned char *buf, struct pack_header *header)
+{
+    binary_reader_t r = {
+        .buf = buf,
+        .len = COLLECTION_PACK_HEADER_SIZE,
+        .pos = 0,
+        .ok  = true
+    };
+
+    if (0 != memcmp(buf, COLLECTION_PACK_MAGIC, COLLECTION_PACK_MAGIC_SIZE)) {
+        errmsg("Error loading " COLLECTION_FILENAME_EXT " \"%s\": not an indexed pack", filename);
+        return false;
+    }
+    r.pos += COLLECTION_PACK_MAGIC_SIZE;
+
+    uint8_t version = binary_get_u8(&r);
+    r.pos += 3;
+    header->level_count = binary_get_u32(&r);
+    header->index_size  = binary_get_u32(&r);
+
+    if (version != COLLECTION_PACK_VERSION) {
+        errmsg("Error loading " COLLECTION_FILENAME_EXT " \"%s\": version is %d, expected %d",
+               filename, version, COLLECTION_PACK_VERSION);
+        return false;
+    }
+
+    return true;
+}
+
+/* creates a stub level for every index entry */
+static collection_t *parse_index(const char *filename, struct pack_header *header,
+                                 const unsigned char *index, size_t pack_size)
+{
+    size_t data_start = COLLECTION_PACK_HEADER_SIZE + (size_t)header->index_size;
+
+    binary_reader_t r = {
+        .buf = index,
+        .len = header->index_size,
+        .pos = 0,
+        .ok  = true
+    };
+
+    collection_t *collection = create_collection();
+    collection->filename = strdup(filename);
+    collection->is_pack = true;
+
+    binary_get_str(&r, collection->unique_id, UNIQUE_ID_LENGTH);
+    binary_get_str(&r, collection->id, COLLECTION_ID_LENGTH);
+
+    for (uint32_t i=0; r.ok && (i < header->level_count); i++) {
+        uint32_t offset = binary_get_u32(&r);
+        uint32_t size   = binary_get_u32(&r);
+        char *level_filename = binary_get_strdup(&r);
+        if (NULL == level_filename) {
+            break;
+        }
+
+        level_t *level = create_level_stub(level_filename, LEVEL_SOURCE_PACK_FILE);
+        free(level_filename);
+
+        binary_get_str(&r, level->name, NAME_MAXLEN);
+        binary_get_str(&r, level->unique_id, UNIQUE_ID_LENGTH);
+
+        if ((data_start + offset + size) > pack_size) {
+            errmsg("Error loading " COLLECTION_FILENAME_EXT " \"%s\": level \"%s\" is outside the pack",
+                   filename, level->name);
+            r.ok = false;
+        }
+
+        level->pack_offset = data_start + offset;
+        level->pack_size   = size;
+
+        collection_add_level(collection, level);
+    }
+
+    if (!r.ok) {
+        errmsg("Error loading " COLLECTION_FILENAME_EXT " \"%s\": corrupt index", filename);
+        destroy_collection(collection);
+        return NULL;
+    }
+
+    return collection;
+}
+
+static bool decode_level(level_t *level, const unsigned char *compressed, const char *source)
+{
+    bool rv = false;
+    cJSON *json = NULL;
+
+    int level_str_size = 0;
+    unsigned char *level_str_data = DecompressData(compressed, level->pack_size, &level_str_size);
+    char *level_str = (char *)level_str_data;
+
+    if ((NULL == level_str) || (level_str_size != ((int)strnlen(level_str, level_str_size) + 1))) {
+        errmsg("Error decompressing level \"%s\" in \"%s\"", level->name, source);
+        goto cleanup;
+    }
+
+    if (level_read_json(level, level_str)) {
+        rv = true;
+        goto cleanup;
+    }
+
+    json = cJSON_Parse(level_str);
+    if (NULL == json) {
+        errmsg("Error parsing level \"%s\" in \"%s\" as JSON", level->name, source);
+        goto cleanup;
+    }
+
+    rv = level_from_json(level, json);
+
+  cleanup:
+    if (json) {
+        cJSON_Delete(json);
+    }
+    if (level_str_data) {
+        MemFree(level_str_data);
+    }
+
+    return rv;
+}
+
+bool collection_pack_data_is_indexed(const unsigned char *data, int size)
+{
+    return (size >= COLLECTION_PACK_HEADER_SIZE)
+        && (0 == memcmp(data, COLLECTION_PACK_MAGIC, COLLECTION_PACK_MAGIC_SIZE));
+}
+
+collection_t *load_collection_pack_index_data(const char *name, const unsigned char *data, int size)
+{
+    assert_not_null(name);
+    assert_not_null(data);
+
+    struct pack_header header;
+    if ((size < COLLECTION_PACK_HEADER_SIZE) || !parse_header(name, data, &header)) {
+        return NULL;
+    }
+
+    if ((COLLECTION_PACK_HEADER_SIZE + (size_t)header.index_size) > (size_t)size) {
+        errmsg("Error loading " COLLECTION_FILENAME_EXT " \"%s\": truncated index", name);
+        return NULL;
+    }
+
+    collection_t *collection = parse_index(name, &header, data + COLLECTION_PACK_HEADER_SIZE, size);
+    if (NULL == collection) {
+        return NULL;
+    }
+
+    /* there is no file to come back to later, so keep a copy of each
+     * level's compressed data instead */
+    for (level_t *level = collection->levels; level; level = level->next) {
+        level->pack_data = MemAlloc(MAX(level->pack_size, 1));
+        memcpy(level->pack_data, data + level->pack_offset, level->pack_size);
+        level->pack_offset = 0;
+        level->source = LEVEL_SOURCE_PACK_DATA;
+    }
+
+    collection_update_level_names(collection);
+
+    return collection;
+}
+
+collection_t *load_collection_pack_index(const char *filename)
+{
+    assert_not_null(filename);
+
+    collection_t *collection = NULL;
+    unsigned char *index = NULL;
+
+    FILE *f = fopen(filename, "rb");
+    if (NULL == f) {
+        errmsg("Could not open \"%s\": %s", filename, strerror(errno));
+        return NULL;
+    }
+
+    unsigned char header_buf[COLLECTION_PACK_HEADER_SIZE];
+    if (!read_exact(f, header_buf, COLLECTION_PACK_HEADER_SIZE)) {
+        errmsg("Error loading " COLLECTION_FILENAME_EXT " \"%s\": truncated header", filename);
+        goto cleanup;
+    }
+
+    struct pack_header header;
+    if (!parse_header(filename, header_buf, &header)) {
+        goto cleanup;
+    }
+
+    if (-1 == fseek(f, 0, SEEK_END)) {
+        errmsg("Error seeking in \"%s\": %s", filename, strerror(errno));
+        goto cleanup;
+    }
+    long file_size = ftell(f);
+
+    if ((COLLECTION_PACK_HEADER_SIZE + (long)header.index_size) > file_size) {
+        errmsg("Error loading " COLLECTION_FILENAME_EXT " \"%s\": truncated index", filename);
+        goto cleanup;
+    }
+
+    index = malloc(MAX(header.index_size, 1));
+    if ((-1 == fseek(f, COLLECTION_PACK_HEADER_SIZE, SEEK_SET)) || !read_exact(f, index, header.index_size)) {
+        errmsg("Error reading the index of \"%s\"", filename);
+        goto cleanup;
+    }
+
+    collection = parse_index(filename, &header, index, file_size);
+    if (NULL == collection) {
+        goto cleanup;
+    }
+
+    collection->loaded_from_file = true;
+    collection->loadpath = strdup(filename);
+
+    collection_update_level_names(collection);
+
+    if (options->verbose) {
+        infomsg("Loaded the index of %d levels from \"%s\"", collection->level_count, filename);
+    }
+
+  cleanup:
+    SAFEFREE(index);
+    fclose(f);
+
+    return collection;
+}
+
+bool collection_pack_load_level(level_t *level)
+{
+    assert_not_null(level);
+
+    /* also level file stubs created from a dir_cache */
+    if (level->pack_data) {
+        return decode_level(level, level->pack_data, level->filename);
+    }
+
+    collection_t *collection = level->collection;
+    if ((level->source != LEVEL_SOURCE_PACK_FILE) || !collection || !collection->loadpath) {
+        errmsg("Cannot load level \"%s\": it is not in a pack file", level->name);
+        return false;
+    }
+
+    unsigned char *compressed = read_file_range(collection->loadpath, level->pack_offset, level->pack_size);
+    if (NULL == compressed) {
+        return false;
+    }
+
+    bool rv = decode_level(level, compressed, collection->loadpath);
+    MemFree(compressed);
+
+    return rv;
+}
+
+/*** saving ***/
+
+struct pack_blob {
+    unsigned char *data;
+    int size;
+};
+
+/* levels that were never decoded are copied from the source pack as-is */
+static bool level_pack_blob(level_t *level, struct pack_blob *blob)
+{
+    if (level->stub && (level->source == LEVEL_SOURCE_PACK_DATA)) {
+        blob->data = MemAlloc(MAX(level->pack_size, 1));
+        memcpy(blob->data, level->pack_data, level->pack_size);
+        blob->size = level->pack_size;
+        return true;
+    }
+
+    if (level->stub && (level->source == LEVEL_SOURCE_PACK_FILE)) {
+        blob->data = read_file_range(level->collection->loadpath, level->pack_offset, level->pack_size);
+        blob->size = level->pack_size;
+        return blob->data != NULL;
+    }
+
+    cJSON *json = level_to_json(level);
+    if (NULL == json) {
+        return false;
+    }
+
+    char *json_str = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (NULL == json_str) {
+        return false;
+    }
+
+    blob->data = CompressData((const unsigned char *)json_str, strlen(json_str) + 1, &blob->size);
+    free(json_str);
+
+    return blob->data != NULL;
+}
+
+bool collection_pack_save(collection_t *collection, const char *filename)
+{
+    assert_not_null(collection);
+    assert_not_null(filename);
+
+    bool rv = false;
+    binary_writer_t index = {0};
+    binary_writer_t file = {0};
+
+    int count = collection->level_count;
+    struct pack_blob *blobs = calloc(MAX(count, 1), sizeof(struct pack_blob));
+    uint32_t *offsets = calloc(MAX(count, 1), sizeof(uint32_t));
+
+    if (options->verbose) {
+        infomsg("Writing level collection to \"%s\"", filename);
+    }
+
+    binary_put_str(&index, collection->unique_id);
+    binary_put_str(&index, collection->id);
+
+    uint32_t offset = 0;
+    int i = 0;
+    level_t *level = collection->levels;
+    for (; level && (i < count); level = level->next, i++) {
+        assert_not_null(level->filename);
+
+        if (!level_pack_blob(level, &blobs[i])) {
+            errmsg("Error encoding level \"%s\" for \"%s\"", level->name, filename);
+            goto cleanup;
+        }
+
+        offsets[i] = offset;
+        offset += blobs[i].size;
+
+        binary_put_u32(&index, offsets[i]);
+        binary_put_u32(&index, blobs[i].size);
+        binary_put_str(&index, level->filename);
+        binary_put_str(&index, level->name);
+        binary_put_str(&index, level->unique_id);
+    }
+
+    binary_writer_reserve(&file, COLLECTION_PACK_HEADER_SIZE + index.len + offset);
+    memcpy(file.buf, COLLECTION_PACK_MAGIC, COLLECTION_PACK_MAGIC_SIZE);
+    file.len = COLLECTION_PACK_MAGIC_SIZE;
+    binary_put_u8(&file, COLLECTION_PACK_VERSION);
+    binary_put_u8(&file, 0);
+    binary_put_u8(&file, 0);
+    binary_put_u8(&file, 0);
+    binary_put_u32(&file, i);
+    binary_put_u32(&file, index.len);
+    assert(file.len == COLLECTION_PACK_HEADER_SIZE);
+
+    memcpy(&file.buf[file.len], index.buf, index.len);
+    file.len += index.len;
+
+    for (int j=0; j < i; j++) {
+        memcpy(&file.buf[file.len], blobs[j].data, blobs[j].size);
+        file.len += blobs[j].size;
+    }
+
+    /*
+     * Written synchronously: the levels below are repointed into the
+     * new file, which must not happen unless the write succeeded.
+     */
+    save_queue_wait_for_path(filename);
+    rv = write_file_atomic(filename, file.buf, file.len);
+
+    if (!rv) {
+        goto cleanup;
+    }
+
+    /* a pack's levels can now be reloaded from their place in the new file */
+    if (collection->is_pack) {
+        uint32_t data_start = COLLECTION_PACK_HEADER_SIZE + index.len;
+        i = 0;
+        for (level = collection->levels; level && (i < count); level = level->next, i++) {
+            if (level->pack_data) {
+                MemFree(level->pack_data);
+                level->pack_data = NULL;
+            }
+            level->source      = LEVEL_SOURCE_PACK_FILE;
+            level->pack_offset = data_start + offsets[i];
+            level->pack_size   = blobs[i].size;
+        }
+
+        if (!collection->loadpath || strcmp(collection->loadpath, filename)) {
+            SAFEFREE(collection->loadpath);
+            collection->loadpath = strdup(filename);
+        }
+    }
+
+  cleanup:
+    for (int j=0; j < count; j++) {
+        if (blobs[j].data) {
+            MemFree(blobs[j].data);
+        }
+    }
+    SAFEFREE(blobs);
+    SAFEFREE(offsets);
+    SAFEFREE(index.buf);
+    SAFEFREE(file.buf);
+
+    return rv;
+}
@@ -0,0 +1,53 @@
+/****************************************************************************
+ *                                                                          *
+ * collection_pack.h                                                        *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef COLLECTION_PACK_H
+#define COLLECTION_PACK_H
+
+#include "collection.h"
+
+/*
+ * Indexed level pack format. The file starts with a small header and
+ * an index of every level (name, unique_id, filename, and the byte
+ * range of its data), followed by each level's JSON compressed
+ * separately. Opening a pack only reads the index; each level is a
+ * stub until it is first previewed, played, edited, or saved (see
+ * level_materialize()).
+ *
+ * Packs written before this format are a single compressed JSON
+ * object, and are still loaded by collection.c. Packs that are not
+ * read from a file (such as the built-in classics) keep each level's
+ * compressed data in memory instead of a byte range.
+ */
+
+#define COLLECTION_PACK_MAGIC      "HXPK"
+#define COLLECTION_PACK_MAGIC_SIZE 4
+#define COLLECTION_PACK_VERSION    2
+
+bool collection_pack_file_is_indexed(const char *filename);
+bool collection_pack_data_is_indexed(const unsigned char *data, int size);
+collection_t *load_collection_pack_index(const char *filename);
+collection_t *load_collection_pack_index_data(const char *name, const unsigned char *data, int size);
+bool collection_pack_load_level(level_t *level);
+bool collection_pack_save(collection_t *collection, const char *filename);
+
+#endif /*COLLECTION_PACK_H*/
+
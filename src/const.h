@@ -26,6 +26,7 @@
 
 #define COLLECTION_FILENAME_EXT "hexlevelpack"
 #define LEVEL_FILENAME_EXT      "hexlevel"
+#define UNDO_LOG_FILENAME_EXT   "undolog"
 
 #define PROJECT_STATE_JSON_NAMESPACE              PACKAGE_NAME "/state"
 #define PROJECT_FINISHED_LEVEL_LOG_JSON_NAMESPACE PACKAGE_NAME "/finished_levels"
@@ -45,7 +46,19 @@
 #define LEVEL_DEFAULT_RADIUS LEVEL_MIN_RADIUS
 
 #define LEVEL_MIN_RADIUS 1
-#define LEVEL_MAX_RADIUS 4
+#define LEVEL_MAX_RADIUS 12
+
+/*
+ * Every level has a grid of tile slots at least this large. Levels
+ * that fit keep the original 9x9 slot layout, so their files, slot
+ * indices and random generator sequences are unchanged; larger
+ * levels get a grid matching their radius.
+ */
+#define LEVEL_DEFAULT_GRID_RADIUS 4
+
+/* collection levels that can be reloaded from their source are
+ * decoded on first use; at most this many are kept decoded */
+#define LEVEL_MATERIALIZED_MAX 32
 #define LEVEL_MIN_FIXED 0
 #define LEVEL_MAX_FIXED 9
 #define LEVEL_MIN_HIDDEN 0
@@ -59,19 +72,6 @@
 
 #define TILE_RESET_TIME 0.35
 
-#define TILE_LEVEL_WIDTH  ((2 * LEVEL_MAX_RADIUS) + 1)
-#define TILE_LEVEL_HEIGHT TILE_LEVEL_WIDTH
-
-#define LEVEL_MAXTILES (TILE_LEVEL_HEIGHT * TILE_LEVEL_WIDTH)
-
-#define LEVEL_CENTER_POSITION  \
-    ((hex_axial_t){            \
-        .q = LEVEL_MAX_RADIUS, \
-        .r = LEVEL_MAX_RADIUS  \
-     })
-
-#define MAX_PATH_DENSITY_ITER LEVEL_MAXTILES
-
 #define LEVEL_FADE_TRANSITION_LENGTH 0.7
 #define LEVEL_FADE_TRANSITION_FRAMES (LEVEL_FADE_TRANSITION_LENGTH * options->max_fps)
 #define LEVEL_FADE_DELTA (1.0 / (LEVEL_FADE_TRANSITION_FRAMES))
@@ -163,9 +163,14 @@
 #define CREATE_DIR_MODE (S_IRWXU | S_IRWXG | (S_IROTH | S_IXOTH))
 
 #define NVDATA_STATE_FILE_NAME "state.json"
-#define NVDATA_FINISHED_LEVEL_FILE_NAME "finished_levels.dat"
+#define NVDATA_FINISHED_LEVEL_FILE_NAME "finished_levels.bin"
+#define NVDATA_FINISHED_LEVEL_JSON_FILE_NAME "finished_levels.dat"
+#define NVDATA_FINISHED_LEVEL_JOURNAL_FILE_NAME "finished_levels.journal"
 #define NVDATA_DEFAULT_BROWSE_PATH_NAME "levels"
+#define NVDATA_DIR_CACHE_DIR_NAME "dircache"
+#define DIR_CACHE_FILENAME_EXT "dircache"
 #define NVDATA_SAVED_CURRENT_LEVEL_FILE_NAME_PREFIX "level_in_progress"
+#define NVDATA_CURRENT_UNDO_LOG_FILE_NAME "current." UNDO_LOG_FILENAME_EXT
 
 #ifndef MAX_FILEPATH_LENGTH
     #if defined(_WIN32)
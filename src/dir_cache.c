@@ -0,0 +1,423 @@
+/****************************************************************************
+ *                                                                          *
+ * dir_cache.c                                                              *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <sys/stat.h>
+
+#include "options.h"
+#include "binary_io.h"
+#include "save_queue.h"
+#include "nvdata.h"
+#include "level.h"
+#include "dir_cache.h"
+
+/* magic, u8 version, 3 reserved bytes, u32 entry_count */
+#define DIR_CACHE_HEADER_SIZE 12
+
+/* FNV-1a */
+uint64_t dir_cache_hash(const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool dir_cache_stat(const char *path, uint64_t *size, int64_t *mtime)
+{
+    struct stat st;
+    if (-1 == stat(path, &st)) {
+        return false;
+    }
+
+    *size  = st.st_size;
+    *mtime = ((int64_t)st.st_mtim.tv_sec * 1000000000LL) + st.st_mtim.tv_nsec;
+    return true;
+}
+
+/*** entries ***/
+
+static void free_dir_cache_entry(dir_cache_entry_t *entry)
+{
+    SAFEFREE(entry->filename);
+    SAFEFREE(entry->data);
+}
+
+static dir_cache_entry_t *dir_cache_append(dir_cache_entry_t **entries, int *count, int *alloc_count)
+{
+    if (*count >= *alloc_count) {
+        *alloc_count = *alloc_count ? (2 * *alloc_count) : 64;
+        *entries = realloc(*entries, *alloc_count * sizeof(dir_cache_entry_t));
+    }
+
+    dir_cache_entry_t *entry = &(*entries)[(*count)++];
+    memset(entry, 0, sizeof(dir_cache_entry_t));
+    return entry;
+}
+
+static int compare_dir_cache_entries(const void *p1, const void *p2)
+{
+    const dir_cache_entry_t *e1 = p1;
+    const dir_cache_entry_t *e2 = p2;
+    return strcmp(e1->filename, e2->filename);
+}
+
+/* one sort for every entry added since the last merge */
+static void dir_cache_merge_added(dir_cache_t *cache)
+{
+    if (!cache->added_count) {
+        return;
+    }
+
+    int count = cache->count + cache->added_count;
+    if (count > cache->alloc_count) {
+        cache->alloc_count = count;
+        cache->entries = realloc(cache->entries, cache->alloc_count * sizeof(dir_cache_entry_t));
+    }
+
+    memcpy(&cache->entries[cache->count], cache->added, cache->added_count * sizeof(dir_cache_entry_t));
+    cache->count = count;
+    cache->added_count = 0;
+
+    qsort(cache->entries, cache->count, sizeof(dir_cache_entry_t), compare_dir_cache_entries);
+}
+
+dir_cache_entry_t *dir_cache_find(dir_cache_t *cache, const char *filename)
+{
+    assert_not_null(cache);
+    assert_not_null(filename);
+
+    dir_cache_merge_added(cache);
+
+    dir_cache_entry_t key = { .filename = (char *)filename };
+    dir_cache_entry_t *entry = bsearch(&key, cache->entries, cache->count,
+                                       sizeof(dir_cache_entry_t), compare_dir_cache_entries);
+    if (entry) {
+        entry->seen = true;
+    }
+    return entry;
+}
+
+void dir_cache_update(dir_cache_t *cache, dir_cache_entry_t *entry, const char *filename, level_file_header_t *header)
+{
+    assert_not_null(cache);
+    assert_not_null(filename);
+    assert_not_null(header);
+
+    if (!header->read_ok || !header->have_header) {
+        return;
+    }
+
+    if (entry &&
+        (entry->size  == header->file_size) &&
+        (entry->mtime == header->file_mtime) &&
+        (entry->hash  == header->hash)) {
+        return;
+    }
+
+    if (!header->data) {
+        /* nothing to preview from; read the file again next time */
+        return;
+    }
+
+    if (entry) {
+        SAFEFREE(entry->data);
+    } else {
+        /* appending to entries could move the ones callers hold */
+        entry = dir_cache_append(&cache->added, &cache->added_count, &cache->added_alloc_count);
+        entry->filename = strdup(filename);
+        entry->seen = true;
+    }
+
+    entry->size  = header->file_size;
+    entry->mtime = header->file_mtime;
+    entry->hash  = header->hash;
+    copy_name(entry->name, header->name);
+    memcpy(entry->unique_id, header->unique_id, UNIQUE_ID_LENGTH);
+    entry->radius = header->radius;
+
+    entry->data = malloc(MAX(header->data_size, 1));
+    memcpy(entry->data, header->data, header->data_size);
+    entry->data_size = header->data_size;
+
+    cache->changed = true;
+}
+
+/* safe to call from a worker thread */
+static void fill_header_from_entry(dir_cache_entry_t *entry, level_file_header_t *header)
+{
+    header->read_ok     = true;
+    header->have_header = true;
+    header->from_cache  = true;
+    header->hash        = entry->hash;
+    header->radius      = entry->radius;
+    copy_name(header->name, entry->name);
+    memcpy(header->unique_id, entry->unique_id, UNIQUE_ID_LENGTH);
+
+    header->data = MemAlloc(MAX(entry->data_size, 1));
+    memcpy(header->data, entry->data, entry->data_size);
+    header->data_size = entry->data_size;
+}
+
+/*
+ * Fills in header from entry if the file is unchanged, or reads and
+ * parses the file if it isn't. Only reads entry; safe to call from a
+ * worker thread.
+ */
+void dir_cache_read_level_file(dir_cache_entry_t *entry, const char *path, level_file_header_t *header)
+{
+    assert_not_null(path);
+    assert_not_null(header);
+
+    save_queue_wait_for_path(path);
+
+    if (!dir_cache_stat(path, &header->file_size, &header->file_mtime)) {
+        header->read_ok = false;
+        return;
+    }
+
+    if (entry &&
+        (entry->size  == header->file_size) &&
+        (entry->mtime == header->file_mtime)) {
+        fill_header_from_entry(entry, header);
+        return;
+    }
+
+    char *str = LoadFileText(path);
+    if (NULL == str) {
+        header->read_ok = false;
+        return;
+    }
+    header->read_ok = true;
+    header->hash = dir_cache_hash(str, strlen(str));
+
+    if (entry && (entry->hash == header->hash)) {
+        /* touched, but not changed */
+        fill_header_from_entry(entry, header);
+    } else {
+        parse_level_file_header(str, header, true);
+    }
+
+    UnloadFileText(str);
+}
+
+/*** loading and saving ***/
+
+static char *dir_cache_path_for(const char *dirpath)
+{
+    char *path = NULL;
+    safe_asprintf(&path, "%s/%016llx." DIR_CACHE_FILENAME_EXT,
+                  nvdata_dir_cache_path,
+                  (unsigned long long)dir_cache_hash(dirpath, strlen(dirpath)));
+    return path;
+}
+
+static bool parse_dir_cache(dir_cache_t *cache, const unsigned char *buf, size_t size)
+{
+    binary_reader_t r = {
+        .buf = buf,
+        .len = size,
+        .pos = 0,
+        .ok  = true
+    };
+
+    if ((size < DIR_CACHE_HEADER_SIZE) ||
+        (0 != memcmp(buf, DIR_CACHE_MAGIC, DIR_CACHE_MAGIC_SIZE))) {
+        warnmsg("Ignoring directory cache \"%s\": bad header", cache->path);
+        return false;
+    }
+    r.pos += DIR_CACHE_MAGIC_SIZE;
+
+    uint8_t version = binary_get_u8(&r);
+    r.pos += 3;
+    uint32_t count = binary_get_u32(&r);
+
+    if (version != DIR_CACHE_VERSION) {
+        if (options->verbose) {
+            infomsg("Ignoring directory cache \"%s\": version is %d, expected %d",
+                    cache->path, version, DIR_CACHE_VERSION);
+        }
+        return false;
+    }
+
+    char *dirpath = binary_get_strdup(&r);
+    bool same_dir = dirpath && (0 == strcmp(dirpath, cache->dirpath));
+    SAFEFREE(dirpath);
+    if (!same_dir) {
+        /* a hash collision with another directory */
+        return false;
+    }
+
+    for (uint32_t i = 0; r.ok && (i < count); i++) {
+        char *filename = binary_get_strdup(&r);
+        if (NULL == filename) {
+            break;
+        }
+
+        dir_cache_entry_t *entry = dir_cache_append(&cache->entries, &cache->count, &cache->alloc_count);
+        entry->filename = filename;
+        entry->size     = binary_get_u64(&r);
+        entry->mtime    = (int64_t)binary_get_u64(&r);
+        entry->hash     = binary_get_u64(&r);
+        binary_get_str(&r, entry->name, NAME_MAXLEN);
+        binary_get_str(&r, entry->unique_id, UNIQUE_ID_LENGTH);
+        entry->radius    = binary_get_u8(&r);
+        entry->data_size = binary_get_u32(&r);
+
+        const unsigned char *data = binary_get_bytes(&r, entry->data_size);
+        if (data) {
+            entry->data = malloc(MAX(entry->data_size, 1));
+            memcpy(entry->data, data, entry->data_size);
+        }
+    }
+
+    if (!r.ok) {
+        warnmsg("Ignoring directory cache \"%s\": truncated", cache->path);
+        return false;
+    }
+
+    /* the file is written in sorted order */
+    return true;
+}
+
+static void dir_cache_clear(dir_cache_t *cache)
+{
+    for (int i = 0; i < cache->count; i++) {
+        free_dir_cache_entry(&cache->entries[i]);
+    }
+    cache->count = 0;
+
+    for (int i = 0; i < cache->added_count; i++) {
+        free_dir_cache_entry(&cache->added[i]);
+    }
+    cache->added_count = 0;
+}
+
+dir_cache_t *load_dir_cache(const char *dirpath)
+{
+    assert_not_null(dirpath);
+
+    if (!nvdata_dir_cache_path || options->safe_mode) {
+        return NULL;
+    }
+
+    dir_cache_t *cache = calloc(1, sizeof(dir_cache_t));
+    cache->dirpath = realpath(dirpath, NULL);
+    if (!cache->dirpath) {
+        cache->dirpath = strdup(dirpath);
+    }
+    cache->path = dir_cache_path_for(cache->dirpath);
+
+    save_queue_wait_for_path(cache->path);
+
+    if (FileExists(cache->path)) {
+        int size = 0;
+        unsigned char *data = LoadFileData(cache->path, &size);
+        if (data) {
+            if (!parse_dir_cache(cache, data, size)) {
+                dir_cache_clear(cache);
+                cache->changed = true;
+            }
+            UnloadFileData(data);
+        }
+
+        if (options->verbose) {
+            infomsg("Loaded directory cache \"%s\" (%d entries)", cache->path, cache->count);
+        }
+    }
+
+    return cache;
+}
+
+void destroy_dir_cache(dir_cache_t *cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    dir_cache_clear(cache);
+    SAFEFREE(cache->entries);
+    SAFEFREE(cache->added);
+    SAFEFREE(cache->dirpath);
+    SAFEFREE(cache->path);
+    SAFEFREE(cache);
+}
+
+/* writes the cache if anything changed, dropping files that are gone */
+void dir_cache_save(dir_cache_t *cache)
+{
+    assert_not_null(cache);
+
+    dir_cache_merge_added(cache);
+
+    int kept = 0;
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].seen) {
+            cache->entries[kept++] = cache->entries[i];
+        } else {
+            free_dir_cache_entry(&cache->entries[i]);
+            cache->changed = true;
+        }
+    }
+    cache->count = kept;
+
+    if (!cache->changed) {
+        return;
+    }
+
+    binary_writer_t w = {0};
+    binary_writer_reserve(&w, DIR_CACHE_HEADER_SIZE);
+    memcpy(w.buf, DIR_CACHE_MAGIC, DIR_CACHE_MAGIC_SIZE);
+    w.len = DIR_CACHE_MAGIC_SIZE;
+    binary_put_u8(&w, DIR_CACHE_VERSION);
+    binary_put_u8(&w, 0);
+    binary_put_u8(&w, 0);
+    binary_put_u8(&w, 0);
+    binary_put_u32(&w, cache->count);
+    assert(w.len == DIR_CACHE_HEADER_SIZE);
+
+    binary_put_str(&w, cache->dirpath);
+
+    for (int i = 0; i < cache->count; i++) {
+        dir_cache_entry_t *entry = &cache->entries[i];
+        binary_put_str(&w, entry->filename);
+        binary_put_u64(&w, entry->size);
+        binary_put_u64(&w, (uint64_t)entry->mtime);
+        binary_put_u64(&w, entry->hash);
+        binary_put_str(&w, entry->name);
+        binary_put_str(&w, entry->unique_id);
+        binary_put_u8(&w, entry->radius);
+        binary_put_u32(&w, entry->data_size);
+        binary_put_bytes(&w, entry->data, entry->data_size);
+    }
+
+    if (options->verbose) {
+        infomsg("Writing directory cache \"%s\" (%d entries)", cache->path, cache->count);
+    }
+
+    /* the save queue owns the buffer now */
+    save_queue_submit(cache->path, w.buf, w.len, NULL, NULL);
+    cache->changed = false;
+}
@@ -0,0 +1,96 @@
+/****************************************************************************
+ *                                                                          *
+ * dir_cache.h                                                              *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef DIR_CACHE_H
+#define DIR_CACHE_H
+
+#include "level.h"
+
+/*
+ * Cache of the level file metadata in a collection directory, so
+ * reopening a directory doesn't have to read and parse every file
+ * again. Each directory's cache is stored in the config dir as
+ * "dircache/<hash of the directory path>.dircache".
+ *
+ * An entry is used as long as its file's size and mtime are
+ * unchanged. A file that was only touched is still read, but if its
+ * content hash matches it isn't parsed again. Each entry also keeps
+ * the level's compressed JSON, so stubs created from the cache can
+ * be previewed without reading the file (see level_materialize()).
+ */
+
+#define DIR_CACHE_MAGIC      "HXDC"
+#define DIR_CACHE_MAGIC_SIZE 4
+#define DIR_CACHE_VERSION    1
+
+struct dir_cache_entry {
+    char *filename;     /* relative to the directory */
+    uint64_t size;
+    int64_t mtime;      /* nanoseconds */
+    uint64_t hash;
+
+    name_str_t name;
+    unique_id_t unique_id;
+    int radius;
+
+    /* the level's JSON compressed with CompressData() */
+    unsigned char *data;
+    uint32_t data_size;
+
+    bool seen;
+};
+typedef struct dir_cache_entry dir_cache_entry_t;
+
+struct dir_cache {
+    char *dirpath;
+    char *path;
+
+    /* sorted by filename */
+    dir_cache_entry_t *entries;
+    int count;
+    int alloc_count;
+
+    /* new entries from dir_cache_update(), sorted into entries
+     * all at once by the next dir_cache_find() or dir_cache_save() */
+    dir_cache_entry_t *added;
+    int added_count;
+    int added_alloc_count;
+
+    bool changed;
+};
+typedef struct dir_cache dir_cache_t;
+
+uint64_t dir_cache_hash(const void *data, size_t size);
+bool dir_cache_stat(const char *path, uint64_t *size, int64_t *mtime);
+
+dir_cache_t *load_dir_cache(const char *dirpath);
+void destroy_dir_cache(dir_cache_t *cache);
+void dir_cache_save(dir_cache_t *cache);
+
+/* entries returned by dir_cache_find() stay valid until the next
+ * dir_cache_find() or dir_cache_save() */
+dir_cache_entry_t *dir_cache_find(dir_cache_t *cache, const char *filename);
+/* entry is what dir_cache_find() returned for filename, or NULL */
+void dir_cache_update(dir_cache_t *cache, dir_cache_entry_t *entry, const char *filename, level_file_header_t *header);
+
+void dir_cache_read_level_file(dir_cache_entry_t *entry, const char *path, level_file_header_t *header);
+
+#endif /*DIR_CACHE_H*/
@@ -22,6 +22,7 @@
 #include "common.h"
 #include "options.h"
 #include "level.h"
+#include "hex_grid.h"
 #include "collection.h"
 #include "generate_level.h"
 #include "blueprint_string.h"
@@ -339,8 +340,9 @@ static tile_pos_t *find_random_empty_tile(level_t *level, tile_t *not_this_tile,
     assert_not_null(level);
 
     //printf("Finding blank tile\n");
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
-        int idx = (i + rng_get(LEVEL_MAXTILES)) % LEVEL_MAXTILES;
+    int maxtiles = level->grid->maxtiles;
+    for (int i=0; i<maxtiles; i++) {
+        int idx = (i + rng_get(maxtiles)) % maxtiles;
         tile_t *tile = &(level->tiles[idx]);
 
         //printf("i=%d idx=%d tile=%p ", i, idx, tile);
@@ -405,8 +407,9 @@ static tile_pos_t *find_nearest_matching_color_tile(level_t *level, tile_pos_t *
     tile_pos_t *closest = NULL;
     int closest_distance = INT_MAX;
 
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
-        int idx = (i + rng_get(LEVEL_MAXTILES)) % LEVEL_MAXTILES;
+    int maxtiles = level->grid->maxtiles;
+    for (int i=0; i<maxtiles; i++) {
+        int idx = (i + rng_get(maxtiles)) % maxtiles;
         tile_t *test_tile = &(level->tiles[idx]);
 
         if (!test_tile->enabled || test_tile->hidden) {
@@ -558,7 +561,7 @@ static void generate_connect_to_point(level_t *level)
         }
     }
 
-    for (int i=0; i<MAX_PATH_DENSITY_ITER; i++) {
+    for (int i=0; i<level->grid->maxtiles; i++) {
         long path_density = level_average_paths_per_tile(level);
         if (path_density >= gen_param.path_density) {
             break;
@@ -648,23 +651,24 @@ static void mark_tile_hidden(tile_t *tile)
     }
 }
 
+static tile_t *symmetric_tile(level_t *level, tile_t *tile, hex_grid_idx_t *mirror)
+{
+    int idx = mirror[level_axial_to_idx(level, tile->solved_pos->position)];
+    assert(idx != HEX_GRID_OFF_BOARD);
+    return level->solved_positions[idx].tile;
+}
+
 static void mark_symmetric_fixed_and_hidden(level_t *level)
 {
     level_use_solved_tile_pos(level);
 
-    hex_axial_t center_pos = level_get_center_tile_pos(level)->position;
     bool reflect = options->create_level_symmetry_mode == SYMMETRY_MODE_REFLECT;
+    hex_grid_idx_t *mirror = reflect ? level->grid->reflect_horiz : level->grid->rotate;
 
     for (int i=0; i<gen_param.fixed_count; i++) {
         tile_t *tile = rng_get_tile(level);
         tile->fixed = true;
-        hex_axial_t rpos;
-        if (reflect) {
-            rpos = hex_axial_reflect_horiz(tile->solved_pos->position, center_pos);
-        } else {
-            rpos = hex_axial_rotate(tile->solved_pos->position, center_pos);
-        }
-        tile_t *refl = level_get_solved_tile(level, rpos);
+        tile_t *refl = symmetric_tile(level, tile, mirror);
         refl->fixed = true;
     }
 
@@ -672,13 +676,7 @@ static void mark_symmetric_fixed_and_hidden(level_t *level)
         tile_t *tile = rng_get_tile(level);
         mark_tile_hidden(tile);
 
-        hex_axial_t rpos;
-        if (reflect) {
-            rpos = hex_axial_reflect_horiz(tile->solved_pos->position, center_pos);
-        } else {
-            rpos = hex_axial_rotate(tile->solved_pos->position, center_pos);
-        }
-        tile_t *refl = level_get_solved_tile(level, rpos);
+        tile_t *refl = symmetric_tile(level, tile, mirror);
         mark_tile_hidden(refl);
     }
 }
@@ -809,7 +807,7 @@ struct level *generate_random_title_level(void)
     generate_level_param_t param = {
         .mode = GENERATE_LEVEL_RANDOM,
         .seed = rand(),
-        .tile_radius = LEVEL_MAX_RADIUS,
+        .tile_radius = LEVEL_DEFAULT_GRID_RADIUS,
         .color = { 0, true, true, true, true },
         .color_count = 4,
         .fixed  = { 0, 0 },
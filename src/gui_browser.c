@@ -30,6 +30,16 @@
 #include "nvdata.h"
 #include "nvdata_finished.h"
 #include "fsdir.h"
+#include "thread_pool.h"
+#include "redraw.h"
+
+#include <strings.h>
+
+#if defined(PLATFORM_DESKTOP)
+# include <dirent.h>
+# include <pthread.h>
+# define BROWSE_SCAN_USE_THREADS
+#endif
 
 extern char *home_dir;
 
@@ -223,7 +233,6 @@ gui_list_vars_t classics = {
 extern char *nvdata_default_browse_path;
 
 char *browse_path = NULL;
-FilePathList browse_file_list;
 
 gui_list_vars_t local_files = {
     .names                 = NULL,
@@ -371,8 +380,7 @@ static void free_gui_list_vars_history_data(gui_list_vars_t *list)
 static void free_local_files_data(void)
 {
     free_gui_list_vars_fspath_data(&local_files);
-
-    UnloadDirectoryFiles(browse_file_list);
+    local_files.count = 0;
 }
 
 static void free_history_data(void)
@@ -403,8 +411,8 @@ int compare_fspath_entries(const void *p1, const void *p2)
 static void prepare_gui_list_names(gui_list_vars_t *list)
 {
     assert_not_null(list);
-    assert_not_null(list->entries);
     assert(list->count >= 0);
+    assert((list->count == 0) || list->entries);
 
     SAFEFREE(list->names);
     list->names = calloc(list->count, sizeof(char *));
@@ -415,15 +423,18 @@ static void prepare_gui_list_names(gui_list_vars_t *list)
         if (entry->common.status == ENTRY_STATUS_LOAD_ERROR) {
             icon_name = GuiIconText(ICON_CRACK, entry->name);
         }
+        SAFEFREE(entry->icon_name);
         entry->icon_name = strdup(icon_name);
-        entry->common.index = i;
     }
 
     gui_list_fspath_entry_t *entries = (gui_list_fspath_entry_t *)list->entries;
-    qsort(entries, list->count, sizeof(gui_list_fspath_entry_t), compare_fspath_entries);
+    if (list->count > 1) {
+        qsort(entries, list->count, sizeof(gui_list_fspath_entry_t), compare_fspath_entries);
+    }
 
     for (int i=0; i<list->count; i++) {
         gui_list_fspath_entry_t *entry = get_gui_list_fspath_entry(list, i);
+        entry->common.index = i;
         list->names[i] = entry->icon_name;
     }
 
@@ -462,94 +473,292 @@ static bool should_skip_file(const char *name)
     return false;
 }
 
-void setup_browse_dir(void)
+/*
+ * Directory scans run on the thread pool, which keeps the stat() of
+ * every entry off the UI thread. The scan collects finished entries
+ * in its own array; poll_browse_scan() moves them into local_files
+ * every frame, so the list fills in while the scan is still running.
+ */
+struct browse_scan {
+    char *path;
+
+#if defined(BROWSE_SCAN_USE_THREADS)
+    pthread_mutex_t mutex;
+#endif
+
+    /* protected by mutex */
+    gui_list_fspath_entry_t *found;
+    int found_count;
+    int found_alloc;
+    bool finished;
+    bool abandoned;
+};
+typedef struct browse_scan browse_scan_t;
+
+static browse_scan_t *browse_scan = NULL;
+
+/* without threads thread_pool_run() finishes the scan before returning */
+static inline void browse_scan_lock(browse_scan_t *scan)
 {
-    assert_not_null(browse_path);
+#if defined(BROWSE_SCAN_USE_THREADS)
+    pthread_mutex_lock(&scan->mutex);
+#else
+    (void)scan;
+#endif
+}
 
-    if (!DirectoryExists(browse_path)) {
-        errmsg("Cannot browse \"%s\": not a directory", browse_path);
-        return;
-    }
+static inline void browse_scan_unlock(browse_scan_t *scan)
+{
+#if defined(BROWSE_SCAN_USE_THREADS)
+    pthread_mutex_unlock(&scan->mutex);
+#else
+    (void)scan;
+#endif
+}
 
-    int len = strlen(browse_path);
-    assert(len > 0);
-    int last = len - 1;
-    if ((last > 0) && ((browse_path[last] == '\\') || (browse_path[last] == '/'))) {
-        browse_path[last] = '\0';
+gui_list_fspath_entry_t *find_entry_by_filename(gui_list_vars_t *list, const char *filename);
+
+/* the entry to select once the scan finds it */
+static char *browse_scan_select_name = NULL;
+
+static void destroy_browse_scan(browse_scan_t *scan)
+{
+    for (int i=0; i<scan->found_count; i++) {
+        SAFEFREE(scan->found[i].name);
+        SAFEFREE(scan->found[i].path);
+    }
+    SAFEFREE(scan->found);
+    SAFEFREE(scan->path);
+#if defined(BROWSE_SCAN_USE_THREADS)
+    pthread_mutex_destroy(&scan->mutex);
+#endif
+    SAFEFREE(scan);
+}
+
+static bool scan_browse_entry(const char *path, gui_list_fspath_entry_t *entry)
+{
+    const char *name = GetFileName(path);
+
+    if (should_skip_file(name)) {
+        if (options->verbose) {
+            infomsg("SCAN> %s (SKIP, FLAGGED)", name);
+        }
+        return false;
     }
 
-    if (local_files.names) {
-        free_local_files_data();
+    char *fd;
+    int icon = ICON_NONE;
+    gui_list_entry_type_t type = ENTRY_TYPE_NULL;
+    gui_list_entry_status_t status = ENTRY_STATUS_UNLOADED;
+    if (IsPathFile(path)) {
+        fd = "FILE";
+
+        /* IsFileExtension() uses raylib's shared text buffers */
+        const char *ext = filename_ext(name);
+        if (0 == strcasecmp(ext, COLLECTION_FILENAME_EXT)) {
+            type = ENTRY_TYPE_COLLECTION_FILE;
+            icon = ICON_SUITCASE;
+        } else if (0 == strcasecmp(ext, LEVEL_FILENAME_EXT)) {
+            type = ENTRY_TYPE_LEVEL_FILE;
+            icon = ICON_FILE;
+        } else {
+            if (options->verbose) {
+                infomsg("SCAN> %s (SKIP, UNKNOWN EXT)", name);
+            }
+            return false;
+        }
+    } else {
+        fd = "DIR";
+
+        char index_file[FULL_PATH_MAXLEN];
+        int len = snprintf(index_file, sizeof(index_file), "%s/%s", path, COLLECTION_ZIP_INDEX_FILENAME);
+        if ((len < (int)sizeof(index_file)) && FileExists(index_file)) {
+            type = ENTRY_TYPE_COLLECTION_DIR;
+            icon = ICON_SUITCASE;
+        } else {
+            type = ENTRY_TYPE_DIR;
+            icon = ICON_FOLDER;
+            status = ENTRY_STATUS_NOT_LOADABLE;
+        }
     }
 
     if (options->verbose) {
-        infomsg("Scanning directory: \"%s\"", browse_path);
+        infomsg("SCAN> %s (%s, %s, %s)", name, fd, entry_type_str(type), entry_status_str(status));
     }
 
-    browse_file_list = LoadDirectoryFilesEx(browse_path, NULL, false);
-    local_files.entries = calloc(browse_file_list.count, sizeof(gui_list_fspath_entry_t));
+    memset(entry, 0, sizeof(gui_list_fspath_entry_t));
+    entry->name   = strdup(name);
+    entry->path   = strdup(path);
+    entry->icon   = icon;
+    entry->common.type   = type;
+    entry->common.status = status;
 
-    local_files.count = 0;
-    int icon = ICON_NONE;
-    for (int i=0; i<(int)browse_file_list.count; i++) {
-        gui_list_fspath_entry_t *entry = get_gui_list_fspath_entry(&local_files, local_files.count);
-        assert(entry >= ((gui_list_fspath_entry_t *)(local_files.entries)));
-        assert(entry < ((gui_list_fspath_entry_t *)(local_files.entries)) + sizeof(gui_list_fspath_entry_t));
+    return true;
+}
 
-        char *path = browse_file_list.paths[i];
-        const char *name = GetFileName(path);
+static void browse_scan_job(void *data)
+{
+    browse_scan_t *scan = (browse_scan_t *)data;
 
-        if (should_skip_file(name)) {
-            if (options->verbose) {
-                infomsg("SCAN> %s (SKIP, FLAGGED)", name);
-            }
+    /* not LoadDirectoryFilesEx(): raylib builds each path in a static
+     * buffer that the main thread may be using at the same time */
+    DIR *dir = opendir(scan->path);
+    if (!dir) {
+        errmsg("Cannot scan \"%s\": %s", scan->path, strerror(errno));
+    }
+
+    struct dirent *dirent;
+    while (dir && (dirent = readdir(dir))) {
+        if ((0 == strcmp(dirent->d_name, ".")) || (0 == strcmp(dirent->d_name, ".."))) {
             continue;
         }
 
-        char *fd;
-        gui_list_entry_type_t type = ENTRY_TYPE_NULL;
-        gui_list_entry_status_t status = ENTRY_STATUS_UNLOADED;
-        if (IsPathFile(path)) {
-            fd = "FILE";
-
-            if (IsFileExtension(name, "." COLLECTION_FILENAME_EXT)) {
-                type = ENTRY_TYPE_COLLECTION_FILE;
-                icon = ICON_SUITCASE;
-            } else if (IsFileExtension(name, "." LEVEL_FILENAME_EXT)) {
-                type = ENTRY_TYPE_LEVEL_FILE;
-                icon = ICON_FILE;
-            } else {
-                status = ENTRY_STATUS_NOT_LOADABLE;
-                if (options->verbose) {
-                    infomsg("SCAN> %s (SKIP, UNKNOWN EXT)", name);
+        browse_scan_lock(scan);
+        bool abandoned = scan->abandoned;
+        browse_scan_unlock(scan);
+        if (abandoned) {
+            break;
+        }
+
+        char path[FULL_PATH_MAXLEN];
+        if (snprintf(path, sizeof(path), "%s/%s", scan->path, dirent->d_name) >= (int)sizeof(path)) {
+            continue;
+        }
+
+        gui_list_fspath_entry_t entry;
+        if (!scan_browse_entry(path, &entry)) {
+            continue;
+        }
+
+        browse_scan_lock(scan);
+        if (scan->found_count >= scan->found_alloc) {
+            scan->found_alloc = scan->found_alloc ? (2 * scan->found_alloc) : 64;
+            scan->found = realloc(scan->found, scan->found_alloc * sizeof(gui_list_fspath_entry_t));
+        }
+        scan->found[scan->found_count++] = entry;
+        browse_scan_unlock(scan);
+    }
+
+    if (dir) {
+        closedir(dir);
+    }
+
+    browse_scan_lock(scan);
+    scan->finished = true;
+    bool abandoned = scan->abandoned;
+    browse_scan_unlock(scan);
+
+    /* nobody is going to collect the results */
+    if (abandoned) {
+        destroy_browse_scan(scan);
+    }
+}
+
+static void abandon_browse_scan(void)
+{
+    if (!browse_scan) {
+        return;
+    }
+
+    browse_scan_lock(browse_scan);
+    browse_scan->abandoned = true;
+    bool finished = browse_scan->finished;
+    browse_scan_unlock(browse_scan);
+
+    /* otherwise the scan job frees it when it notices */
+    if (finished) {
+        destroy_browse_scan(browse_scan);
+    }
+
+    browse_scan = NULL;
+    SAFEFREE(browse_scan_select_name);
+}
+
+static void poll_browse_scan(void)
+{
+    if (!browse_scan) {
+        return;
+    }
+
+    browse_scan_lock(browse_scan);
+    gui_list_fspath_entry_t *found = browse_scan->found;
+    int found_count = browse_scan->found_count;
+    bool finished = browse_scan->finished;
+    browse_scan->found = NULL;
+    browse_scan->found_count = 0;
+    browse_scan->found_alloc = 0;
+    browse_scan_unlock(browse_scan);
+
+    if (found_count > 0) {
+        /* sorting the new entries in moves the selection */
+        char *active_path = NULL;
+        if (local_files.active >= 0) {
+            active_path = strdup(get_gui_list_fspath_entry(&local_files, local_files.active)->path);
+        }
+
+        local_files.entries = realloc(local_files.entries,
+                                      (local_files.count + found_count) * sizeof(gui_list_fspath_entry_t));
+        memcpy(get_gui_list_fspath_entry(&local_files, local_files.count),
+               found,
+               found_count * sizeof(gui_list_fspath_entry_t));
+        local_files.count += found_count;
+
+        prepare_gui_list_names(&local_files);
+
+        if (active_path) {
+            local_files.active = -1;
+            for (int i=0; i<local_files.count; i++) {
+                if (0 == strcmp(active_path, get_gui_list_fspath_entry(&local_files, i)->path)) {
+                    local_files.active = i;
+                    break;
                 }
-                continue;
             }
-        } else {
-            fd = "DIR";
+            free(active_path);
+        }
 
-            const char *index_file = TextFormat("%s/%s", path, COLLECTION_ZIP_INDEX_FILENAME);
-            if (FileExists(index_file)) {
-                type = ENTRY_TYPE_COLLECTION_DIR;
-                icon = ICON_SUITCASE;
-            } else {
-                type = ENTRY_TYPE_DIR;
-                icon = ICON_FOLDER;
-                status = ENTRY_STATUS_NOT_LOADABLE;
+        if (browse_scan_select_name) {
+            gui_list_fspath_entry_t *entry = find_entry_by_filename(&local_files, browse_scan_select_name);
+            if (entry) {
+                local_files.active = entry->common.index;
+                SAFEFREE(browse_scan_select_name);
             }
         }
+    }
+
+    SAFEFREE(found);
 
+    if (finished) {
         if (options->verbose) {
-            infomsg("SCAN> %s (%s, %s, %s)", name, fd, entry_type_str(type), entry_status_str(status));
+            infomsg("Finished scanning \"%s\" (%d entries)", browse_scan->path, local_files.count);
         }
 
-        entry->name   = strdup(name);
-        entry->path   = strdup(path);
-        entry->icon   = icon;
-        entry->common.type   = type;
-        entry->common.status = status;
+        destroy_browse_scan(browse_scan);
+        browse_scan = NULL;
+        SAFEFREE(browse_scan_select_name);
+    }
+}
+
+void setup_browse_dir(void)
+{
+    assert_not_null(browse_path);
+
+    if (!DirectoryExists(browse_path)) {
+        errmsg("Cannot browse \"%s\": not a directory", browse_path);
+        return;
+    }
+
+    int len = strlen(browse_path);
+    assert(len > 0);
+    int last = len - 1;
+    if ((last > 0) && ((browse_path[last] == '\\') || (browse_path[last] == '/'))) {
+        browse_path[last] = '\0';
+    }
 
-        local_files.count++;
+    abandon_browse_scan();
+    free_local_files_data();
+
+    if (options->verbose) {
+        infomsg("Scanning directory: \"%s\"", browse_path);
     }
 
     local_files.scroll_index = -1;
@@ -557,6 +766,17 @@ void setup_browse_dir(void)
     local_files.focus        = -1;
 
     prepare_gui_list_names(&local_files);
+
+    browse_scan = calloc(1, sizeof(browse_scan_t));
+    browse_scan->path = strdup(browse_path);
+#if defined(BROWSE_SCAN_USE_THREADS)
+    pthread_mutex_init(&browse_scan->mutex, NULL);
+#endif
+
+    thread_pool_run(browse_scan_job, browse_scan);
+
+    /* without worker threads the scan has already finished */
+    poll_browse_scan();
 }
 
 void change_gui_browser_path(const char *dir)
@@ -854,6 +1074,13 @@ void select_entry_by_filename(gui_list_vars_t *list, const char *filename)
         list->active = entry->common.index;
     } else {
         list->active = -1;
+
+#if defined(PLATFORM_DESKTOP)
+        if ((list == &local_files) && browse_scan) {
+            SAFEFREE(browse_scan_select_name);
+            browse_scan_select_name = strdup(filename);
+        }
+#endif
     }
 }
 
@@ -953,6 +1180,8 @@ void setup_browse_history(void)
         free_history_data();
     }
 
+    struct finished_level *tree = nvdata_finished_tree();
+
     if (options->verbose) {
         infomsg("Scanning finished level history (count = %d)", finished_levels.count);
     }
@@ -972,7 +1201,7 @@ void setup_browse_history(void)
 
     int count = 0;
 
-    for(fl = sglib_finished_level_it_init_inorder(&it, finished_levels.tree);
+    for(fl = sglib_finished_level_it_init_inorder(&it, tree);
         fl != NULL;
         fl = sglib_finished_level_it_next(&it), count++
     ) {
@@ -1192,6 +1421,8 @@ void cleanup_gui_browser(void)
         free_history_data();
     }
 
+    abandon_browse_scan();
+
     if (local_files.names) {
         free_local_files_data();
     }
@@ -1535,7 +1766,8 @@ static inline void draw_gui_browser_local_level_file_rename_button(gui_list_fspa
         ? local_files_rename_button_with_preview_rect
         : local_files_rename_button_rect;
 
-    bool disable_rename_btn = local_files.active == -1;
+    /* the entry may move while a scan is still adding entries */
+    bool disable_rename_btn = (local_files.active == -1) || browse_scan;
     if (disable_rename_btn) {
         GuiDisable();
     }
@@ -1621,8 +1853,19 @@ void draw_gui_browser_local_level_file(void)
         setup_browse_dir();
     }
 
+    poll_browse_scan();
+
+    if (browse_scan) {
+        /* the results are only picked up while drawing */
+        redraw_animate();
+    }
+
     GuiLabel(local_files_dir_label_rect, local_files_dir_label_text);
-    GuiStatusBar(local_files_dir_rect, browse_path);
+    if (browse_scan) {
+        GuiStatusBar(local_files_dir_rect, TextFormat("%s (scanning...)", browse_path));
+    } else {
+        GuiStatusBar(local_files_dir_rect, browse_path);
+    }
 
     if (GuiButton(local_files_refresh_button_rect, local_files_refresh_button_text)) {
         setup_browse_dir();
@@ -64,6 +64,7 @@ hotkey_desc_t hotkey_desc[] = {
     { .key = "<B>",                                 .desc = "Toggle animated background" },
     { .key = "<P>",                                 .desc = "Toggle postprocessing shader" },
     { .key = "<F>",                                 .desc = "Show FPS" },
+    { .key = "<SHIFT> + <F>",                       .desc = "Show frame time graph" },
     { .key = "<Q>", .key2 = "<ESC>",                .desc = "Quit the program" },
     { .key = "<SHIFT> + <R>",                       .desc = "Reset window possition/size" }
 };
@@ -41,6 +41,8 @@ Rectangle options_log_finished_levels_rect;
 Rectangle options_compress_finished_levels_dat_rect;
 Rectangle options_reset_finished_rect;
 Rectangle options_use_postprocessing_rect;
+Rectangle options_postprocessing_quality_label_rect;
+Rectangle options_postprocessing_quality_rect;
 Rectangle options_use_solve_timer_rect;
 Rectangle options_description_rect;
 
@@ -55,11 +57,14 @@ char options_log_finished_levels_text[] = "Log Finished Levels";
 char options_compress_finished_levels_dat_text[] = "Compress History Log";
 char options_reset_finished_text[] = "Expunge Finished Level Data";
 char options_use_postprocessing_text[] = "Use Shader Effects";
+char options_postprocessing_quality_text[] = "Shader Effects Quality";
+char options_postprocessing_quality_choices[] = "Full;Half;Quarter";
 char options_use_solve_timer_text[] = "Solve Time Clock";
 
 char options_color_edit_tooltip[] = "Select Color";
 char options_color_reset_tooltip[] = "Reset color back to default";
 char options_reset_finished_text_tooltip[] = "WARNING: Permanent!";
+char options_postprocessing_quality_tooltip[] = "Lower quality blurs at a smaller resolution, which is much faster";
 
 char options_anim_bg_desc_text[]  = "Disable if the animated background is too distracting.";
 char options_anim_win_desc_text[] = "Special effects animation that plays when a level is completed.";
@@ -69,7 +74,7 @@ char options_use_two_click_dnd_desc_text[] = "Click on two tiles to swap them. A
 char options_show_level_previews_desc_text[] = "Show small level previews.";
 char options_show_tooltips_desc_text[] = "Show popup tooltips when hovering over some controls.";
 char options_log_finished_levels_desc_text[] = "Save the win time and blueprint string of finished levels in a browsable history log.";
-char options_compress_finished_levels_dat_desc_text[] = "Disables compression of the history log file \"finished levels.dat\". Unless you are interested in using the history log as raw uncompressed JSON, leave this enabled";
+char options_compress_finished_levels_dat_desc_text[] = "Disables compression of history logs exported as JSON with --export-history. Unless you are interested in using the exported history log as raw uncompressed JSON, leave this enabled";
 
 #ifdef USE_PHYSICS
 Rectangle options_use_physics_rect;
@@ -474,6 +479,17 @@ void resize_gui_options(void)
     options_icon_scale_rect.height = TOOL_BUTTON_HEIGHT;
     options_icon_scale_rect.x += (3 * BUTTON_MARGIN) - 1;
 
+    Vector2 options_postprocessing_quality_text_size = measure_gui_text(options_postprocessing_quality_text);
+    options_postprocessing_quality_label_rect.x = options_area_rect.x;
+    options_postprocessing_quality_label_rect.y = options_icon_scale_rect.y + options_icon_scale_rect.height + RAYGUI_ICON_SIZE;
+    options_postprocessing_quality_label_rect.width = options_postprocessing_quality_text_size.x;
+    options_postprocessing_quality_label_rect.height = TOOL_BUTTON_HEIGHT;
+
+    options_postprocessing_quality_rect.x = options_postprocessing_quality_label_rect.x + options_postprocessing_quality_label_rect.width + (3 * BUTTON_MARGIN);
+    options_postprocessing_quality_rect.y = options_postprocessing_quality_label_rect.y;
+    options_postprocessing_quality_rect.width = 120;
+    options_postprocessing_quality_rect.height = TOOL_BUTTON_HEIGHT;
+
     options_status_on.text_size  = measure_gui_text(options_status_on.text);
     options_status_off.text_size = measure_gui_text(options_status_off.text);
 
@@ -627,6 +643,24 @@ static void draw_gui_ui_options(void)
         options->cursor_scale = cursor_scale;
     }
 
+    bool do_disable = !options->use_postprocessing;
+    if (do_disable) {
+        GuiDisable();
+    } else {
+        tooltip(options_postprocessing_quality_rect, options_postprocessing_quality_tooltip);
+    }
+
+    GuiLabel(options_postprocessing_quality_label_rect, options_postprocessing_quality_text);
+
+    int quality = options->postprocessing_quality;
+    GuiComboBox(options_postprocessing_quality_rect, options_postprocessing_quality_choices, &quality);
+    CLAMPVAR(quality, POSTPROCESSING_QUALITY_MIN, POSTPROCESSING_QUALITY_MAX);
+    options->postprocessing_quality = quality;
+
+    if (do_disable) {
+        GuiEnable();
+    }
+
     GuiSetStyle(TOGGLE, TEXT_ALIGNMENT, prev_align);
 }
 
@@ -687,14 +721,8 @@ static void draw_gui_data_options(void)
 {
     bool do_disable = !have_nvdata_finished_levels_data();
 
-    bool old_compress_finished_levels_dat = options->compress_finished_levels_dat;
-
     draw_bool_opt_list(&data_options);
 
-    if (old_compress_finished_levels_dat != options->compress_finished_levels_dat) {
-        force_save_nvdata_finished_levels();
-    }
-
     if (do_disable) {
         GuiDisable();
     } else {
@@ -25,6 +25,7 @@
 
 #include "color.h"
 #include "gui_popup_message.h"
+#include "redraw.h"
 
 #include "sglib/sglib.h"
 
@@ -102,6 +103,8 @@ popup_msg *create_popup_msg(char *message)
 
     message_queue = msg;
 
+    redraw_request();
+
     return msg;
 }
 
@@ -254,6 +257,10 @@ static inline void show_next_popup_message(void)
 
 void draw_gui_popup_message(void)
 {
+    if (current_message || message_queue) {
+        redraw_animate();
+    }
+
     if (current_message) {
         draw_current_popup_message();
     } else {
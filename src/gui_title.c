@@ -26,6 +26,7 @@
 #include "level_draw.h"
 #include "gui_random.h"
 #include "gui_title.h"
+#include "redraw.h"
 #include "generate_level.h"
 
 Rectangle panel_rect;
@@ -192,6 +193,7 @@ static inline void draw_title(void)
         .y = 0.0f
     };
     shadow_offset = Vector2Rotate(shadow_offset, -fmodf(0.3 * current_time, TAU));
+    redraw_ambient();
 
     Vector2 noffset = Vector2Scale(shadow_offset, 2.7);
     title1_text_neg_shadow_position = Vector2Subtract(title1_text_position, noffset);
@@ -177,16 +177,33 @@ hex_axial_t pixel_to_hex_axial(Vector2 p, float size)
     return hex_axial_round(result);
 }
 
+/*
+ * The non-_r versions below return a static buffer, which is
+ * overwritten by the next call. Anything that might run on
+ * another thread should use the _r versions instead.
+ */
+
 Vector2 *hex_axial_pixel_corners(hex_axial_t axial, float size)
 {
     Vector2 pos = hex_axial_to_pixel(axial, size);
     return hex_pixel_corners(pos, size);
 }
 
-Vector2 *hex_pixel_corners(Vector2 pos, float size)\
+Vector2 *hex_pixel_corners(Vector2 pos, float size)
 {
     static Vector2 corners[7];
+    hex_pixel_corners_r(pos, size, corners);
+    return corners;
+}
+
+void hex_axial_pixel_corners_r(hex_axial_t axial, float size, Vector2 *corners)
+{
+    Vector2 pos = hex_axial_to_pixel(axial, size);
+    hex_pixel_corners_r(pos, size, corners);
+}
 
+void hex_pixel_corners_r(Vector2 pos, float size, Vector2 *corners)
+{
     // right
     corners[0].x = pos.x + size;
     corners[0].y = pos.y;
@@ -213,8 +230,99 @@ Vector2 *hex_pixel_corners(Vector2 pos, float size)\
 
     // repeat first corner for easier polyline drawing
     corners[6] = corners[0];
+}
 
-    return corners;
+void hex_axial_pixel_edge_midpoints_r(hex_axial_t axial, float size, Vector2 *midpoints)
+{
+    Vector2 corners[7];
+    hex_axial_pixel_corners_r(axial, size, corners);
+
+    each_direction {
+        midpoints[dir] = Vector2Lerp(corners[dir], corners[dir + 1], 0.5);
+    }
+
+    midpoints[6] = midpoints[0];
+}
+
+/*** batch geometry ***/
+
+/*
+ * These fill flat arrays for many hexes at once. The per-hex math
+ * is kept in simple counted loops over plain arrays with no calls
+ * or branches, so the compiler is free to vectorize them.
+ */
+
+static void hex_axial_coords_to_pixel(Vector2 *coords, int count, float size)
+{
+    const float qx = size * (3.0f / 2.0f);
+    const float qy = size * (float)SQRT_3_2;
+    const float ry = size * (float)SQRT_3;
+
+    for (int i = 0; i < count; i++) {
+        float q = coords[i].x;
+        float r = coords[i].y;
+        coords[i].x = qx * q;
+        coords[i].y = (qy * q) + (ry * r);
+    }
+}
+
+static int hex_axial_ring_coords(hex_axial_t center, int radius, Vector2 *coords)
+{
+    hex_axial_t offset = hex_axial_scale(hex_axial_direction(4), radius);
+    hex_axial_t hex = hex_axial_add(center, offset);
+
+    int n = 0;
+    for (int i=0; i < 6; i++) {
+        for (int j=0; j < radius; j++) {
+            coords[n].x = (float)hex.q;
+            coords[n].y = (float)hex.r;
+            n++;
+            hex = hex_axial_neighbor(hex, i);
+        }
+    }
+
+    return n;
+}
+
+int hex_axial_ring_to_pixel(hex_axial_t center, int radius, float size, Vector2 *centers)
+{
+    assert(radius > 0);
+
+    int n = hex_axial_ring_coords(center, radius, centers);
+    hex_axial_coords_to_pixel(centers, n, size);
+    return n;
+}
+
+int hex_axial_spiral_to_pixel(hex_axial_t center, int radius, float size, Vector2 *centers)
+{
+    assert(radius > 0);
+
+    int n = 0;
+    centers[n].x = (float)center.q;
+    centers[n].y = (float)center.r;
+    n++;
+
+    for (int k = 1; k <= radius; k++) {
+        n += hex_axial_ring_coords(center, k, &centers[n]);
+    }
+
+    hex_axial_coords_to_pixel(centers, n, size);
+    return n;
+}
+
+void hex_pixel_corners_batch(const Vector2 *centers, int count, float size, Vector2 *corners)
+{
+    Vector2 offset[7];
+    hex_pixel_corners_r(Vector2Zero(), size, offset);
+
+    for (int i = 0; i < count; i++) {
+        Vector2 c = centers[i];
+        Vector2 *out = &corners[i * 7];
+        for (int j = 0; j < 7; j++) {
+            out[j].x = c.x + offset[j].x;
+            out[j].y = c.y + offset[j].y;
+        }
+    }
 }
 
 hex_direction_t pixel_to_hex_axial_section(Vector2 p, float size)
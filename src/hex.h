@@ -98,7 +98,8 @@ Vector2 hex_axial_to_pixel(hex_axial_t axial, float size);
 hex_axial_t pixel_to_hex_axial(Vector2 p, float size);
 
 Vector2 *hex_axial_pixel_corners(hex_axial_t axial, float size);
-Vector2 *hex_axial_pixel_edge_midpoints(hex_axial_t axial, float size);
+void hex_axial_pixel_corners_r(hex_axial_t axial, float size, Vector2 *corners);
+void hex_axial_pixel_edge_midpoints_r(hex_axial_t axial, float size, Vector2 *midpoints);
 
 bool hex_axial_eq(hex_axial_t a, hex_axial_t b);
 
@@ -116,6 +117,18 @@ inline static hex_axial_t hex_axial_scale(hex_axial_t axial, int factor)
 void hex_axial_foreach_in_ring(hex_axial_t center, int radius, hex_axial_cb_t callback, void *data);
 void hex_axial_foreach_in_spiral(hex_axial_t center, int radius, hex_axial_cb_t callback, void *data);
 
+/* number of hexes in a ring or a filled spiral of the given radius */
+#define HEX_RING_SIZE(radius)   (6 * (radius))
+#define HEX_SPIRAL_SIZE(radius) (1 + (3 * (radius) * ((radius) + 1)))
+
+/* centers has room for HEX_RING_SIZE() / HEX_SPIRAL_SIZE() entries,
+ * in hex_axial_foreach_in_*() order; returns the count */
+int hex_axial_ring_to_pixel(hex_axial_t center, int radius, float size, Vector2 *centers);
+int hex_axial_spiral_to_pixel(hex_axial_t center, int radius, float size, Vector2 *centers);
+
+/* corners has room for 7 * count entries, laid out as for hex_pixel_corners_r() */
+void hex_pixel_corners_batch(const Vector2 *centers, int count, float size, Vector2 *corners);
+
 /*
  * Cube Coordinates for hexagons
  */
@@ -233,6 +246,7 @@ static inline hex_cubef_t hex_axialf_to_cubef(hex_axialf_t axialf)
 }
 
 Vector2 *hex_pixel_corners(Vector2 pos, float size);
+void hex_pixel_corners_r(Vector2 pos, float size, Vector2 *corners);
 
 hex_offset_t hex_axial_to_offset(hex_axial_t axial, hex_offset_type_t type);
 hex_axial_t hex_offset_to_axial(hex_offset_t off);
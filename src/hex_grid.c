@@ -0,0 +1,136 @@
+/****************************************************************************
+ *                                                                          *
+ * hex_grid.c                                                               *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "hex_grid.h"
+
+static hex_grid_t *hex_grids[LEVEL_MAX_RADIUS + 1];
+
+struct spiral_fill {
+    hex_grid_t *grid;
+    int count;
+};
+
+static void add_spiral_slot(hex_axial_t axial, void *data)
+{
+    struct spiral_fill *fill = (struct spiral_fill *)data;
+
+    int idx = hex_grid_idx(fill->grid, axial);
+    assert(idx != HEX_GRID_OFF_BOARD);
+    assert(fill->count < fill->grid->spiral_size);
+
+    fill->grid->spiral[fill->count++] = idx;
+}
+
+static hex_grid_t *create_hex_grid(int radius)
+{
+    hex_grid_t *grid = calloc(1, sizeof(hex_grid_t));
+
+    grid->radius      = radius;
+    grid->width       = (2 * radius) + 1;
+    grid->maxtiles    = grid->width * grid->width;
+    grid->center.q    = radius;
+    grid->center.r    = radius;
+    grid->spiral_size = HEX_SPIRAL_SIZE(radius);
+
+    grid->neighbor      = calloc(grid->maxtiles,    sizeof(grid->neighbor[0]));
+    grid->spiral        = calloc(grid->spiral_size, sizeof(hex_grid_idx_t));
+    grid->ring_start    = calloc(radius + 2,        sizeof(int));
+    grid->reflect_horiz = calloc(grid->maxtiles,    sizeof(hex_grid_idx_t));
+    grid->rotate        = calloc(grid->maxtiles,    sizeof(hex_grid_idx_t));
+    grid->axial         = calloc(grid->maxtiles,    sizeof(hex_axial_t));
+
+    for (int q=0; q<grid->width; q++) {
+        for (int r=0; r<grid->width; r++) {
+            hex_axial_t axial = {
+                .q = q,
+                .r = r
+            };
+            int idx = hex_grid_idx(grid, axial);
+
+            grid->axial[idx] = axial;
+
+            each_direction {
+                grid->neighbor[idx][dir] = hex_grid_idx(grid, hex_axial_neighbor(axial, dir));
+            }
+
+            grid->reflect_horiz[idx] = hex_grid_idx(grid, hex_axial_reflect_horiz(axial, grid->center));
+            grid->rotate[idx]        = hex_grid_idx(grid, hex_axial_rotate(axial, grid->center));
+        }
+    }
+
+    struct spiral_fill fill = {
+        .grid  = grid,
+        .count = 0
+    };
+
+    grid->ring_start[0] = 0;
+    add_spiral_slot(grid->center, &fill);
+
+    for (int k = 1; k <= radius; k++) {
+        grid->ring_start[k] = fill.count;
+        hex_axial_foreach_in_ring(grid->center, k, add_spiral_slot, &fill);
+    }
+    grid->ring_start[radius + 1] = fill.count;
+
+    assert(fill.count == grid->spiral_size);
+
+    return grid;
+}
+
+static void destroy_hex_grid(hex_grid_t *grid)
+{
+    if (grid) {
+        SAFEFREE(grid->neighbor);
+        SAFEFREE(grid->spiral);
+        SAFEFREE(grid->ring_start);
+        SAFEFREE(grid->reflect_horiz);
+        SAFEFREE(grid->rotate);
+        SAFEFREE(grid->axial);
+        SAFEFREE(grid);
+    }
+}
+
+void init_hex_grids(void)
+{
+    for (int radius = LEVEL_MIN_RADIUS; radius <= LEVEL_MAX_RADIUS; radius++) {
+        if (!hex_grids[radius]) {
+            hex_grids[radius] = create_hex_grid(radius);
+        }
+    }
+}
+
+hex_grid_t *get_hex_grid(int radius)
+{
+    assert(radius >= LEVEL_MIN_RADIUS);
+    assert(radius <= LEVEL_MAX_RADIUS);
+    assert_not_null(hex_grids[radius]);
+
+    return hex_grids[radius];
+}
+
+void cleanup_hex_grids(void)
+{
+    for (int i=0; i<=LEVEL_MAX_RADIUS; i++) {
+        destroy_hex_grid(hex_grids[i]);
+        hex_grids[i] = NULL;
+    }
+}
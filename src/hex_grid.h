@@ -0,0 +1,90 @@
+/****************************************************************************
+ *                                                                          *
+ * hex_grid.h                                                               *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef HEX_GRID_H
+#define HEX_GRID_H
+
+#include "hex.h"
+
+/*
+ * Precomputed addressing tables for the square grid of tile slots
+ * that backs a level. A grid of radius R is (2R+1) x (2R+1) slots
+ * centered on (R, R), and can hold any level whose radius is <= R.
+ * A slot index is hex_grid_idx() of its position; HEX_GRID_OFF_BOARD
+ * marks a neighbor that would fall outside the grid.
+ *
+ * init_hex_grids() builds the grid for every radius before any other
+ * thread starts, so get_hex_grid() is a plain lookup that is safe to
+ * call from thread pool jobs. Each grid is shared by every level with
+ * the same grid radius.
+ */
+
+#define HEX_GRID_OFF_BOARD (-1)
+
+typedef int16_t hex_grid_idx_t;
+
+struct hex_grid {
+    int radius;
+    int width;
+    int maxtiles;
+    hex_axial_t center;
+
+    /* number of slots within radius of the center */
+    int spiral_size;
+
+    /* neighbor slot of each slot, indexed by hex_direction_t */
+    hex_grid_idx_t (*neighbor)[6];
+
+    /* the slots around the center in the same order as
+     * hex_axial_foreach_in_spiral(); ring k is the half-open range
+     * spiral[ring_start[k] .. ring_start[k+1]] */
+    hex_grid_idx_t *spiral;
+    int *ring_start;
+
+    /* each slot reflected/rotated about the center */
+    hex_grid_idx_t *reflect_horiz;
+    hex_grid_idx_t *rotate;
+
+    hex_axial_t *axial;
+};
+typedef struct hex_grid hex_grid_t;
+
+void init_hex_grids(void);
+void cleanup_hex_grids(void);
+hex_grid_t *get_hex_grid(int radius);
+
+static inline int hex_grid_idx(hex_grid_t *grid, hex_axial_t axial)
+{
+    /* negative coordinates wrap to large unsigned values */
+    bool off_board = (((unsigned)axial.q >= (unsigned)grid->width) |
+                      ((unsigned)axial.r >= (unsigned)grid->width));
+    return off_board ? HEX_GRID_OFF_BOARD : (axial.q * grid->width) + axial.r;
+}
+
+/* number of slots within radius of the center */
+static inline int hex_grid_spiral_count(hex_grid_t *grid, int radius)
+{
+    CLAMPVAR(radius, 0, grid->radius);
+    return grid->ring_start[radius + 1];
+}
+
+#endif /*HEX_GRID_H*/
+
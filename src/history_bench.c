@@ -0,0 +1,313 @@
+/****************************************************************************
+ *                                                                          *
+ * history_bench.c                                                          *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include "options.h"
+#include "nvdata_finished.h"
+#include "nvdata_finished_journal.h"
+#include "history_bench.h"
+
+#define HISTORY_BENCH_ENTRY_COUNT 100000
+#define HISTORY_BENCH_RUNS        3
+
+/* a journal that hasn't been compacted yet: levels finished
+ * since the snapshot, and a few removed from the history */
+#define HISTORY_BENCH_JOURNAL_MARKS   200
+#define HISTORY_BENCH_JOURNAL_UNMARKS 50
+#define HISTORY_BENCH_JOURNAL_COUNT \
+    (HISTORY_BENCH_ENTRY_COUNT + HISTORY_BENCH_JOURNAL_MARKS - HISTORY_BENCH_JOURNAL_UNMARKS)
+
+static double bench_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static void bench_entry_id(char *id, int n)
+{
+    snprintf(id, ID_MAXLEN, "%08x-0000-4000-8000-%012x", n, n * 7919);
+}
+
+static void bench_entry(struct finished_level *entry, int i)
+{
+    time_t base_time = 1700000000;
+    char name[NAME_MAXLEN];
+
+    bench_entry_id(entry->id, i);
+
+    snprintf(name, NAME_MAXLEN, "Level %d", i);
+    finished_level_set_name(entry, name);
+    finished_level_set_win_time(entry, base_time + (i * 60));
+
+    elapsed_time_parts_t elapsed_time = {
+        .day = 0,
+        .hr  = 0,
+        .min = i % 60,
+        .sec = (i / 60) % 60,
+        .ms  = i % 1000
+    };
+    finished_level_set_elapsed_time(entry, &elapsed_time);
+
+    if (i % 3) {
+        char blueprint[BLUEPRINT_STRING_MAXLEN];
+        snprintf(blueprint, BLUEPRINT_STRING_MAXLEN, "hexbp1:s%x:r4:c4", i);
+        finished_level_set_blueprint(entry, blueprint);
+    } else {
+        filename_t filename;
+        unique_id_t level_unique_id = {0};
+        snprintf(filename, FILENAME_MAXLEN, "pack-%d.hexlevelpack", i / 100);
+        bench_entry_id(level_unique_id, i);
+        finished_level_set_fileref(entry, filename, level_unique_id);
+        finished_level_set_collection(entry);
+    }
+}
+
+static void fill_history(void)
+{
+    nvdata_finished_clear();
+
+    for (int i=0; i<HISTORY_BENCH_ENTRY_COUNT; i++) {
+        struct finished_level entry = {0};
+        bench_entry(&entry, i);
+        nvdata_mark_id_finished(&entry);
+    }
+}
+
+/* unmarks skip every id bench_lookup_all() looks for */
+static bool fill_journal(void)
+{
+    if (!nvdata_finished_journal_reset()) {
+        return false;
+    }
+
+    for (int i=0; i<HISTORY_BENCH_JOURNAL_MARKS; i++) {
+        struct finished_level entry = {0};
+        bench_entry(&entry, HISTORY_BENCH_ENTRY_COUNT + i);
+        if (!nvdata_finished_journal_append_mark(&entry)) {
+            return false;
+        }
+    }
+
+    for (int i=0; i<HISTORY_BENCH_JOURNAL_UNMARKS; i++) {
+        char id[ID_MAXLEN];
+        bench_entry_id(id, (i * 97) + 1);
+        if (!nvdata_finished_journal_append_unmark(id)) {
+            return false;
+        }
+    }
+
+    nvdata_finished_journal_close();
+    return true;
+}
+
+static bool bench_lookup_all(void)
+{
+    char id[ID_MAXLEN];
+
+    for (int i=0; i<HISTORY_BENCH_ENTRY_COUNT; i += 97) {
+        bench_entry_id(id, i);
+        if (!nvdata_is_id_finished(id)) {
+            errmsg("BENCHMARK: lookup of \"%s\" failed", id);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool bench_json(const char *path, double *load, double *lookup)
+{
+    *load = *lookup = 1e9;
+
+    for (int run=0; run<HISTORY_BENCH_RUNS; run++) {
+        nvdata_finished_clear();
+
+        double start = bench_time();
+        if (!nvdata_finished_import_json(path)) {
+            return false;
+        }
+        double loaded = bench_time();
+        if (!bench_lookup_all()) {
+            return false;
+        }
+        double done = bench_time();
+
+        *load   = MIN(*load,   loaded - start);
+        *lookup = MIN(*lookup, done - loaded);
+    }
+
+    return finished_levels.count == HISTORY_BENCH_ENTRY_COUNT;
+}
+
+static bool bench_store(const char *path, bool journal, double *load, double *lookup, double *tree)
+{
+    *load = *lookup = *tree = 1e9;
+
+    for (int run=0; run<HISTORY_BENCH_RUNS; run++) {
+        nvdata_finished_clear();
+
+        double start = bench_time();
+        if (!nvdata_finished_load_store(path)) {
+            return false;
+        }
+        if (journal && !nvdata_finished_journal_replay()) {
+            return false;
+        }
+        double loaded = bench_time();
+        if (!bench_lookup_all()) {
+            return false;
+        }
+        double looked_up = bench_time();
+        nvdata_finished_tree();
+        double done = bench_time();
+
+        *load   = MIN(*load,   loaded - start);
+        *lookup = MIN(*lookup, looked_up - loaded);
+        *tree   = MIN(*tree,   done - looked_up);
+
+        nvdata_finished_journal_close();
+    }
+
+    return finished_levels.count == (journal
+                                     ? HISTORY_BENCH_JOURNAL_COUNT
+                                     : HISTORY_BENCH_ENTRY_COUNT);
+}
+
+bool run_history_benchmark(void)
+{
+    bool rv = false;
+    bool save_verbose = options->verbose;
+    char *save_journal_path = nvdata_state_finished_levels_journal_path;
+
+    const char *tmpdir = getenv("TMPDIR");
+    if (!tmpdir || !*tmpdir) {
+        tmpdir = "/tmp";
+    }
+
+    char *dir = NULL;
+    char *json_path = NULL;
+    char *store_path = NULL;
+    char *journal_path = NULL;
+    safe_asprintf(&dir, "%s/" PACKAGE_NAME "-history-bench-XXXXXX", tmpdir);
+
+    if (NULL == mkdtemp(dir)) {
+        errmsg("Could not create a temporary directory \"%s\": %s", dir, strerror(errno));
+        goto bench_cleanup;
+    }
+
+    safe_asprintf(&json_path, "%s/%s", dir, NVDATA_FINISHED_LEVEL_JSON_FILE_NAME);
+    safe_asprintf(&store_path, "%s/%s", dir, NVDATA_FINISHED_LEVEL_FILE_NAME);
+    safe_asprintf(&journal_path, "%s/%s", dir, NVDATA_FINISHED_LEVEL_JOURNAL_FILE_NAME);
+
+    /* the real journal is closed before anything is benchmarked */
+    nvdata_finished_journal_close();
+    nvdata_state_finished_levels_journal_path = journal_path;
+
+    infomsg("BENCHMARK: finished level history (%d entries, best of %d runs)",
+            HISTORY_BENCH_ENTRY_COUNT, HISTORY_BENCH_RUNS);
+
+    /* per-entry MARK messages would swamp the results */
+    options->verbose = false;
+
+    fill_history();
+
+    if (!nvdata_finished_export_json(json_path) ||
+        !nvdata_finished_save_store(store_path)) {
+        errmsg("BENCHMARK: could not write the test files");
+        goto bench_cleanup;
+    }
+
+    double json_load, json_lookup;
+    if (!bench_json(json_path, &json_load, &json_lookup)) {
+        errmsg("BENCHMARK: loading \"%s\" failed", json_path);
+        goto bench_cleanup;
+    }
+
+    double store_load, store_lookup, store_tree;
+    if (!bench_store(store_path, false, &store_load, &store_lookup, &store_tree)) {
+        errmsg("BENCHMARK: loading \"%s\" failed", store_path);
+        goto bench_cleanup;
+    }
+
+    if (!fill_journal()) {
+        errmsg("BENCHMARK: could not write \"%s\"", journal_path);
+        goto bench_cleanup;
+    }
+
+    double journal_load, journal_lookup, journal_tree;
+    if (!bench_store(store_path, true, &journal_load, &journal_lookup, &journal_tree)) {
+        errmsg("BENCHMARK: loading \"%s\" with \"%s\" failed", store_path, journal_path);
+        goto bench_cleanup;
+    }
+
+    infomsg("BENCHMARK: JSON  (%s, %7d KiB): load %8.3f ms, first lookups %8.3f ms",
+            options->compress_finished_levels_dat ? "compressed" : "plain",
+            GetFileLength(json_path) / 1024,
+            json_load * 1000.0,
+            json_lookup * 1000.0);
+
+    infomsg("BENCHMARK: store (binary,     %7d KiB): load %8.3f ms, first lookups %8.3f ms, build tree %8.3f ms",
+            GetFileLength(store_path) / 1024,
+            store_load * 1000.0,
+            store_lookup * 1000.0,
+            store_tree * 1000.0);
+
+    infomsg("BENCHMARK: store + journal (%3d records): load %8.3f ms, first lookups %8.3f ms, build tree %8.3f ms",
+            HISTORY_BENCH_JOURNAL_MARKS + HISTORY_BENCH_JOURNAL_UNMARKS,
+            journal_load * 1000.0,
+            journal_lookup * 1000.0,
+            journal_tree * 1000.0);
+
+    rv = true;
+
+  bench_cleanup:
+    options->verbose = save_verbose;
+
+    nvdata_finished_clear();
+
+    nvdata_finished_journal_close();
+    nvdata_state_finished_levels_journal_path = save_journal_path;
+
+    if (journal_path) {
+        unlink(journal_path);
+    }
+    if (store_path) {
+        unlink(store_path);
+    }
+    if (json_path) {
+        unlink(json_path);
+    }
+    if (dir) {
+        rmdir(dir);
+    }
+
+    SAFEFREE(journal_path);
+    SAFEFREE(store_path);
+    SAFEFREE(json_path);
+    SAFEFREE(dir);
+
+    return rv;
+}
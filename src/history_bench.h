@@ -0,0 +1,33 @@
+/****************************************************************************
+ *                                                                          *
+ * history_bench.h                                                          *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef HISTORY_BENCH_H
+#define HISTORY_BENCH_H
+
+/*
+ * Compares load times of a large synthetic finished level history
+ * stored as JSON and as the binary store (--benchmark-history).
+ * Runs before the window is opened and never touches the real
+ * history files.
+ */
+bool run_history_benchmark(void);
+
+#endif /*HISTORY_BENCH_H*/
@@ -0,0 +1,467 @@
+/****************************************************************************
+ *                                                                          *
+ * json_bench.c                                                             *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <time.h>
+
+#include "cJSON/cJSON.h"
+#include "options.h"
+#include "level.h"
+#include "hex_grid.h"
+#include "collection.h"
+#include "collection_pack.h"
+#include "json_bench.h"
+
+#define JSON_BENCH_RUNS 5
+
+struct json_bench_input {
+    char *name;
+    char *str;
+    size_t len;
+};
+typedef struct json_bench_input json_bench_input_t;
+
+struct json_bench_list {
+    json_bench_input_t *inputs;
+    int count;
+    int size;
+    size_t bytes;
+};
+typedef struct json_bench_list json_bench_list_t;
+
+static json_bench_list_t bench_levels;
+static json_bench_list_t bench_packs;
+static int bench_mismatches;
+static int bench_fallbacks;
+
+static double bench_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static void bench_list_add(json_bench_list_t *list, const char *name, char *str)
+{
+    if (list->count >= list->size) {
+        list->size = list->size ? (list->size * 2) : 256;
+        list->inputs = realloc(list->inputs, list->size * sizeof(json_bench_input_t));
+    }
+
+    json_bench_input_t *input = &(list->inputs[list->count++]);
+    input->name = strdup(name);
+    input->str  = str;
+    input->len  = strlen(str);
+    list->bytes += input->len;
+}
+
+static void bench_list_free(json_bench_list_t *list)
+{
+    for (int i=0; i<list->count; i++) {
+        SAFEFREE(list->inputs[i].name);
+        SAFEFREE(list->inputs[i].str);
+    }
+    SAFEFREE(list->inputs);
+    memset(list, 0, sizeof(*list));
+}
+
+/* returns a malloc()ed copy of the decompressed NUL terminated text */
+static char *bench_decompress(const unsigned char *data, int size)
+{
+    int str_size = 0;
+    unsigned char *str_data = DecompressData(data, size, &str_size);
+    if (NULL == str_data) {
+        return NULL;
+    }
+
+    char *str = malloc(str_size + 1);
+    memcpy(str, str_data, str_size);
+    str[str_size] = '\0';
+    MemFree(str_data);
+
+    return str;
+}
+
+static void bench_add_pack(const char *path)
+{
+    int filesize = 0;
+    unsigned char *filedata = LoadFileData(path, &filesize);
+    if (NULL == filedata) {
+        errmsg("BENCHMARK: cannot read \"%s\"", path);
+        return;
+    }
+
+    if (!collection_pack_data_is_indexed(filedata, filesize)) {
+        char *str = bench_decompress(filedata, filesize);
+        if (str) {
+            bench_list_add(&bench_packs, path, str);
+        }
+    }
+
+    collection_t *collection = load_collection_pack_file(path);
+    if (collection) {
+        for (level_t *level = collection->levels; level; level = level->next) {
+            char *str = NULL;
+            if (level->pack_data) {
+                str = bench_decompress(level->pack_data, level->pack_size);
+            } else if ((level->source == LEVEL_SOURCE_PACK_FILE) &&
+                       ((level->pack_offset + level->pack_size) <= (uint32_t)filesize)) {
+                str = bench_decompress(filedata + level->pack_offset, level->pack_size);
+            }
+
+            if (str) {
+                char *name = NULL;
+                safe_asprintf(&name, "%s:%s", path, level->filename);
+                bench_list_add(&bench_levels, name, str);
+                free(name);
+            }
+        }
+        destroy_collection(collection);
+    }
+
+    UnloadFileData(filedata);
+}
+
+static void bench_add_path(const char *path)
+{
+    if (IsFileExtension(path, "." LEVEL_FILENAME_EXT)) {
+        char *str = LoadFileText(path);
+        if (str) {
+            char *copy = strdup(str);
+            UnloadFileText(str);
+            bench_list_add(&bench_levels, path, copy);
+        } else {
+            errmsg("BENCHMARK: cannot read \"%s\"", path);
+        }
+    } else if (IsFileExtension(path, "." COLLECTION_FILENAME_EXT)) {
+        bench_add_pack(path);
+    }
+}
+
+static void bench_mismatch(const char *name, const char *what)
+{
+    errmsg("BENCHMARK: \"%s\": streaming reader and cJSON differ: %s", name, what);
+    bench_mismatches++;
+}
+
+static void bench_compare_levels(const char *name, level_t *a, level_t *b)
+{
+    if (strcmp(a->name, b->name)) {
+        bench_mismatch(name, "name");
+        return;
+    }
+    if (strcmp(a->unique_id, b->unique_id)) {
+        bench_mismatch(name, "unique_id");
+        return;
+    }
+    if ((a->radius != b->radius) || (a->grid->radius != b->grid->radius)) {
+        bench_mismatch(name, "radius");
+        return;
+    }
+    if (a->current_tile_write_idx != b->current_tile_write_idx) {
+        bench_mismatch(name, "tile count");
+        return;
+    }
+
+    for (int i=0; i<a->current_tile_write_idx; i++) {
+        tile_t *ta = &(a->tiles[i]);
+        tile_t *tb = &(b->tiles[i]);
+
+        if ((ta->enabled != tb->enabled) ||
+            (ta->hidden  != tb->hidden)  ||
+            (ta->fixed   != tb->fixed)   ||
+            (ta->path_count != tb->path_count) ||
+            memcmp(ta->path, tb->path, sizeof(ta->path)) ||
+            !hex_axial_eq(ta->solved_pos->position, tb->solved_pos->position) ||
+            !hex_axial_eq(ta->unsolved_pos->position, tb->unsolved_pos->position)) {
+            bench_mismatch(name, TextFormat("tile %d", i));
+            return;
+        }
+    }
+}
+
+/* what parse_level_file_header() did before it used the streaming reader */
+static void bench_cjson_header(const char *str, level_file_header_t *header)
+{
+    header->have_header = false;
+
+    cJSON *json = cJSON_Parse(str);
+
+    cJSON *name_json      = cJSON_GetObjectItem(json, "name");
+    cJSON *unique_id_json = cJSON_GetObjectItem(json, "unique_id");
+    cJSON *radius_json    = cJSON_GetObjectItem(json, "radius");
+
+    if (cJSON_IsString(name_json) && cJSON_IsString(unique_id_json)) {
+        snprintf(header->name, NAME_MAXLEN, "%s", name_json->valuestring);
+        snprintf(header->unique_id, UNIQUE_ID_LENGTH, "%s", unique_id_json->valuestring);
+        header->radius = cJSON_IsNumber(radius_json) ? radius_json->valueint : 0;
+        header->have_header = true;
+    }
+
+    cJSON_Delete(json);
+}
+
+static bool bench_cjson_level(level_t *level, const char *str)
+{
+    cJSON *json = cJSON_Parse(str);
+    bool rv = level_from_json(level, json);
+    cJSON_Delete(json);
+    return rv;
+}
+
+static bool bench_cjson_pack(collection_t *collection, const char *str)
+{
+    cJSON *json = cJSON_Parse(str);
+    if (NULL == json) {
+        return false;
+    }
+    bool rv = collection_from_json(collection, json);
+    cJSON_Delete(json);
+    return rv;
+}
+
+static void bench_validate(void)
+{
+    for (int i=0; i<bench_levels.count; i++) {
+        json_bench_input_t *input = &(bench_levels.inputs[i]);
+
+        level_file_header_t ha = {0}, hb = {0};
+        bench_cjson_header(input->str, &ha);
+        parse_level_file_header(input->str, &hb, false);
+        if ((ha.have_header != hb.have_header) ||
+            (ha.have_header && (strcmp(ha.name, hb.name) ||
+                                strcmp(ha.unique_id, hb.unique_id) ||
+                                (ha.radius != hb.radius)))) {
+            bench_mismatch(input->name, "header");
+        }
+
+        level_t *a = create_level(NULL);
+        level_t *b = create_level(NULL);
+        bool a_ok = bench_cjson_level(a, input->str);
+        bool b_ok = level_read_json(b, input->str);
+
+        if (b_ok && !a_ok) {
+            bench_mismatch(input->name, "only the streaming reader accepted it");
+        } else if (!b_ok) {
+            if (options->verbose) {
+                infomsg("BENCHMARK: \"%s\" falls back to cJSON", input->name);
+            }
+            bench_fallbacks++;
+        } else {
+            bench_compare_levels(input->name, a, b);
+        }
+
+        destroy_level(a);
+        destroy_level(b);
+    }
+
+    for (int i=0; i<bench_packs.count; i++) {
+        json_bench_input_t *input = &(bench_packs.inputs[i]);
+
+        collection_t *a = create_collection();
+        collection_t *b = create_collection();
+        bool a_ok = bench_cjson_pack(a, input->str);
+        bool b_ok = collection_read_json(b, input->str);
+
+        if (b_ok && !a_ok) {
+            bench_mismatch(input->name, "only the streaming reader accepted it");
+        } else if (!b_ok) {
+            bench_fallbacks++;
+        } else if (strcmp(a->unique_id, b->unique_id) || strcmp(a->id, b->id) ||
+                   (a->level_count != b->level_count)) {
+            bench_mismatch(input->name, "pack header");
+        } else {
+            level_t *la = a->levels;
+            level_t *lb = b->levels;
+            for (; la && lb; la = la->next, lb = lb->next) {
+                if (strcmp(la->name, lb->name) ||
+                    strcmp(la->unique_id, lb->unique_id) ||
+                    strcmp(la->filename, lb->filename)) {
+                    bench_mismatch(input->name, TextFormat("level \"%s\"", la->filename));
+                    break;
+                }
+
+                /* both stubs have to decode to the same level */
+                if (!level_materialize(la) || !level_materialize(lb)) {
+                    bench_mismatch(input->name, TextFormat("level \"%s\" didn't decode", la->filename));
+                    break;
+                }
+                bench_compare_levels(la->filename, la, lb);
+            }
+        }
+
+        destroy_collection(a);
+        destroy_collection(b);
+    }
+}
+
+static double bench_levels_run(bool stream, level_t **levels)
+{
+    double best = 1e9;
+
+    for (int run=0; run<JSON_BENCH_RUNS; run++) {
+        double start = bench_time();
+        for (int i=0; i<bench_levels.count; i++) {
+            if (stream) {
+                level_read_json(levels[i], bench_levels.inputs[i].str);
+            } else {
+                bench_cjson_level(levels[i], bench_levels.inputs[i].str);
+            }
+        }
+        best = MIN(best, bench_time() - start);
+    }
+
+    return best;
+}
+
+static double bench_headers_run(bool stream)
+{
+    double best = 1e9;
+
+    for (int run=0; run<JSON_BENCH_RUNS; run++) {
+        double start = bench_time();
+        for (int i=0; i<bench_levels.count; i++) {
+            level_file_header_t header = {0};
+            if (stream) {
+                parse_level_file_header(bench_levels.inputs[i].str, &header, false);
+            } else {
+                bench_cjson_header(bench_levels.inputs[i].str, &header);
+            }
+        }
+        best = MIN(best, bench_time() - start);
+    }
+
+    return best;
+}
+
+static double bench_packs_run(bool stream)
+{
+    double best = 1e9;
+
+    for (int run=0; run<JSON_BENCH_RUNS; run++) {
+        double elapsed = 0.0;
+        for (int i=0; i<bench_packs.count; i++) {
+            collection_t *collection = create_collection();
+
+            double start = bench_time();
+            if (stream) {
+                collection_read_json(collection, bench_packs.inputs[i].str);
+            } else {
+                bench_cjson_pack(collection, bench_packs.inputs[i].str);
+            }
+            elapsed += bench_time() - start;
+
+            destroy_collection(collection);
+        }
+        best = MIN(best, elapsed);
+    }
+
+    return best;
+}
+
+static void bench_report(const char *what, json_bench_list_t *list, double cjson, double stream)
+{
+    double mib = (double)list->bytes / (1024.0 * 1024.0);
+
+    infomsg("BENCHMARK: %-7s cJSON %9.3f ms (%7.1f MiB/s), stream %9.3f ms (%7.1f MiB/s), %5.2fx",
+            what,
+            cjson * 1000.0,  mib / MAX(cjson,  1e-9),
+            stream * 1000.0, mib / MAX(stream, 1e-9),
+            cjson / MAX(stream, 1e-9));
+}
+
+bool run_json_benchmark(void)
+{
+    bool rv = false;
+    bool save_verbose = options->verbose;
+
+    bench_mismatches = 0;
+    bench_fallbacks = 0;
+
+    for (int arg=0; arg < options->extra_argc; arg++) {
+        const char *path = options->extra_argv[arg];
+
+        if (DirectoryExists(path)) {
+            FilePathList files = LoadDirectoryFilesEx(path, NULL, true);
+            for (unsigned int i=0; i<files.count; i++) {
+                bench_add_path(files.paths[i]);
+            }
+            UnloadDirectoryFiles(files);
+        } else if (FileExists(path)) {
+            bench_add_path(path);
+        } else {
+            errmsg("BENCHMARK: no such file or directory: \"%s\"", path);
+        }
+    }
+
+    if (!bench_levels.count) {
+        errmsg("BENCHMARK: no ." LEVEL_FILENAME_EXT " or ." COLLECTION_FILENAME_EXT " files found");
+        goto bench_cleanup;
+    }
+
+    infomsg("BENCHMARK: %d levels (%d KiB of JSON) and %d JSON packs (%d KiB), best of %d runs",
+            bench_levels.count, (int)(bench_levels.bytes / 1024),
+            bench_packs.count,  (int)(bench_packs.bytes / 1024),
+            JSON_BENCH_RUNS);
+
+    bench_validate();
+
+    /* level_from_json() warnings would swamp the results */
+    options->verbose = false;
+
+    level_t **levels = calloc(bench_levels.count, sizeof(level_t *));
+    for (int i=0; i<bench_levels.count; i++) {
+        levels[i] = create_level(NULL);
+    }
+
+    double level_cjson   = bench_levels_run(false, levels);
+    double level_stream  = bench_levels_run(true,  levels);
+    double header_cjson  = bench_headers_run(false);
+    double header_stream = bench_headers_run(true);
+
+    for (int i=0; i<bench_levels.count; i++) {
+        destroy_level(levels[i]);
+    }
+    free(levels);
+
+    bench_report("levels", &bench_levels, level_cjson, level_stream);
+    bench_report("headers", &bench_levels, header_cjson, header_stream);
+
+    if (bench_packs.count) {
+        double pack_cjson  = bench_packs_run(false);
+        double pack_stream = bench_packs_run(true);
+        bench_report("packs", &bench_packs, pack_cjson, pack_stream);
+    }
+
+    infomsg("BENCHMARK: %d mismatches, %d inputs fall back to cJSON",
+            bench_mismatches, bench_fallbacks);
+
+    rv = (0 == bench_mismatches);
+
+  bench_cleanup:
+    options->verbose = save_verbose;
+
+    bench_list_free(&bench_levels);
+    bench_list_free(&bench_packs);
+
+    return rv;
+}
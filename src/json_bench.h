@@ -0,0 +1,33 @@
+/****************************************************************************
+ *                                                                          *
+ * json_bench.h                                                             *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef JSON_BENCH_H
+#define JSON_BENCH_H
+
+/*
+ * Reads every level file and pack in the paths given on the command
+ * line (--benchmark-json) with both the streaming JSON reader and
+ * cJSON, checks that they agree, and compares their speed. Runs
+ * before the window is opened.
+ */
+bool run_json_benchmark(void);
+
+#endif /*JSON_BENCH_H*/
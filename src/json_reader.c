@@ -0,0 +1,470 @@
+/****************************************************************************
+ *                                                                          *
+ * json_reader.c                                                            *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <limits.h>
+
+#include "cJSON/cJSON.h"
+#include "json_reader.h"
+
+#define JSON_READER_NUMBER_MAXLEN 64
+
+static const char *skip_whitespace(const char *p)
+{
+    while (*p && ((unsigned char)*p <= 32)) {
+        p++;
+    }
+    return p;
+}
+
+static bool json_reader_fail(json_reader_t *r)
+{
+    r->ok = false;
+    return false;
+}
+
+void init_json_reader(json_reader_t *r, const char *str)
+{
+    assert_not_null(r);
+
+    memset(r, 0, sizeof(*r));
+
+    if (NULL == str) {
+        r->pos = "";
+        return;
+    }
+
+    if (0 == strncmp(str, "\xEF\xBB\xBF", 3)) {
+        str += 3;
+    }
+
+    r->pos = str;
+    r->ok = true;
+}
+
+void cleanup_json_reader(json_reader_t *r)
+{
+    assert_not_null(r);
+
+    SAFEFREE(r->buf);
+    r->buf_size = 0;
+}
+
+json_reader_type_t json_reader_peek(json_reader_t *r)
+{
+    if (!r->ok) {
+        return JSON_READER_NONE;
+    }
+
+    r->pos = skip_whitespace(r->pos);
+
+    switch (*r->pos) {
+    case '{':
+        return JSON_READER_OBJECT;
+    case '[':
+        return JSON_READER_ARRAY;
+    case '"':
+        return JSON_READER_STRING;
+    case '-':
+        return JSON_READER_NUMBER;
+    case 't':
+        return (0 == strncmp(r->pos, "true", 4)) ? JSON_READER_BOOL : JSON_READER_NONE;
+    case 'f':
+        return (0 == strncmp(r->pos, "false", 5)) ? JSON_READER_BOOL : JSON_READER_NONE;
+    case 'n':
+        return (0 == strncmp(r->pos, "null", 4)) ? JSON_READER_NULL : JSON_READER_NONE;
+    default:
+        if ((*r->pos >= '0') && (*r->pos <= '9')) {
+            return JSON_READER_NUMBER;
+        }
+        return JSON_READER_NONE;
+    }
+}
+
+/* where the next value starts, for callers that keep its raw text */
+const char *json_reader_value_start(json_reader_t *r)
+{
+    json_reader_peek(r);
+    return r->pos;
+}
+
+static bool json_reader_begin(json_reader_t *r, char c)
+{
+    if (!r->ok) {
+        return false;
+    }
+
+    r->pos = skip_whitespace(r->pos);
+    if (*r->pos != c) {
+        return json_reader_fail(r);
+    }
+
+    if (r->depth >= CJSON_NESTING_LIMIT) {
+        return json_reader_fail(r);
+    }
+
+    r->pos++;
+    r->depth++;
+    r->first = true;
+    return true;
+}
+
+/* true if another member/item follows; false at the closing bracket */
+static bool json_reader_next(json_reader_t *r, char close)
+{
+    if (!r->ok) {
+        return false;
+    }
+
+    r->pos = skip_whitespace(r->pos);
+
+    if (*r->pos == close) {
+        r->pos++;
+        r->depth--;
+        /* the container was a value of its parent, which had at
+         * least this one member */
+        r->first = false;
+        return false;
+    }
+
+    if (r->first) {
+        r->first = false;
+    } else if (*r->pos == ',') {
+        r->pos++;
+    } else {
+        return json_reader_fail(r);
+    }
+
+    return true;
+}
+
+bool json_reader_begin_object(json_reader_t *r)
+{
+    return json_reader_begin(r, '{');
+}
+
+bool json_reader_next_key(json_reader_t *r, const char **key)
+{
+    if (!json_reader_next(r, '}')) {
+        return false;
+    }
+
+    const char *str = json_reader_string(r);
+    if (NULL == str) {
+        return false;
+    }
+
+    r->pos = skip_whitespace(r->pos);
+    if (*r->pos != ':') {
+        return json_reader_fail(r);
+    }
+    r->pos++;
+
+    if (key) {
+        *key = str;
+    }
+    return true;
+}
+
+bool json_reader_begin_array(json_reader_t *r)
+{
+    return json_reader_begin(r, '[');
+}
+
+bool json_reader_next_item(json_reader_t *r)
+{
+    return json_reader_next(r, ']');
+}
+
+static int parse_hex4(const char *p)
+{
+    int value = 0;
+
+    for (int i=0; i<4; i++) {
+        char c = p[i];
+        value <<= 4;
+        if ((c >= '0') && (c <= '9')) {
+            value |= c - '0';
+        } else if ((c >= 'a') && (c <= 'f')) {
+            value |= c - 'a' + 10;
+        } else if ((c >= 'A') && (c <= 'F')) {
+            value |= c - 'A' + 10;
+        } else {
+            return -1;
+        }
+    }
+
+    return value;
+}
+
+/* writes the UTF-8 for a \u escape at p (which points at the 'u');
+ * returns how many input bytes were used, or 0 if it is invalid */
+static int unescape_utf16(const char *p, char **out)
+{
+    int first = parse_hex4(p + 1);
+    if (first < 0) {
+        return 0;
+    }
+
+    if ((first >= 0xDC00) && (first <= 0xDFFF)) {
+        return 0;
+    }
+
+    int used = 5;
+    unsigned long codepoint = first;
+
+    if ((first >= 0xD800) && (first <= 0xDBFF)) {
+        if ((p[5] != '\\') || (p[6] != 'u')) {
+            return 0;
+        }
+        int second = parse_hex4(p + 7);
+        if ((second < 0xDC00) || (second > 0xDFFF)) {
+            return 0;
+        }
+        codepoint = 0x10000 + (((first & 0x3FF) << 10) | (second & 0x3FF));
+        used = 11;
+    }
+
+    unsigned char *o = (unsigned char *)*out;
+    if (codepoint < 0x80) {
+        *o++ = codepoint;
+    } else if (codepoint < 0x800) {
+        *o++ = 0xC0 | (codepoint >> 6);
+        *o++ = 0x80 | (codepoint & 0x3F);
+    } else if (codepoint < 0x10000) {
+        *o++ = 0xE0 | (codepoint >> 12);
+        *o++ = 0x80 | ((codepoint >> 6) & 0x3F);
+        *o++ = 0x80 | (codepoint & 0x3F);
+    } else {
+        *o++ = 0xF0 | (codepoint >> 18);
+        *o++ = 0x80 | ((codepoint >> 12) & 0x3F);
+        *o++ = 0x80 | ((codepoint >> 6) & 0x3F);
+        *o++ = 0x80 | (codepoint & 0x3F);
+    }
+    *out = (char *)o;
+
+    return used;
+}
+
+const char *json_reader_string(json_reader_t *r)
+{
+    if (JSON_READER_STRING != json_reader_peek(r)) {
+        json_reader_fail(r);
+        return NULL;
+    }
+
+    const char *start = r->pos + 1;
+    const char *end = start;
+    while (*end && (*end != '"')) {
+        if (*end == '\\') {
+            end++;
+            if (!*end) {
+                break;
+            }
+        }
+        end++;
+    }
+    if (*end != '"') {
+        json_reader_fail(r);
+        return NULL;
+    }
+
+    /* unescaping never makes a string longer */
+    size_t need = (end - start) + 1;
+    if (need > r->buf_size) {
+        r->buf_size = MAX(need, 256);
+        r->buf = realloc(r->buf, r->buf_size);
+    }
+
+    const char *p = start;
+    char *out = r->buf;
+    while (p < end) {
+        if (*p != '\\') {
+            *out++ = *p++;
+            continue;
+        }
+
+        switch (p[1]) {
+        case 'b':  *out++ = '\b'; break;
+        case 'f':  *out++ = '\f'; break;
+        case 'n':  *out++ = '\n'; break;
+        case 'r':  *out++ = '\r'; break;
+        case 't':  *out++ = '\t'; break;
+        case '"':  *out++ = '"';  break;
+        case '\\': *out++ = '\\'; break;
+        case '/':  *out++ = '/';  break;
+
+        case 'u': {
+            if ((end - p) < 6) {
+                json_reader_fail(r);
+                return NULL;
+            }
+            int used = unescape_utf16(p + 1, &out);
+            if (!used || ((p + 1 + used) > end)) {
+                json_reader_fail(r);
+                return NULL;
+            }
+            p += 1 + used;
+            continue;
+        }
+
+        default:
+            json_reader_fail(r);
+            return NULL;
+        }
+        p += 2;
+    }
+    *out = '\0';
+
+    r->pos = end + 1;
+    return r->buf;
+}
+
+bool json_reader_number(json_reader_t *r, double *value)
+{
+    if (JSON_READER_NUMBER != json_reader_peek(r)) {
+        return json_reader_fail(r);
+    }
+
+    /* most numbers in the level schema are small integers */
+    const char *p = r->pos;
+    bool negative = (*p == '-');
+    if (negative) {
+        p++;
+    }
+    if ((*p >= '0') && (*p <= '9')) {
+        const char *digits = p;
+        long n = 0;
+        while ((*p >= '0') && (*p <= '9') && ((p - digits) < 9)) {
+            n = (n * 10) + (*p - '0');
+            p++;
+        }
+        if (!strchr("0123456789+-eE.", *p) || !*p) {
+            r->pos = p;
+            *value = negative ? -(double)n : (double)n;
+            return true;
+        }
+    }
+
+    /* the same characters cJSON hands to strtod() */
+    char num[JSON_READER_NUMBER_MAXLEN];
+    size_t len = 0;
+    while ((len < (sizeof(num) - 1)) && r->pos[len] &&
+           strchr("0123456789+-eE.", r->pos[len])) {
+        num[len] = r->pos[len];
+        len++;
+    }
+    num[len] = '\0';
+
+    char *num_end = NULL;
+    double d = strtod(num, &num_end);
+    if (num_end == num) {
+        return json_reader_fail(r);
+    }
+
+    r->pos += num_end - num;
+    *value = d;
+    return true;
+}
+
+/* clamped like cJSON's valueint */
+bool json_reader_int(json_reader_t *r, int *value)
+{
+    double d;
+    if (!json_reader_number(r, &d)) {
+        return false;
+    }
+
+    if (d >= INT_MAX) {
+        *value = INT_MAX;
+    } else if (d <= (double)INT_MIN) {
+        *value = INT_MIN;
+    } else {
+        *value = (int)d;
+    }
+
+    return true;
+}
+
+bool json_reader_bool(json_reader_t *r, bool *value)
+{
+    if (JSON_READER_BOOL != json_reader_peek(r)) {
+        return json_reader_fail(r);
+    }
+
+    if (*r->pos == 't') {
+        *value = true;
+        r->pos += 4;
+    } else {
+        *value = false;
+        r->pos += 5;
+    }
+
+    return true;
+}
+
+bool json_reader_skip(json_reader_t *r)
+{
+    switch (json_reader_peek(r)) {
+    case JSON_READER_OBJECT:
+        if (!json_reader_begin_object(r)) {
+            return false;
+        }
+        while (json_reader_next_key(r, NULL)) {
+            if (!json_reader_skip(r)) {
+                return false;
+            }
+        }
+        return r->ok;
+
+    case JSON_READER_ARRAY:
+        if (!json_reader_begin_array(r)) {
+            return false;
+        }
+        while (json_reader_next_item(r)) {
+            if (!json_reader_skip(r)) {
+                return false;
+            }
+        }
+        return r->ok;
+
+    case JSON_READER_STRING:
+        return NULL != json_reader_string(r);
+
+    case JSON_READER_NUMBER: {
+        double d;
+        return json_reader_number(r, &d);
+    }
+
+    case JSON_READER_BOOL: {
+        bool b;
+        return json_reader_bool(r, &b);
+    }
+
+    case JSON_READER_NULL:
+        r->pos += 4;
+        return true;
+
+    default:
+        return json_reader_fail(r);
+    }
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+ *                                                                          *
+ * json_reader.h                                                            *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+/*
+ * Pull style JSON reader that walks the text in place instead of
+ * building a cJSON tree, for the schemas that are loaded often
+ * (levels, tiles, collection packs).
+ *
+ * It accepts the same input cJSON_Parse() does: a leading UTF-8 BOM
+ * is skipped, any byte <= 32 is whitespace, trailing data after the
+ * root value is ignored, and nesting stops at CJSON_NESTING_LIMIT.
+ * Any syntax error or a value of the wrong type clears the ok flag
+ * and every call after that fails, so a schema reader can bail out
+ * and let the cJSON path report what is wrong.
+ *
+ * Strings (keys and values) are unescaped into a buffer owned by the
+ * reader that is only valid until the next string is read.
+ */
+
+enum json_reader_type {
+    JSON_READER_NONE = 0,
+    JSON_READER_OBJECT,
+    JSON_READER_ARRAY,
+    JSON_READER_STRING,
+    JSON_READER_NUMBER,
+    JSON_READER_BOOL,
+    JSON_READER_NULL
+};
+typedef enum json_reader_type json_reader_type_t;
+
+struct json_reader {
+    const char *pos;
+    bool ok;
+    bool first;
+    int depth;
+
+    char *buf;
+    size_t buf_size;
+};
+typedef struct json_reader json_reader_t;
+
+void init_json_reader(json_reader_t *r, const char *str);
+void cleanup_json_reader(json_reader_t *r);
+
+json_reader_type_t json_reader_peek(json_reader_t *r);
+const char *json_reader_value_start(json_reader_t *r);
+
+bool json_reader_begin_object(json_reader_t *r);
+bool json_reader_next_key(json_reader_t *r, const char **key);
+bool json_reader_begin_array(json_reader_t *r);
+bool json_reader_next_item(json_reader_t *r);
+
+const char *json_reader_string(json_reader_t *r);
+bool json_reader_number(json_reader_t *r, double *value);
+bool json_reader_int(json_reader_t *r, int *value);
+bool json_reader_bool(json_reader_t *r, bool *value);
+bool json_reader_skip(json_reader_t *r);
+
+#endif /*JSON_READER_H*/
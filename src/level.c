@@ -34,18 +34,27 @@
 #include "tile_pos.h"
 #include "level.h"
 #include "level_undo.h"
+#include "level_undo_log.h"
+#include "hex_grid.h"
 #include "collection.h"
+#include "collection_pack.h"
 #include "nvdata.h"
 #include "nvdata_finished.h"
 #include "gui_random.h"
 #include "win_anim.h"
 #include "solver.h"
 #include "blueprint_string.h"
+#include "dir_cache.h"
+#include "save_queue.h"
+#include "json_reader.h"
+#include "redraw.h"
 
 
 //#define DEBUG_DRAG_AND_DROP 1
 //#define DEBUG_LEVEL_FADE
 
+static void level_lru_remove(level_t *level);
+
 void print_level(level_t *level)
 {
     if (!level) {
@@ -64,7 +73,7 @@ void print_level_tiles(level_t *level)
     level_sort_tiles(level);
 
     printf("Level \"%s\" tiles:\n", level->name);
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
+    for (int i=0; i<level->grid->maxtiles; i++) {
         tile_t *tile = level->sorted_tiles[i];
         printf("%02d: ", i);
         print_tile(tile);
@@ -75,7 +84,7 @@ void print_tile_solved_positionss(level_t *level)
 {
     printf("Level \"%s\" solved tile positionss:\n", level->name);
 
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_pos_t *pos = &level->solved_positions[i];
         printf("idx=%02d [%d, %d] ", i, pos->position.q, pos->position.r);
         print_tile(pos->tile);
@@ -86,7 +95,7 @@ void print_tile_unsolved_positionss(level_t *level)
 {
     printf("Level \"%s\" unsolved tile positionss:\n", level->name);
 
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_pos_t *pos = &level->unsolved_positions[i];
         printf("idx=%02d [%d, %d] ", i, pos->position.q, pos->position.r);
         print_tile(pos->tile);
@@ -226,29 +235,45 @@ static void level_disable_current_tile_callback(hex_axial_t axial, void *data)
     }
 }
 
-int hex_axial_to_idx(hex_axial_t axial)
+int level_axial_to_idx(level_t *level, hex_axial_t axial)
+{
+    return (axial.q * level->grid->width) + axial.r;
+}
+
+static inline tile_pos_t *tile_pos_at_idx(tile_pos_t *positions, int idx)
 {
-    return (axial.q * TILE_LEVEL_WIDTH) + axial.r;
+    return (idx == HEX_GRID_OFF_BOARD) ? NULL : &positions[idx];
 }
 
-#define RETURN_NULL_IF_OUT_OF_BOUNDS                       \
-    if ((axial.r < 0) || (axial.r >= TILE_LEVEL_HEIGHT) || \
-        (axial.q < 0) || (axial.q >= TILE_LEVEL_WIDTH)) {  \
-        return NULL;                                       \
+tile_pos_t *level_get_current_positions(level_t *level)
+{
+    switch (level->currently_used_tiles) {
+    case USED_TILES_NULL:
+        assert(false && "not using any tile set");
+        __builtin_unreachable();
+        return NULL;
+
+    case USED_TILES_SOLVED:
+        return level->solved_positions;
+
+    case USED_TILES_UNSOLVED:
+        return level->unsolved_positions;
     }
 
+    __builtin_unreachable();
+    return NULL;
+}
+
 tile_pos_t *level_get_solved_tile_pos(level_t *level,  hex_axial_t axial)
 {
     assert_not_null(level);
-    RETURN_NULL_IF_OUT_OF_BOUNDS;
-    return &level->solved_positions[hex_axial_to_idx(axial)];
+    return tile_pos_at_idx(level->solved_positions, hex_grid_idx(level->grid, axial));
 }
 
 tile_pos_t *level_get_unsolved_tile_pos(level_t *level,  hex_axial_t axial)
 {
     assert_not_null(level);
-    RETURN_NULL_IF_OUT_OF_BOUNDS;
-    return &level->unsolved_positions[hex_axial_to_idx(axial)];
+    return tile_pos_at_idx(level->unsolved_positions, hex_grid_idx(level->grid, axial));
 }
 
 void level_use_solved_tile_pos(level_t *level)
@@ -320,47 +345,86 @@ static void update_neighbor_groups(tile_pos_t *pos)
     }
 }
 
-static level_t *init_level(level_t *level)
+static void level_free_grid(level_t *level)
 {
-    assert_not_null(level);
+    SAFEFREE(level->tiles);
+    SAFEFREE(level->sorted_tiles);
+    SAFEFREE(level->enabled_tiles);
+    SAFEFREE(level->solved_positions);
+    SAFEFREE(level->unsolved_positions);
+    SAFEFREE(level->enabled_positions);
+    level->grid = NULL;
+}
 
-    memset(level, 0, sizeof(level_t));
+/*
+ * (Re)allocates the tile and slot storage for a grid of grid_radius.
+ * Every tile starts out in the slot with the same index in both the
+ * solved and unsolved positions.
+ */
+static void level_alloc_grid(level_t *level, int grid_radius)
+{
+    level_free_grid(level);
 
-    gen_unique_id(level->unique_id);
+    hex_grid_t *grid = get_hex_grid(grid_radius);
 
-    level->center = LEVEL_CENTER_POSITION;
+    level->grid   = grid;
+    level->center = grid->center;
 
-    int i=0;
-    for (int q=0; q<TILE_LEVEL_WIDTH; q++) {
-        for (int r=0; r<TILE_LEVEL_HEIGHT; r++) {
-            assert(i < LEVEL_MAXTILES);
+    level->tiles              = calloc(grid->maxtiles, sizeof(tile_t));
+    level->sorted_tiles       = calloc(grid->maxtiles, sizeof(tile_t *));
+    level->enabled_tiles      = calloc(grid->maxtiles, sizeof(tile_t *));
+    level->solved_positions   = calloc(grid->maxtiles, sizeof(tile_pos_t));
+    level->unsolved_positions = calloc(grid->maxtiles, sizeof(tile_pos_t));
+    level->enabled_positions  = calloc(grid->maxtiles, sizeof(tile_pos_t *));
 
-            hex_axial_t addr = {
-                .q = q,
-                .r = r
-            };
+    for (int i=0; i<grid->maxtiles; i++) {
+        hex_axial_t addr = grid->axial[i];
 
-            init_tile(&level->tiles[i]);
-            level->tiles[i].id = i;
+        init_tile(&level->tiles[i]);
+        level->tiles[i].id = i;
 
-            init_tile_pos(&level->solved_positions[i], &level->tiles[i], addr);
-            init_tile_pos(&level->unsolved_positions[i], &level->tiles[i], addr);
+        init_tile_pos(&level->solved_positions[i], &level->tiles[i], addr);
+        init_tile_pos(&level->unsolved_positions[i], &level->tiles[i], addr);
 
-            level->sorted_tiles[i] = &(level->tiles[i]);
+        level->sorted_tiles[i] = &(level->tiles[i]);
 
-            level->tiles[i].solved_pos   = &level->solved_positions[i];
-            level->tiles[i].unsolved_pos = &level->unsolved_positions[i];
+        level->tiles[i].solved_pos   = &level->solved_positions[i];
+        level->tiles[i].unsolved_pos = &level->unsolved_positions[i];
 
-            level->solved_positions[i].solved = true;
-            level->unsolved_positions[i].solved = false;
+        level->solved_positions[i].solved = true;
+        level->unsolved_positions[i].solved = false;
 
-            level->solved_positions[i].center_distance =
-                hex_axial_distance(level->solved_positions[i].position, level->center);
-            level->unsolved_positions[i].center_distance =
-                hex_axial_distance(level->unsolved_positions[i].position, level->center);
+        level->solved_positions[i].center_distance =
+            hex_axial_distance(level->solved_positions[i].position, level->center);
+        level->unsolved_positions[i].center_distance =
+            hex_axial_distance(level->unsolved_positions[i].position, level->center);
+    }
+
+    for (int i=0; i<grid->maxtiles; i++) {
+        tile_pos_t *solved_pos   = &level->solved_positions[i];
+        tile_pos_t *unsolved_pos = &level->unsolved_positions[i];
 
-            i++;
+        for (hex_direction_t dir = 0; dir < 6; dir++) {
+            solved_pos->neighbors[dir]   = level_find_solved_neighbor_tile_pos(  level,   solved_pos, dir);
+            unsolved_pos->neighbors[dir] = level_find_unsolved_neighbor_tile_pos(level, unsolved_pos, dir);
         }
+
+        update_neighbor_groups(solved_pos);
+        update_neighbor_groups(unsolved_pos);
+    }
+}
+
+static level_t *init_level(level_t *level, bool stub)
+{
+    assert_not_null(level);
+
+    memset(level, 0, sizeof(level_t));
+
+    gen_unique_id(level->unique_id);
+
+    level->stub = stub;
+    if (!stub) {
+        level_alloc_grid(level, LEVEL_DEFAULT_GRID_RADIUS);
     }
 
     level->name[0] = '\0';
@@ -411,45 +475,11 @@ static level_t *init_level(level_t *level)
 
     level->radius = LEVEL_MIN_RADIUS;
 
-    for (int q=0; q<TILE_LEVEL_WIDTH; q++) {
-        for (int r=0; r<TILE_LEVEL_HEIGHT; r++) {
-            hex_axial_t addr = {
-                .q = q,
-                .r = r
-            };
-
-            tile_pos_t *solved_pos   = level_get_solved_tile_pos(level, addr);
-            tile_pos_t *unsolved_pos = level_get_unsolved_tile_pos(level, addr);
-
-            for (hex_direction_t dir = 0; dir < 6; dir++) {
-                solved_pos->neighbors[dir]   = level_find_solved_neighbor_tile_pos(  level,   solved_pos, dir);
-                unsolved_pos->neighbors[dir] = level_find_unsolved_neighbor_tile_pos(level, unsolved_pos, dir);
-
-#if 0
-                hex_axial_t sn = hex_axial_neighbor(  solved_pos->position, dir);
-                hex_axial_t un = hex_axial_neighbor(unsolved_pos->position, dir);
-
-                printf("  solved_pos->neighbors[%d] = %9p  <% 2d,% 2d> -> <% 2d,% 2d>\n",
-                       dir,   solved_pos->neighbors[dir],
-                       solved_pos->position.q, solved_pos->position.r,
-                       sn.q, sn.r);
-                printf("unsolved_pos->neighbors[%d] = %9p  <% 2d,% 2d> -> <% 2d,% 2d>\n",
-                       dir, unsolved_pos->neighbors[dir],
-                       unsolved_pos->position.q, unsolved_pos->position.r,
-                       un.q, un.r);
-#endif
-            }
-
-            update_neighbor_groups(solved_pos);
-            update_neighbor_groups(unsolved_pos);
-        }
-    }
-
 #if 0
     printf("<level name=\"%s\">\n", level->name);
     printf("  <neighbors tiles=SOLVED>\n");
 
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_pos_t *solved_pos   = &level->solved_positions[i];
         printf("    ");
         print_tile_pos(solved_pos);
@@ -462,7 +492,7 @@ static level_t *init_level(level_t *level)
     }
     printf("  </neighbors>\n");
     printf("  <neighbors tiles=UNSOLVED>\n");
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_pos_t *unsolved_pos = &level->unsolved_positions[i];
         printf("    ");
         print_tile_pos(unsolved_pos);
@@ -477,7 +507,9 @@ static level_t *init_level(level_t *level)
     printf("</level>\n");
 #endif
 
-    level_reset(level);
+    if (!stub) {
+        level_reset(level);
+    }
 
     return level;
 }
@@ -485,13 +517,20 @@ static level_t *init_level(level_t *level)
 static level_t *alloc_level(void)
 {
     level_t *level = calloc(1, sizeof(level_t));
-    init_level(level);
+    init_level(level, false);
+    return level;
+}
+
+static level_t *alloc_level_stub(void)
+{
+    level_t *level = calloc(1, sizeof(level_t));
+    init_level(level, true);
     return level;
 }
 
 void level_backup_unsolved_tiles(level_t *level)
 {
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_pos_t *pos = &level->unsolved_positions[i];
         pos->orig_tile = pos->tile;
     }
@@ -501,7 +540,7 @@ static void level_reset_unsolved_tiles(level_t *level)
 {
     assert_not_null(level);
 
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_pos_t *pos = &level->unsolved_positions[i];
         pos->tile = pos->orig_tile;
         pos->tile->unsolved_pos = pos;
@@ -521,7 +560,7 @@ void level_reset(level_t *level)
     level->hover_section_adjacency_radius = 16.0;
     level->drag_target = NULL;
 
-    level->center = LEVEL_CENTER_POSITION;
+    level->center = level->grid->center;
 
     level_resize(level);
 
@@ -536,9 +575,10 @@ void level_reset(level_t *level)
     level_use_null_tile_pos(level);
 
     if (level->undo) {
-        destroy_level_undo(level->undo);
+        reset_level_undo(level->undo);
+    } else {
+        level->undo = create_level_undo(level);
     }
-    level->undo = create_level_undo(level);
 }
 
 void level_reset_tile_positions(level_t *level)
@@ -560,11 +600,15 @@ void level_update_id(level_t *level)
     } else {
         level->have_id = false;
     }
+
+    if (level->in_collection) {
+        collection_reindex_level(level->collection, level);
+    }
 }
 
 void level_update_path_counts(level_t *level)
 {
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_t *tile = &(level->tiles[i]);
         tile_update_path_count(tile);
     }
@@ -639,16 +683,25 @@ void destroy_level(level_t *level)
         SAFEFREE(level->loadpath);
         SAFEFREE(level->gen_param);
         SAFEFREE(level->blueprint);
+        if (level->pack_data) {
+            MemFree(level->pack_data);
+        }
+        level_lru_remove(level);
+        level_free_grid(level);
         SAFEFREE(level);
     }
 }
 
 bool level_eq_tiles(level_t *level, level_t *other)
 {
+    if (level->grid != other->grid) {
+        return false;
+    }
+
     level_sort_tiles(level);
     level_sort_tiles(other);
 
-    for (int i=0; i < LEVEL_MAXTILES; i++) {
+    for (int i=0; i < level->grid->maxtiles; i++) {
         tile_t *level_tile = level->sorted_tiles[i];
         tile_t *other_tile = other->sorted_tiles[i];
 
@@ -662,16 +715,16 @@ bool level_eq_tiles(level_t *level, level_t *other)
 
 void level_sort_tiles(level_t *level)
 {
-    qsort(level->sorted_tiles, LEVEL_MAXTILES, sizeof(level_t *), compare_tiles);
+    qsort(level->sorted_tiles, level->grid->maxtiles, sizeof(level_t *), compare_tiles);
 }
 
 int level_get_enabled_tiles(level_t *level)
 {
-    memset(level->enabled_tiles, 0, sizeof(level->enabled_tiles));
+    memset(level->enabled_tiles, 0, level->grid->maxtiles * sizeof(tile_t *));
 
     int num_enabled = 0;
 
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
+    for (int i=0; i<level->grid->maxtiles; i++) {
         tile_t *tile = &(level->tiles[i]);
         if (tile->enabled) {
             level->enabled_tiles[num_enabled] = tile;
@@ -684,7 +737,7 @@ int level_get_enabled_tiles(level_t *level)
 
 int level_get_enabled_positions(level_t *level)
 {
-    memset(level->enabled_positions, 0, sizeof(level->enabled_positions));
+    memset(level->enabled_positions, 0, level->grid->maxtiles * sizeof(tile_pos_t *));
 
     int num_enabled = 0;
 
@@ -697,7 +750,7 @@ int level_get_enabled_positions(level_t *level)
         break;
 
     case USED_TILES_SOLVED:
-        for (int i=0; i<LEVEL_MAXTILES; i++) {
+        for (int i=0; i<level->grid->maxtiles; i++) {
             tile_t *tile = &(level->tiles[i]);
             if (tile->enabled) {
                 level->enabled_positions[num_enabled] = tile->solved_pos;
@@ -707,7 +760,7 @@ int level_get_enabled_positions(level_t *level)
         break;
 
     case USED_TILES_UNSOLVED:
-        for (int i=0; i<LEVEL_MAXTILES; i++) {
+        for (int i=0; i<level->grid->maxtiles; i++) {
             tile_t *tile = &(level->tiles[i]);
             if (tile->enabled) {
                 level->enabled_positions[num_enabled] = tile->unsolved_pos;
@@ -722,7 +775,7 @@ int level_get_enabled_positions(level_t *level)
 
 int level_get_movable_positions(level_t *level)
 {
-    memset(level->enabled_positions, 0, sizeof(level->enabled_positions));
+    memset(level->enabled_positions, 0, level->grid->maxtiles * sizeof(tile_pos_t *));
 
     int num_movable = 0;
 
@@ -732,7 +785,7 @@ int level_get_movable_positions(level_t *level)
         break;
 
     case USED_TILES_SOLVED:
-        for (int i=0; i<LEVEL_MAXTILES; i++) {
+        for (int i=0; i<level->grid->maxtiles; i++) {
             tile_t *tile = &(level->tiles[i]);
             if (tile->enabled) {
                 level->enabled_positions[num_movable] = tile->solved_pos;
@@ -742,7 +795,7 @@ int level_get_movable_positions(level_t *level)
         break;
 
     case USED_TILES_UNSOLVED:
-        for (int i=0; i<LEVEL_MAXTILES; i++) {
+        for (int i=0; i<level->grid->maxtiles; i++) {
             tile_t *tile = &(level->tiles[i]);
             if (tile->enabled && !tile->fixed && !tile->hidden) {
                 level->enabled_positions[num_movable] = tile->unsolved_pos;
@@ -757,28 +810,13 @@ int level_get_movable_positions(level_t *level)
 
 tile_pos_t *level_get_center_tile_pos(level_t *level)
 {
-    return level_get_current_tile_pos(level, LEVEL_CENTER_POSITION);
+    return level_get_current_tile_pos(level, level->center);
 }
 
 tile_pos_t *level_get_current_tile_pos(level_t *level,  hex_axial_t axial)
 {
     assert_not_null(level);
-    RETURN_NULL_IF_OUT_OF_BOUNDS;
-    switch (level->currently_used_tiles) {
-    case USED_TILES_NULL:
-        assert(false && "not using any tile set");
-        __builtin_unreachable();
-        return NULL;
-
-    case USED_TILES_SOLVED:
-        return level_get_solved_tile_pos(level, axial);
-
-    case USED_TILES_UNSOLVED:
-        return level_get_unsolved_tile_pos(level, axial);
-    }
-
-    __builtin_unreachable();
-    return NULL;
+    return tile_pos_at_idx(level_get_current_positions(level), hex_grid_idx(level->grid, axial));
 }
 
 tile_t *level_get_tile(level_t *level,  hex_axial_t axial)
@@ -804,6 +842,12 @@ bool level_parse_string(level_t *level, const char *str)
     assert_not_null(level);
     assert_not_null(str);
 
+    if (level_read_json(level, str)) {
+        return true;
+    }
+
+    /* the streaming reader gives up quietly; the cJSON path reports
+     * the problem and fills in any replacement fields */
     cJSON *json = cJSON_Parse(str);
     bool rv = level_from_json(level, json);
     cJSON_Delete(json);
@@ -816,6 +860,9 @@ void level_set_name(level_t *level, const char *name)
     if (level->collection) {
         collection_update_level_names(level->collection);
     }
+    if (level->in_collection) {
+        collection_reindex_level(level->collection, level);
+    }
 }
 
 void level_set_file_path(level_t *level, const char *path)
@@ -826,6 +873,10 @@ void level_set_file_path(level_t *level, const char *path)
     level->dirpath  = strdup(dirname(dirc));
     free(basec);
     free(dirc);
+
+    if (level->in_collection) {
+        collection_reindex_level(level->collection, level);
+    }
 }
 
 level_t *load_level_string(const char *filename, const char *str, bool is_pack)
@@ -894,6 +945,7 @@ level_t *load_level_file(const char *filename)
 {
     assert_not_null(filename);
 
+    save_queue_wait_for_path(filename);
     char *str = LoadFileText(filename);
     if (NULL == str) {
         errmsg("Error reading level file \"%s\"", filename);
@@ -913,6 +965,403 @@ level_t *load_level_file(const char *filename)
     return level;
 }
 
+/*
+ * Reads the level object at r, keeping only what a stub needs. Like
+ * cJSON_Parse() followed by cJSON_GetObjectItem(), the whole object
+ * has to be valid JSON and the first (case insensitive) match of each
+ * name wins.
+ */
+static bool read_level_json_header(json_reader_t *r, level_file_header_t *header)
+{
+    bool seen_name      = false;
+    bool seen_unique_id = false;
+    bool seen_radius    = false;
+    bool have_name      = false;
+    bool have_unique_id = false;
+    const char *key;
+
+    header->have_header = false;
+    header->radius = 0;
+
+    if (!json_reader_begin_object(r)) {
+        return false;
+    }
+
+    while (json_reader_next_key(r, &key)) {
+        if (!seen_name && (0 == strcasecmp(key, "name"))) {
+            seen_name = true;
+            if (JSON_READER_STRING == json_reader_peek(r)) {
+                const char *value = json_reader_string(r);
+                if (value) {
+                    snprintf(header->name, NAME_MAXLEN, "%s", value);
+                    have_name = true;
+                }
+                continue;
+            }
+        } else if (!seen_unique_id && (0 == strcasecmp(key, "unique_id"))) {
+            seen_unique_id = true;
+            if (JSON_READER_STRING == json_reader_peek(r)) {
+                const char *value = json_reader_string(r);
+                if (value) {
+                    snprintf(header->unique_id, UNIQUE_ID_LENGTH, "%s", value);
+                    have_unique_id = true;
+                }
+                continue;
+            }
+        } else if (!seen_radius && (0 == strcasecmp(key, "radius"))) {
+            seen_radius = true;
+            if (JSON_READER_NUMBER == json_reader_peek(r)) {
+                json_reader_int(r, &header->radius);
+                continue;
+            }
+        }
+
+        json_reader_skip(r);
+    }
+
+    if (!r->ok) {
+        header->radius = 0;
+        return false;
+    }
+
+    header->have_header = have_name && have_unique_id;
+    return true;
+}
+
+/* safe to call from a worker thread */
+void parse_level_file_header(const char *str, level_file_header_t *header, bool keep_data)
+{
+    assert_not_null(str);
+    assert_not_null(header);
+
+    json_reader_t r;
+    init_json_reader(&r, str);
+    read_level_json_header(&r, header);
+    cleanup_json_reader(&r);
+
+    if (keep_data && header->have_header) {
+        int size = 0;
+        header->data = CompressData((const unsigned char *)str, strlen(str) + 1, &size);
+        header->data_size = header->data ? size : 0;
+    }
+}
+
+/* only reads the file; safe to call from a worker thread */
+void read_level_file_header(const char *filename, level_file_header_t *header)
+{
+    assert_not_null(filename);
+    assert_not_null(header);
+
+    header->read_ok = false;
+    header->have_header = false;
+
+    save_queue_wait_for_path(filename);
+    char *str = LoadFileText(filename);
+    if (NULL == str) {
+        return;
+    }
+    header->read_ok = true;
+
+    parse_level_file_header(str, header, false);
+    UnloadFileText(str);
+}
+
+level_t *create_level_file_stub(const char *filename, level_file_header_t *header)
+{
+    assert_not_null(filename);
+    assert_not_null(header);
+
+    if (!header->read_ok) {
+        errmsg("Error reading level file \"%s\"", filename);
+        return NULL;
+    }
+
+    if (!header->have_header) {
+        /* let the full parser report the problem and fill in replacements */
+        return load_level_file(filename);
+    }
+
+    level_t *level = alloc_level_stub();
+    snprintf(level->name, NAME_MAXLEN, "%s", header->name);
+    snprintf(level->unique_id, UNIQUE_ID_LENGTH, "%s", header->unique_id);
+
+    level_set_file_path(level, filename);
+    level->source = LEVEL_SOURCE_LEVEL_FILE;
+    level->loaded_from_file = true;
+    level->loadpath = strdup(filename);
+    level->savepath = strdup(filename);
+
+    if (header->data) {
+        /* the stub takes over the cached data */
+        level->pack_data    = header->data;
+        level->pack_size    = header->data_size;
+        level->source_size  = header->file_size;
+        level->source_mtime = header->file_mtime;
+        header->data = NULL;
+        header->data_size = 0;
+    }
+
+    return level;
+}
+
+level_t *load_level_file_stub(const char *filename)
+{
+    level_file_header_t header = {0};
+    read_level_file_header(filename, &header);
+    return create_level_file_stub(filename, &header);
+}
+
+level_t *create_level_stub(const char *filename, level_source_t source)
+{
+    assert_not_null(filename);
+
+    level_t *level = alloc_level_stub();
+    level->dirpath = strdup(LEVEL_PACK_DIRPATH_MARKER);
+    level->filename = strdup(filename);
+    level->stored_in_collection = true;
+    level->source = source;
+
+    return level;
+}
+
+/* keeps the level's JSON compressed in memory until it is first used */
+level_t *load_level_json_stub(const char *filename, cJSON *json)
+{
+    assert_not_null(filename);
+
+    cJSON *name_json      = cJSON_GetObjectItem(json, "name");
+    cJSON *unique_id_json = cJSON_GetObjectItem(json, "unique_id");
+
+    if (!cJSON_IsString(name_json) || !cJSON_IsString(unique_id_json)) {
+        return load_level_json(filename, json, true);
+    }
+
+    char *json_str = cJSON_PrintUnformatted(json);
+    int size = 0;
+    unsigned char *data = CompressData((const unsigned char *)json_str, strlen(json_str) + 1, &size);
+    free(json_str);
+
+    if (NULL == data) {
+        return load_level_json(filename, json, true);
+    }
+
+    level_t *level = create_level_stub(filename, LEVEL_SOURCE_PACK_DATA);
+    snprintf(level->name, NAME_MAXLEN, "%s", name_json->valuestring);
+    snprintf(level->unique_id, UNIQUE_ID_LENGTH, "%s", unique_id_json->valuestring);
+    level->pack_data = data;
+    level->pack_size = size;
+
+    return level;
+}
+
+/*
+ * load_level_json_stub() for the level object at r in a pack's JSON
+ * text, keeping the object's own text instead of printing it again.
+ * Returns NULL without a message if the level isn't valid JSON or has
+ * no name or unique_id; the pack is then loaded through cJSON.
+ */
+level_t *read_level_json_stub(const char *filename, json_reader_t *r)
+{
+    assert_not_null(filename);
+    assert_not_null(r);
+
+    const char *start = json_reader_value_start(r);
+
+    level_file_header_t header = {0};
+    if (!read_level_json_header(r, &header) || !header.have_header) {
+        return NULL;
+    }
+
+    size_t len = r->pos - start;
+    char *json_str = malloc(len + 1);
+    memcpy(json_str, start, len);
+    json_str[len] = '\0';
+
+    int size = 0;
+    unsigned char *data = CompressData((const unsigned char *)json_str, len + 1, &size);
+    free(json_str);
+
+    if (NULL == data) {
+        return NULL;
+    }
+
+    level_t *level = create_level_stub(filename, LEVEL_SOURCE_PACK_DATA);
+    snprintf(level->name, NAME_MAXLEN, "%s", header.name);
+    snprintf(level->unique_id, UNIQUE_ID_LENGTH, "%s", header.unique_id);
+    level->pack_data = data;
+    level->pack_size = size;
+
+    return level;
+}
+
+/*** materialized level LRU ***/
+
+/* most recently used first */
+static level_t *lru_head = NULL;
+static level_t *lru_tail = NULL;
+static int lru_count = 0;
+
+static bool level_lru_contains(level_t *level)
+{
+    return level->lru_prev || level->lru_next || (lru_head == level);
+}
+
+static void level_lru_remove(level_t *level)
+{
+    if (!level_lru_contains(level)) {
+        return;
+    }
+
+    if (level->lru_prev) {
+        level->lru_prev->lru_next = level->lru_next;
+    } else {
+        lru_head = level->lru_next;
+    }
+
+    if (level->lru_next) {
+        level->lru_next->lru_prev = level->lru_prev;
+    } else {
+        lru_tail = level->lru_prev;
+    }
+
+    level->lru_prev = NULL;
+    level->lru_next = NULL;
+    lru_count--;
+}
+
+static void level_lru_push(level_t *level)
+{
+    level_lru_remove(level);
+
+    level->lru_next = lru_head;
+    if (lru_head) {
+        lru_head->lru_prev = level;
+    } else {
+        lru_tail = level;
+    }
+    lru_head = level;
+    lru_count++;
+}
+
+/* only levels that would decode back to exactly their current state */
+static bool level_can_dematerialize(level_t *level)
+{
+    return (level->source != LEVEL_SOURCE_NONE)
+        && (level != current_level)
+        && !level->changed
+        && level->unplayed
+        && !level->solver
+        && !level->win_anim;
+}
+
+static void level_dematerialize(level_t *level)
+{
+    if (level->undo) {
+        destroy_level_undo(level->undo);
+        level->undo = NULL;
+    }
+
+    level_free_grid(level);
+
+    level->hover          = NULL;
+    level->hover_adjacent = NULL;
+    level->drag_target    = NULL;
+    level->enabled_tile_count = 0;
+
+    level->stub = true;
+}
+
+static void level_lru_evict(void)
+{
+    level_t *level = lru_tail;
+    while (level && (lru_count > LEVEL_MATERIALIZED_MAX)) {
+        level_t *prev = level->lru_prev;
+        if (level_can_dematerialize(level)) {
+            level_lru_remove(level);
+            level_dematerialize(level);
+        }
+        level = prev;
+    }
+}
+
+int level_materialized_count(void)
+{
+    return lru_count;
+}
+
+static bool level_decode_source(level_t *level)
+{
+    switch (level->source) {
+    case LEVEL_SOURCE_LEVEL_FILE: {
+        save_queue_wait_for_path(level->loadpath);
+
+        if (level->pack_data) {
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            if (dir_cache_stat(level->loadpath, &size, &mtime) &&
+                (size == level->source_size) && (mtime == level->source_mtime)) {
+                return collection_pack_load_level(level);
+            }
+
+            /* the file changed since its directory was scanned */
+            MemFree(level->pack_data);
+            level->pack_data = NULL;
+            level->pack_size = 0;
+        }
+
+        char *str = LoadFileText(level->loadpath);
+        if (NULL == str) {
+            return false;
+        }
+        bool rv = level_parse_string(level, str);
+        UnloadFileText(str);
+        return rv;
+    }
+
+    case LEVEL_SOURCE_PACK_FILE:
+        /* fall through */
+    case LEVEL_SOURCE_PACK_DATA:
+        return collection_pack_load_level(level);
+
+    default:
+        return false;
+    }
+}
+
+bool level_materialize(level_t *level)
+{
+    assert_not_null(level);
+
+    if (!level->stub) {
+        if (level_lru_contains(level)) {
+            level_lru_push(level);
+        }
+        return true;
+    }
+
+    /* don't retry every frame */
+    if (level->decode_failed) {
+        return false;
+    }
+
+    level->stub = false;
+    level_alloc_grid(level, LEVEL_DEFAULT_GRID_RADIUS);
+    level_reset(level);
+
+    if (!level_decode_source(level)) {
+        errmsg("Error loading level \"%s\" from \"%s\"", level->name,
+               level->loadpath ? level->loadpath : level->filename);
+        level_dematerialize(level);
+        level->decode_failed = true;
+        return false;
+    }
+
+    level_lru_push(level);
+    level_lru_evict();
+
+    return true;
+}
+
 void level_update_ui_name(level_t *level, int idx)
 {
     assert_not_null(level);
@@ -952,6 +1401,7 @@ void level_unload(void)
         }
     }
 
+    level_undo_log_detach(current_level);
     current_level = NULL;
 }
 
@@ -960,6 +1410,7 @@ void level_load(level_t *level)
     level_unload();
     current_level = level;
     level_reset(current_level);
+    level_undo_log_start(current_level);
 }
 
 void level_play_fade_in_callback(UNUSED struct level *level, UNUSED void *data)
@@ -972,6 +1423,10 @@ void level_play(level_t *level)
 {
     assert_not_null(level);
 
+    if (!level_materialize(level)) {
+        return;
+    }
+
     level_load(level);
     level_use_unsolved_tile_pos(level);
 
@@ -997,45 +1452,55 @@ void level_edit(level_t *level)
 {
     assert_not_null(level);
 
+    if (!level_materialize(level)) {
+        return;
+    }
+
     level_load(level);
     level_use_solved_tile_pos(level);
     level_fade_in(level, NULL, NULL);
     set_game_mode(GAME_MODE_EDIT_LEVEL);
 }
 
+static void level_saved_callback(const char *filepath, bool ok, UNUSED void *data)
+{
+    if (ok) {
+        popup_info_message("Level saved to \"%s\"", GetFileName(filepath));
+    } else {
+        popup_error_message("Error saving level to \"%s\"", GetFileName(filepath));
+    }
+}
+
 void level_save_to_filename(level_t *level, const char *filepath)
 {
     assert_not_null(level);
     assert_not_null(filepath);
 
-    char *tmpname;
-    safe_asprintf(&tmpname, "%s.tmp", filepath);
-
     if (options->verbose) {
-        infomsg("saving level \"%s\" to: \"%s\"", level->name, tmpname);
+        infomsg("saving level \"%s\" to: \"%s\"", level->name, filepath);
     }
 
     cJSON *json = level_to_json(level);
-    char *json_str = cJSON_PrintUnformatted(json);
-
-    SaveFileText(tmpname, json_str);
+    if (NULL == json) {
+        errmsg("Not saving level \"%s\": it couldn't be loaded", level->name);
+        return;
+    }
 
-    free(json_str);
+    char *json_str = cJSON_PrintUnformatted(json);
     cJSON_Delete(json);
 
-    if (tmpname) {
-        if (-1 == rename(tmpname, filepath)) {
-            errmsg("Error trying to rename \"%s\" to \"%s\" - ",
-                   tmpname, filepath);
-            popup_error_message("Error renaming file to \"%s\"", GetFileName(filepath));
-        } else {
-            popup_info_message("Level saved to \"%s\"", GetFileName(filepath));
-        }
+    if (NULL == json_str) {
+        errmsg("Error printing level \"%s\" as JSON", level->name);
+        return;
+    }
 
-        free(tmpname);
-    } else {
-        popup_info_message("Level saved to \"%s\"", GetFileName(filepath));
+    /* the level's source no longer matches what is being saved */
+    if ((level->source != LEVEL_SOURCE_LEVEL_FILE) ||
+        !level->loadpath || strcmp(level->loadpath, filepath)) {
+        level->source = LEVEL_SOURCE_NONE;
     }
+
+    save_queue_submit(filepath, json_str, strlen(json_str), level_saved_callback, NULL);
 }
 
 void level_save_to_file(level_t *level, const char *dirpath)
@@ -1120,7 +1585,170 @@ void level_save(level_t *level)
     }
 }
 
-#define LEVEL_JSON_VERSION 1
+/* every tile slot as an object (version 1) or only the enabled
+ * tiles in a packed form (version 2); both are read */
+#define LEVEL_JSON_VERSION_FULL   1
+#define LEVEL_JSON_VERSION_SPARSE 2
+
+/*
+ * Sparse level JSON stores each enabled tile as a [solved slot,
+ * unsolved slot, packed string] Array, with slots being hex_grid
+ * indexes. Every other slot gets a blank disabled tile, which stays
+ * in place where its slot is free in both the solved and unsolved
+ * positions.
+ */
+struct sparse_tiles {
+    bool *solved_used;
+    bool *unsolved_used;
+};
+
+static void init_sparse_tiles(level_t *level, struct sparse_tiles *st)
+{
+    st->solved_used   = calloc(level->grid->maxtiles, sizeof(bool));
+    st->unsolved_used = calloc(level->grid->maxtiles, sizeof(bool));
+    level->current_tile_write_idx = 0;
+}
+
+static void cleanup_sparse_tiles(struct sparse_tiles *st)
+{
+    SAFEFREE(st->solved_used);
+    SAFEFREE(st->unsolved_used);
+}
+
+static bool sparse_tiles_add(level_t *level, struct sparse_tiles *st, int solved_idx, int unsolved_idx, const char *packed)
+{
+    hex_grid_t *grid = level->grid;
+
+    if ((solved_idx < 0) || (solved_idx >= grid->maxtiles) ||
+        (unsolved_idx < 0) || (unsolved_idx >= grid->maxtiles) ||
+        st->solved_used[solved_idx] || st->unsolved_used[unsolved_idx] ||
+        (level->current_tile_write_idx >= grid->maxtiles)) {
+        return false;
+    }
+
+    tile_t *tile = &(level->tiles[level->current_tile_write_idx]);
+    if (!tile_from_packed_string(tile, level, grid->axial[solved_idx], grid->axial[unsolved_idx], packed)) {
+        return false;
+    }
+
+    st->solved_used[solved_idx] = true;
+    st->unsolved_used[unsolved_idx] = true;
+    level->current_tile_write_idx++;
+
+    return true;
+}
+
+static void sparse_tiles_finish(level_t *level, struct sparse_tiles *st)
+{
+    int maxtiles = level->grid->maxtiles;
+
+    for (int i=0; i<maxtiles; i++) {
+        if (!st->solved_used[i] && !st->unsolved_used[i]) {
+            sparse_tiles_add(level, st, i, i, NULL);
+        }
+    }
+
+    /* there are as many free unsolved slots as free solved slots */
+    int u = 0;
+    for (int s=0; s<maxtiles; s++) {
+        if (st->solved_used[s]) {
+            continue;
+        }
+        while (st->unsolved_used[u]) {
+            u++;
+        }
+        sparse_tiles_add(level, st, s, u, NULL);
+    }
+}
+
+static bool sparse_tiles_from_json(level_t *level, cJSON *tiles_json)
+{
+    bool rv = false;
+    struct sparse_tiles st;
+    init_sparse_tiles(level, &st);
+
+    int n = 0;
+    cJSON *tile_json;
+    cJSON_ArrayForEach(tile_json, tiles_json) {
+        cJSON *solved_json   = cJSON_IsArray(tile_json) ? cJSON_GetArrayItem(tile_json, 0) : NULL;
+        cJSON *unsolved_json = cJSON_IsArray(tile_json) ? cJSON_GetArrayItem(tile_json, 1) : NULL;
+        cJSON *packed_json   = cJSON_IsArray(tile_json) ? cJSON_GetArrayItem(tile_json, 2) : NULL;
+
+        if (!cJSON_IsNumber(solved_json) || !cJSON_IsNumber(unsolved_json) || !cJSON_IsString(packed_json)) {
+            errmsg("Error parsing level JSON: tile %d is not a [solved, unsolved, \"paths\"] Array", n);
+            goto cleanup;
+        }
+
+        if (!sparse_tiles_add(level, &st, solved_json->valueint, unsolved_json->valueint, packed_json->valuestring)) {
+            errmsg("Error parsing level JSON: tile %d has a bad slot or paths string", n);
+            goto cleanup;
+        }
+        n++;
+    }
+
+    sparse_tiles_finish(level, &st);
+    rv = true;
+
+  cleanup:
+    cleanup_sparse_tiles(&st);
+    return rv;
+}
+
+static bool read_sparse_tiles(level_t *level, json_reader_t *r)
+{
+    bool rv = false;
+    struct sparse_tiles st;
+    init_sparse_tiles(level, &st);
+
+    if (!json_reader_begin_array(r)) {
+        goto cleanup;
+    }
+
+    while (json_reader_next_item(r)) {
+        int solved_idx, unsolved_idx;
+        if (!json_reader_begin_array(r) ||
+            !json_reader_next_item(r) || !json_reader_int(r, &solved_idx) ||
+            !json_reader_next_item(r) || !json_reader_int(r, &unsolved_idx) ||
+            !json_reader_next_item(r)) {
+            goto cleanup;
+        }
+
+        const char *packed = json_reader_string(r);
+        if (!packed || !sparse_tiles_add(level, &st, solved_idx, unsolved_idx, packed)) {
+            goto cleanup;
+        }
+
+        while (json_reader_next_item(r)) {
+            json_reader_skip(r);
+        }
+    }
+
+    if (!r->ok) {
+        goto cleanup;
+    }
+
+    sparse_tiles_finish(level, &st);
+    rv = true;
+
+  cleanup:
+    cleanup_sparse_tiles(&st);
+    return rv;
+}
+
+/* sparse JSON can't hold disabled tiles that were moved or changed */
+static bool level_can_write_sparse(level_t *level)
+{
+    for (int i=0; i<level->grid->maxtiles; i++) {
+        tile_t *tile = &(level->tiles[i]);
+        if (!tile->enabled &&
+            (tile->hidden || tile->fixed || !tile_is_blank(tile) ||
+             !hex_axial_eq(tile->solved_pos->position, tile->unsolved_pos->position))) {
+            return false;
+        }
+    }
+
+    return true;
+}
 
 bool level_from_json(level_t *level, cJSON *json)
 {
@@ -1135,9 +1763,10 @@ bool level_from_json(level_t *level, cJSON *json)
         return false;
     }
 
-    if (version_json->valueint != LEVEL_JSON_VERSION) {
-        errmsg("Error parsing level JSON: 'version' is %d, expected %d",
-               version_json->valueint, LEVEL_JSON_VERSION);
+    int version = version_json->valueint;
+    if ((version != LEVEL_JSON_VERSION_FULL) && (version != LEVEL_JSON_VERSION_SPARSE)) {
+        errmsg("Error parsing level JSON: 'version' is %d, expected %d or %d",
+               version, LEVEL_JSON_VERSION_FULL, LEVEL_JSON_VERSION_SPARSE);
         return false;
     }
 
@@ -1169,15 +1798,55 @@ bool level_from_json(level_t *level, cJSON *json)
     }
     level->radius = radius_json->valueint;
 
+    if ((level->radius < LEVEL_MIN_RADIUS) || (level->radius > LEVEL_MAX_RADIUS)) {
+        errmsg("Error parsing level JSON: 'radius' is %d, expected %d to %d",
+               level->radius, LEVEL_MIN_RADIUS, LEVEL_MAX_RADIUS);
+        return false;
+    }
+
+    /* optional; only levels larger than the default grid save it */
+    int grid_radius = LEVEL_DEFAULT_GRID_RADIUS;
+    cJSON *grid_radius_json = cJSON_GetObjectItem(json, "grid_radius");
+    if (grid_radius_json) {
+        if (!cJSON_IsNumber(grid_radius_json)) {
+            errmsg("Error parsing level JSON: 'grid_radius' is not a Number");
+            return false;
+        }
+        grid_radius = grid_radius_json->valueint;
+    }
+
+    if ((grid_radius < level->radius) || (grid_radius > LEVEL_MAX_RADIUS)) {
+        errmsg("Error parsing level JSON: 'grid_radius' is %d, expected %d to %d",
+               grid_radius, level->radius, LEVEL_MAX_RADIUS);
+        return false;
+    }
+
+    if (grid_radius != level->grid->radius) {
+        level_alloc_grid(level, grid_radius);
+    }
+
     cJSON *tiles_json = cJSON_GetObjectItem(json, "tiles");
     if (!cJSON_IsArray(tiles_json)) {
         errmsg("Error parsing level JSON: 'tiles' is not an Array");
         return false;
     }
 
+    if (version == LEVEL_JSON_VERSION_SPARSE) {
+        if (!sparse_tiles_from_json(level, tiles_json)) {
+            return false;
+        }
+        level_backup_unsolved_tiles(level);
+        return true;
+    }
+
     level->current_tile_write_idx = 0;
     cJSON *tile_json;
     cJSON_ArrayForEach(tile_json, tiles_json) {
+        if (level->current_tile_write_idx >= level->grid->maxtiles) {
+            errmsg("Error parsing level JSON: more than %d tiles", level->grid->maxtiles);
+            return false;
+        }
+
         tile_t *tile = &(level->tiles[level->current_tile_write_idx]);
         if (!tile_from_json(tile, level, tile_json)) {
             errmsg("Error parsing level JSON: parsing tike %d failed", level->current_tile_write_idx);
@@ -1191,11 +1860,129 @@ bool level_from_json(level_t *level, cJSON *json)
     return true;
 }
 
+/*
+ * level_from_json() without the cJSON tree: tiles are filled in as
+ * they are read. Only handles valid levels that have the header
+ * fields before "tiles" (as level_to_json() writes them); anything
+ * else returns false without a message so level_parse_string() can
+ * fall back to level_from_json().
+ */
+bool level_read_json(level_t *level, const char *str)
+{
+    assert_not_null(level);
+    assert_not_null(str);
+
+    bool rv = false;
+    bool have_version     = false;
+    bool have_unique_id   = false;
+    bool have_name        = false;
+    bool have_radius      = false;
+    bool have_grid_radius = false;
+    bool have_tiles       = false;
+    int version = 0;
+    int radius = 0;
+    int grid_radius = LEVEL_DEFAULT_GRID_RADIUS;
+    const char *key;
+
+    json_reader_t r;
+    init_json_reader(&r, str);
+
+    if (!json_reader_begin_object(&r)) {
+        goto cleanup;
+    }
+
+    while (json_reader_next_key(&r, &key)) {
+        if (have_tiles && !have_grid_radius && (0 == strcasecmp(key, "grid_radius"))) {
+            /* the tiles were already placed in the default grid */
+            goto cleanup;
+        }
+
+        if (!have_version && (0 == strcasecmp(key, "version"))) {
+            have_version = json_reader_int(&r, &version);
+        } else if (!have_unique_id && (0 == strcasecmp(key, "unique_id"))) {
+            const char *value = json_reader_string(&r);
+            if (value) {
+                snprintf(level->unique_id, UNIQUE_ID_LENGTH, "%s", value);
+                have_unique_id = true;
+            }
+        } else if (!have_name && (0 == strcasecmp(key, "name"))) {
+            const char *value = json_reader_string(&r);
+            if (value) {
+                snprintf(level->name, NAME_MAXLEN, "%s", value);
+                have_name = true;
+            }
+        } else if (!have_radius && (0 == strcasecmp(key, "radius"))) {
+            have_radius = json_reader_int(&r, &radius);
+        } else if (!have_grid_radius && (0 == strcasecmp(key, "grid_radius"))) {
+            have_grid_radius = json_reader_int(&r, &grid_radius);
+        } else if (!have_tiles && (0 == strcasecmp(key, "tiles"))) {
+            have_tiles = true;
+
+            if (!have_version ||
+                ((version != LEVEL_JSON_VERSION_FULL) && (version != LEVEL_JSON_VERSION_SPARSE)) ||
+                !have_unique_id || !have_name || !have_radius ||
+                (radius < LEVEL_MIN_RADIUS) || (radius > LEVEL_MAX_RADIUS) ||
+                (grid_radius < radius) || (grid_radius > LEVEL_MAX_RADIUS)) {
+                goto cleanup;
+            }
+
+            level_update_id(level);
+            level->radius = radius;
+            if (grid_radius != level->grid->radius) {
+                level_alloc_grid(level, grid_radius);
+            }
+
+            if (version == LEVEL_JSON_VERSION_SPARSE) {
+                if (!read_sparse_tiles(level, &r)) {
+                    goto cleanup;
+                }
+                continue;
+            }
+
+            level->current_tile_write_idx = 0;
+            if (!json_reader_begin_array(&r)) {
+                goto cleanup;
+            }
+            while (json_reader_next_item(&r)) {
+                if (level->current_tile_write_idx >= level->grid->maxtiles) {
+                    goto cleanup;
+                }
+
+                tile_t *tile = &(level->tiles[level->current_tile_write_idx]);
+                if (!tile_read_json(tile, level, &r)) {
+                    goto cleanup;
+                }
+                level->current_tile_write_idx++;
+            }
+        } else {
+            json_reader_skip(&r);
+        }
+    }
+
+    if (!r.ok || !have_tiles) {
+        goto cleanup;
+    }
+
+    level_backup_unsolved_tiles(level);
+    rv = true;
+
+  cleanup:
+    cleanup_json_reader(&r);
+    return rv;
+}
+
 cJSON *level_to_json(level_t *level)
 {
+    if (!level_materialize(level)) {
+        return NULL;
+    }
+
+    bool sparse = level_can_write_sparse(level);
+
     cJSON *json = cJSON_CreateObject();
 
-    if (cJSON_AddNumberToObject(json, "version", LEVEL_JSON_VERSION) == NULL) {
+    if (cJSON_AddNumberToObject(json, "version",
+                                sparse ? LEVEL_JSON_VERSION_SPARSE : LEVEL_JSON_VERSION_FULL) == NULL) {
         goto json_err;
     }
 
@@ -1211,14 +1998,48 @@ cJSON *level_to_json(level_t *level)
         goto json_err;
     }
 
+    if (level->grid->radius != LEVEL_DEFAULT_GRID_RADIUS) {
+        if (cJSON_AddNumberToObject(json, "grid_radius", level->grid->radius) == NULL) {
+            goto json_err;
+        }
+    }
+
     cJSON *tiles = cJSON_AddArrayToObject(json, "tiles");
     if (tiles == NULL) {
         goto json_err;
     }
 
+    if (sparse) {
+        /* in solved slot order */
+        for (int i=0; i < level->grid->maxtiles; i++) {
+            tile_t *tile = level->solved_positions[i].tile;
+            if (!tile->enabled) {
+                continue;
+            }
+
+            char packed[TILE_PACKED_STRING_MAXLEN];
+            tile_to_packed_string(tile, packed);
+
+            cJSON *tjson = cJSON_CreateArray();
+            if (tjson == NULL) {
+                goto json_err;
+            }
+            cJSON_AddItemToArray(tiles, tjson);
+
+            int unsolved_idx = hex_grid_idx(level->grid, tile->unsolved_pos->position);
+            if (!cJSON_AddItemToArray(tjson, cJSON_CreateNumber(i)) ||
+                !cJSON_AddItemToArray(tjson, cJSON_CreateNumber(unsolved_idx)) ||
+                !cJSON_AddItemToArray(tjson, cJSON_CreateString(packed))) {
+                goto json_err;
+            }
+        }
+
+        return json;
+    }
+
     level_sort_tiles(level);
 
-    for (int i=0; i < LEVEL_MAXTILES; i++) {
+    for (int i=0; i < level->grid->maxtiles; i++) {
         tile_t *tile = level->sorted_tiles[i];
         cJSON *tjson = tile_to_json(tile);
         if (tjson == NULL) {
@@ -1289,7 +2110,7 @@ void level_resize(level_t *level)
 
     level->enabled_tile_count = 0;
 
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
+    for (int i=0; i<level->grid->maxtiles; i++) {
         tile_t *tile = &(level->tiles[i]);
         assert_not_null(tile);
 
@@ -1318,7 +2139,7 @@ void level_resize(level_t *level)
 
     tile_pos_t *center_pos = level_get_center_tile_pos(level);
 
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
+    for (int i=0; i<level->grid->maxtiles; i++) {
         tile_t *tile = &(level->tiles[i]);
 
         if (tile->enabled) {
@@ -1361,36 +2182,31 @@ void level_resize(level_t *level)
 #endif
 }
 
+static inline int neighbor_idx(level_t *level, tile_pos_t *pos, hex_direction_t section)
+{
+    return level->grid->neighbor[level_axial_to_idx(level, pos->position)][(section + 1) % 6];
+}
+
 tile_pos_t *level_find_solved_neighbor_tile_pos(level_t *level, tile_pos_t *pos, hex_direction_t section)
 {
-    section = (section + 1) % 6;
-    hex_axial_t neighbor_pos = hex_axial_neighbor(pos->position, section);
-    tile_pos_t *neighbor = level_get_solved_tile_pos(level, neighbor_pos);
-    return neighbor;
+    return tile_pos_at_idx(level->solved_positions, neighbor_idx(level, pos, section));
 }
 
 tile_pos_t *level_find_unsolved_neighbor_tile_pos(level_t *level, tile_pos_t *pos, hex_direction_t section)
 {
-    section = (section + 1) % 6;
-    hex_axial_t neighbor_pos = hex_axial_neighbor(pos->position, section);
-    tile_pos_t *neighbor = level_get_unsolved_tile_pos(level, neighbor_pos);
-    return neighbor;
+    return tile_pos_at_idx(level->unsolved_positions, neighbor_idx(level, pos, section));
 }
 
 tile_pos_t *level_find_current_neighbor_tile_pos(level_t *level, tile_pos_t *pos, hex_direction_t section)
 {
-    hex_direction_t section_1 = (section + 1) % 6;
-    hex_axial_t neighbor_pos = hex_axial_neighbor(pos->position, section_1);
-    paxial(neighbor_pos);
-    tile_pos_t *neighbor = level_get_current_tile_pos(level, neighbor_pos);
-    return neighbor;
+    return tile_pos_at_idx(level_get_current_positions(level), neighbor_idx(level, pos, section));
 }
 
 bool level_has_empty_tiles(level_t *level)
 {
     assert_not_null(level);
 
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
+    for (int i=0; i<level->grid->maxtiles; i++) {
         tile_t *tile = &(level->tiles[i]);
 
         if (!tile->enabled) {
@@ -1435,22 +2251,19 @@ bool level_check(level_t *level)
     level->path_count = 0;
     level->finished_path_count = 0;
 
-    for (int q=0; q<TILE_LEVEL_WIDTH; q++) {
-        for (int r=0; r<TILE_LEVEL_HEIGHT; r++) {
-            hex_axial_t axial = {
-                .q = q,
-                .r = r
-            };
-            tile_pos_t *pos = level_get_current_tile_pos(level, axial);
-            if (pos->tile->enabled) {
-                if (!tile_pos_check(pos, &(level->path_count), &(level->finished_path_count))) {
-                    rv = false;
-                }
+    /* tiles outside level->radius can never be enabled */
+    tile_pos_t *positions = level_get_current_positions(level);
+    int spiral_count = hex_grid_spiral_count(level->grid, level->radius);
+    for (int i=0; i<spiral_count; i++) {
+        tile_pos_t *pos = &positions[level->grid->spiral[i]];
+        if (pos->tile->enabled) {
+            if (!tile_pos_check(pos, &(level->path_count), &(level->finished_path_count))) {
+                rv = false;
+            }
 
-                path_int_t counts = tile_count_path_types(pos->tile);
-                for (int i=0; i<PATH_TYPE_COUNT; i++) {
-                    total.path[i] += counts.path[i];
-                }
+            path_int_t counts = tile_count_path_types(pos->tile);
+            for (int j=0; j<PATH_TYPE_COUNT; j++) {
+                total.path[j] += counts.path[j];
             }
         }
     }
@@ -1491,16 +2304,13 @@ void level_set_hover(level_t *level, IVector2 mouse_position)
         level->hover_adjacent = false;
     }
 
-    for (int q=0; q<TILE_LEVEL_WIDTH; q++) {
-        for (int r=0; r<TILE_LEVEL_HEIGHT; r++) {
-            hex_axial_t axial = {
-                .q = q,
-                .r = r
-            };
-            tile_pos_t *pos = level_get_current_tile_pos(level, axial);
-            pos->hover = false;
-            pos->hover_adjacent = NULL;
-        }
+    /* hover can only reach enabled tiles and their neighbors */
+    tile_pos_t *positions = level_get_current_positions(level);
+    int spiral_count = hex_grid_spiral_count(level->grid, level->radius + 1);
+    for (int i=0; i<spiral_count; i++) {
+        tile_pos_t *pos = &positions[level->grid->spiral[i]];
+        pos->hover = false;
+        pos->hover_adjacent = NULL;
     }
 
     level->mouse_pos.x = (float)mouse_position.x;
@@ -1509,6 +2319,8 @@ void level_set_hover(level_t *level, IVector2 mouse_position)
 
     if (level->drag_target) {
         if (level->drag_reset_frames > 0) {
+            redraw_animate();
+
             float reset_fract = ((float)level->drag_reset_frames) / ((float)level->drag_reset_total_frames);
             reset_fract = ease_exponential_in(reset_fract);
             level->drag_offset = Vector2Scale(level->drag_reset_vector, reset_fract);
@@ -1750,7 +2562,7 @@ void level_solve(level_t *level)
 {
     assert_not_null(level);
 
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
+    for (int i=0; i<level->grid->maxtiles; i++) {
         tile_t *tile = &(level->tiles[i]);
 
         if ((!tile->enabled) ||
@@ -1854,46 +2666,144 @@ void level_clear_hovered_tile(level_t *level)
     }
 }
 
+/* walks grid->spiral[first..last) around the level's center */
+static void level_foreach_spiral_slot(level_t *level, int first, int last, hex_axial_cb_t callback)
+{
+    for (int i=first; i<last; i++) {
+        callback(level->grid->axial[level->grid->spiral[i]], level);
+    }
+}
+
 void level_enable_spiral(level_t *level, int radius)
 {
-    tile_pos_t *pos = level_get_center_tile_pos(level);
-    hex_axial_foreach_in_spiral(pos->position,
-                                radius,
-                                level_enable_current_tile_callback,
-                                level);
+    assert(radius > 0);
+    level_foreach_spiral_slot(level,
+                              0,
+                              hex_grid_spiral_count(level->grid, radius),
+                              level_enable_current_tile_callback);
     level_resize(level);
 }
 
 void level_disable_spiral(level_t *level, int radius)
 {
-    tile_pos_t *pos = level_get_center_tile_pos(level);
-    hex_axial_foreach_in_spiral(pos->position,
-                                radius,
-                                level_disable_current_tile_callback,
-                                level);
+    assert(radius > 0);
+    level_foreach_spiral_slot(level,
+                              0,
+                              hex_grid_spiral_count(level->grid, radius),
+                              level_disable_current_tile_callback);
     level_resize(level);
 }
 
 void level_enable_ring(level_t *level, int radius)
 {
-    tile_pos_t *pos = level_get_center_tile_pos(level);
-    hex_axial_foreach_in_ring(pos->position,
-                              radius,
-                              level_enable_current_tile_callback,
-                              level);
+    assert(radius > 0);
+    level_foreach_spiral_slot(level,
+                              hex_grid_spiral_count(level->grid, radius - 1),
+                              hex_grid_spiral_count(level->grid, radius),
+                              level_enable_current_tile_callback);
     level_resize(level);
 }
 
 void level_disable_ring(level_t *level, int radius)
 {
-    tile_pos_t *pos = level_get_center_tile_pos(level);
-    hex_axial_foreach_in_ring(pos->position,
-                              radius,
-                              level_disable_current_tile_callback,
-                              level);
+    assert(radius > 0);
+    level_foreach_spiral_slot(level,
+                              hex_grid_spiral_count(level->grid, radius - 1),
+                              hex_grid_spiral_count(level->grid, radius),
+                              level_disable_current_tile_callback);
     level_resize(level);
 }
 
+static inline hex_axial_t shift_axial(hex_axial_t axial, int offset)
+{
+    axial.q += offset;
+    axial.r += offset;
+    return axial;
+}
+
+/*
+ * Moves the level onto a larger grid, keeping every tile at the same
+ * position relative to the center. The undo history and any solver
+ * refer to the old storage, so both are discarded.
+ */
+static void level_grow_grid(level_t *level, int grid_radius)
+{
+    assert(grid_radius > level->grid->radius);
+
+    if (options->verbose) {
+        infomsg("Growing level \"%s\" grid from radius %d to %d",
+                level->name, level->grid->radius, grid_radius);
+    }
+
+    hex_grid_t *old_grid         = level->grid;
+    tile_t *old_tiles            = level->tiles;
+    tile_pos_t *old_solved       = level->solved_positions;
+    tile_pos_t *old_unsolved     = level->unsolved_positions;
+
+    level->tiles              = NULL;
+    level->solved_positions   = NULL;
+    level->unsolved_positions = NULL;
+
+    level_alloc_grid(level, grid_radius);
+
+    int offset = grid_radius - old_grid->radius;
+    tile_t **moved = calloc(old_grid->maxtiles, sizeof(tile_t *));
+
+    for (int i=0; i<old_grid->maxtiles; i++) {
+        tile_t *old = &old_tiles[i];
+        tile_t *tile = level_get_solved_tile(level, shift_axial(old->solved_pos->position, offset));
+
+        tile_copy_attributes(tile, old);
+        memcpy(tile->hidden_saved_path,  old->hidden_saved_path,  sizeof(tile->hidden_saved_path));
+        memcpy(tile->enabled_saved_path, old->enabled_saved_path, sizeof(tile->enabled_saved_path));
+        tile->path_count          = old->path_count;
+        tile->start_for_path_type = old->start_for_path_type;
+
+        moved[i] = tile;
+    }
+
+    /* the old tiles are a permutation of the inner slots in both
+     * tile sets, so the outer slots keep their blank tiles */
+    for (int i=0; i<old_grid->maxtiles; i++) {
+        tile_pos_t *pos = level_get_unsolved_tile_pos(level, shift_axial(old_tiles[i].unsolved_pos->position, offset));
+        pos->tile = moved[i];
+        moved[i]->unsolved_pos = pos;
+    }
+
+    level_backup_unsolved_tiles(level);
+
+    for (int i=0; i<old_grid->maxtiles; i++) {
+        tile_pos_t *old_pos = &old_unsolved[i];
+        if (old_pos->orig_tile) {
+            tile_pos_t *pos = level_get_unsolved_tile_pos(level, shift_axial(old_pos->position, offset));
+            pos->orig_tile = moved[old_pos->orig_tile->id];
+        }
+    }
+
+    SAFEFREE(moved);
+    SAFEFREE(old_tiles);
+    SAFEFREE(old_solved);
+    SAFEFREE(old_unsolved);
+
+    level->hover          = NULL;
+    level->hover_adjacent = NULL;
+    level->drag_target    = NULL;
+
+    if (level->solver) {
+        destroy_solver(level->solver);
+        level->solver = NULL;
+    }
+
+    if (level->win_anim) {
+        destroy_win_anim(level->win_anim);
+        level->win_anim = NULL;
+    }
+
+    if (level->undo) {
+        reset_level_undo(level->undo);
+    }
+}
+
 void level_set_radius(level_t *level, int new_radius)
 {
     assert_not_null(level);
@@ -1905,6 +2815,10 @@ void level_set_radius(level_t *level, int new_radius)
     used_tiles_t save_used_tiles = level->currently_used_tiles;
     level_use_solved_tile_pos(level);
 
+    if (new_radius > level->grid->radius) {
+        level_grow_grid(level, new_radius);
+    }
+
     while (new_radius > level->radius) {
         level->radius++;
         level_enable_ring(level, level->radius );
@@ -1995,6 +2909,8 @@ bool level_update_fade(level_t *level)
     assert_not_null(level);
 
     if (level->fade.active && (level->fade.value != level->fade.target)) {
+        redraw_animate();
+
         if (fabs(level->fade.value - level->fade.target) <= LEVEL_FADE_DELTA) {
             level->fade.value           = level->fade.target;
             level->fade.value_eased_out = level->fade.target;
@@ -2040,6 +2956,8 @@ static void level_fade_transition(level_t *level, level_fade_finished_cb_t callb
     level->fade.finished_callback = callback;
     level->fade.finished_data = data;
 
+    redraw_request();
+
     level->fade.rotate_speed = 0.8333;
     if (rand() & 0x00000001) {
         level->fade.rotate_speed *= -1.0;
@@ -2139,14 +3057,8 @@ void level_fade_out(level_t *level, level_fade_finished_cb_t callback, void *dat
     }
 }
 
-static void level_update_tile_pops_callback(hex_axial_t axial, void *data)
+static void level_update_tile_pop(tile_pos_t *pos)
 {
-    level_t *level = (level_t *)data;
-    tile_pos_t *pos = level_get_unsolved_tile_pos(level, axial);
-    if (!pos) {
-        return;
-    }
-
     assert(pos->inner_neighbors_count >= 0);
 
     switch (pos->inner_neighbors_count) {
@@ -2171,12 +3083,12 @@ static void level_update_tile_pops_callback(hex_axial_t axial, void *data)
 
 void level_update_tile_pops(level_t *level)
 {
-    tile_pos_t *center = level_get_center_tile_pos(level);
-    for (int ring = 1; ring < level->radius; ring++) {
-        hex_axial_foreach_in_ring(center->position,
-                                  ring + 1,
-                                  level_update_tile_pops_callback,
-                                  level);
+    /* rings 2..radius, inner rings first */
+    int first = hex_grid_spiral_count(level->grid, 1);
+    int last  = hex_grid_spiral_count(level->grid, level->radius);
+
+    for (int i=first; i<last; i++) {
+        level_update_tile_pop(&level->unsolved_positions[level->grid->spiral[i]]);
     }
 }
 
@@ -2185,8 +3097,9 @@ void level_shuffle_tiles(level_t *level)
     used_tiles_t save_currently_used_tiles = level->currently_used_tiles;
     level->currently_used_tiles = USED_TILES_UNSOLVED;
 
-    tile_pos_t *backup_enabled_positions[LEVEL_MAXTILES];
-    memcpy(backup_enabled_positions, level->enabled_positions, sizeof(backup_enabled_positions));
+    size_t backup_size = level->grid->maxtiles * sizeof(tile_pos_t *);
+    tile_pos_t **backup_enabled_positions = malloc(backup_size);
+    memcpy(backup_enabled_positions, level->enabled_positions, backup_size);
 
     int num_positions = level_get_movable_positions(level);
 
@@ -2203,7 +3116,8 @@ void level_shuffle_tiles(level_t *level)
         level->enabled_positions[j] = pos_i;
     }
 
-    memcpy(level->enabled_positions, backup_enabled_positions, sizeof(backup_enabled_positions));
+    memcpy(level->enabled_positions, backup_enabled_positions, backup_size);
+    free(backup_enabled_positions);
     level->currently_used_tiles = save_currently_used_tiles;
 }
 
@@ -2222,7 +3136,7 @@ void level_reset_win_anim(level_t *level)
     /* level->fade.value_eased_in  = level->fade.target; */
     /* level->fade.rotate_speed    = 0.0f; */
 
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_pos_t *solved_pos = &level->solved_positions[i];
         tile_pos_t *unsolved_pos = &level->unsolved_positions[i];
 
@@ -2236,7 +3150,7 @@ long level_average_paths_per_tile(level_t *level)
     int path_count = 0;
     int enabled_tile_count = 0;
 
-    for (int i = 0; i < LEVEL_MAXTILES; i++) {
+    for (int i = 0; i < level->grid->maxtiles; i++) {
         tile_t *tile = &(level->tiles[i]);
         if (!tile->enabled) {
             continue;
@@ -48,6 +48,35 @@ struct solver;
 struct undo;
 struct generate_level_param;
 struct classic_collection;
+struct hex_grid;
+struct json_reader;
+
+/* where a collection level can be decoded from again */
+enum level_source {
+    LEVEL_SOURCE_NONE = 0,
+    LEVEL_SOURCE_LEVEL_FILE,   /* the level file at loadpath */
+    LEVEL_SOURCE_PACK_FILE,    /* pack_size bytes at pack_offset in the collection's pack file */
+    LEVEL_SOURCE_PACK_DATA     /* pack_size bytes of compressed JSON at pack_data */
+};
+typedef enum level_source level_source_t;
+
+/* what a level file stub needs from the file */
+struct level_file_header {
+    bool read_ok;
+    bool have_header;
+    bool from_cache;
+    name_str_t name;
+    unique_id_t unique_id;
+    int radius;
+
+    /* only filled in when read through a dir_cache */
+    uint64_t file_size;
+    int64_t file_mtime;
+    uint64_t hash;
+    unsigned char *data;
+    uint32_t data_size;
+};
+typedef struct level_file_header level_file_header_t;
 
 typedef void (*level_fade_finished_cb_t)(struct level *level, void *data);
 
@@ -85,14 +114,17 @@ struct level {
 
     int enabled_tile_count;
 
+    /* slot storage below has grid->maxtiles entries */
+    struct hex_grid *grid;
+
     int current_tile_write_idx;
-    tile_t tiles[LEVEL_MAXTILES];
-    tile_t *sorted_tiles[LEVEL_MAXTILES];
-    tile_t *enabled_tiles[LEVEL_MAXTILES];
+    tile_t *tiles;
+    tile_t **sorted_tiles;
+    tile_t **enabled_tiles;
 
-    tile_pos_t solved_positions[LEVEL_MAXTILES];
-    tile_pos_t unsolved_positions[LEVEL_MAXTILES];
-    tile_pos_t *enabled_positions[LEVEL_MAXTILES];
+    tile_pos_t *solved_positions;
+    tile_pos_t *unsolved_positions;
+    tile_pos_t **enabled_positions;
 
     hex_axial_t center;
 
@@ -136,6 +168,24 @@ struct level {
 
     bool loaded_from_file;
     bool stored_in_collection;
+
+    /* a stub only has the name, unique_id and file fields set until
+     * level_materialize() decodes it from its source */
+    bool stub;
+    /* the source couldn't be decoded; the level stays a stub and is
+     * never saved, so the empty board can't replace the real file */
+    bool decode_failed;
+    level_source_t source;
+    uint32_t pack_offset;
+    uint32_t pack_size;
+    unsigned char *pack_data;
+    struct level *lru_prev, *lru_next;
+
+    /* a level file stub with pack_data decodes it instead of reading
+     * the file, as long as the file still has this size and mtime */
+    uint64_t source_size;
+    int64_t source_mtime;
+
     bool unplayed;
     bool finished;
     float finished_fract;
@@ -158,6 +208,9 @@ struct level {
     struct undo *undo;
 
     struct collection *collection;
+    /* set by collection_add_level() once the level is in the
+     * collection's list, and so may be in its level_index */
+    bool in_collection;
 
     struct level *prev, *next;
 
@@ -179,7 +232,8 @@ typedef struct level level_t;
 void print_level(level_t *level);
 void print_level_tiles(level_t *level);
 
-int hex_axial_to_idx(hex_axial_t axial);
+int level_axial_to_idx(level_t *level, hex_axial_t axial);
+tile_pos_t *level_get_current_positions(level_t *level);
 tile_pos_t *level_get_solved_tile_pos(level_t *level,  hex_axial_t axial);
 tile_pos_t *level_get_unsolved_tile_pos(level_t *level,  hex_axial_t axial);
 
@@ -224,6 +278,15 @@ bool level_parse_string(level_t *level, const char *str);
 level_t *load_level_string(const char *filename, const char *str, bool is_pack);
 level_t *load_level_json(const char *filename, cJSON *json, bool is_pack);
 level_t *load_level_file(const char *filename);
+level_t *load_level_file_stub(const char *filename);
+void parse_level_file_header(const char *str, level_file_header_t *header, bool keep_data);
+void read_level_file_header(const char *filename, level_file_header_t *header);
+level_t *create_level_file_stub(const char *filename, level_file_header_t *header);
+level_t *load_level_json_stub(const char *filename, cJSON *json);
+level_t *read_level_json_stub(const char *filename, struct json_reader *r);
+level_t *create_level_stub(const char *filename, level_source_t source);
+bool level_materialize(level_t *level);
+int level_materialized_count(void);
 
 void level_update_ui_name(level_t *level, int idx);
 
@@ -242,6 +305,7 @@ void level_save_to_file_if_changed(level_t *level, const char *dirpath);
 void level_save_to_local_levels(level_t *level, const char *prefix, const char *name);
 void level_save(level_t *level);
 bool level_from_json(level_t *level, cJSON *json);
+bool level_read_json(level_t *level, const char *str);
 cJSON *level_to_json(level_t *level);
 
 tile_pos_t *level_find_solved_neighbor_tile_pos(level_t *level, tile_pos_t *tile, hex_direction_t section);
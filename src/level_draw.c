@@ -26,48 +26,616 @@
 #include "tile_draw.h"
 #include "level.h"
 #include "level_draw.h"
+#include "hex_grid.h"
 #include "shader.h"
 #include "win_anim.h"
 #include "util.h"
 #include "background.h"
+#include "tile_batch.h"
+#include "tile_instance.h"
+#include "tile_sdf.h"
+#include "options.h"
+#include "profiler.h"
 
 
 extern float postprocessing_effect_amount1[4];
 extern float postprocessing_effect_amount2[4];
 
-static void level_set_fade_transition(level_t *level, tile_pos_t *pos)
+static tile_batch_t tile_batch;
+static bool tile_batch_ready = false;
+
+static tile_instances_t tile_instances;
+static bool tile_instances_ready = false;
+
+/* slots left for level_draw_tiles_batched() after the SDF pass */
+static bool *sdf_remaining = NULL;
+static int sdf_remaining_count = 0;
+
+static Vector2 level_fade_translate(level_t *level, tile_pos_t *pos)
 {
     tile_pos_t *center_pos = level_get_center_tile_pos(level);
     if (!level->fade.active && center_pos == pos) {
-        return;
+        return VEC2_ZERO;
     }
 
     Vector2 modded = Vector2Scale(pos->radial_vector, 5.0);
     Vector2 faded  = Vector2Lerp(modded, pos->radial_vector, level->fade.value_eased_out);
 
-    Vector2 translate = Vector2Subtract(faded, pos->radial_vector);
-
-    rlTranslatef(translate.x,
-                 translate.y,
-                 0.0);
+    return Vector2Subtract(faded, pos->radial_vector);
 }
 
-static void level_set_transition(level_t *level, tile_pos_t *pos, bool do_fade, float fade_ammount)
+static Vector2 level_transition_translate(level_t *level, tile_pos_t *pos, bool do_fade, float fade_ammount)
 {
     fade_ammount = 1.0;
     Vector2 extra_tvec = Vector2Scale(pos->extra_translate, ease_quad_out(fade_ammount));
     Vector2 tvec = Vector2Add(pos->win.center, Vector2Add(extra_tvec, pos->pop_translate));
 
+    if (do_fade) {
+        tvec = Vector2Add(tvec, level_fade_translate(level, pos));
+    }
+
+    return tvec;
+}
+
+static void level_set_transition(level_t *level, tile_pos_t *pos, bool do_fade, float fade_ammount)
+{
+    Vector2 tvec = level_transition_translate(level, pos, do_fade, fade_ammount);
 
     rlTranslatef(tvec.x,
                  tvec.y,
                  0.0);
 
-    if (do_fade) {
-        level_set_fade_transition(level, pos);
+    rlRotatef(TO_DEGREES(pos->extra_rotate), 0.0, 0.0, 1.0);
+}
+
+static void cleanup_board_cache(void);
+
+void cleanup_level_draw(void)
+{
+    if (tile_batch_ready) {
+        cleanup_tile_batch(&tile_batch);
+        tile_batch_ready = false;
     }
 
-    rlRotatef(TO_DEGREES(pos->extra_rotate), 0.0, 0.0, 1.0);
+    if (tile_instances_ready) {
+        cleanup_tile_instances(&tile_instances);
+        tile_instances_ready = false;
+    }
+
+    SAFEFREE(sdf_remaining);
+    sdf_remaining_count = 0;
+
+    cleanup_board_cache();
+}
+
+/* the tiles themselves, without the drag ghost or win effects */
+static void level_draw_tiles(level_t *level, bool finished, bool do_fade, Color finished_color, float finished_fade_in)
+{
+    /* tiles outside level->radius are never enabled */
+    tile_pos_t *positions = level_get_current_positions(level);
+    int spiral_count = hex_grid_spiral_count(level->grid, level->radius);
+    for (int i=0; i<spiral_count; i++) {
+        tile_pos_t *pos = &positions[level->grid->spiral[i]];
+        assert_not_null(pos);
+
+        if (pos->tile->enabled) {
+            if (level->drag_target && pos->tile == level->drag_target->tile) {
+                if (pos->swap_target) {
+                    // preview the swap
+                    rlPushMatrix();
+                    rlTranslatef(pos->win.center.x,
+                                 pos->win.center.y,
+                                 0.0);
+
+                    tile_draw(pos, level->drag_target, finished, finished_color, finished_fade_in);
+
+                    rlPopMatrix();
+                } else {
+                    // defer until after bg tiles are drawn
+                }
+            } else {
+                rlPushMatrix();
+
+                level_set_transition(level, pos, do_fade, finished_fade_in);
+                tile_draw(pos, level->drag_target, finished, finished_color, finished_fade_in);
+
+                rlPopMatrix();
+            }
+        }
+    }
+}
+
+/* mask, if not NULL, selects which grid slots are drawn */
+static void level_draw_tiles_batched(level_t *level, bool finished, bool do_fade, Color finished_color, float finished_fade_in, const bool *mask)
+{
+    if (!tile_batch_ready) {
+        init_tile_batch(&tile_batch);
+        tile_batch_ready = true;
+    }
+
+    tile_batch_begin(&tile_batch);
+
+    tile_pos_t *positions = level_get_current_positions(level);
+    int spiral_count = hex_grid_spiral_count(level->grid, level->radius);
+    for (int i=0; i<spiral_count; i++) {
+        int slot = level->grid->spiral[i];
+        tile_pos_t *pos = &positions[slot];
+
+        if (!pos->tile->enabled) {
+            continue;
+        }
+
+        if (mask && !mask[slot]) {
+            continue;
+        }
+
+        if (level->drag_target && pos->tile == level->drag_target->tile) {
+            if (!pos->swap_target) {
+                continue;
+            }
+            tile_batch_set_transform(&tile_batch, pos->win.center, 0.0f);
+        } else {
+            tile_batch_set_transform(&tile_batch,
+                                     level_transition_translate(level, pos, do_fade, finished_fade_in),
+                                     pos->extra_rotate);
+        }
+
+        tile_draw_batched(&tile_batch, pos, level->drag_target, finished, finished_color, finished_fade_in);
+    }
+
+    tile_batch_draw(&tile_batch);
+}
+
+/*
+ * Draws the idle tiles in mask (all if NULL) with the SDF shader, and
+ * returns the mask of the tiles that still need to be drawn.
+ */
+static const bool *level_draw_tiles_sdf(level_t *level, bool finished, bool do_fade, const bool *mask)
+{
+    if (finished || edit_mode || !tile_sdf_available()) {
+        return mask;
+    }
+
+    int maxtiles = level->grid->maxtiles;
+    if (sdf_remaining_count != maxtiles) {
+        sdf_remaining_count = maxtiles;
+        sdf_remaining = realloc(sdf_remaining, maxtiles * sizeof(bool));
+    }
+
+    bool started = false;
+    tile_pos_t *positions = level_get_current_positions(level);
+    int spiral_count = hex_grid_spiral_count(level->grid, level->radius);
+    for (int i=0; i<spiral_count; i++) {
+        int slot = level->grid->spiral[i];
+        tile_pos_t *pos = &positions[slot];
+
+        sdf_remaining[slot] = !mask || mask[slot];
+
+        if (!sdf_remaining[slot] || !tile_sdf_can_draw(pos)) {
+            continue;
+        }
+
+        if (level->drag_target && ((pos == level->drag_target) ||
+                                   (pos->tile == level->drag_target->tile))) {
+            continue;
+        }
+
+        if (!started) {
+            tile_sdf_begin(pos);
+            started = true;
+        } else if (!tile_sdf_matches_template(pos)) {
+            continue;
+        }
+
+        tile_sdf_draw(pos,
+                      level_transition_translate(level, pos, do_fade, 1.0f),
+                      pos->extra_rotate);
+        sdf_remaining[slot] = false;
+    }
+
+    if (started) {
+        tile_sdf_end();
+    }
+
+    return sdf_remaining;
+}
+
+/* finished tiles, each one an instance of the same tile mesh */
+static void level_draw_tiles_instanced(level_t *level, bool do_fade, Color finished_color, float finished_fade_in)
+{
+    if (!tile_instances_ready) {
+        init_tile_instances(&tile_instances);
+        tile_instances_ready = true;
+    }
+
+    tile_instances_begin(&tile_instances);
+
+    tile_pos_t *positions = level_get_current_positions(level);
+    int spiral_count = hex_grid_spiral_count(level->grid, level->radius);
+    for (int i=0; i<spiral_count; i++) {
+        tile_pos_t *pos = &positions[level->grid->spiral[i]];
+
+        tile_instances_add(&tile_instances,
+                           pos,
+                           level_transition_translate(level, pos, do_fade, finished_fade_in),
+                           pos->extra_rotate);
+    }
+
+    tile_instances_draw(&tile_instances,
+                        tile_finished_bg_color(tile_bg_color, finished_fade_in),
+                        tile_finished_bg_color(tile_bg_hover_color, finished_fade_in),
+                        tile_finished_center_color(finished_color));
+}
+
+static float level_board_rotation(level_t *level)
+{
+    return level->fade.rotate_level + level->extra_rotate_level;
+}
+
+static void level_apply_board_transform(level_t *level)
+{
+    float level_rotate = level_board_rotation(level);
+    rlTranslatef(window_center.x, window_center.y, 0.0);
+    rlRotatef(TO_DEGREES(level_rotate), 0.0, 0.0, 1.0);
+    rlTranslatef(-window_center.x, -window_center.y, 0.0);
+
+    rlTranslatef(level->px_offset.x, level->px_offset.y, 0.0);
+}
+
+/*
+ * Retained board layer. Tiles that aren't changing are kept in a
+ * render texture, so an idle frame only draws that texture plus the
+ * few tiles that are hovered, dragged or previewing a swap.
+ *
+ * Each tile has a signature of everything tile_draw() reads. When
+ * level_swap_tile_pos(), a hover change or an edit changes a tile's
+ * signature, only the area under that tile is cleared and redrawn.
+ * Fades, the win animation and anything that moves the whole board
+ * skip the cache and draw directly.
+ */
+struct board_cache {
+    RenderTexture2D target;
+    bool have_target;
+
+    level_t *level;
+    bool valid;
+    bool use_next_draw;
+    uint64_t key;
+
+    int slot_count;
+    uint64_t *signatures;    /* 0 if the slot isn't in the texture */
+    uint64_t *new_signatures;
+    Rectangle *bounds;       /* screen area of each slot's last draw */
+    bool *mask;
+};
+typedef struct board_cache board_cache_t;
+
+static board_cache_t board_cache;
+
+/* redrawing more tiles than this just redraws the whole board */
+#define BOARD_CACHE_MAX_PARTIAL_FRACTION 4
+
+/* FNV-1a */
+static uint64_t board_cache_hash(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+#define BOARD_CACHE_HASH_INIT 0xcbf29ce484222325ULL
+#define HASH_VALUE(hash, value) board_cache_hash((hash), &(value), sizeof(value))
+
+static void cleanup_board_cache(void)
+{
+    if (board_cache.have_target) {
+        UnloadRenderTexture(board_cache.target);
+        board_cache.have_target = false;
+    }
+
+    SAFEFREE(board_cache.signatures);
+    SAFEFREE(board_cache.new_signatures);
+    SAFEFREE(board_cache.bounds);
+    SAFEFREE(board_cache.mask);
+    board_cache.slot_count = 0;
+    board_cache.level = NULL;
+    board_cache.valid = false;
+}
+
+static bool board_cache_tile_is_dynamic(level_t *level, tile_pos_t *pos)
+{
+    return pos->hover
+        || pos->hover_adjacent
+        || pos->swap_target
+        || (pos == level->drag_target)
+        || (level->drag_target && (pos->tile == level->drag_target->tile));
+}
+
+/* everything outside of the tiles that changes how they are drawn */
+static uint64_t board_cache_frame_key(level_t *level)
+{
+    uint64_t hash = BOARD_CACHE_HASH_INIT;
+
+    uintptr_t level_ptr = (uintptr_t)level;
+    float rotation = level_board_rotation(level);
+    int maxtiles = level->grid->maxtiles;
+    bool editing = edit_mode;
+
+    hash = HASH_VALUE(hash, level_ptr);
+    hash = HASH_VALUE(hash, maxtiles);
+    hash = HASH_VALUE(hash, window_size);
+    hash = HASH_VALUE(hash, rotation);
+    hash = HASH_VALUE(hash, level->px_offset);
+    hash = HASH_VALUE(hash, level->currently_used_tiles);
+    hash = HASH_VALUE(hash, editing);
+
+    hash = HASH_VALUE(hash, tile_bg_color);
+    hash = HASH_VALUE(hash, tile_bg_hidden_color);
+    hash = HASH_VALUE(hash, tile_edge_color);
+    hash = HASH_VALUE(hash, tile_edge_hidden_color);
+    hash = HASH_VALUE(hash, tile_center_color);
+    hash = board_cache_hash(hash, options->path_color, sizeof(options->path_color));
+
+    return hash;
+}
+
+static uint64_t board_cache_tile_signature(level_t *level, tile_pos_t *pos)
+{
+    tile_t *tile = pos->tile;
+
+    if (!tile->enabled || board_cache_tile_is_dynamic(level, pos)) {
+        return 0;
+    }
+
+    uint64_t hash = BOARD_CACHE_HASH_INIT;
+
+    hash = HASH_VALUE(hash, tile->hidden);
+    hash = HASH_VALUE(hash, tile->fixed);
+    hash = HASH_VALUE(hash, tile->path_count);
+    hash = HASH_VALUE(hash, tile->path);
+
+    /* path highlights depend on the neighbor's matching path */
+    each_direction {
+        tile_pos_t *neighbor = pos->neighbors[dir];
+        path_type_t neighbor_path = neighbor
+            ? neighbor->tile->path[hex_opposite_direction(dir)]
+            : PATH_TYPE_NONE;
+        hash = HASH_VALUE(hash, neighbor_path);
+    }
+
+    Vector2 translate = level_transition_translate(level, pos, false, 1.0f);
+    hash = HASH_VALUE(hash, translate);
+    hash = HASH_VALUE(hash, pos->extra_rotate);
+    hash = HASH_VALUE(hash, pos->rel.center);
+    hash = HASH_VALUE(hash, pos->size);
+    hash = HASH_VALUE(hash, pos->line_width);
+    hash = HASH_VALUE(hash, pos->center_circle_draw_radius);
+
+    return hash | 1;
+}
+
+static Rectangle board_cache_tile_bounds(level_t *level, tile_pos_t *pos)
+{
+    Vector2 translate = level_transition_translate(level, pos, false, 1.0f);
+    Vector2 center = Vector2Rotate(pos->rel.center, pos->extra_rotate);
+    center = Vector2Add(center, translate);
+    center = Vector2Add(center, level->px_offset);
+    center = Vector2RotateAroundPoint(center, level_board_rotation(level), window_center);
+
+    /* room for the border and antialiasing */
+    float radius = pos->size + pos->line_width + 4.0f;
+
+    return (Rectangle) {
+        .x      = floorf(center.x - radius),
+        .y      = floorf(center.y - radius),
+        .width  = ceilf(2.0f * radius) + 1.0f,
+        .height = ceilf(2.0f * radius) + 1.0f
+    };
+}
+
+static bool board_cache_resize(level_t *level)
+{
+    int maxtiles = level->grid->maxtiles;
+    if (board_cache.slot_count != maxtiles) {
+        board_cache.slot_count     = maxtiles;
+        board_cache.signatures     = realloc(board_cache.signatures,     maxtiles * sizeof(uint64_t));
+        board_cache.new_signatures = realloc(board_cache.new_signatures, maxtiles * sizeof(uint64_t));
+        board_cache.bounds         = realloc(board_cache.bounds,         maxtiles * sizeof(Rectangle));
+        board_cache.mask           = realloc(board_cache.mask,           maxtiles * sizeof(bool));
+        memset(board_cache.signatures, 0, maxtiles * sizeof(uint64_t));
+        board_cache.valid = false;
+    }
+
+    if (board_cache.have_target
+        && ((board_cache.target.texture.width  != window_size.x) ||
+            (board_cache.target.texture.height != window_size.y))) {
+        UnloadRenderTexture(board_cache.target);
+        board_cache.have_target = false;
+    }
+
+    if (!board_cache.have_target) {
+        board_cache.target = LoadRenderTexture(window_size.x, window_size.y);
+        if (!IsRenderTextureReady(board_cache.target)) {
+            warnmsg("couldn't create the board cache texture; drawing the board directly");
+            options->cache_board = false;
+            return false;
+        }
+        board_cache.have_target = true;
+        board_cache.valid = false;
+    }
+
+    return true;
+}
+
+/* draws the selected slots over whatever is in the target */
+static void board_cache_draw_slots(level_t *level)
+{
+    /* premultiplied color with the correct alpha, so compositing the
+     * texture blends the same as drawing the tiles directly */
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    rlSetBlendMode(RL_BLEND_CUSTOM_SEPARATE);
+
+    rlPushMatrix();
+    level_apply_board_transform(level);
+    level_draw_tiles_batched(level, false, false, WHITE, 1.0f,
+                             level_draw_tiles_sdf(level, false, false, board_cache.mask));
+    rlPopMatrix();
+
+    rlSetBlendMode(RL_BLEND_ALPHA);
+}
+
+static void board_cache_redraw_all(level_t *level)
+{
+    for (int slot=0; slot<board_cache.slot_count; slot++) {
+        board_cache.mask[slot] = board_cache.new_signatures[slot] != 0;
+    }
+
+    BeginTextureMode(board_cache.target);
+    ClearBackground(BLANK);
+    board_cache_draw_slots(level);
+    EndTextureMode();
+}
+
+static void board_cache_redraw_area(level_t *level, Rectangle area)
+{
+    tile_pos_t *positions = level_get_current_positions(level);
+
+    for (int slot=0; slot<board_cache.slot_count; slot++) {
+        board_cache.mask[slot] = (board_cache.new_signatures[slot] != 0)
+            && CheckCollisionRecs(area, board_cache_tile_bounds(level, &positions[slot]));
+    }
+
+    BeginScissorMode(area.x, area.y, area.width, area.height);
+    ClearBackground(BLANK);
+    board_cache_draw_slots(level);
+    EndScissorMode();
+}
+
+static Rectangle rect_union(Rectangle a, Rectangle b)
+{
+    float x0 = MIN(a.x, b.x);
+    float y0 = MIN(a.y, b.y);
+    float x1 = MAX(a.x + a.width,  b.x + b.width);
+    float y1 = MAX(a.y + a.height, b.y + b.height);
+    return (Rectangle) { x0, y0, x1 - x0, y1 - y0 };
+}
+
+/*
+ * Brings the board cache up to date for the next level_draw(). Has to
+ * be called before the frame starts drawing, as it renders into the
+ * cache texture.
+ */
+void level_draw_prepare(level_t *level, bool finished)
+{
+    board_cache.use_next_draw = false;
+
+    if (!options->cache_board || !level) {
+        return;
+    }
+
+    if (finished || level->fade.active || (level->fade.value != 1.0f)) {
+        board_cache.valid = false;
+        return;
+    }
+
+    if (!board_cache_resize(level)) {
+        return;
+    }
+
+    /* wait for whatever is moving the whole board to settle */
+    uint64_t key = board_cache_frame_key(level);
+    if (!board_cache.valid || (key != board_cache.key) || (board_cache.level != level)) {
+        bool settled = (key == board_cache.key) && (board_cache.level == level);
+        board_cache.key   = key;
+        board_cache.level = level;
+        board_cache.valid = false;
+        if (!settled) {
+            return;
+        }
+    }
+
+    tile_pos_t *positions = level_get_current_positions(level);
+
+    int dirty = 0;
+    for (int slot=0; slot<board_cache.slot_count; slot++) {
+        board_cache.new_signatures[slot] = board_cache_tile_signature(level, &positions[slot]);
+        if (board_cache.new_signatures[slot] != board_cache.signatures[slot]) {
+            dirty++;
+        }
+    }
+
+    if (dirty > (board_cache.slot_count / BOARD_CACHE_MAX_PARTIAL_FRACTION)) {
+        /* many tiles are moving; draw directly until they stop */
+        memcpy(board_cache.signatures, board_cache.new_signatures, board_cache.slot_count * sizeof(uint64_t));
+        board_cache.valid = false;
+        return;
+    }
+
+    if (!board_cache.valid) {
+        board_cache_redraw_all(level);
+    } else if (dirty) {
+        BeginTextureMode(board_cache.target);
+        for (int slot=0; slot<board_cache.slot_count; slot++) {
+            if (board_cache.new_signatures[slot] != board_cache.signatures[slot]) {
+                Rectangle area = board_cache_tile_bounds(level, &positions[slot]);
+                if (board_cache.signatures[slot]) {
+                    area = rect_union(area, board_cache.bounds[slot]);
+                }
+                board_cache_redraw_area(level, area);
+            }
+        }
+        EndTextureMode();
+    }
+
+    for (int slot=0; slot<board_cache.slot_count; slot++) {
+        board_cache.signatures[slot] = board_cache.new_signatures[slot];
+        if (board_cache.signatures[slot]) {
+            board_cache.bounds[slot] = board_cache_tile_bounds(level, &positions[slot]);
+        }
+    }
+
+    board_cache.valid = true;
+    board_cache.use_next_draw = true;
+}
+
+static bool board_cache_use(level_t *level, bool finished, bool do_fade)
+{
+    bool use = board_cache.use_next_draw
+        && board_cache.valid
+        && (board_cache.level == level)
+        && !finished
+        && !do_fade;
+
+    board_cache.use_next_draw = false;
+
+    return use;
+}
+
+static void board_cache_draw(level_t *level)
+{
+    Rectangle src_rect = {
+        .x      = 0.0f,
+        .y      = 0.0f,
+        .width  = (float) board_cache.target.texture.width,
+        .height = (float)-board_cache.target.texture.height
+    };
+
+    rlSetBlendMode(RL_BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(board_cache.target.texture, src_rect, VEC2_ZERO, WHITE);
+    rlSetBlendMode(RL_BLEND_ALPHA);
+
+    /* then only the tiles that aren't in the texture */
+    for (int slot=0; slot<board_cache.slot_count; slot++) {
+        board_cache.mask[slot] = !board_cache.signatures[slot];
+    }
+
+    rlPushMatrix();
+    level_apply_board_transform(level);
+    level_draw_tiles_batched(level, false, false, WHITE, 1.0f,
+                             level_draw_tiles_sdf(level, false, false, board_cache.mask));
+    rlPopMatrix();
 }
 
 static void level_draw_corner_connections(level_t *level, win_anim_mode_t win_mode)
@@ -82,21 +650,17 @@ static void level_draw_corner_connections(level_t *level, win_anim_mode_t win_mo
 
     BeginShaderMode(win_border_shader);
     {
-        for (int q=0; q<TILE_LEVEL_WIDTH; q++) {
-            for (int r=0; r<TILE_LEVEL_HEIGHT; r++) {
-                hex_axial_t addr = {
-                    .q = q,
-                    .r = r
-                };
-                tile_pos_t *pos = level_get_current_tile_pos(level, addr);
+        tile_pos_t *positions = level_get_current_positions(level);
+        int spiral_count = hex_grid_spiral_count(level->grid, level->radius);
+        for (int i=0; i<spiral_count; i++) {
+            tile_pos_t *pos = &positions[level->grid->spiral[i]];
 
-                rlPushMatrix();
+            rlPushMatrix();
 
-                //level_set_transition(level, pos, do_fade, finished_fade_in);
-                tile_draw_corner_connections(pos, win_mode);
+            //level_set_transition(level, pos, do_fade, finished_fade_in);
+            tile_draw_corner_connections(pos, win_mode);
 
-                rlPopMatrix();
-            }
+            rlPopMatrix();
         }
     }
     EndShaderMode();
@@ -113,11 +677,18 @@ void level_draw(level_t *level, bool finished)
     while (level->finished_hue > 360.0f) {
         level->finished_hue -= 360.0f;
     }
+    profile_begin(PROFILE_PHASE_WIN_ANIM);
     win_anim_update(level->win_anim);
+    profile_end(PROFILE_PHASE_WIN_ANIM);
 
     Color finished_color = ColorFromHSV(level->finished_hue, 0.7, 1.0);
     float finished_fade_in = level->win_anim ? level->win_anim->fade[2] : 1.0;
 
+    bool use_board_cache = board_cache_use(level, finished, do_fade);
+    if (use_board_cache) {
+        board_cache_draw(level);
+    }
+
     rlPushMatrix();
 
     if (do_fade) {
@@ -126,53 +697,26 @@ void level_draw(level_t *level, bool finished)
         rlSetBlendMode(RL_BLEND_CUSTOM);
     }
 
-    float level_rotate = level->fade.rotate_level + level->extra_rotate_level;
-    rlTranslatef(window_center.x, window_center.y, 0.0);
-    rlRotatef(TO_DEGREES(level_rotate), 0.0, 0.0, 1.0);
-    rlTranslatef(-window_center.x, -window_center.y, 0.0);
-
-    rlTranslatef(level->px_offset.x, level->px_offset.y, 0.0);
+    level_apply_board_transform(level);
 
     if (finished && level->fade.value >= 1.0f) {
         level_draw_corner_connections(level, level->win_anim ? level->win_anim->mode : WIN_ANIM_MODE_SIMPLE);
     }
-    for (int q=0; q<TILE_LEVEL_WIDTH; q++) {
-        for (int r=0; r<TILE_LEVEL_HEIGHT; r++) {
-            hex_axial_t addr = {
-                .q = q,
-                .r = r
-            };
-            tile_pos_t *pos = level_get_current_tile_pos(level, addr);
-            assert_not_null(pos);
-
-            if (pos->tile->enabled) {
-                if (level->drag_target && pos->tile == level->drag_target->tile) {
-                    if (pos->swap_target) {
-                        // preview the swap
-                        rlPushMatrix();
-                        rlTranslatef(pos->win.center.x,
-                                     pos->win.center.y,
-                                     0.0);
-
-                        tile_draw(pos, level->drag_target, finished, finished_color, finished_fade_in);
-
-                        rlPopMatrix();
-                    } else {
-                        // defer until after bg tiles are drawn
-                    }
-                } else {
-                    rlPushMatrix();
-
-                    level_set_transition(level, pos, do_fade, finished_fade_in);
-                    tile_draw(pos, level->drag_target, finished, finished_color, finished_fade_in);
-
-                    rlPopMatrix();
-                }
-            }
-        }
+    if (use_board_cache) {
+        /* already drawn */
+    } else if (finished && !level->drag_target && !edit_mode && tile_instances_available()) {
+        level_draw_tiles_instanced(level, do_fade, finished_color, finished_fade_in);
+    } else if (options->batch_tile_draw) {
+        level_draw_tiles_batched(level, finished, do_fade, finished_color, finished_fade_in,
+                                 level_draw_tiles_sdf(level, finished, do_fade, NULL));
+    } else {
+        level_draw_tiles(level, finished, do_fade, finished_color, finished_fade_in);
     }
 
     if (finished) {
+        tile_pos_t *positions = level_get_current_positions(level);
+        int spiral_count = hex_grid_spiral_count(level->grid, level->radius);
+
         postprocessing_effect_amount1[3] = 0.0f;
 
         SetShaderValue(win_border_shader, win_border_shader_loc.effect_amount1, &(postprocessing_effect_amount1[0]), SHADER_UNIFORM_VEC4);
@@ -180,21 +724,15 @@ void level_draw(level_t *level, bool finished)
 
         BeginShaderMode(win_border_shader);
         {
-            for (int q=0; q<TILE_LEVEL_WIDTH; q++) {
-                for (int r=0; r<TILE_LEVEL_HEIGHT; r++) {
-                    hex_axial_t addr = {
-                        .q = q,
-                        .r = r
-                    };
-                    tile_pos_t *pos = level_get_current_tile_pos(level, addr);
+            for (int i=0; i<spiral_count; i++) {
+                tile_pos_t *pos = &positions[level->grid->spiral[i]];
 
-                    rlPushMatrix();
+                rlPushMatrix();
 
-                    level_set_transition(level, pos, do_fade, finished_fade_in);
-                    tile_draw_win_anim(pos);
+                level_set_transition(level, pos, do_fade, finished_fade_in);
+                tile_draw_win_anim(pos);
 
-                    rlPopMatrix();
-                }
+                rlPopMatrix();
             }
         }
         EndShaderMode();
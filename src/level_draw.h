@@ -22,9 +22,11 @@
 #ifndef LEVEL_DRAW_H
 #define LEVEL_DRAW_H
 
+void level_draw_prepare(level_t *level, bool finished);
 void level_draw(level_t *level, bool finishe);
 void level_preview(level_t *level, Rectangle rect);
 void level_draw_for_title(level_t *level, Rectangle rect);
+void cleanup_level_draw(void);
 
 #endif /*LEVEL_DRAW_H*/
 
@@ -0,0 +1,177 @@
+/****************************************************************************
+ *                                                                          *
+ * level_index.c                                                            *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include "level.h"
+#include "level_index.h"
+
+#define LEVEL_INDEX_INITIAL_SIZE 64
+
+/* FNV-1a */
+static uint32_t level_index_hash(const char *str)
+{
+    uint32_t hash = 0x811c9dc5;
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        hash ^= *p;
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+/* NULL if the level has no value for the key */
+static const char *level_index_key_value(level_t *level, level_index_key_t key)
+{
+    switch (key) {
+    case LEVEL_INDEX_UNIQUE_ID:
+        /* collection_find_level_by_unique_id() has always skipped
+         * levels without an id */
+        return level->id ? level->unique_id : NULL;
+
+    case LEVEL_INDEX_ID:
+        return level->id;
+
+    case LEVEL_INDEX_FILENAME:
+        return level->filename;
+
+    case LEVEL_INDEX_NAME:
+        return level->name;
+
+    default:
+        return NULL;
+    }
+}
+
+static bool level_index_entry_is_current(level_index_entry_t *entry, level_index_key_t key)
+{
+    const char *value = level_index_key_value(entry->level, key);
+    return value && (entry->hash == level_index_hash(value));
+}
+
+static void level_index_table_insert(level_index_table_t *table, level_t *level, uint32_t hash)
+{
+    uint32_t mask = table->size - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        level_index_entry_t *entry = &table->entries[i];
+        if (!entry->level) {
+            entry->hash  = hash;
+            entry->level = level;
+            table->count++;
+            return;
+        }
+        if ((entry->level == level) && (entry->hash == hash)) {
+            return;
+        }
+    }
+}
+
+static void level_index_table_grow(level_index_table_t *table, level_index_key_t key)
+{
+    level_index_entry_t *old_entries = table->entries;
+    uint32_t old_size = table->size;
+
+    /* only count the entries that survive the rehash */
+    uint32_t live = 0;
+    for (uint32_t i = 0; i < old_size; i++) {
+        if (old_entries[i].level && level_index_entry_is_current(&old_entries[i], key)) {
+            live++;
+        }
+    }
+
+    uint32_t size = old_size ? old_size : LEVEL_INDEX_INITIAL_SIZE;
+    while (size < 4 * (live + 1)) {
+        size *= 2;
+    }
+
+    table->entries = calloc(size, sizeof(level_index_entry_t));
+    table->size    = size;
+    table->count   = 0;
+
+    for (uint32_t i = 0; i < old_size; i++) {
+        level_index_entry_t *entry = &old_entries[i];
+        if (entry->level && level_index_entry_is_current(entry, key)) {
+            level_index_table_insert(table, entry->level, entry->hash);
+        }
+    }
+
+    SAFEFREE(old_entries);
+}
+
+level_index_t *create_level_index(void)
+{
+    level_index_t *index = calloc(1, sizeof(level_index_t));
+    return index;
+}
+
+void destroy_level_index(level_index_t *index)
+{
+    if (index) {
+        for (int key = 0; key < LEVEL_INDEX_KEY_COUNT; key++) {
+            SAFEFREE(index->tables[key].entries);
+        }
+        SAFEFREE(index);
+    }
+}
+
+void level_index_add(level_index_t *index, level_t *level)
+{
+    assert_not_null(index);
+    assert_not_null(level);
+
+    for (int key = 0; key < LEVEL_INDEX_KEY_COUNT; key++) {
+        const char *value = level_index_key_value(level, key);
+        if (!value) {
+            continue;
+        }
+
+        level_index_table_t *table = &index->tables[key];
+        if (2 * (table->count + 1) > table->size) {
+            level_index_table_grow(table, key);
+        }
+
+        level_index_table_insert(table, level, level_index_hash(value));
+    }
+}
+
+level_t *level_index_find(level_index_t *index, level_index_key_t key, const char *value)
+{
+    assert_not_null(index);
+    assert_not_null(value);
+
+    level_index_table_t *table = &index->tables[key];
+    if (!table->size) {
+        return NULL;
+    }
+
+    uint32_t hash = level_index_hash(value);
+    uint32_t mask = table->size - 1;
+    for (uint32_t i = hash & mask; table->entries[i].level; i = (i + 1) & mask) {
+        level_index_entry_t *entry = &table->entries[i];
+        if (entry->hash == hash) {
+            const char *current = level_index_key_value(entry->level, key);
+            if (current && (0 == strcmp(current, value))) {
+                return entry->level;
+            }
+        }
+    }
+
+    return NULL;
+}
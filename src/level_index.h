@@ -0,0 +1,72 @@
+/****************************************************************************
+ *                                                                          *
+ * level_index.h                                                            *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef LEVEL_INDEX_H
+#define LEVEL_INDEX_H
+
+#include "level.h"
+
+/*
+ * Hash indexes of a collection's levels, so looking a level up by
+ * one of its keys doesn't walk the level list.
+ *
+ * An entry only remembers the level and the hash its key had when it
+ * was added. Lookups compare against the level's current key, so when
+ * a key changes the level is simply added again under the new one and
+ * the old entry never matches anything. Stale entries are dropped
+ * whenever a table grows.
+ */
+
+enum level_index_key {
+    LEVEL_INDEX_UNIQUE_ID = 0,
+    LEVEL_INDEX_ID,
+    LEVEL_INDEX_FILENAME,
+    LEVEL_INDEX_NAME,
+
+    LEVEL_INDEX_KEY_COUNT
+};
+typedef enum level_index_key level_index_key_t;
+
+struct level_index_entry {
+    uint32_t hash;
+    level_t *level;
+};
+typedef struct level_index_entry level_index_entry_t;
+
+struct level_index_table {
+    level_index_entry_t *entries;
+    uint32_t size;    /* always a power of 2 */
+    uint32_t count;
+};
+typedef struct level_index_table level_index_table_t;
+
+struct level_index {
+    level_index_table_t tables[LEVEL_INDEX_KEY_COUNT];
+};
+typedef struct level_index level_index_t;
+
+level_index_t *create_level_index(void);
+void destroy_level_index(level_index_t *index);
+
+void level_index_add(level_index_t *index, level_t *level);
+level_t *level_index_find(level_index_t *index, level_index_key_t key, const char *value);
+
+#endif /*LEVEL_INDEX_H*/
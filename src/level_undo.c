@@ -22,10 +22,13 @@
 #include "common.h"
 #include "level.h"
 #include "level_undo.h"
+#include "level_undo_log.h"
+#include "hex_grid.h"
 
 //#define DEBUG_UNDO_LIST
 
 #define UNDO_LIST_MAX_EVENTS 64
+#define UNDO_ARENA_MAX_CHUNK_SIZE (512 * 1024)
 struct undo_list {
     undo_event_t events[UNDO_LIST_MAX_EVENTS];
     int last;
@@ -135,11 +138,9 @@ static void print_undo(undo_t *undo)
 }
 #endif
 
-static undo_list_t *create_undo_list(void)
+static undo_list_t *create_undo_list(arena_t *arena)
 {
-    undo_list_t *list = calloc(1, sizeof(undo_list_t));list->current++;
-
-    memset(&(list->events[0]), 0, sizeof(list->events));
+    undo_list_t *list = arena_calloc(arena, 1, sizeof(undo_list_t));
 
     list->last    = 0;
     list->current = 0;
@@ -150,37 +151,14 @@ static undo_list_t *create_undo_list(void)
     return list;
 }
 
-static void cleanup_undo_event(undo_event_t *event)
+static void print_undo_arena_stats(undo_t *undo, const char *label)
 {
-    switch (event->edit.type) {
-    case UNDO_EDIT_TYPE_SHUFFLE:
-        SAFEFREE(event->edit.shuffle.from);
-        SAFEFREE(event->edit.shuffle.to);
-        break;
-
-    default:
-        /* do nothing */
-        break;
-    }
-}
-
-static void destroy_undo_list(undo_list_t *list)
-{
-    for (int i=0; i<list->last; i++) {
-        cleanup_undo_event(&(list->events[i]));
-    }
-
-    if (list->prev) {
-        list->prev->next = NULL;
-        destroy_undo_list(list->prev);
-        list->prev = NULL;
-    }
-    if (list->next) {
-        list->next->prev = NULL;
-        destroy_undo_list(list->next);
-        list->next = NULL;
-    }
-    SAFEFREE(list);
+    infomsg("UNDO(%s): %d events, %zu bytes used (%zu reserved in %d chunks)",
+            label,
+            undo->event_count,
+            undo->arena->bytes_used,
+            undo->arena->bytes_reserved,
+            undo->arena->chunk_count);
 }
 
 static undo_list_t *find_current_list(undo_list_t *list)
@@ -295,31 +273,53 @@ undo_t *create_level_undo(struct level *level)
     undo_t *undo = calloc(1, sizeof(undo_t));
 
     undo->level = level;
+    /* the first chunk only holds the empty play and edit lists;
+     * it grows from there if the level is actually played */
+    undo->arena = create_arena(2 * ARENA_ALIGN(sizeof(undo_list_t)), UNDO_ARENA_MAX_CHUNK_SIZE);
 
-    undo->play_count = 0;
-    undo->edit_count = 0;
-
-    undo->play_event_list = create_undo_list();
-    undo->edit_event_list = create_undo_list();
+    reset_level_undo(undo);
 
     return undo;
 }
 
 void destroy_level_undo(undo_t *undo)
 {
-    if (undo->play_event_list) {
-        destroy_undo_list(undo->play_event_list);
-        undo->play_event_list = NULL;
-    }
+    level_undo_log_detach(undo->level);
 
-    if (undo->edit_event_list) {
-        destroy_undo_list(undo->edit_event_list);
-        undo->edit_event_list = NULL;
+    if (options->verbose && undo->event_count > 0) {
+        print_undo_arena_stats(undo, "destroy");
     }
 
+    /* frees every event list and snapshot in one step */
+    destroy_arena(undo->arena);
+    undo->arena = NULL;
+
+    undo->play_event_list = NULL;
+    undo->edit_event_list = NULL;
+
     SAFEFREE(undo);
 }
 
+void reset_level_undo(undo_t *undo)
+{
+    assert_not_null(undo);
+    assert_not_null(undo->arena);
+
+    if (options->verbose && undo->event_count > 0) {
+        print_undo_arena_stats(undo, "reset");
+    }
+
+    arena_reset(undo->arena);
+    level_undo_log_truncate(undo->level);
+
+    undo->play_count  = 0;
+    undo->edit_count  = 0;
+    undo->event_count = 0;
+
+    undo->play_event_list = create_undo_list(undo->arena);
+    undo->edit_event_list = create_undo_list(undo->arena);
+}
+
 void chain_with_prev_edit_event(level_t *level, undo_event_t *event)
 {
     undo_event_t *prev = find_prev_event(level->undo->edit_event_list);
@@ -367,7 +367,7 @@ void level_undo_add_event(level_t *level, undo_event_t event)
     while ((list->last    == UNDO_LIST_MAX_EVENTS) &&
            (list->current == UNDO_LIST_MAX_EVENTS)) {
         if (!list->next) {
-            undo_list_t *newlist = create_undo_list();
+            undo_list_t *newlist = create_undo_list(level->undo->arena);
             newlist->prev = list;
             list->next = newlist;
         }
@@ -380,6 +380,10 @@ void level_undo_add_event(level_t *level, undo_event_t event)
     list->current++;
     list->last = list->current;
 
+    level->undo->event_count++;
+
+    level_undo_log_event(level, &event);
+
 #ifdef DEBUG_UNDO_LIST
     print_undo(level->undo);
     //print_undo_lists(list);
@@ -417,14 +421,34 @@ void level_undo_add_swap_event(level_t *level, hex_axial_t a, hex_axial_t b)
     event.type = UNDO_EVENT_TYPE_PLAY;    \
     event.play.type = UNDO_PLAY_TYPE_##enum_name;
 
+static void take_tile_snapshot(level_t *level, undo_tile_snapshot_t *snapshot)
+{
+    int count = level->grid->maxtiles;
+
+    snapshot->tile_count         = count;
+    snapshot->tiles              = arena_alloc(level->undo->arena, count * sizeof(tile_t));
+    snapshot->unsolved_positions = arena_alloc(level->undo->arena, count * sizeof(tile_pos_t));
+
+    memcpy(snapshot->tiles, level->tiles, count * sizeof(tile_t));
+    memcpy(snapshot->unsolved_positions, level->unsolved_positions, count * sizeof(tile_pos_t));
+}
+
+static void restore_tile_snapshot(level_t *level, undo_tile_snapshot_t *snapshot)
+{
+    assert(snapshot->tile_count == level->grid->maxtiles);
+
+    memcpy(level->tiles, snapshot->tiles, snapshot->tile_count * sizeof(tile_t));
+    memcpy(level->unsolved_positions, snapshot->unsolved_positions, snapshot->tile_count * sizeof(tile_pos_t));
+}
+
 undo_reset_data_t *level_undo_copy_reset_data(level_t *level)
 {
-    undo_reset_data_t *data = calloc(1, sizeof(undo_reset_data_t));
+    assert_not_null(level->undo);
+    undo_reset_data_t *data = arena_calloc(level->undo->arena, 1, sizeof(undo_reset_data_t));
 
     data->finished = level->finished;
 
-    memcpy(data->tiles, level->tiles, sizeof(data->tiles));
-    memcpy(data->unsolved_positions, level->unsolved_positions, sizeof(data->unsolved_positions));
+    take_tile_snapshot(level, &data->snapshot);
     if (level->win_anim) {
         data->have_win_anim = true;
         memcpy(&data->win_anim, level->win_anim, sizeof(data->win_anim));
@@ -559,10 +583,10 @@ void level_undo_add_change_paths_event(
 
 undo_shuffle_data_t *level_undo_copy_shuffle_data(level_t *level)
 {
-    undo_shuffle_data_t *data = calloc(1, sizeof(undo_shuffle_data_t));
+    assert_not_null(level->undo);
+    undo_shuffle_data_t *data = arena_calloc(level->undo->arena, 1, sizeof(undo_shuffle_data_t));
 
-    memcpy(data->tiles, level->tiles, sizeof(data->tiles));
-    memcpy(data->unsolved_positions, level->unsolved_positions, sizeof(data->unsolved_positions));
+    take_tile_snapshot(level, &data->snapshot);
 
     return data;
 }
@@ -656,8 +680,7 @@ static void replay_change_path(UNUSED level_t *level, undo_change_path_event_t e
 
 static void apply_shuffle_data(level_t *level, undo_shuffle_data_t *data)
 {
-    memcpy(level->tiles, data->tiles, sizeof(data->tiles));
-    memcpy(level->unsolved_positions, data->unsolved_positions, sizeof(data->unsolved_positions));
+    restore_tile_snapshot(level, &data->snapshot);
 }
 
 static void rewind_shuffle(level_t *level, undo_shuffle_t event)
@@ -672,9 +695,7 @@ static void replay_shuffle(level_t *level, undo_shuffle_t event)
 
 static void apply_reset_data(level_t *level, undo_reset_data_t *data)
 {
-
-    memcpy(level->tiles, data->tiles, sizeof(data->tiles));
-    memcpy(level->unsolved_positions, data->unsolved_positions, sizeof(data->unsolved_positions));
+    restore_tile_snapshot(level, &data->snapshot);
 
     if (data->finished) {
         level_win(level);
@@ -733,6 +754,7 @@ void level_undo_play(level_t *level)
     assert(event.type == UNDO_EVENT_TYPE_PLAY);
 
     level->undo->play_count--;
+    level_undo_log_undo(level, UNDO_EVENT_TYPE_PLAY);
 #ifdef DEBUG_UNDO_LIST
     printf("\nafter undo_play\n");
     print_undo(level->undo);
@@ -777,6 +799,7 @@ void level_undo_edit(level_t *level)
         assert(event.type == UNDO_EVENT_TYPE_EDIT);
 
         level->undo->edit_count--;
+        level_undo_log_undo(level, UNDO_EVENT_TYPE_EDIT);
 
 #ifdef DEBUG_UNDO_LIST
         print_undo_lists(level->undo->edit_event_list);
@@ -840,6 +863,7 @@ void level_redo_play(level_t *level)
     assert(event.type == UNDO_EVENT_TYPE_PLAY);
 
     level->undo->play_count++;
+    level_undo_log_redo(level, UNDO_EVENT_TYPE_PLAY);
 
 #ifdef DEBUG_UNDO_LIST
     print_undo_lists(level->undo->play_event_list);
@@ -883,6 +907,7 @@ void level_redo_edit(level_t *level)
         assert(event.type == UNDO_EVENT_TYPE_EDIT);
 
         level->undo->edit_count++;
+        level_undo_log_redo(level, UNDO_EVENT_TYPE_EDIT);
 
 #ifdef DEBUG_UNDO_LIST
         print_undo_lists(level->undo->edit_event_list);
@@ -930,6 +955,73 @@ void level_redo_edit(level_t *level)
     } while(event.chain_next);
 }
 
+/*
+ * These move through the history without touching the level, and are
+ * used to rebuild the undo lists from a saved undo log. The level is
+ * expected to already be in the state the log ends with.
+ */
+
+static undo_list_t **get_event_list_ptr(level_t *level, undo_event_type_t type, int **countp)
+{
+    switch (type) {
+    case UNDO_EVENT_TYPE_PLAY:
+        *countp = &level->undo->play_count;
+        return &level->undo->play_event_list;
+
+    case UNDO_EVENT_TYPE_EDIT:
+        *countp = &level->undo->edit_count;
+        return &level->undo->edit_event_list;
+
+    default:
+        __builtin_unreachable();
+    }
+}
+
+bool level_undo_step_back(level_t *level, undo_event_type_t type)
+{
+    assert_not_null(level);
+    assert_not_null(level->undo);
+
+    int *count;
+    undo_list_t **list = get_event_list_ptr(level, type, &count);
+
+    if (_get_undo_event(*list, true)) {
+        (*count)--;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool level_undo_step_forward(level_t *level, undo_event_type_t type)
+{
+    assert_not_null(level);
+    assert_not_null(level->undo);
+
+    int *count;
+    undo_list_t **list = get_event_list_ptr(level, type, &count);
+
+    if (_get_redo_event(*list, true)) {
+        (*count)++;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+void level_undo_clear_history(level_t *level, undo_event_type_t type)
+{
+    assert_not_null(level);
+    assert_not_null(level->undo);
+
+    int *count;
+    undo_list_t **list = get_event_list_ptr(level, type, &count);
+
+    /* the old list stays in the arena until the next reset */
+    *list  = create_undo_list(level->undo->arena);
+    *count = 0;
+}
+
 static undo_list_t *get_current_event_list(level_t *level)
 {
     switch (game_mode) {
@@ -22,6 +22,7 @@
 #ifndef LEVEL_UNDO_H
 #define LEVEL_UNDO_H
 
+#include "arena.h"
 #include "hex.h"
 #include "tile.h"
 #include "level.h"
@@ -76,9 +77,17 @@ struct undo_change_path_event {
 };
 typedef struct undo_change_path_event undo_change_path_event_t;
 
+/* copy of the level's tiles and unsolved positions; both arrays
+ * have tile_count (the level's grid->maxtiles) entries */
+struct undo_tile_snapshot {
+    int tile_count;
+    tile_t *tiles;
+    tile_pos_t *unsolved_positions;
+};
+typedef struct undo_tile_snapshot undo_tile_snapshot_t;
+
 struct undo_shuffle_data {
-    tile_t tiles[LEVEL_MAXTILES];
-    tile_pos_t unsolved_positions[LEVEL_MAXTILES];
+    undo_tile_snapshot_t snapshot;
 };
 typedef struct undo_shuffle_data undo_shuffle_data_t;
 
@@ -91,8 +100,7 @@ typedef struct undo_shuffle undo_shuffle_t;
 struct undo_reset_data {
     bool finished;
 
-    tile_t tiles[LEVEL_MAXTILES];
-    tile_pos_t unsolved_positions[LEVEL_MAXTILES];
+    undo_tile_snapshot_t snapshot;
 
     bool have_win_anim;
     win_anim_t win_anim;
@@ -180,13 +188,19 @@ struct undo {
     int edit_count;
     struct undo_list *play_event_list;
     struct undo_list *edit_event_list;
+
+    /* all undo lists and snapshot data are allocated from here */
+    arena_t *arena;
+    int event_count;
 };
 typedef struct undo undo_t;
 
 
 undo_t *create_level_undo(struct level *level);
 void destroy_level_undo(undo_t *undo);
+void reset_level_undo(undo_t *undo);
 
+void chain_with_prev_edit_event(level_t *level, undo_event_t *event);
 void level_undo_add_event(level_t *level, undo_event_t event);
 void level_undo_add_play_event(level_t *level, undo_play_event_t event);
 void level_undo_add_edit_event(level_t *level, undo_edit_event_t event);
@@ -244,5 +258,9 @@ void level_redo_edit(level_t *level);
 bool level_can_undo(level_t *level);
 bool level_can_redo(level_t *level);
 
+bool level_undo_step_back(level_t *level, undo_event_type_t type);
+bool level_undo_step_forward(level_t *level, undo_event_type_t type);
+void level_undo_clear_history(level_t *level, undo_event_type_t type);
+
 #endif /*LEVEL_UNDO_H*/
 
@@ -0,0 +1,630 @@
+/****************************************************************************
+ *                                                                          *
+ * level_undo_log.c                                                         *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "level.h"
+#include "level_undo.h"
+#include "level_undo_log.h"
+#include "hex_grid.h"
+
+#define UNDO_LOG_HEADER_SIZE      5
+#define UNDO_LOG_RECORD_MAX_SIZE  256
+#define UNDO_LOG_NULL_SLOT        0xffff
+
+/* u16 tile slot, u8 section, u8 path, u8 hidden_saved, u8 enabled_saved */
+#define UNDO_LOG_PATH_STATE_SIZE  6
+#define UNDO_LOG_PATHS_SIZE       (6 * 2 * UNDO_LOG_PATH_STATE_SIZE)
+
+char *level_undo_log_path = NULL;
+
+static FILE *log_file = NULL;
+static level_t *log_level = NULL;
+static bool replaying = false;
+
+static size_t undo_log_record_size(uint8_t code)
+{
+    switch (code & UNDO_LOG_RECORD_CODE_MASK) {
+    case UNDO_LOG_RECORD_PLAY_RESET:
+    case UNDO_LOG_RECORD_EDIT_SHUFFLE:
+    case UNDO_LOG_RECORD_UNDO_PLAY:
+    case UNDO_LOG_RECORD_REDO_PLAY:
+    case UNDO_LOG_RECORD_UNDO_EDIT:
+    case UNDO_LOG_RECORD_REDO_EDIT:
+        return 1;
+
+    case UNDO_LOG_RECORD_EDIT_USE_TILES:
+    case UNDO_LOG_RECORD_EDIT_SET_RADIUS:
+        return 1 + 1 + 1;
+
+    case UNDO_LOG_RECORD_PLAY_SWAP:
+    case UNDO_LOG_RECORD_EDIT_SWAP:
+        return 1 + 2 + 2;
+
+    case UNDO_LOG_RECORD_EDIT_SET_FLAGS:
+        return 1 + 2 + 1 + 1;
+
+    case UNDO_LOG_RECORD_EDIT_SET_FLAGS_AND_PATHS:
+        return 1 + 2 + 1 + 1 + (2 * UNDO_LOG_PATHS_SIZE);
+
+    case UNDO_LOG_RECORD_EDIT_CHANGE_PATH:
+        return 1 + (2 * (2 + 1 + 1 + 1));
+
+    default:
+        return 0;
+    }
+}
+
+/*** encoding ***/
+
+static void put_u8(unsigned char *buf, size_t *len, uint8_t value)
+{
+    buf[(*len)++] = value;
+}
+
+static void put_u16(unsigned char *buf, size_t *len, uint16_t value)
+{
+    buf[(*len)++] = value & 0xff;
+    buf[(*len)++] = (value >> 8) & 0xff;
+}
+
+static uint16_t axial_slot(hex_axial_t axial)
+{
+    return (uint16_t)level_axial_to_idx(log_level, axial);
+}
+
+static uint16_t tile_slot(tile_t *tile)
+{
+    if (tile && tile->solved_pos) {
+        return axial_slot(tile->solved_pos->position);
+    } else {
+        return UNDO_LOG_NULL_SLOT;
+    }
+}
+
+static uint8_t pack_flags(tile_flags_t flags)
+{
+    return ((flags.enabled ? 1 : 0) |
+            (flags.fixed   ? 2 : 0) |
+            (flags.hidden  ? 4 : 0));
+}
+
+static void put_path_state(unsigned char *buf, size_t *len, path_state_t *state)
+{
+    put_u16(buf, len, tile_slot(state->tile));
+    put_u8(buf, len, state->section);
+    put_u8(buf, len, state->path);
+    put_u8(buf, len, state->hidden_saved_path);
+    put_u8(buf, len, state->enabled_saved_path);
+}
+
+static void put_paths(unsigned char *buf, size_t *len, tile_neighbor_paths_t *paths)
+{
+    each_direction {
+        put_path_state(buf, len, &paths->sections[dir].local);
+        put_path_state(buf, len, &paths->sections[dir].neighbor);
+    }
+}
+
+static size_t encode_play_event(unsigned char *buf, undo_play_event_t *event)
+{
+    size_t len = 0;
+
+    switch (event->type) {
+    case UNDO_PLAY_TYPE_SWAP:
+        put_u8(buf, &len, UNDO_LOG_RECORD_PLAY_SWAP);
+        put_u16(buf, &len, axial_slot(event->swap.a));
+        put_u16(buf, &len, axial_slot(event->swap.b));
+        break;
+
+    case UNDO_PLAY_TYPE_RESET:
+        /* snapshots are too big to log; replay drops older history */
+        put_u8(buf, &len, UNDO_LOG_RECORD_PLAY_RESET);
+        break;
+
+    default:
+        break;
+    }
+
+    return len;
+}
+
+static size_t encode_edit_event(unsigned char *buf, undo_edit_event_t *event)
+{
+    size_t len = 0;
+
+    switch (event->type) {
+    case UNDO_EDIT_TYPE_SWAP:
+        put_u8(buf, &len, UNDO_LOG_RECORD_EDIT_SWAP);
+        put_u16(buf, &len, axial_slot(event->swap.a));
+        put_u16(buf, &len, axial_slot(event->swap.b));
+        break;
+
+    case UNDO_EDIT_TYPE_USE_TILES:
+        put_u8(buf, &len, UNDO_LOG_RECORD_EDIT_USE_TILES);
+        put_u8(buf, &len, event->use_tiles.from);
+        put_u8(buf, &len, event->use_tiles.to);
+        break;
+
+    case UNDO_EDIT_TYPE_SET_RADIUS:
+        put_u8(buf, &len, UNDO_LOG_RECORD_EDIT_SET_RADIUS);
+        put_u8(buf, &len, event->set_radius.from);
+        put_u8(buf, &len, event->set_radius.to);
+        break;
+
+    case UNDO_EDIT_TYPE_SET_FLAGS:
+        put_u8(buf, &len, UNDO_LOG_RECORD_EDIT_SET_FLAGS);
+        put_u16(buf, &len, tile_slot(event->set_flags.tile));
+        put_u8(buf, &len, pack_flags(event->set_flags.from));
+        put_u8(buf, &len, pack_flags(event->set_flags.to));
+        break;
+
+    case UNDO_EDIT_TYPE_SET_FLAGS_AND_PATHS:
+        put_u8(buf, &len, UNDO_LOG_RECORD_EDIT_SET_FLAGS_AND_PATHS);
+        put_u16(buf, &len, tile_slot(event->set_flags_and_paths.tile));
+        put_u8(buf, &len, pack_flags(event->set_flags_and_paths.flags_from));
+        put_u8(buf, &len, pack_flags(event->set_flags_and_paths.flags_to));
+        put_paths(buf, &len, &event->set_flags_and_paths.paths_from);
+        put_paths(buf, &len, &event->set_flags_and_paths.paths_to);
+        break;
+
+    case UNDO_EDIT_TYPE_CHANGE_PATH:
+        put_u8(buf, &len, UNDO_LOG_RECORD_EDIT_CHANGE_PATH);
+        put_u16(buf, &len, tile_slot(event->change_path.tile1));
+        put_u8(buf, &len, event->change_path.tile1_section);
+        put_u8(buf, &len, event->change_path.tile1_path_from);
+        put_u8(buf, &len, event->change_path.tile1_path_to);
+        put_u16(buf, &len, tile_slot(event->change_path.tile2));
+        put_u8(buf, &len, event->change_path.tile2_section);
+        put_u8(buf, &len, event->change_path.tile2_path_from);
+        put_u8(buf, &len, event->change_path.tile2_path_to);
+        break;
+
+    case UNDO_EDIT_TYPE_SHUFFLE:
+        put_u8(buf, &len, UNDO_LOG_RECORD_EDIT_SHUFFLE);
+        break;
+
+    default:
+        break;
+    }
+
+    return len;
+}
+
+/*** decoding ***/
+
+static uint8_t get_u8(const unsigned char *buf, size_t *pos)
+{
+    return buf[(*pos)++];
+}
+
+static uint16_t get_u16(const unsigned char *buf, size_t *pos)
+{
+    uint16_t value = buf[*pos] | (buf[*pos + 1] << 8);
+    *pos += 2;
+    return value;
+}
+
+static bool get_axial(const unsigned char *buf, size_t *pos, level_t *level, hex_axial_t *axial)
+{
+    uint16_t slot = get_u16(buf, pos);
+    if (slot >= level->grid->maxtiles) {
+        return false;
+    }
+
+    *axial = level->solved_positions[slot].position;
+    return true;
+}
+
+static bool get_tile(const unsigned char *buf, size_t *pos, level_t *level, tile_t **tile)
+{
+    uint16_t slot = get_u16(buf, pos);
+    if (slot == UNDO_LOG_NULL_SLOT) {
+        *tile = NULL;
+        return true;
+    }
+    if (slot >= level->grid->maxtiles) {
+        return false;
+    }
+
+    *tile = level->solved_positions[slot].tile;
+    return true;
+}
+
+static tile_flags_t unpack_flags(uint8_t packed)
+{
+    tile_flags_t flags = {
+        .enabled = (packed & 1) != 0,
+        .fixed   = (packed & 2) != 0,
+        .hidden  = (packed & 4) != 0
+    };
+    return flags;
+}
+
+static bool get_path_state(const unsigned char *buf, size_t *pos, level_t *level, path_state_t *state)
+{
+    if (!get_tile(buf, pos, level, &state->tile)) {
+        return false;
+    }
+    state->section            = get_u8(buf, pos);
+    state->path               = get_u8(buf, pos);
+    state->hidden_saved_path  = get_u8(buf, pos);
+    state->enabled_saved_path = get_u8(buf, pos);
+    return true;
+}
+
+static bool get_paths(const unsigned char *buf, size_t *pos, level_t *level, tile_neighbor_paths_t *paths)
+{
+    each_direction {
+        if (!get_path_state(buf, pos, level, &paths->sections[dir].local)) {
+            return false;
+        }
+        if (!get_path_state(buf, pos, level, &paths->sections[dir].neighbor)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool decode_event(const unsigned char *buf, level_t *level, undo_event_t *event)
+{
+    size_t pos = 0;
+    uint8_t code = get_u8(buf, &pos);
+
+    memset(event, 0, sizeof(undo_event_t));
+
+    switch (code & UNDO_LOG_RECORD_CODE_MASK) {
+    case UNDO_LOG_RECORD_PLAY_SWAP:
+        event->type = UNDO_EVENT_TYPE_PLAY;
+        event->play.type = UNDO_PLAY_TYPE_SWAP;
+        return (get_axial(buf, &pos, level, &event->play.swap.a) &&
+                get_axial(buf, &pos, level, &event->play.swap.b));
+
+    case UNDO_LOG_RECORD_EDIT_SWAP:
+        event->type = UNDO_EVENT_TYPE_EDIT;
+        event->edit.type = UNDO_EDIT_TYPE_SWAP;
+        return (get_axial(buf, &pos, level, &event->edit.swap.a) &&
+                get_axial(buf, &pos, level, &event->edit.swap.b));
+
+    case UNDO_LOG_RECORD_EDIT_USE_TILES:
+        event->type = UNDO_EVENT_TYPE_EDIT;
+        event->edit.type = UNDO_EDIT_TYPE_USE_TILES;
+        event->edit.use_tiles.from = get_u8(buf, &pos);
+        event->edit.use_tiles.to   = get_u8(buf, &pos);
+        return true;
+
+    case UNDO_LOG_RECORD_EDIT_SET_RADIUS:
+        event->type = UNDO_EVENT_TYPE_EDIT;
+        event->edit.type = UNDO_EDIT_TYPE_SET_RADIUS;
+        event->edit.set_radius.from = get_u8(buf, &pos);
+        event->edit.set_radius.to   = get_u8(buf, &pos);
+        return true;
+
+    case UNDO_LOG_RECORD_EDIT_SET_FLAGS:
+        event->type = UNDO_EVENT_TYPE_EDIT;
+        event->edit.type = UNDO_EDIT_TYPE_SET_FLAGS;
+        if (!get_tile(buf, &pos, level, &event->edit.set_flags.tile) || !event->edit.set_flags.tile) {
+            return false;
+        }
+        event->edit.set_flags.from = unpack_flags(get_u8(buf, &pos));
+        event->edit.set_flags.to   = unpack_flags(get_u8(buf, &pos));
+        return true;
+
+    case UNDO_LOG_RECORD_EDIT_SET_FLAGS_AND_PATHS:
+        event->type = UNDO_EVENT_TYPE_EDIT;
+        event->edit.type = UNDO_EDIT_TYPE_SET_FLAGS_AND_PATHS;
+        if (!get_tile(buf, &pos, level, &event->edit.set_flags_and_paths.tile) ||
+            !event->edit.set_flags_and_paths.tile) {
+            return false;
+        }
+        event->edit.set_flags_and_paths.flags_from = unpack_flags(get_u8(buf, &pos));
+        event->edit.set_flags_and_paths.flags_to   = unpack_flags(get_u8(buf, &pos));
+        return (get_paths(buf, &pos, level, &event->edit.set_flags_and_paths.paths_from) &&
+                get_paths(buf, &pos, level, &event->edit.set_flags_and_paths.paths_to));
+
+    case UNDO_LOG_RECORD_EDIT_CHANGE_PATH:
+        event->type = UNDO_EVENT_TYPE_EDIT;
+        event->edit.type = UNDO_EDIT_TYPE_CHANGE_PATH;
+        if (!get_tile(buf, &pos, level, &event->edit.change_path.tile1)) {
+            return false;
+        }
+        event->edit.change_path.tile1_section   = get_u8(buf, &pos);
+        event->edit.change_path.tile1_path_from = get_u8(buf, &pos);
+        event->edit.change_path.tile1_path_to   = get_u8(buf, &pos);
+        if (!get_tile(buf, &pos, level, &event->edit.change_path.tile2)) {
+            return false;
+        }
+        event->edit.change_path.tile2_section   = get_u8(buf, &pos);
+        event->edit.change_path.tile2_path_from = get_u8(buf, &pos);
+        event->edit.change_path.tile2_path_to   = get_u8(buf, &pos);
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/*** log file management ***/
+
+static void close_log_file(void)
+{
+    if (log_file) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+    log_level = NULL;
+}
+
+static bool open_log_file(level_t *level)
+{
+    close_log_file();
+
+    if (!level_undo_log_path || demo_mode) {
+        return false;
+    }
+
+    log_file = fopen(level_undo_log_path, "wb");
+    if (NULL == log_file) {
+        errmsg("Could not open undo log \"%s\" for writing: %s",
+               level_undo_log_path, strerror(errno));
+        return false;
+    }
+
+    unsigned char header[UNDO_LOG_HEADER_SIZE];
+    memcpy(header, UNDO_LOG_MAGIC, 4);
+    header[4] = UNDO_LOG_VERSION;
+
+    if (1 != fwrite(header, sizeof(header), 1, log_file)) {
+        errmsg("Error writing undo log header to \"%s\"", level_undo_log_path);
+        close_log_file();
+        return false;
+    }
+    fflush(log_file);
+
+    log_level = level;
+    return true;
+}
+
+static void append_record(const unsigned char *buf, size_t len)
+{
+    if (!log_file || !len) {
+        return;
+    }
+
+    if (1 != fwrite(buf, len, 1, log_file)) {
+        errmsg("Error appending to undo log \"%s\" - undo history will not be saved",
+               level_undo_log_path);
+        close_log_file();
+        return;
+    }
+
+    fflush(log_file);
+}
+
+void level_undo_log_start(level_t *level)
+{
+    assert_not_null(level);
+
+    open_log_file(level);
+}
+
+void level_undo_log_detach(level_t *level)
+{
+    if (level && level == log_level) {
+        close_log_file();
+    }
+}
+
+void level_undo_log_truncate(level_t *level)
+{
+    if (level && level == log_level && !replaying) {
+        open_log_file(level);
+    }
+}
+
+void level_undo_log_event(level_t *level, undo_event_t *event)
+{
+    assert_not_null(event);
+
+    if (level != log_level || replaying) {
+        return;
+    }
+
+    unsigned char buf[UNDO_LOG_RECORD_MAX_SIZE];
+    size_t len = 0;
+
+    switch (event->type) {
+    case UNDO_EVENT_TYPE_PLAY:
+        len = encode_play_event(buf, &event->play);
+        break;
+
+    case UNDO_EVENT_TYPE_EDIT:
+        len = encode_edit_event(buf, &event->edit);
+        break;
+
+    default:
+        __builtin_unreachable();
+    }
+
+    if (len && event->chain_prev) {
+        buf[0] |= UNDO_LOG_RECORD_CHAIN_PREV;
+    }
+
+    append_record(buf, len);
+}
+
+static void log_cursor_record(level_t *level, uint8_t code)
+{
+    if (level != log_level || replaying) {
+        return;
+    }
+
+    append_record(&code, 1);
+}
+
+void level_undo_log_undo(level_t *level, undo_event_type_t type)
+{
+    log_cursor_record(level, (type == UNDO_EVENT_TYPE_PLAY)
+                      ? UNDO_LOG_RECORD_UNDO_PLAY
+                      : UNDO_LOG_RECORD_UNDO_EDIT);
+}
+
+void level_undo_log_redo(level_t *level, undo_event_type_t type)
+{
+    log_cursor_record(level, (type == UNDO_EVENT_TYPE_PLAY)
+                      ? UNDO_LOG_RECORD_REDO_PLAY
+                      : UNDO_LOG_RECORD_REDO_EDIT);
+}
+
+bool level_undo_log_save_as(level_t *level, const char *path)
+{
+    assert_not_null(path);
+
+    if (!level || level != log_level) {
+        return false;
+    }
+
+    close_log_file();
+
+    if (-1 == rename(level_undo_log_path, path)) {
+        errmsg("Error trying to rename \"%s\" to \"%s\": %s",
+               level_undo_log_path, path, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+/*** replay ***/
+
+static bool replay_record(level_t *level, const unsigned char *buf)
+{
+    undo_event_t event;
+
+    switch (buf[0] & UNDO_LOG_RECORD_CODE_MASK) {
+    case UNDO_LOG_RECORD_PLAY_RESET:
+        level_undo_clear_history(level, UNDO_EVENT_TYPE_PLAY);
+        return true;
+
+    case UNDO_LOG_RECORD_EDIT_SHUFFLE:
+        level_undo_clear_history(level, UNDO_EVENT_TYPE_EDIT);
+        return true;
+
+    case UNDO_LOG_RECORD_UNDO_PLAY:
+        level_undo_step_back(level, UNDO_EVENT_TYPE_PLAY);
+        return true;
+
+    case UNDO_LOG_RECORD_REDO_PLAY:
+        level_undo_step_forward(level, UNDO_EVENT_TYPE_PLAY);
+        return true;
+
+    case UNDO_LOG_RECORD_UNDO_EDIT:
+        level_undo_step_back(level, UNDO_EVENT_TYPE_EDIT);
+        return true;
+
+    case UNDO_LOG_RECORD_REDO_EDIT:
+        level_undo_step_forward(level, UNDO_EVENT_TYPE_EDIT);
+        return true;
+
+    default:
+        if (!decode_event(buf, level, &event)) {
+            return false;
+        }
+
+        if (buf[0] & UNDO_LOG_RECORD_CHAIN_PREV) {
+            chain_with_prev_edit_event(level, &event);
+        }
+
+        level_undo_add_event(level, event);
+        return true;
+    }
+}
+
+bool level_undo_log_replay(level_t *level, const char *path)
+{
+    assert_not_null(level);
+    assert_not_null(level->undo);
+    assert_not_null(path);
+
+    int size = 0;
+    unsigned char *data = LoadFileData(path, &size);
+    if (!data) {
+        errmsg("Could not read undo log \"%s\"", path);
+        return false;
+    }
+
+    bool rv = false;
+    int count = 0;
+
+    if ((size < UNDO_LOG_HEADER_SIZE) ||
+        (0 != memcmp(data, UNDO_LOG_MAGIC, 4))) {
+        errmsg("Error parsing undo log \"%s\": bad header", path);
+        goto replay_cleanup;
+    }
+
+    if (data[4] != UNDO_LOG_VERSION) {
+        errmsg("Undo log \"%s\" is version %d, expected %d",
+               path, data[4], UNDO_LOG_VERSION);
+        goto replay_cleanup;
+    }
+
+    replaying = true;
+
+    size_t pos = UNDO_LOG_HEADER_SIZE;
+    while (pos < (size_t)size) {
+        size_t record_size = undo_log_record_size(data[pos]);
+        if (!record_size) {
+            errmsg("Error parsing undo log \"%s\": unknown record 0x%02x at offset %zu",
+                   path, data[pos], pos);
+            break;
+        }
+
+        if ((pos + record_size) > (size_t)size) {
+            /* probably interrupted while appending */
+            warnmsg("Ignoring truncated record at the end of undo log \"%s\"", path);
+            break;
+        }
+
+        if (!replay_record(level, &data[pos])) {
+            errmsg("Error parsing undo log \"%s\": invalid record at offset %zu",
+                   path, pos);
+            break;
+        }
+
+        /* carry the replayed history over to the active log */
+        if (level == log_level) {
+            append_record(&data[pos], record_size);
+        }
+
+        pos += record_size;
+        count++;
+    }
+
+    replaying = false;
+    rv = true;
+
+    if (options->verbose) {
+        infomsg("Replayed %d undo log records from \"%s\"", count, path);
+    }
+
+  replay_cleanup:
+    UnloadFileData(data);
+    return rv;
+}
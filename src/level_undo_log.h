@@ -0,0 +1,68 @@
+/****************************************************************************
+ *                                                                          *
+ * level_undo_log.h                                                         *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef LEVEL_UNDO_LOG_H
+#define LEVEL_UNDO_LOG_H
+
+#include "level_undo.h"
+
+/*
+ * Compact binary log of a level's undo history. Every undo event,
+ * undo, and redo is appended to the log as it happens, so the history
+ * can be rebuilt after a restart without ever rewriting the file.
+ */
+
+#define UNDO_LOG_MAGIC   "HXUL"
+#define UNDO_LOG_VERSION 1
+
+/* record codes; the high bit flags an event chained with the previous one */
+#define UNDO_LOG_RECORD_CHAIN_PREV               0x80
+#define UNDO_LOG_RECORD_CODE_MASK                0x7f
+
+#define UNDO_LOG_RECORD_PLAY_SWAP                0x01
+#define UNDO_LOG_RECORD_PLAY_RESET               0x02
+#define UNDO_LOG_RECORD_EDIT_SWAP                0x11
+#define UNDO_LOG_RECORD_EDIT_USE_TILES           0x12
+#define UNDO_LOG_RECORD_EDIT_SET_RADIUS          0x13
+#define UNDO_LOG_RECORD_EDIT_SET_FLAGS           0x14
+#define UNDO_LOG_RECORD_EDIT_SET_FLAGS_AND_PATHS 0x15
+#define UNDO_LOG_RECORD_EDIT_CHANGE_PATH         0x16
+#define UNDO_LOG_RECORD_EDIT_SHUFFLE             0x17
+#define UNDO_LOG_RECORD_UNDO_PLAY                0x20
+#define UNDO_LOG_RECORD_REDO_PLAY                0x21
+#define UNDO_LOG_RECORD_UNDO_EDIT                0x22
+#define UNDO_LOG_RECORD_REDO_EDIT                0x23
+
+extern char *level_undo_log_path;
+
+void level_undo_log_start(level_t *level);
+void level_undo_log_detach(level_t *level);
+void level_undo_log_truncate(level_t *level);
+
+void level_undo_log_event(level_t *level, undo_event_t *event);
+void level_undo_log_undo(level_t *level, undo_event_type_t type);
+void level_undo_log_redo(level_t *level, undo_event_type_t type);
+
+bool level_undo_log_save_as(level_t *level, const char *path);
+bool level_undo_log_replay(level_t *level, const char *path);
+
+#endif /*LEVEL_UNDO_LOG_H*/
+
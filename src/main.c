@@ -36,12 +36,16 @@
 #include "raygui/style/dark_alt.h"
 
 #include "options.h"
+#include "save_queue.h"
+#include "thread_pool.h"
 #include "color.h"
 #include "raylib_helper.h"
 
 #include "tile_draw.h"
 
 #include "level.h"
+#include "hex_grid.h"
+#include "board_bench.h"
 #include "level_draw.h"
 #include "level_undo.h"
 #include "collection.h"
@@ -57,6 +61,10 @@
 #include "gui_popup_message.h"
 #include "gui_help.h"
 #include "background.h"
+#include "postprocessing.h"
+#include "quality_governor.h"
+#include "redraw.h"
+#include "profiler.h"
 
 #include "nvdata.h"
 #include "nvdata_finished.h"
@@ -92,7 +100,6 @@ bool demo_mode = false;
 int automatic_event_polling_semaphore = 0;
 bool mouse_input_accepted = true;
 bool event_waiting_active = false;
-bool render_next_frame_no_waiting = false;
 bool window_size_changed = false;
 bool first_resize = true;
 bool skip_next_resize_event = false;
@@ -808,6 +815,7 @@ schedule_resize(
     window_size_changed = true;
     double curtime = GetTime();
     resize_time = curtime + resize_delay;
+    redraw_wake_at(resize_time);
 
 #if 0
     infomsg("scheduled resize at %f (now = %f, delta = %f)",
@@ -841,6 +849,8 @@ unload_render_textures(
 
     scene_read_target  = NULL;
     scene_write_target = NULL;
+
+    cleanup_postprocessing();
 }
 
 static void
@@ -914,6 +924,7 @@ void do_resize(void)
 
     window_size_changed = false;
     resize_time = 0;
+    redraw_request();
 
     if (first_resize) {
         first_resize = false;
@@ -970,7 +981,7 @@ static void handle_mouse_events(void)
     if (IsCursorOnScreen()) {
         if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
             mouse_left_click = true;
-            render_next_frame_no_waiting = true;
+            redraw_request();
 
             
             double click_time = GetTime();
@@ -1013,7 +1024,7 @@ static void handle_mouse_events(void)
 
         if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
             mouse_left_release = false;
-            render_next_frame_no_waiting = true;
+            redraw_request();
             if (do_level_ui_interaction()) {
                 if (options->use_two_click_dnd) {
                     if (two_click_dnd_in_progress) {
@@ -1039,7 +1050,7 @@ static void handle_mouse_events(void)
 
         if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
             mouse_right_click = true;
-            render_next_frame_no_waiting = true;
+            redraw_request();
             if (do_level_ui_interaction()) {
                 if (edit_mode_solved) {
                     if (is_any_shift_down()) {
@@ -1106,7 +1117,9 @@ handle_events(
         running = false;
     }
 
-    if (IsKeyPressed(KEY_F)) {
+    if (is_key_pressed_with_shift(KEY_F)) {
+        show_profiler = !show_profiler;
+    } else if (IsKeyPressed(KEY_F)) {
         show_fps = !show_fps;
     }
 
@@ -1147,8 +1160,8 @@ handle_events(
             debug_dir = (debug_dir + 1) % 6;
         }
 
-        if (IsKeyPressed(KEY_F4)) {
-            debug_id = (debug_id + 1) % LEVEL_MAXTILES;
+        if (IsKeyPressed(KEY_F4) && current_level) {
+            debug_id = (debug_id + 1) % current_level->grid->maxtiles;
         }
 #endif
 
@@ -2055,8 +2068,14 @@ bool draw_level_preview(level_t *level, Rectangle bounds)
 
     DrawRectangleRec(bounds, BLACK);
 
+    bool was_stub = level && level->stub;
+    if (level && !level_materialize(level)) {
+        /* shown like a missing level */
+        level = NULL;
+    }
+
     if (level) {
-        if (current_level_preview != level) {
+        if (was_stub || (current_level_preview != level)) {
             current_level_preview = level;
 
             level_resize(level);
@@ -2607,6 +2626,11 @@ static void draw_solve_timer(void)
 
         str = elapsed_time_parts_to_readable_string(&(solve_timer.elapsed_time.parts));
 
+        if (solve_timer.state == SOLVE_TIMER_STATE_RUNNING) {
+            /* the display changes when the next second starts */
+            redraw_wake_at(GetTime() + (0.001 * (1000 - solve_timer.elapsed_time.parts.ms)));
+        }
+
         switch (game_mode) {
         case GAME_MODE_WIN_LEVEL:
             draw_border = true;
@@ -2708,11 +2732,17 @@ static void draw_cursor(void)
 
 static void draw_feedback_bg(void)
 {
+    /* below full quality this is a smaller copy of the last frame */
+    Texture2D *texture = postprocessing_feedback_texture();
+    if (!texture) {
+        texture = &(scene_read_target->texture);
+    }
+
     Rectangle src = {
         .x      = 0.0f,
         .y      = 0.0f,
-        .width  = (float) scene_read_target->texture.width,
-        .height = (float)-scene_read_target->texture.height,
+        .width  = (float) texture->width,
+        .height = (float)-texture->height,
     };
     Rectangle dst = {
         .x      = -feedback_bg_zoom_margin.x + window_center.x,
@@ -2721,7 +2751,7 @@ static void draw_feedback_bg(void)
         .height = (float)scene_read_target->texture.height + (2.0f * feedback_bg_zoom_margin.y),
     };
     float rot = sin(current_time * 0.17) * (TAU / 36.0);
-    DrawTexturePro(scene_read_target->texture, src, dst, window_center, rot, feedback_bg_tint_color);
+    DrawTexturePro(*texture, src, dst, window_center, rot, feedback_bg_tint_color);
 }
 
 static void draw_gui_tooltip(void)
@@ -2839,7 +2869,29 @@ render_frame(
     SetShaderValue(postprocessing_shader, postprocessing_shader_loc.time, &current_time, SHADER_UNIFORM_FLOAT);
     SetShaderValue(background_shader, background_shader_loc.time, &current_time, SHADER_UNIFORM_FLOAT);
 
-    bool do_postprocessing_this_frame = do_postprocessing && options->use_postprocessing && !options->wait_events && options->animate_bg;
+    bool do_postprocessing_this_frame = do_postprocessing
+        && options->use_postprocessing
+        && !options->wait_events
+        && options->animate_bg
+        && quality_governor_allow_postprocessing();
+
+    /* updates the board cache, which can't happen inside the
+     * texture mode below */
+    switch (game_mode) {
+    case GAME_MODE_WIN_LEVEL:
+        fallthrough;
+    case GAME_MODE_PLAY_LEVEL:
+        level_draw_prepare(current_level, level_finished);
+        break;
+
+    case GAME_MODE_EDIT_LEVEL:
+        level_draw_prepare(current_level, false);
+        break;
+
+    default:
+        /* do nothing */
+        break;
+    }
 
     if (do_postprocessing_this_frame) {
         BeginTextureMode(*scene_write_target);
@@ -2854,18 +2906,22 @@ render_frame(
             draw_feedback_bg();
         }
 
+        profile_begin(PROFILE_PHASE_BACKGROUND);
         BeginShaderMode(background_shader);
         {
             background_draw(background);
         }
         EndShaderMode();
+        profile_end(PROFILE_PHASE_BACKGROUND);
 
         switch (game_mode) {
         case GAME_MODE_WIN_LEVEL:
             fallthrough;
         case GAME_MODE_PLAY_LEVEL:
             if (current_level) {
+                profile_begin(PROFILE_PHASE_LEVEL);
                 level_draw(current_level, level_finished);
+                profile_end(PROFILE_PHASE_LEVEL);
             }
             if (options->use_solve_timer) {
                 draw_solve_timer();
@@ -2874,7 +2930,9 @@ render_frame(
 
         case GAME_MODE_EDIT_LEVEL:
             if (current_level) {
+                profile_begin(PROFILE_PHASE_LEVEL);
                 level_draw(current_level, false);
+                profile_end(PROFILE_PHASE_LEVEL);
             }
             break;
 
@@ -2887,10 +2945,16 @@ render_frame(
     if (do_postprocessing_this_frame) {
         EndTextureMode();
 
+        if (postprocessing_reduced()) {
+            postprocessing_prepare(scene_write_target);
+        }
+
         BeginDrawing();
         {
             BeginShaderMode(postprocessing_shader);
             {
+                postprocessing_set_uniforms();
+
                 Rectangle src_rect = {
                     .x      = 0.0f,
                     .y      = 0.0f,
@@ -2920,7 +2984,9 @@ render_frame(
     if (demo_mode) {
         draw_gui_popup_message();
     } else {
+        profile_begin(PROFILE_PHASE_GUI);
         draw_gui();
+        profile_end(PROFILE_PHASE_GUI);
 
         switch (game_mode) {
         case GAME_MODE_WIN_LEVEL:
@@ -2937,7 +3003,14 @@ render_frame(
     }
 
     if (show_fps) {
-        DrawTextShadow(TextFormat("FPS: %d", GetFPS()), 15, 10, DEFAULT_GUI_FONT_SIZE, WHITE);
+        DrawTextShadow(TextFormat("FPS: %d  drawn: %ld  skipped: %ld",
+                                  GetFPS(), redraw_frames_rendered(), redraw_frames_skipped()),
+                       15, 10, DEFAULT_GUI_FONT_SIZE, WHITE);
+    }
+
+    if (show_profiler) {
+        float graph_y = show_fps ? (15 + DEFAULT_GUI_FONT_SIZE) : 10;
+        draw_profiler_graph((Vector2){ 15, graph_y });
     }
 
 #ifdef DEBUG_ID_AND_DIR
@@ -2948,14 +3021,19 @@ render_frame(
 
     draw_cursor();
 
-    if (event_waiting_active && render_next_frame_no_waiting) {
+    quality_governor_frame_end();
+
+    bool draw_next_frame = redraw_frame_end();
+
+    profile_begin(PROFILE_PHASE_END_DRAWING);
+    if (event_waiting_active && draw_next_frame) {
         DisableEventWaiting();
         EndDrawing();
         EnableEventWaiting();
-        render_next_frame_no_waiting = false;
     } else {
         EndDrawing();
     }
+    profile_end(PROFILE_PHASE_END_DRAWING);
 
     swap_scene_targets();
 
@@ -2967,18 +3045,25 @@ static void early_frame_setup(void)
     double_current_time = GetTime();
     current_time = (float)double_current_time;
 
+    quality_governor_frame_begin();
+
     set_mouse_cursor(MOUSE_CURSOR_DEFAULT);
 
     if (current_level && current_level->solver) {
+        profile_begin(PROFILE_PHASE_SOLVER);
         solver_update(current_level->solver);
+        profile_end(PROFILE_PHASE_SOLVER);
     }
 
     if (level_finished) {
         SetShaderValue(win_border_shader, win_border_shader_loc.time, &current_time, SHADER_UNIFORM_FLOAT);
+        redraw_animate();
     }
 
     if (gui_dialog_active() || show_help_box) {
         modal_ui_active = true;
+        /* keeps text box cursors blinking */
+        redraw_ambient();
         GuiLock();
     } else {
         modal_ui_active = false;
@@ -2988,21 +3073,38 @@ static void early_frame_setup(void)
 
 bool do_one_frame(void)
 {
+    profile_frame_begin();
+
+    profile_begin(PROFILE_PHASE_FRAME_SETUP);
     early_frame_setup();
+    profile_end(PROFILE_PHASE_FRAME_SETUP);
+
+    save_queue_poll();
 
     if (window_size_changed) {
         resize();
     }
 
-    if (!handle_events()) {
+    profile_begin(PROFILE_PHASE_HANDLE_EVENTS);
+    bool events_ok = handle_events();
+    profile_end(PROFILE_PHASE_HANDLE_EVENTS);
+
+    if (!events_ok) {
         return false;
     }
 
-    if (!render_frame()) {
-        return false;
+    bool drawn = redraw_frame_needed();
+    if (drawn) {
+        if (!render_frame()) {
+            return false;
+        }
+
+        frame_count += 1;
+    } else {
+        redraw_skip_frame();
     }
 
-    frame_count += 1;
+    profile_frame_end(drawn);
 
     return true;
 }
@@ -3140,6 +3242,8 @@ static void game_init(void)
         }
     }
 
+    init_save_queue();
+    init_thread_pool();
     init_gui_options();
     init_search_dirs();
     init_nvdata();
@@ -3150,6 +3254,7 @@ static void game_init(void)
     init_gui_title();
     init_gui_dialog();
     init_gui_popup_message();
+    init_profiler();
 
     init_solve_timer(&solve_timer);
 
@@ -3198,6 +3303,11 @@ static void start_given_file(void)
         solver_toggle_solve(current_level->solver);
         break;
 
+    case STARTUP_ACTION_BENCHMARK_BOARD:
+        run_board_benchmark();
+        running = false;
+        break;
+
     default:
         if (options->extra_argc == 1) {
             char *filename = options->extra_argv[0];
@@ -3213,19 +3323,29 @@ static void start_given_file(void)
 static void game_cleanup(void)
 {
     save_nvdata();
+    cleanup_save_queue();
 
     cleanup_gui_popup_message();
     cleanup_gui_dialog();
     cleanup_gui_random();
     cleanup_gui_collection();
     cleanup_gui_browser();
+    cleanup_thread_pool();
     cleanup_gui_help();
     cleanup_gui_title();
     cleanup_nvdata();
     cleanup_search_dirs();
     cleanup_gui_options();
+    cleanup_level_draw();
+    cleanup_hex_grids();
 
     destroy_background(background);
+
+    cleanup_profiler();
+
+    if (options->verbose) {
+        redraw_log_stats();
+    }
 }
 #endif
 
@@ -3319,6 +3439,9 @@ main(
         infomsg("");
     }
 
+    /* before any thread pool job can ask for a grid */
+    init_hex_grids();
+
 #if defined(PLATFORM_DESKTOP)
     if (run_startup_action()) {
         if (startup_action_ok) {
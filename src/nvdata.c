@@ -28,12 +28,15 @@
 #include "cJSON/cJSON.h"
 
 #include "options.h"
+#include "save_queue.h"
 #include "level.h"
+#include "level_undo_log.h"
 #include "win_anim.h"
 #include "win_anim_mode_config.h"
 
 #include "nvdata.h"
 #include "nvdata_finished.h"
+#include "nvdata_finished_journal.h"
 #include "gui_browser.h"
 #include "gui_random.h"
 #include "fsdir.h"
@@ -44,8 +47,21 @@ char *local_config_dir = NULL;
 char *nvdata_dir = NULL;
 char *nvdata_state_file_path = NULL;
 char *nvdata_default_browse_path = NULL;
+char *nvdata_dir_cache_path = NULL;
 char *nvdata_saved_current_level_path = NULL;
 
+/* level_in_progress-<timestamp>.hexlevel -> level_in_progress-<timestamp>.undolog */
+static char *saved_level_undo_log_path(const char *level_filename)
+{
+    char *path = NULL;
+    const char *ext = strrchr(level_filename, '.');
+    int len = ext ? (int)(ext - level_filename) : (int)strlen(level_filename);
+
+    safe_asprintf(&path, "%.*s.%s", len, level_filename, UNDO_LOG_FILENAME_EXT);
+
+    return path;
+}
+
 static void find_or_create_dir(const char *path, const char *desc)
 {
     if (DirectoryExists(path)) {
@@ -158,6 +174,13 @@ static bool program_state_from_json(cJSON *root_json)
                     level_play(level);
                     solve_timer.valid = false;
                     unlink(filename);
+
+                    char *undo_log_filename = saved_level_undo_log_path(filename);
+                    if (FileExists(undo_log_filename)) {
+                        level_undo_log_replay(level, undo_log_filename);
+                        unlink(undo_log_filename);
+                    }
+                    free(undo_log_filename);
                 } else {
                     errmsg("Load failed!");
                 }
@@ -322,6 +345,22 @@ static bool program_state_from_json(cJSON *root_json)
             warnmsg("Program state JSON['ui'] is missing \"max_win_radius\"");
         }
 
+        if (options->load_state_postprocessing_quality) {
+            cJSON *quality_json = cJSON_GetObjectItem(ui_json, "shader_effects_quality");
+            if (quality_json) {
+                if (cJSON_IsString(quality_json)) {
+                    if (!postprocessing_quality_from_name(quality_json->valuestring, &options->postprocessing_quality)) {
+                        errmsg("Program state JSON['ui']['shader_effects_quality'] is not a known quality: \"%s\"",
+                               quality_json->valuestring);
+                    }
+                } else {
+                    errmsg("Program state JSON['ui']['shader_effects_quality'] is not a STRING");
+                }
+            } else {
+                warnmsg("Program state JSON['ui'] is missing \"shader_effects_quality\"");
+            }
+        }
+
         cJSON *browser_active_tab_json = cJSON_GetObjectItem(ui_json, "browser_active_tab");
         if (browser_active_tab_json) {
             if (cJSON_IsNumber(browser_active_tab_json)) {
@@ -592,6 +631,12 @@ static cJSON *program_state_to_json(void)
         goto to_json_error;
     }
 
+    if (cJSON_AddStringToObject(ui_json, "shader_effects_quality",
+                                postprocessing_quality_name(options->postprocessing_quality)) == NULL) {
+        errmsg("Error adding \"shader_effects_quality\" to JSON.ui");
+        goto to_json_error;
+    }
+
     cJSON *bool_json = NULL;
 
 #define mk_bool_json(group, field, name)                                \
@@ -658,9 +703,6 @@ static void save_nvdata_program_state(void)
         return;
     }
 
-    char *tmpname;
-    safe_asprintf(&tmpname, "%s.tmp", nvdata_state_file_path);
-
     cJSON *json = program_state_to_json();
     if (!json) {
         errmsg("Failed to convert program state to JSON");
@@ -668,9 +710,9 @@ static void save_nvdata_program_state(void)
     }
 
     char *json_str = cJSON_Print(json);
+    cJSON_Delete(json);
     if (!json_str) {
         errmsg("Failed to print program state JSON to a string");
-        cJSON_Delete(json);
         return;
     }
 
@@ -678,19 +720,7 @@ static void save_nvdata_program_state(void)
         infomsg("Saving program state to: \"%s\"", nvdata_state_file_path);
     }
 
-    SaveFileText(tmpname, json_str);
-
-    free(json_str);
-    cJSON_Delete(json);
-
-    if (tmpname) {
-        if (-1 == rename(tmpname, nvdata_state_file_path)) {
-            errmsg("Error trying to rename \"%s\" to \"%s\" - ",
-                   tmpname, nvdata_state_file_path);
-        }
-
-        free(tmpname);
-    }
+    save_queue_submit(nvdata_state_file_path, json_str, strlen(json_str), NULL, NULL);
 }
 
 static void load_nvdata_game_metadata(void)
@@ -731,6 +761,21 @@ void init_nvdata(void)
                  nvdata_state_finished_levels_file_path);
     }
 
+    if (nvdata_state_finished_levels_json_path == NULL) {
+        safe_asprintf(&nvdata_state_finished_levels_json_path, "%s/%s",
+                 nvdata_dir, NVDATA_FINISHED_LEVEL_JSON_FILE_NAME);
+    }
+
+    if (nvdata_state_finished_levels_journal_path == NULL) {
+        safe_asprintf(&nvdata_state_finished_levels_journal_path, "%s/%s",
+                 nvdata_dir, NVDATA_FINISHED_LEVEL_JOURNAL_FILE_NAME);
+    }
+
+    if (level_undo_log_path == NULL) {
+        safe_asprintf(&level_undo_log_path, "%s/%s",
+                 nvdata_dir, NVDATA_CURRENT_UNDO_LOG_FILE_NAME);
+    }
+
     if (nvdata_default_browse_path == NULL) {
         safe_asprintf(&nvdata_default_browse_path, "%s/%s",
                  nvdata_dir, NVDATA_DEFAULT_BROWSE_PATH_NAME);
@@ -738,6 +783,13 @@ void init_nvdata(void)
 
     find_or_create_dir(nvdata_default_browse_path, "level file");
 
+    if (nvdata_dir_cache_path == NULL) {
+        safe_asprintf(&nvdata_dir_cache_path, "%s/%s",
+                 nvdata_dir, NVDATA_DIR_CACHE_DIR_NAME);
+    }
+
+    find_or_create_dir(nvdata_dir_cache_path, "directory cache");
+
 
     init_nvdata_finished();
 }
@@ -750,6 +802,8 @@ void cleanup_nvdata(void)
     SAFEFREE(nvdata_dir);
     SAFEFREE(nvdata_state_file_path);
     SAFEFREE(nvdata_default_browse_path);
+    SAFEFREE(nvdata_dir_cache_path);
+    SAFEFREE(level_undo_log_path);
 
 }
 
@@ -788,4 +842,10 @@ void save_current_level_with_nvdata(void)
     infomsg("Saving current level to: %s", nvdata_saved_current_level_path);
 
     level_save_to_filename(current_level, nvdata_saved_current_level_path);
+
+    char *undo_log_filename = saved_level_undo_log_path(nvdata_saved_current_level_path);
+    if (level_undo_log_save_as(current_level, undo_log_filename)) {
+        infomsg("Saving current level undo history to: %s", undo_log_filename);
+    }
+    free(undo_log_filename);
 }
@@ -31,6 +31,7 @@ void save_current_level_with_nvdata(void);
 
 extern char *nvdata_dir;
 extern char *nvdata_default_browse_path;
+extern char *nvdata_dir_cache_path;
 
 #endif /*NVDATA_H*/
 
@@ -24,15 +24,19 @@
 #include <time.h>
 
 #include "options.h"
+#include "save_queue.h"
 #include "level.h"
 #include "collection.h"
 #include "solve_timer.h"
 #include "nvdata_finished.h"
+#include "nvdata_finished_journal.h"
+#include "nvdata_finished_store.h"
 
 uint16_t history_log_file_version = 1;
 
 char *nvdata_state_finished_levels_file_path = NULL;
 char *nvdata_state_finished_levels_backup_file_path = NULL;
+char *nvdata_state_finished_levels_json_path = NULL;
 
 #define TREE_INDENT_MAXLEN 60
 char indentbuf[TREE_INDENT_MAXLEN];
@@ -42,6 +46,35 @@ SGLIB_DEFINE_RBTREE_FUNCTIONS(finished_level, left, right, rb_color, compare_fin
 finished_levels_t finished_levels;
 bool finished_levels_changed = false;
 
+/* changes that could not be recorded in the journal, so
+ * the snapshot has to be rewritten to keep them */
+static bool finished_levels_need_snapshot = false;
+
+/* the history is still only in the mapped store; the tree
+ * is built from it the first time it is needed */
+static bool finished_levels_tree_pending = false;
+
+/* tree nodes copied out of the store are allocated as one block */
+static struct finished_level *finished_level_block = NULL;
+static int finished_level_block_count = 0;
+
+/* ids sorted for nvdata_is_id_finished(); rebuilt on demand after changes */
+static const char **finished_level_id_index = NULL;
+static int finished_level_id_index_count = 0;
+
+/* changes made while the tree is still pending (usually the journal
+ * replayed at startup) are kept out of the store until the tree is
+ * built: levels marked finished in a small tree of their own, and the
+ * ids of stored levels that were unmarked */
+static struct finished_level *finished_levels_overlay = NULL;
+static char (*finished_levels_removed)[ID_MAXLEN] = NULL;
+static int finished_levels_removed_count = 0;
+
+/* ids in the mapped store, sorted; the store doesn't change
+ * while the tree is pending, so this is built only once */
+static const char **finished_store_id_index = NULL;
+static int finished_store_id_index_count = 0;
+
 char *finished_level_flag_str(flags16_t flags)
 {
     static char buf[6] = {0};
@@ -62,9 +95,11 @@ void print_finished_levels(void)
     struct sglib_finished_level_iterator it;
     int count = 0;
 
+    struct finished_level *tree = nvdata_finished_tree();
+
     printf("<finished_levels count=%d>\n", finished_levels.count);
 
-    for(e = sglib_finished_level_it_init_inorder(&it, finished_levels.tree);
+    for(e = sglib_finished_level_it_init_inorder(&it, tree);
         e != NULL;
         e = sglib_finished_level_it_next(&it)
     ) {
@@ -104,6 +139,13 @@ void init_nvdata_finished(void)
     finished_levels.count = 0;
 }
 
+static bool finished_level_in_block(struct finished_level *node)
+{
+    return (finished_level_block &&
+            (node >= finished_level_block) &&
+            (node < (finished_level_block + finished_level_block_count)));
+}
+
 void destroy_finished_level(struct finished_level *node)
 {
     if (node) {
@@ -115,24 +157,302 @@ void destroy_finished_level(struct finished_level *node)
             destroy_finished_level(node->right);
         }
 
-        FREE(node);
+        if (!finished_level_in_block(node)) {
+            FREE(node);
+        }
     }
 }
 
+static void invalidate_finished_level_id_index(void)
+{
+    SAFEFREE(finished_level_id_index);
+    finished_level_id_index_count = 0;
+}
+
+static void destroy_finished_levels_overlay(void)
+{
+    if (finished_levels_overlay) {
+        destroy_finished_level(finished_levels_overlay);
+        finished_levels_overlay = NULL;
+    }
+
+    SAFEFREE(finished_levels_removed);
+    finished_levels_removed_count = 0;
+
+    SAFEFREE(finished_store_id_index);
+    finished_store_id_index_count = 0;
+}
+
 static void destroy_finished_levels_tree(void)
 {
+    invalidate_finished_level_id_index();
+    destroy_finished_levels_overlay();
+
     if (finished_levels.tree) {
         destroy_finished_level(finished_levels.tree);
         finished_levels.tree = NULL;
     }
 
+    SAFEFREE(finished_level_block);
+    finished_level_block_count = 0;
+
+    finished_store_close();
+    finished_levels_tree_pending = false;
+
     finished_levels.count = 0;
 }
 
+void nvdata_finished_clear(void)
+{
+    destroy_finished_levels_tree();
+}
+
+/* the ids may point into the mapped store, which doesn't
+ * guarantee they are NUL terminated */
+static int compare_id_index_entries(const void *a, const void *b)
+{
+    return strncmp(*(const char * const *)a, *(const char * const *)b, ID_MAXLEN);
+}
+
+static bool id_in_index(const char *id, const char **index, int count)
+{
+    if (count < 1) {
+        return false;
+    }
+
+    return NULL != bsearch(&id,
+                           index,
+                           count,
+                           sizeof(const char *),
+                           compare_id_index_entries);
+}
+
+static void build_finished_store_id_index(void)
+{
+    if (finished_store_id_index) {
+        return;
+    }
+
+    int count = finished_store_count();
+    if (count < 1) {
+        return;
+    }
+
+    finished_store_id_index = calloc(count, sizeof(const char *));
+
+    for (int i=0; i<count; i++) {
+        finished_store_id_index[i] = finished_store_record(i)->id;
+    }
+
+    qsort(finished_store_id_index, count, sizeof(const char *), compare_id_index_entries);
+    finished_store_id_index_count = count;
+}
+
+static int finished_levels_removed_position(const char *id, bool *found)
+{
+    int lo = 0;
+    int hi = finished_levels_removed_count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strncmp(finished_levels_removed[mid], id, ID_MAXLEN);
+        if (cmp == 0) {
+            *found = true;
+            return mid;
+        } else if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *found = false;
+    return lo;
+}
+
+static bool finished_level_id_removed(const char *id)
+{
+    bool found;
+    finished_levels_removed_position(id, &found);
+    return found;
+}
+
+static void finished_levels_remove_stored_id(const char *id)
+{
+    bool found;
+    int pos = finished_levels_removed_position(id, &found);
+    if (found) {
+        return;
+    }
+
+    finished_levels_removed = realloc(finished_levels_removed,
+                                      (finished_levels_removed_count + 1) * ID_MAXLEN);
+
+    memmove(finished_levels_removed[pos + 1],
+            finished_levels_removed[pos],
+            (finished_levels_removed_count - pos) * ID_MAXLEN);
+    snprintf(finished_levels_removed[pos], ID_MAXLEN, "%s", id);
+
+    finished_levels_removed_count++;
+}
+
+static const struct finished_level_record *find_stored_record(const char *id)
+{
+    if (finished_level_id_removed(id)) {
+        return NULL;
+    }
+
+    build_finished_store_id_index();
+
+    if (finished_store_id_index_count < 1) {
+        return NULL;
+    }
+
+    const char **slot = bsearch(&id,
+                                finished_store_id_index,
+                                finished_store_id_index_count,
+                                sizeof(const char *),
+                                compare_id_index_entries);
+    if (!slot) {
+        return NULL;
+    }
+
+    return (const struct finished_level_record *)
+        (*slot - offsetof(struct finished_level_record, id));
+}
+
+/* the tree would keep the stored copy instead of adding it again */
+static bool finished_level_already_stored(struct finished_level *e)
+{
+    const struct finished_level_record *rec = find_stored_record(e->id);
+    if (!rec) {
+        return false;
+    }
+
+    struct finished_level stored = {0};
+    finished_level_from_record(&stored, rec);
+
+    return 0 == compare_finished_level(&stored, e);
+}
+
+/* the overlay is ordered like the tree (win time first),
+ * so finding an id means walking it */
+static struct finished_level *find_overlay_id(const char *id)
+{
+    struct finished_level *e = NULL;
+    struct sglib_finished_level_iterator it;
+
+    for(e = sglib_finished_level_it_init_inorder(&it, finished_levels_overlay);
+        e != NULL;
+        e = sglib_finished_level_it_next(&it)
+    ) {
+        if (0 == strncmp(e->id, id, ID_MAXLEN)) {
+            return e;
+        }
+    }
+
+    return NULL;
+}
+
+/* move the overlay into the tree once the store has been copied */
+static void apply_finished_levels_overlay(void)
+{
+    while (finished_levels_overlay) {
+        struct finished_level *e = finished_levels_overlay;
+        struct finished_level *member;
+
+        sglib_finished_level_delete(&finished_levels_overlay, e);
+        e->left = e->right = NULL;
+
+        if (sglib_finished_level_add_if_not_member(&(finished_levels.tree), e, &member)) {
+            finished_levels.count++;
+        } else {
+            FREE(e);
+        }
+    }
+}
+
+/* copy every record out of the mapped store into the rb-tree */
+static void materialize_finished_levels(void)
+{
+    if (!finished_levels_tree_pending) {
+        return;
+    }
+
+    finished_levels_tree_pending = false;
+    invalidate_finished_level_id_index();
+
+    assert(finished_levels.tree == NULL);
+    assert(finished_level_block == NULL);
+
+    int count = finished_store_count();
+    finished_levels.count = 0;
+
+    if (count > 0) {
+        finished_level_block = calloc(count, sizeof(struct finished_level));
+        finished_level_block_count = count;
+
+        for (int i=0; i<count; i++) {
+            struct finished_level *e = &finished_level_block[i];
+            struct finished_level *member;
+
+            finished_level_from_record(e, finished_store_record(i));
+
+            if (finished_levels_removed_count && finished_level_id_removed(e->id)) {
+                continue;
+            }
+
+            if (sglib_finished_level_add_if_not_member(&(finished_levels.tree), e, &member)) {
+                finished_levels.count++;
+            }
+        }
+    }
+
+    apply_finished_levels_overlay();
+    destroy_finished_levels_overlay();
+
+    finished_store_close();
+}
+
+struct finished_level *nvdata_finished_tree(void)
+{
+    materialize_finished_levels();
+    return finished_levels.tree;
+}
+
+static void build_finished_level_id_index(void)
+{
+    invalidate_finished_level_id_index();
+
+    if (finished_levels.count < 1) {
+        return;
+    }
+
+    finished_level_id_index = calloc(finished_levels.count, sizeof(const char *));
+
+    int n = 0;
+    struct finished_level *e = NULL;
+    struct sglib_finished_level_iterator it;
+
+    for(e = sglib_finished_level_it_init_inorder(&it, finished_levels.tree);
+        e != NULL && n<finished_levels.count;
+        e = sglib_finished_level_it_next(&it)
+    ) {
+        finished_level_id_index[n++] = e->id;
+    }
+
+    qsort(finished_level_id_index, n, sizeof(const char *), compare_id_index_entries);
+    finished_level_id_index_count = n;
+}
+
 void cleanup_nvdata_finished(void)
 {
+    nvdata_finished_journal_close();
+
     destroy_finished_levels_tree();
 
+    SAFEFREE(nvdata_state_finished_levels_journal_path);
+    SAFEFREE(nvdata_state_finished_levels_json_path);
     SAFEFREE(nvdata_state_finished_levels_backup_file_path);
     SAFEFREE(nvdata_state_finished_levels_file_path);
 }
@@ -182,8 +502,19 @@ void nvdata_mark_id_finished(struct finished_level *entry)
         infomsg("MARK finished: id=\"%s\" flags=%s", e->id, finished_level_flag_str(e->flags));
     }
 
-    if (sglib_finished_level_add_if_not_member(&(finished_levels.tree), e, &member)) {
-        finished_levels.count++;
+    if (finished_levels_tree_pending) {
+        if (!finished_level_already_stored(e) &&
+            sglib_finished_level_add_if_not_member(&finished_levels_overlay, e, &member)) {
+            finished_levels.count++;
+        } else {
+            FREE(e);
+        }
+    } else {
+        invalidate_finished_level_id_index();
+
+        if (sglib_finished_level_add_if_not_member(&(finished_levels.tree), e, &member)) {
+            finished_levels.count++;
+        }
     }
 
     assert(finished_levels.count > 0);
@@ -238,6 +569,45 @@ void nvdata_mark_finished(struct level *level)
     snprintf(&entry.id, ID_MAXLEN, "%s", level->unique_id);
 
     nvdata_mark_id_finished(&entry);
+
+    if (!nvdata_finished_journal_append_mark(&entry)) {
+        finished_levels_need_snapshot = true;
+    }
+}
+
+void nvdata_unmark_id_finished(const char *id)
+{
+    assert_not_null(id);
+
+    struct finished_level e = {0}, *result;
+    snprintf(&e.id, ID_MAXLEN, "%s", id);
+
+    if (options->verbose) {
+        infomsg("UNMARK finished: \"%s\"", e.id);
+    }
+
+    if (finished_levels_tree_pending) {
+        result = find_overlay_id(e.id);
+        if (result) {
+            sglib_finished_level_delete(&finished_levels_overlay, result);
+            FREE(result);
+            finished_levels.count--;
+        } else if (find_stored_record(e.id)) {
+            finished_levels_remove_stored_id(e.id);
+            finished_levels.count--;
+        }
+    } else {
+        invalidate_finished_level_id_index();
+
+        if (sglib_finished_level_delete_if_member(&(finished_levels.tree), &e, &result)) {
+            finished_levels.count--;
+        }
+    }
+
+    assert(finished_levels.count >= 0);
+
+    finished_levels_changed = true;
+    rebuild_history_browser = true;
 }
 
 void nvdata_unmark_finished(struct level *level)
@@ -248,22 +618,26 @@ void nvdata_unmark_finished(struct level *level)
         return;
     }
 
-    struct finished_level e, *result;
-    e.left = e.right = NULL;
-    snprintf(&e.id, ID_MAXLEN, "%s", level->unique_id);
+    nvdata_unmark_id_finished(level->unique_id);
 
-    if (options->verbose) {
-        infomsg("UNMARK finished: \"%s\"", e.id);
+    if (!nvdata_finished_journal_append_unmark(level->unique_id)) {
+        finished_levels_need_snapshot = true;
     }
+}
+
+bool nvdata_is_id_finished(const char *id)
+{
+    assert_not_null(id);
 
-    if (sglib_finished_level_delete_if_member(&(finished_levels.tree), &e, &result)) {
-        finished_levels.count--;
+    if (finished_levels_tree_pending) {
+        return (find_overlay_id(id) != NULL) || (find_stored_record(id) != NULL);
     }
 
-    assert(finished_levels.count >= 0);
+    if (!finished_level_id_index) {
+        build_finished_level_id_index();
+    }
 
-    finished_levels_changed = true;
-    rebuild_history_browser = true;
+    return id_in_index(id, finished_level_id_index, finished_level_id_index_count);
 }
 
 bool nvdata_is_finished(struct level *level)
@@ -275,10 +649,7 @@ bool nvdata_is_finished(struct level *level)
         return false;
     }
 
-    struct finished_level e, *result;
-    e.left = e.right = NULL;
-    snprintf(&e.id, ID_MAXLEN, "%s", level->unique_id);
-    return NULL != sglib_finished_level_find_member(finished_levels.tree, &e);
+    return nvdata_is_id_finished(level->unique_id);
 }
 
 bool nvdata_finished_from_json(cJSON *root_json)
@@ -498,6 +869,7 @@ bool nvdata_finished_from_json(cJSON *root_json)
     }
 
     finished_levels_changed = new_changed_value;
+    finished_levels_need_snapshot = new_changed_value;
 
     if (options->verbose) {
         infomsg("Read %d level finished level IDs", count);
@@ -533,12 +905,13 @@ cJSON *nvdata_finished_to_json(void)
 
     //printf(">> JSON encoding %d entries\n", finished_levels.count);
 
+    struct finished_level *tree = nvdata_finished_tree();
     struct finished_level *e = NULL;
     struct sglib_finished_level_iterator it;
 
     int count = 0;
 
-    for(e = sglib_finished_level_it_init_inorder(&it, finished_levels.tree);
+    for(e = sglib_finished_level_it_init_inorder(&it, tree);
         e != NULL;
         e = sglib_finished_level_it_next(&it)
     ) {
@@ -640,44 +1013,144 @@ bool nvdata_finished_save_to_file(const char *filepath)
 
     //print_cjson(json);
 
+    /* write a temp file first so a crash never leaves a partial file */
+    char *tmpname = NULL;
+    safe_asprintf(&tmpname, "%s.tmp", filepath);
+
     bool ret = false;
     if (options->compress_finished_levels_dat) {
-        ret = WriteCompressedJSONFile(filepath, json);
+        ret = WriteCompressedJSONFile(tmpname, json);
     } else {
-        ret = WriteUncompressedJSONFile(filepath, json);
+        ret = WriteUncompressedJSONFile(tmpname, json);
     }
 
     cJSON_Delete(json);
 
+    if (ret && (-1 == rename(tmpname, filepath))) {
+        errmsg("Error trying to rename \"%s\" to \"%s\": %s",
+               tmpname, filepath, strerror(errno));
+        ret = false;
+    }
+
+    free(tmpname);
+
     return ret;
 }
 
+bool nvdata_finished_load_store(const char *filepath)
+{
+    destroy_finished_levels_tree();
+
+    if (!finished_store_open(filepath)) {
+        return false;
+    }
+
+    finished_levels.count = finished_store_count();
+    finished_levels_tree_pending = true;
+    finished_levels_changed = false;
+    finished_levels_need_snapshot = false;
+
+    return true;
+}
+
+bool nvdata_finished_save_store(const char *filepath)
+{
+    struct finished_level *tree = nvdata_finished_tree();
+    return finished_store_write(filepath, tree, finished_levels.count);
+}
+
+bool nvdata_finished_import_json(const char *filepath)
+{
+    if (!nvdata_finished_load_from_file(filepath)) {
+        return false;
+    }
+
+    finished_levels_changed = true;
+    finished_levels_need_snapshot = true;
+    return true;
+}
+
+bool nvdata_finished_export_json(const char *filepath)
+{
+    return nvdata_finished_save_to_file(filepath);
+}
+
+/* the old JSON history has been imported; move it out of the
+ * way so it isn't imported again after the store is reset */
+static void retire_legacy_finished_levels_json(void)
+{
+    const char *json_path = nvdata_state_finished_levels_json_path;
+    if (!json_path || !FileExists(json_path)) {
+        return;
+    }
+
+    char *imported_path = NULL;
+    safe_asprintf(&imported_path, "%s.imported", json_path);
+
+    if (-1 == rename(json_path, imported_path)) {
+        errmsg("Error trying to rename \"%s\" to \"%s\": %s",
+               json_path, imported_path, strerror(errno));
+    } else if (options->verbose) {
+        infomsg("Renamed imported finished level data \"%s\" to \"%s\"",
+                json_path, imported_path);
+    }
+
+    free(imported_path);
+}
+
 void load_nvdata_finished_levels(void)
 {
-    if (!FileExists(nvdata_state_finished_levels_file_path)) {
-        if (options->verbose) {
-            infomsg("Skipping loading finished levels file (\"%s\" doesn't exist)",
-                    nvdata_state_finished_levels_file_path);
-        }
+    if (FileExists(nvdata_state_finished_levels_file_path)) {
+        nvdata_finished_load_store(nvdata_state_finished_levels_file_path);
+    } else if (nvdata_state_finished_levels_json_path &&
+               FileExists(nvdata_state_finished_levels_json_path)) {
+        infomsg("Importing finished level data from \"%s\"",
+                nvdata_state_finished_levels_json_path);
+        nvdata_finished_import_json(nvdata_state_finished_levels_json_path);
+    } else if (options->verbose) {
+        infomsg("Skipping loading finished levels file (\"%s\" doesn't exist)",
+                nvdata_state_finished_levels_file_path);
+    }
+
+    nvdata_finished_journal_replay();
+}
+
+/* runs on the main thread once the snapshot is on disk */
+static void finished_levels_saved_callback(const char *path, bool ok, void *data)
+{
+    unsigned long journal_seq = (unsigned long)(uintptr_t)data;
+
+    if (!ok) {
+        errmsg("Saving finished level data to \"%s\" failed!", path);
+        /* try again at the next save */
+        finished_levels_changed = true;
+        finished_levels_need_snapshot = true;
         return;
     }
 
-    nvdata_finished_load_from_file(nvdata_state_finished_levels_file_path);
+    if (options->verbose) {
+        infomsg("Successfully saved finished level data \"%s\"", path);
+    }
+
+    /* everything in the journal is in the snapshot now, unless more
+     * changes were journaled while it was being written */
+    if (journal_seq == nvdata_finished_journal_sequence()) {
+        nvdata_finished_journal_reset();
+    }
+    retire_legacy_finished_levels_json();
 }
 
 void force_save_nvdata_finished_levels(void)
 {
-    if (nvdata_finished_save_to_file(nvdata_state_finished_levels_file_path)) {
-        if (options->verbose) {
-            infomsg("Successfully saved finished level data \"%s\"",
-                    nvdata_state_finished_levels_file_path);
-        }
-        //print_finished_levels();
-        finished_levels_changed = false;
-    } else {
-        errmsg("Loading saved finished level data from \"%s\" failed!",
-               nvdata_state_finished_levels_file_path);
-    }
+    size_t size = 0;
+    unsigned char *data = finished_store_serialize(nvdata_finished_tree(), finished_levels.count, &size);
+
+    finished_levels_changed = false;
+    finished_levels_need_snapshot = false;
+
+    save_queue_submit(nvdata_state_finished_levels_file_path, data, size,
+                      finished_levels_saved_callback,
+                      (void *)(uintptr_t)nvdata_finished_journal_sequence());
 }
 
 void save_nvdata_finished_levels(void)
@@ -706,12 +1179,26 @@ void save_nvdata_finished_levels(void)
         return;
     }
 
+    if (!finished_levels_need_snapshot &&
+        (nvdata_finished_journal_record_count() < FINISHED_JOURNAL_COMPACT_RECORDS)) {
+        if (options->verbose) {
+            infomsg("Skipping saving finished level data (%d changes are in the journal)",
+                    nvdata_finished_journal_record_count());
+        }
+        return;
+    }
+
     force_save_nvdata_finished_levels();
 }
 
 bool reset_nvdata_finished_levels(void)
 {
+    /* don't let a queued snapshot land after the reset */
+    save_queue_flush();
+
     destroy_finished_levels_tree();
+    nvdata_finished_journal_reset();
+    retire_legacy_finished_levels_json();
 
     assert_not_null(nvdata_state_finished_levels_file_path);
     assert_not_null(nvdata_state_finished_levels_backup_file_path);
@@ -742,5 +1229,5 @@ bool reset_nvdata_finished_levels(void)
 
 bool have_nvdata_finished_levels_data(void)
 {
-    return finished_levels.tree != NULL;
+    return finished_levels.count > 0;
 }
@@ -215,11 +215,19 @@ typedef struct finished_levels finished_levels_t;
 
 void init_nvdata_finished(void);
 void cleanup_nvdata_finished(void);
+void nvdata_finished_clear(void);
+struct finished_level *nvdata_finished_tree(void);
 void nvdata_mark_id_finished(struct finished_level *entry);
 void nvdata_mark_finished(struct level *level);
+void nvdata_unmark_id_finished(const char *id);
 void nvdata_unmark_finished(struct level *level);
+bool nvdata_is_id_finished(const char *id);
 bool nvdata_is_finished(struct level *level);
 void nvdata_finished_write(FILE *f);
+bool nvdata_finished_load_store(const char *filepath);
+bool nvdata_finished_save_store(const char *filepath);
+bool nvdata_finished_import_json(const char *filepath);
+bool nvdata_finished_export_json(const char *filepath);
 void load_nvdata_finished_levels(void);
 void save_nvdata_finished_levels(void);
 void force_save_nvdata_finished_levels(void);
@@ -228,6 +236,7 @@ bool have_nvdata_finished_levels_data(void);
 
 extern char *nvdata_state_finished_levels_file_path;
 extern char *nvdata_state_finished_levels_backup_file_path;
+extern char *nvdata_state_finished_levels_json_path;
 
 extern finished_levels_t finished_levels;
 
@@ -0,0 +1,487 @@
+/****************************************************************************
+ *                                                                          *
+ * nvdata_finished_journal.c                                                *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <unistd.h>
+
+#include "options.h"
+#include "nvdata_finished.h"
+#include "nvdata_finished_journal.h"
+
+#define FINISHED_JOURNAL_HEADER_SIZE      5
+/* u8 code, u16 payload length */
+#define FINISHED_JOURNAL_RECORD_HEAD_SIZE 3
+/* u32 checksum */
+#define FINISHED_JOURNAL_RECORD_TAIL_SIZE 4
+#define FINISHED_JOURNAL_PAYLOAD_MAX_SIZE 1024
+
+char *nvdata_state_finished_levels_journal_path = NULL;
+
+static FILE *journal_file = NULL;
+static int journal_record_count = 0;
+/* counts every append; unlike the record count it is never reset */
+static unsigned long journal_append_seq = 0;
+
+static uint32_t journal_checksum(const unsigned char *buf, size_t len)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (size_t i=0; i<len; i++) {
+        hash ^= buf[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*** encoding ***/
+
+static void put_u8(unsigned char *buf, size_t *len, uint8_t value)
+{
+    buf[(*len)++] = value;
+}
+
+static void put_u16(unsigned char *buf, size_t *len, uint16_t value)
+{
+    buf[(*len)++] = value & 0xff;
+    buf[(*len)++] = (value >> 8) & 0xff;
+}
+
+static void put_u32(unsigned char *buf, size_t *len, uint32_t value)
+{
+    put_u16(buf, len, value & 0xffff);
+    put_u16(buf, len, (value >> 16) & 0xffff);
+}
+
+static void put_u64(unsigned char *buf, size_t *len, uint64_t value)
+{
+    put_u32(buf, len, value & 0xffffffff);
+    put_u32(buf, len, (value >> 32) & 0xffffffff);
+}
+
+static void put_str(unsigned char *buf, size_t *len, const char *str)
+{
+    size_t n = strlen(str);
+    if (n > UINT8_MAX) {
+        n = UINT8_MAX;
+    }
+
+    put_u8(buf, len, n);
+    memcpy(&buf[*len], str, n);
+    *len += n;
+}
+
+static size_t encode_mark(unsigned char *buf, struct finished_level *entry)
+{
+    size_t len = 0;
+
+    put_u16(buf, &len, entry->flags);
+    put_str(buf, &len, entry->id);
+
+    if (finished_level_has_name(entry)) {
+        put_str(buf, &len, entry->name);
+    }
+
+    if (finished_level_has_win_time(entry)) {
+        put_u64(buf, &len, (uint64_t)entry->win_time);
+    }
+
+    if (finished_level_has_elapsed_time(entry)) {
+        put_u32(buf, &len, entry->elapsed_time.day);
+        put_u32(buf, &len, entry->elapsed_time.hr);
+        put_u32(buf, &len, entry->elapsed_time.min);
+        put_u32(buf, &len, entry->elapsed_time.sec);
+        put_u32(buf, &len, entry->elapsed_time.ms);
+    }
+
+    if (finished_level_has_blueprint(entry)) {
+        put_str(buf, &len, entry->blueprint);
+    } else if (finished_level_has_classic(entry)) {
+        put_str(buf, &len, entry->classic_nameref.collection_id);
+        put_str(buf, &len, entry->classic_nameref.level_unique_id);
+    } else if (finished_level_has_fileref(entry)) {
+        put_str(buf, &len, entry->fileref.filename);
+        put_str(buf, &len, entry->fileref.level_unique_id);
+    }
+
+    return len;
+}
+
+/*** decoding ***/
+
+struct journal_reader {
+    const unsigned char *buf;
+    size_t len;
+    size_t pos;
+    bool ok;
+};
+
+static bool reader_has(struct journal_reader *r, size_t n)
+{
+    if (r->ok && ((r->pos + n) > r->len)) {
+        r->ok = false;
+    }
+    return r->ok;
+}
+
+static uint8_t get_u8(struct journal_reader *r)
+{
+    if (!reader_has(r, 1)) {
+        return 0;
+    }
+    return r->buf[r->pos++];
+}
+
+static uint16_t get_u16(struct journal_reader *r)
+{
+    uint16_t lo = get_u8(r);
+    uint16_t hi = get_u8(r);
+    return lo | (hi << 8);
+}
+
+static uint32_t get_u32(struct journal_reader *r)
+{
+    uint32_t lo = get_u16(r);
+    uint32_t hi = get_u16(r);
+    return lo | (hi << 16);
+}
+
+static uint64_t get_u64(struct journal_reader *r)
+{
+    uint64_t lo = get_u32(r);
+    uint64_t hi = get_u32(r);
+    return lo | (hi << 32);
+}
+
+static void get_str(struct journal_reader *r, char *dst, size_t dst_size)
+{
+    size_t n = get_u8(r);
+    if (!reader_has(r, n)) {
+        dst[0] = '\0';
+        return;
+    }
+
+    size_t copy_len = MIN(n, dst_size - 1);
+    memcpy(dst, &r->buf[r->pos], copy_len);
+    dst[copy_len] = '\0';
+    r->pos += n;
+}
+
+static bool decode_mark(struct journal_reader *r, struct finished_level *entry)
+{
+    flags16_t flags = get_u16(r);
+    get_str(r, entry->id, ID_MAXLEN);
+
+    if (flags & FINISHED_LEVEL_FLAG_NAME) {
+        name_str_t name;
+        get_str(r, name, NAME_MAXLEN);
+        finished_level_set_name(entry, name);
+    }
+
+    if (flags & FINISHED_LEVEL_FLAG_WIN_TIME) {
+        finished_level_set_win_time(entry, (time_t)get_u64(r));
+    }
+
+    if (flags & FINISHED_LEVEL_FLAG_ELAPSED_TIME) {
+        elapsed_time_parts_t elapsed_time;
+        elapsed_time.day = (int)get_u32(r);
+        elapsed_time.hr  = (int)get_u32(r);
+        elapsed_time.min = (int)get_u32(r);
+        elapsed_time.sec = (int)get_u32(r);
+        elapsed_time.ms  = (int)get_u32(r);
+        finished_level_set_elapsed_time(entry, &elapsed_time);
+    }
+
+    if (flags & FINISHED_LEVEL_FLAG_BLUEPRINT) {
+        blueprint_string_t blueprint;
+        get_str(r, blueprint, BLUEPRINT_STRING_MAXLEN);
+        finished_level_set_blueprint(entry, blueprint);
+    } else if (flags & FINISHED_LEVEL_FLAG_CLASSIC) {
+        name_str_t collection_id;
+        unique_id_t level_unique_id;
+        get_str(r, collection_id, NAME_MAXLEN);
+        get_str(r, level_unique_id, UNIQUE_ID_LENGTH);
+        finished_level_set_classic(entry, collection_id, level_unique_id);
+    } else if (flags & FINISHED_LEVEL_FLAG_FILEREF) {
+        filename_t filename;
+        unique_id_t level_unique_id;
+        get_str(r, filename, FILENAME_MAXLEN);
+        get_str(r, level_unique_id, UNIQUE_ID_LENGTH);
+        finished_level_set_fileref(entry, filename, level_unique_id);
+    }
+
+    if (flags & FINISHED_LEVEL_FLAG_SOLVER) {
+        finished_level_set_solver(entry);
+    }
+
+    if (flags & FINISHED_LEVEL_FLAG_COLLECTION) {
+        finished_level_set_collection(entry);
+    }
+
+    return r->ok && (r->pos == r->len);
+}
+
+static bool replay_record(uint8_t code, const unsigned char *payload, size_t len)
+{
+    struct journal_reader r = {
+        .buf = payload,
+        .len = len,
+        .pos = 0,
+        .ok  = true
+    };
+
+    switch (code) {
+    case FINISHED_JOURNAL_RECORD_MARK: {
+        struct finished_level entry = {0};
+        if (!decode_mark(&r, &entry)) {
+            return false;
+        }
+        nvdata_mark_id_finished(&entry);
+        return true;
+    }
+
+    case FINISHED_JOURNAL_RECORD_UNMARK: {
+        char id[ID_MAXLEN];
+        get_str(&r, id, ID_MAXLEN);
+        if (!r.ok || (r.pos != r.len)) {
+            return false;
+        }
+        nvdata_unmark_id_finished(id);
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+/*** journal file management ***/
+
+void nvdata_finished_journal_close(void)
+{
+    if (journal_file) {
+        fclose(journal_file);
+        journal_file = NULL;
+    }
+}
+
+static bool open_journal_file(void)
+{
+    nvdata_finished_journal_close();
+
+    journal_file = fopen(nvdata_state_finished_levels_journal_path, "ab");
+    if (NULL == journal_file) {
+        errmsg("Could not open finished level journal \"%s\" for writing: %s",
+               nvdata_state_finished_levels_journal_path, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool nvdata_finished_journal_reset(void)
+{
+    nvdata_finished_journal_close();
+    journal_record_count = 0;
+
+    if (!nvdata_state_finished_levels_journal_path || demo_mode) {
+        return false;
+    }
+
+    journal_file = fopen(nvdata_state_finished_levels_journal_path, "wb");
+    if (NULL == journal_file) {
+        errmsg("Could not open finished level journal \"%s\" for writing: %s",
+               nvdata_state_finished_levels_journal_path, strerror(errno));
+        return false;
+    }
+
+    unsigned char header[FINISHED_JOURNAL_HEADER_SIZE];
+    memcpy(header, FINISHED_JOURNAL_MAGIC, 4);
+    header[4] = FINISHED_JOURNAL_VERSION;
+
+    if (1 != fwrite(header, sizeof(header), 1, journal_file)) {
+        errmsg("Error writing finished level journal header to \"%s\"",
+               nvdata_state_finished_levels_journal_path);
+        nvdata_finished_journal_close();
+        return false;
+    }
+    fflush(journal_file);
+
+    return true;
+}
+
+int nvdata_finished_journal_record_count(void)
+{
+    return journal_record_count;
+}
+
+unsigned long nvdata_finished_journal_sequence(void)
+{
+    return journal_append_seq;
+}
+
+static bool append_record(uint8_t code, const unsigned char *payload, size_t payload_len)
+{
+    if (!journal_file) {
+        return false;
+    }
+
+    unsigned char buf[FINISHED_JOURNAL_RECORD_HEAD_SIZE +
+                      FINISHED_JOURNAL_PAYLOAD_MAX_SIZE +
+                      FINISHED_JOURNAL_RECORD_TAIL_SIZE];
+    size_t len = 0;
+
+    assert(payload_len <= FINISHED_JOURNAL_PAYLOAD_MAX_SIZE);
+
+    put_u8(buf, &len, code);
+    put_u16(buf, &len, payload_len);
+    memcpy(&buf[len], payload, payload_len);
+    len += payload_len;
+    put_u32(buf, &len, journal_checksum(buf, len));
+
+    if (1 != fwrite(buf, len, 1, journal_file)) {
+        errmsg("Error appending to finished level journal \"%s\"",
+               nvdata_state_finished_levels_journal_path);
+        nvdata_finished_journal_close();
+        return false;
+    }
+
+    if (fflush(journal_file)) {
+        errmsg("Error flushing finished level journal \"%s\": %s",
+               nvdata_state_finished_levels_journal_path, strerror(errno));
+        nvdata_finished_journal_close();
+        return false;
+    }
+
+    journal_record_count++;
+    journal_append_seq++;
+    return true;
+}
+
+bool nvdata_finished_journal_append_mark(struct finished_level *entry)
+{
+    assert_not_null(entry);
+
+    unsigned char payload[FINISHED_JOURNAL_PAYLOAD_MAX_SIZE];
+    size_t len = encode_mark(payload, entry);
+
+    return append_record(FINISHED_JOURNAL_RECORD_MARK, payload, len);
+}
+
+bool nvdata_finished_journal_append_unmark(const char *id)
+{
+    assert_not_null(id);
+
+    unsigned char payload[FINISHED_JOURNAL_PAYLOAD_MAX_SIZE];
+    size_t len = 0;
+    put_str(payload, &len, id);
+
+    return append_record(FINISHED_JOURNAL_RECORD_UNMARK, payload, len);
+}
+
+/*** replay ***/
+
+bool nvdata_finished_journal_replay(void)
+{
+    const char *path = nvdata_state_finished_levels_journal_path;
+    assert_not_null(path);
+
+    nvdata_finished_journal_close();
+    journal_record_count = 0;
+
+    if (!FileExists(path)) {
+        return nvdata_finished_journal_reset();
+    }
+
+    int size = 0;
+    unsigned char *data = LoadFileData(path, &size);
+    if (!data) {
+        errmsg("Could not read finished level journal \"%s\"", path);
+        return false;
+    }
+
+    if ((size < FINISHED_JOURNAL_HEADER_SIZE) ||
+        (0 != memcmp(data, FINISHED_JOURNAL_MAGIC, 4)) ||
+        (data[4] != FINISHED_JOURNAL_VERSION)) {
+        errmsg("Error parsing finished level journal \"%s\": bad header - starting a new journal", path);
+        UnloadFileData(data);
+        return nvdata_finished_journal_reset();
+    }
+
+    size_t pos = FINISHED_JOURNAL_HEADER_SIZE;
+    while (pos < (size_t)size) {
+        size_t remaining = (size_t)size - pos;
+        if (remaining < (FINISHED_JOURNAL_RECORD_HEAD_SIZE + FINISHED_JOURNAL_RECORD_TAIL_SIZE)) {
+            break;
+        }
+
+        size_t payload_len = data[pos + 1] | (data[pos + 2] << 8);
+        size_t record_len = (FINISHED_JOURNAL_RECORD_HEAD_SIZE +
+                             payload_len +
+                             FINISHED_JOURNAL_RECORD_TAIL_SIZE);
+        if (record_len > remaining) {
+            break;
+        }
+
+        size_t sum_pos = pos + FINISHED_JOURNAL_RECORD_HEAD_SIZE + payload_len;
+        uint32_t sum = (data[sum_pos]
+                        | (data[sum_pos + 1] << 8)
+                        | (data[sum_pos + 2] << 16)
+                        | ((uint32_t)data[sum_pos + 3] << 24));
+        if (sum != journal_checksum(&data[pos], sum_pos - pos)) {
+            break;
+        }
+
+        if (!replay_record(data[pos], &data[pos + FINISHED_JOURNAL_RECORD_HEAD_SIZE], payload_len)) {
+            errmsg("Error parsing finished level journal \"%s\": invalid record at offset %zu",
+                   path, pos);
+            break;
+        }
+
+        pos += record_len;
+        journal_record_count++;
+    }
+
+    UnloadFileData(data);
+
+    if (pos < (size_t)size) {
+        /* probably interrupted while appending; drop the damaged
+         * tail so new records are appended after the last good one */
+        warnmsg("Discarding %zu bytes of damaged records at the end of finished level journal \"%s\"",
+                (size_t)size - pos, path);
+
+        if (-1 == truncate(path, (off_t)pos)) {
+            errmsg("Error truncating \"%s\": %s", path, strerror(errno));
+            return false;
+        }
+    }
+
+    if (options->verbose) {
+        infomsg("Replayed %d finished level journal records from \"%s\"",
+                journal_record_count, path);
+    }
+
+    if (demo_mode) {
+        return true;
+    }
+
+    return open_journal_file();
+}
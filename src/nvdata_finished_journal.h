@@ -0,0 +1,55 @@
+/****************************************************************************
+ *                                                                          *
+ * nvdata_finished_journal.h                                                *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef NVDATA_FINISHED_JOURNAL_H
+#define NVDATA_FINISHED_JOURNAL_H
+
+#include "nvdata_finished.h"
+
+/*
+ * Append-only journal of changes to the finished level history. Each
+ * mark/unmark is appended as a small checksummed record instead of
+ * rewriting the whole finished_levels.dat snapshot. The journal is
+ * replayed on top of the snapshot at startup, and is only folded
+ * back into the snapshot once it grows past a limit.
+ */
+
+#define FINISHED_JOURNAL_MAGIC   "HXFJ"
+#define FINISHED_JOURNAL_VERSION 1
+
+#define FINISHED_JOURNAL_RECORD_MARK   0x01
+#define FINISHED_JOURNAL_RECORD_UNMARK 0x02
+
+/* rewrite the snapshot once the journal holds this many records */
+#define FINISHED_JOURNAL_COMPACT_RECORDS 256
+
+extern char *nvdata_state_finished_levels_journal_path;
+
+bool nvdata_finished_journal_replay(void);
+void nvdata_finished_journal_close(void);
+bool nvdata_finished_journal_reset(void);
+int nvdata_finished_journal_record_count(void);
+unsigned long nvdata_finished_journal_sequence(void);
+
+bool nvdata_finished_journal_append_mark(struct finished_level *entry);
+bool nvdata_finished_journal_append_unmark(const char *id);
+
+#endif /*NVDATA_FINISHED_JOURNAL_H*/
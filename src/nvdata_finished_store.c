@@ -0,0 +1,301 @@
+/****************************************************************************
+ *                                                                          *
+ * nvdata_finished_store.c                                                  *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#ifdef HAVE_MMAP
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include "options.h"
+#include "save_queue.h"
+#include "nvdata_finished.h"
+#include "nvdata_finished_store.h"
+
+static unsigned char *store_data = NULL;
+static size_t store_size = 0;
+static int store_count = 0;
+
+static const struct finished_level_record *store_records = NULL;
+
+static bool check_store_header(const char *path, const unsigned char *data, size_t size)
+{
+    const struct finished_store_header *header = (const struct finished_store_header *)data;
+
+    if ((size < sizeof(struct finished_store_header)) ||
+        (0 != memcmp(header->magic, FINISHED_STORE_MAGIC, 4))) {
+        errmsg("Error parsing finished level store \"%s\": bad header", path);
+        return false;
+    }
+
+    if (header->version != FINISHED_STORE_VERSION) {
+        errmsg("Finished level store \"%s\" is version %d, expected %d",
+               path, header->version, FINISHED_STORE_VERSION);
+        return false;
+    }
+
+    if ((header->byte_order != FINISHED_STORE_BYTE_ORDER) ||
+        (header->record_size != sizeof(struct finished_level_record))) {
+        errmsg("Finished level store \"%s\" was written with an incompatible record layout", path);
+        return false;
+    }
+
+    size_t expected_size = (sizeof(struct finished_store_header) +
+                            ((size_t)header->record_count * header->record_size));
+    if (size < expected_size) {
+        errmsg("Finished level store \"%s\" is truncated (%zu bytes, expected %zu)",
+               path, size, expected_size);
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef HAVE_MMAP
+static bool map_store_file(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (-1 == fd) {
+        errmsg("Could not open finished level store \"%s\": %s", path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (-1 == fstat(fd, &st)) {
+        errmsg("Could not stat finished level store \"%s\": %s", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0) {
+        close(fd);
+        errmsg("Finished level store \"%s\" is empty", path);
+        return false;
+    }
+
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == addr) {
+        errmsg("Could not map finished level store \"%s\": %s", path, strerror(errno));
+        return false;
+    }
+
+    store_data = addr;
+    store_size = st.st_size;
+    return true;
+}
+
+static void unmap_store_file(void)
+{
+    munmap(store_data, store_size);
+}
+#else
+static bool map_store_file(const char *path)
+{
+    int size = 0;
+    store_data = LoadFileData(path, &size);
+    if (!store_data) {
+        errmsg("Could not read finished level store \"%s\"", path);
+        return false;
+    }
+
+    store_size = size;
+    return true;
+}
+
+static void unmap_store_file(void)
+{
+    UnloadFileData(store_data);
+}
+#endif
+
+bool finished_store_open(const char *path)
+{
+    assert_not_null(path);
+
+    finished_store_close();
+
+    if (!map_store_file(path)) {
+        return false;
+    }
+
+    if (!check_store_header(path, store_data, store_size)) {
+        finished_store_close();
+        return false;
+    }
+
+    const struct finished_store_header *header = (const struct finished_store_header *)store_data;
+    store_count = header->record_count;
+    store_records = (const struct finished_level_record *)(store_data + sizeof(struct finished_store_header));
+
+    if (options->verbose) {
+        infomsg("Mapped %d finished level records from \"%s\"", store_count, path);
+    }
+
+    return true;
+}
+
+void finished_store_close(void)
+{
+    if (store_data) {
+        unmap_store_file();
+    }
+
+    store_data = NULL;
+    store_size = 0;
+    store_count = 0;
+    store_records = NULL;
+}
+
+int finished_store_count(void)
+{
+    return store_count;
+}
+
+const struct finished_level_record *finished_store_record(int index)
+{
+    assert(index >= 0);
+    assert(index < store_count);
+
+    return &store_records[index];
+}
+
+void finished_level_from_record(struct finished_level *fl, const struct finished_level_record *rec)
+{
+    assert_not_null(fl);
+    assert_not_null(rec);
+
+    memcpy(fl->id, rec->id, ID_MAXLEN);
+    fl->id[ID_MAXLEN - 1] = '\0';
+    memcpy(fl->name, rec->name, NAME_MAXLEN);
+    fl->name[NAME_MAXLEN - 1] = '\0';
+
+    fl->win_time = rec->win_time;
+    fl->elapsed_time.day = rec->elapsed_time[0];
+    fl->elapsed_time.hr  = rec->elapsed_time[1];
+    fl->elapsed_time.min = rec->elapsed_time[2];
+    fl->elapsed_time.sec = rec->elapsed_time[3];
+    fl->elapsed_time.ms  = rec->elapsed_time[4];
+
+    if (rec->flags & FINISHED_LEVEL_FLAG_BLUEPRINT) {
+        memcpy(fl->blueprint, rec->blueprint, BLUEPRINT_STRING_MAXLEN);
+        fl->blueprint[BLUEPRINT_STRING_MAXLEN - 1] = '\0';
+    } else if (rec->flags & FINISHED_LEVEL_FLAG_CLASSIC) {
+        memcpy(&fl->classic_nameref, &rec->classic_nameref, sizeof(classic_level_nameref_t));
+        fl->classic_nameref.collection_id[NAME_MAXLEN - 1] = '\0';
+        fl->classic_nameref.level_unique_id[UNIQUE_ID_LENGTH - 1] = '\0';
+    } else if (rec->flags & FINISHED_LEVEL_FLAG_FILEREF) {
+        memcpy(&fl->fileref, &rec->fileref, sizeof(fileref_t));
+        fl->fileref.filename[FILENAME_MAXLEN - 1] = '\0';
+        fl->fileref.level_unique_id[UNIQUE_ID_LENGTH - 1] = '\0';
+    }
+
+    fl->flags = rec->flags;
+}
+
+void finished_level_to_record(struct finished_level_record *rec, struct finished_level *fl)
+{
+    assert_not_null(rec);
+    assert_not_null(fl);
+
+    memset(rec, 0, sizeof(struct finished_level_record));
+
+    memcpy(rec->id, fl->id, ID_MAXLEN);
+    memcpy(rec->name, fl->name, NAME_MAXLEN);
+
+    rec->win_time = fl->win_time;
+    rec->elapsed_time[0] = fl->elapsed_time.day;
+    rec->elapsed_time[1] = fl->elapsed_time.hr;
+    rec->elapsed_time[2] = fl->elapsed_time.min;
+    rec->elapsed_time[3] = fl->elapsed_time.sec;
+    rec->elapsed_time[4] = fl->elapsed_time.ms;
+
+    if (finished_level_has_blueprint(fl)) {
+        copy_blueprint_string(rec->blueprint, fl->blueprint);
+    } else if (finished_level_has_classic(fl)) {
+        memcpy(&rec->classic_nameref, &fl->classic_nameref, sizeof(classic_level_nameref_t));
+    } else if (finished_level_has_fileref(fl)) {
+        memcpy(&rec->fileref, &fl->fileref, sizeof(fileref_t));
+    }
+
+    rec->flags = fl->flags;
+}
+
+/* returns a malloc()ed copy of the store file for the records in tree */
+unsigned char *finished_store_serialize(struct finished_level *tree, int count, size_t *size)
+{
+    assert_not_null(size);
+
+    size_t alloc_size = sizeof(struct finished_store_header)
+        + ((size_t)count * sizeof(struct finished_level_record));
+    unsigned char *data = calloc(1, alloc_size);
+
+    struct finished_store_header *header = (struct finished_store_header *)data;
+    memcpy(header->magic, FINISHED_STORE_MAGIC, 4);
+    header->version      = FINISHED_STORE_VERSION;
+    header->byte_order   = FINISHED_STORE_BYTE_ORDER;
+    header->record_size  = sizeof(struct finished_level_record);
+
+    struct finished_level_record *records =
+        (struct finished_level_record *)(data + sizeof(struct finished_store_header));
+
+    struct finished_level *e = NULL;
+    struct sglib_finished_level_iterator it;
+    int written = 0;
+
+    for(e = sglib_finished_level_it_init_inorder(&it, tree);
+        (e != NULL) && (written < count);
+        e = sglib_finished_level_it_next(&it)
+    ) {
+        finished_level_to_record(&records[written], e);
+        written++;
+    }
+
+    if (written != count) {
+        warnmsg("Wrote %d finished level records, but expected %d", written, count);
+    }
+    header->record_count = written;
+
+    *size = sizeof(struct finished_store_header)
+        + ((size_t)written * sizeof(struct finished_level_record));
+
+    return data;
+}
+
+bool finished_store_write(const char *path, struct finished_level *tree, int count)
+{
+    assert_not_null(path);
+
+    size_t size = 0;
+    unsigned char *data = finished_store_serialize(tree, count, &size);
+
+    bool rv = write_file_atomic(path, data, size);
+    if (!rv) {
+        errmsg("Error writing finished level store \"%s\"", path);
+    }
+
+    free(data);
+    return rv;
+}
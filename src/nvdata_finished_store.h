@@ -0,0 +1,76 @@
+/****************************************************************************
+ *                                                                          *
+ * nvdata_finished_store.h                                                  *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef NVDATA_FINISHED_STORE_H
+#define NVDATA_FINISHED_STORE_H
+
+#include "nvdata_finished.h"
+
+/*
+ * Binary snapshot of the finished level history: a small header
+ * followed by fixed-size records holding the same fields as
+ * struct finished_level. The file is memory-mapped when loaded, so
+ * startup cost does not grow with the size of the history; records
+ * are only copied out when something needs them.
+ *
+ * Records are stored in host byte order. A file written on a host
+ * with a different layout fails the header check and is ignored.
+ */
+
+#define FINISHED_STORE_MAGIC       "HXFS"
+#define FINISHED_STORE_VERSION     1
+#define FINISHED_STORE_BYTE_ORDER  0x0102
+
+struct finished_store_header {
+    char     magic[4];
+    uint16_t version;
+    uint16_t byte_order;
+    uint32_t record_size;
+    uint32_t record_count;
+};
+
+struct finished_level_record {
+    int64_t  win_time;
+    int32_t  elapsed_time[5];
+    uint16_t flags;
+
+    char id[ID_MAXLEN];
+    char name[NAME_MAXLEN];
+
+    union {
+        blueprint_string_t blueprint;
+        classic_level_nameref_t classic_nameref;
+        fileref_t fileref;
+    };
+};
+
+bool finished_store_open(const char *path);
+void finished_store_close(void);
+int finished_store_count(void);
+const struct finished_level_record *finished_store_record(int index);
+
+void finished_level_from_record(struct finished_level *fl, const struct finished_level_record *rec);
+void finished_level_to_record(struct finished_level_record *rec, struct finished_level *fl);
+
+unsigned char *finished_store_serialize(struct finished_level *tree, int count, size_t *size);
+bool finished_store_write(const char *path, struct finished_level *tree, int count);
+
+#endif /*NVDATA_FINISHED_STORE_H*/
@@ -73,8 +73,23 @@ static struct option long_options[] = {
 #endif
     {          "use-shader-effects",       no_argument, 0, 'x' },
     {       "no-use-shader-effects",       no_argument, 0, 'X' },
+    {          "shader-effects-quality", required_argument, 0, '5' },
     {             "use-solve-timer",       no_argument, 0, 'm' },
     {          "no-use-solve-timer",       no_argument, 0, 'M' },
+    {             "batch-tile-draw",       no_argument, 0, 'g' },
+    {          "no-batch-tile-draw",       no_argument, 0, 'D' },
+    {                 "cache-board",       no_argument, 0, 'Q' },
+    {              "no-cache-board",       no_argument, 0, 'Z' },
+    {              "instance-tiles",       no_argument, 0, '{' },
+    {           "no-instance-tiles",       no_argument, 0, '}' },
+    {                   "sdf-tiles",       no_argument, 0, '+' },
+    {                "no-sdf-tiles",       no_argument, 0, '=' },
+    {               "procedural-bg",       no_argument, 0, '4' },
+    {            "no-procedural-bg",       no_argument, 0, '$' },
+    {                "auto-quality",       no_argument, 0, '6' },
+    {             "no-auto-quality",       no_argument, 0, '^' },
+    {                 "lazy-redraw",       no_argument, 0, '7' },
+    {              "no-lazy-redraw",       no_argument, 0, '&' },
     {           "use-two-click-dnd",       no_argument, 0, '2' },
     {        "no-use-two-click-dnd",       no_argument, 0, '@' },
     {               "show-previews",       no_argument, 0, '-' },
@@ -87,10 +102,21 @@ static struct option long_options[] = {
     { "no-compress-finished-levels",       no_argument, 0, '#' },
     {              "extra-rainbows",       no_argument, 0, ':' },
     {           "no-extra-rainbows",       no_argument, 0, ';' },
+    {                  "async-save",       no_argument, 0, 'a' },
+    {               "no-async-save",       no_argument, 0, 'N' },
+    {                  "durability", required_argument, 0, 'u' },
+    {                "load-threads", required_argument, 0, 'n' },
     {             "allow-edit-mode",       no_argument, 0, 'E' },
     {                        "demo",       no_argument, 0, 'j' },
     {                    "demo-win",       no_argument, 0, 'J' },
+    {             "benchmark-board",       no_argument, 0, 'k' },
+    {           "benchmark-history",       no_argument, 0, 'q' },
+    {              "benchmark-json",       no_argument, 0, 'z' },
+    {           "export-thumbnails",       no_argument, 0, '9' },
+    {              "export-history",       no_argument, 0, 'o' },
+    {              "import-history",       no_argument, 0, 'O' },
     {                 "wait-events",       no_argument, 0, 'w' },
+    {                  "trace-file", required_argument, 0, '8' },
     {                   "color-log",       no_argument, 0, '>' },
     {                "no-color-log",       no_argument, 0, '<' },
     {                     "verbose",       no_argument, 0, 'v' },
@@ -120,9 +146,23 @@ static char help_text[] =
     "      --color-log             Enable ANSI color in the log output (default: on)\n"
     "   --no-color-log             Disable ANSI color in the log output\n"
     "\n"
+    "      --async-save            Write saved files on a background thread (default: on)\n"
+    "   --no-async-save            Write saved files immediately\n"
+    "      --durability=MODE       How hard to try to get saved files onto the disk:\n"
+    "                                none - write the file and rename it into place\n"
+    "                                file - also fsync() the file first (default)\n"
+    "                                full - also fsync() the directory afterwards\n"
+    "      --load-threads=NUMBER   Threads used to read level files and scan\n"
+    "                                directories (default: 0, which picks a\n"
+    "                                number based on the CPU count; 1 reads\n"
+    "                                everything on the main thread)\n"
+    "\n"
     "  -v, --verbose               More logging output (including raylib)\n"
     "                                Use -v/--verbose twice to also enable\n"
     "                                verbose raylib log messages\n"
+    "      --trace-file=FILE       Time each part of every frame and write the\n"
+    "                                times to FILE on exit, as a Chrome trace\n"
+    "                                (open it in chrome://tracing or Perfetto)\n"
     "\n"
     "  -V, --version               Show version information and exit\n"
     "  -h, --help                  Show this help and exit\n"
@@ -136,6 +176,28 @@ static char help_text[] =
     "   --no-use-physics           Disable the physucs engine\n"
     "      --use-shader-effects    Enable shader postprocesing effects (default: on)\n"
     "   --no-use-shader-effects    Disable shader postprocesing effects\n"
+    "      --shader-effects-quality=QUALITY\n"
+    "                                Resolution of the blur and feedback effects:\n"
+    "                                full (default), half or quarter\n"
+    "      --batch-tile-draw       Draw all tiles with one batched draw call (default: off)\n"
+    "   --no-batch-tile-draw       Draw each tile with separate shape calls\n"
+    "      --cache-board           Keep tiles that aren't changing in a texture (default: off)\n"
+    "   --no-cache-board           Redraw every tile each frame\n"
+    "      --instance-tiles        Draw finished tiles with instanced rendering\n"
+    "                                (OpenGL 3.3 only, default: off)\n"
+    "   --no-instance-tiles        Draw finished tiles like any other tile\n"
+    "      --sdf-tiles             Draw idle tiles as one quad each with a distance\n"
+    "                                field shader (default: off)\n"
+    "   --no-sdf-tiles             Draw idle tiles with triangles\n"
+    "      --procedural-bg         Draw the background grid entirely in its shader\n"
+    "                                (default: off)\n"
+    "   --no-procedural-bg         Draw the background grid from textured quads\n"
+    "      --auto-quality          Lower the effect quality while frames are too slow\n"
+    "                                (default: off)\n"
+    "   --no-auto-quality          Always draw effects at the chosen quality\n"
+    "      --lazy-redraw           Only draw frames when something on screen\n"
+    "                                changes (default: off)\n"
+    "   --no-lazy-redraw           Draw every frame\n"
     "      --use-solve-timer       Enable level solve time tracking (default: on)\n"
     "   --no-use-solve-timer       Disable level solve time tracking\n"
     "      --show-previews         Enable showing small level previews (default: on)\n"
@@ -144,8 +206,8 @@ static char help_text[] =
     "   --no-show-tooltips         Disable popup tooltips\n"
     "      --log-finished-levels   Enable ssving a log of finished levels (default: on)\n"
     "   --no-log-finished-levels   Disable saving a log of finished levels\n"
-    "      --compress-finished-levels  Enable compressing finished_levels.dat (default: on)\n"
-    "   --no-compress-finished-levels  Save finished_levels.dat as uncompressed JSON\n"
+    "      --compress-finished-levels  Enable compressing exported history JSON (default: on)\n"
+    "   --no-compress-finished-levels  Export history as uncompressed JSON\n"
     "\n"
     "  -W, --width=NUMBER          Window width (default: " STR(OPTIONS_DEFAULT_INITIAL_WINDOW_WIDTH) ")\n"
     "  -H, --height=NUMBER         Window height (default: " STR(OPTIONS_DEFAULT_INITIAL_WINDOW_HEIGHT) ")\n"
@@ -174,6 +236,24 @@ static char help_text[] =
     "                                     No user input accepted except SPACE to advance\n"
     "                                     the demo and ESC/q to quit.\n"
     "      --demo-win                   Same as --demo, but only show the win animations.\n"
+    "      --export-history <file>      Export the finished level history as JSON\n"
+    "      --import-history <file>...   Merge JSON finished level history files\n"
+    "                                     into the history\n"
+    "      --benchmark-board            Time level generation and drawing (with and\n"
+    "                                     without --batch-tile-draw and\n"
+    "                                     --cache-board) at board radius 4, 8\n"
+    "                                     and 12, then exit.\n"
+    "      --benchmark-history          Compare JSON and binary load times of a\n"
+    "                                     large generated history, then exit.\n"
+    "      --benchmark-json <path>...   Read the level files and packs in each path\n"
+    "                                     with the streaming JSON reader and with\n"
+    "                                     cJSON, check they agree and compare their\n"
+    "                                     speed, then exit.\n"
+    "      --export-thumbnails <path>...\n"
+    "                                   Render a PNG thumbnail of every level in each\n"
+    "                                     pack or directory into NAME-thumbnails/\n"
+    "                                     on the CPU (no display needed), report\n"
+    "                                     thumbnails per second, then exit.\n"
     "\n"
     "ACTION OPTIONS\n"
     "      --force                   Allow files to be overwritten (dangerous!)\n"
@@ -248,6 +328,7 @@ alloc_options(
     options_t *options = calloc(1, sizeof(options_t));
 
     options->nvdata_dir = NULL;
+    options->trace_file = NULL;
 
     return options;
 }
@@ -258,6 +339,7 @@ free_options(
 ) {
     if (options) {
         SAFEFREE(options->nvdata_dir);
+        SAFEFREE(options->trace_file);
         FREE(options);
     }
 }
@@ -454,6 +536,7 @@ options_set_defaults(
     options->animate_win                  = OPTIONS_DEFAULT_ANIMATE_WIN;
     options->use_physics                  = OPTIONS_DEFAULT_USE_PHYSICS;
     options->use_postprocessing           = OPTIONS_DEFAULT_USE_POSTPROCESSING;
+    options->postprocessing_quality       = OPTIONS_DEFAULT_POSTPROCESSING_QUALITY;
     options->use_solve_timer              = OPTIONS_DEFAULT_USE_SOLVE_TIMER;
     options->use_two_click_dnd            = OPTIONS_DEFAULT_USE_TWO_CLICK_DND;
     options->show_level_previews          = OPTIONS_DEFAULT_SHOW_LEVEL_PREVIEWS;
@@ -461,6 +544,16 @@ options_set_defaults(
     options->log_finished_levels          = OPTIONS_DEFAULT_LOG_FINISHED_LEVELS;
     options->compress_finished_levels_dat = OPTIONS_DEFAULT_COMPRESS_FINISHED_LEVELS_DAT;
     options->extra_rainbows               = OPTIONS_DEFAULT_EXTRA_RAINBOWS;
+    options->batch_tile_draw              = OPTIONS_DEFAULT_BATCH_TILE_DRAW;
+    options->cache_board                  = OPTIONS_DEFAULT_CACHE_BOARD;
+    options->instance_tiles               = OPTIONS_DEFAULT_INSTANCE_TILES;
+    options->sdf_tiles                    = OPTIONS_DEFAULT_SDF_TILES;
+    options->procedural_bg                = OPTIONS_DEFAULT_PROCEDURAL_BG;
+    options->auto_quality                 = OPTIONS_DEFAULT_AUTO_QUALITY;
+    options->lazy_redraw                  = OPTIONS_DEFAULT_LAZY_REDRAW;
+    options->async_save                   = OPTIONS_DEFAULT_ASYNC_SAVE;
+    options->save_durability              = OPTIONS_DEFAULT_SAVE_DURABILITY;
+    options->load_threads                 = OPTIONS_DEFAULT_LOAD_THREADS;
     options->max_fps                      = OPTIONS_DEFAULT_MAX_FPS;
     options->initial_window_width         = OPTIONS_DEFAULT_INITIAL_WINDOW_WIDTH;
     options->initial_window_height        = OPTIONS_DEFAULT_INITIAL_WINDOW_HEIGHT;
@@ -472,6 +565,7 @@ options_set_defaults(
     options->load_state_animate_win = true;
     options->load_state_use_physics = true;
     options->load_state_use_postprocessing = true;
+    options->load_state_postprocessing_quality = true;
     options->load_state_use_solve_timer = true;
     options->load_state_use_two_click_dnd = true;
     options->load_state_show_level_previews = true;
@@ -716,6 +810,10 @@ options_parse_args(
             options_set_string(&options->nvdata_dir);
             break;
 
+        case '8':
+            options_set_string(&options->trace_file);
+            break;
+
         case 'F':
             options_set_long(&options->max_fps);
             break;
@@ -768,6 +866,14 @@ options_parse_args(
             options->load_state_use_postprocessing = false;
             break;
 
+        case '5':
+            if (!postprocessing_quality_from_name(optarg, &options->postprocessing_quality)) {
+                errmsg("bad value for --shader-effects-quality: \"%s\" (expected full, half or quarter)", optarg);
+                return false;
+            }
+            options->load_state_postprocessing_quality = false;
+            break;
+
         case 'm':
             options->use_solve_timer = true;
             options->load_state_use_solve_timer = false;
@@ -836,6 +942,87 @@ options_parse_args(
             options->extra_rainbows = false;
             break;
 
+        case 'g':
+            options->batch_tile_draw = true;
+            break;
+
+        case 'D':
+            options->batch_tile_draw = false;
+            break;
+
+        case 'Q':
+            options->cache_board = true;
+            break;
+
+        case 'Z':
+            options->cache_board = false;
+            break;
+
+        case '{':
+            options->instance_tiles = true;
+            break;
+
+        case '}':
+            options->instance_tiles = false;
+            break;
+
+        case '+':
+            options->sdf_tiles = true;
+            break;
+
+        case '=':
+            options->sdf_tiles = false;
+            break;
+
+        case '4':
+            options->procedural_bg = true;
+            break;
+
+        case '$':
+            options->procedural_bg = false;
+            break;
+
+        case '6':
+            options->auto_quality = true;
+            break;
+
+        case '^':
+            options->auto_quality = false;
+            break;
+
+        case '7':
+            options->lazy_redraw = true;
+            break;
+
+        case '&':
+            options->lazy_redraw = false;
+            break;
+
+        case 'a':
+            options->async_save = true;
+            break;
+
+        case 'N':
+            options->async_save = false;
+            break;
+
+        case 'u':
+            if (!save_durability_from_name(optarg, &options->save_durability)) {
+                errmsg("bad value for --durability: \"%s\" (expected none, file or full)", optarg);
+                return false;
+            }
+            break;
+
+        case 'n':
+            if (!options_set_int_bounds(&options->load_threads,
+                                        0,
+                                        OPTIONS_MAX_LOAD_THREADS)) {
+                errmsg("bad value for --load-threads (expected 0 - %d)",
+                       OPTIONS_MAX_LOAD_THREADS);
+                return false;
+            }
+            break;
+
         case 'j':
             options->startup_action = STARTUP_ACTION_DEMO_SOLVE;
             break;
@@ -844,6 +1031,30 @@ options_parse_args(
             options->startup_action = STARTUP_ACTION_DEMO_WIN_ANIM;
             break;
 
+        case 'k':
+            options->startup_action = STARTUP_ACTION_BENCHMARK_BOARD;
+            break;
+
+        case 'q':
+            options->startup_action = STARTUP_ACTION_BENCHMARK_HISTORY;
+            break;
+
+        case 'z':
+            options->startup_action = STARTUP_ACTION_BENCHMARK_JSON;
+            break;
+
+        case '9':
+            options->startup_action = STARTUP_ACTION_EXPORT_THUMBNAILS;
+            break;
+
+        case 'o':
+            options->startup_action = STARTUP_ACTION_EXPORT_HISTORY;
+            break;
+
+        case 'O':
+            options->startup_action = STARTUP_ACTION_IMPORT_HISTORY;
+            break;
+
         case 'w':
             options->wait_events = true;
             break;
@@ -27,6 +27,8 @@
 #include "color.h"
 //#include "path.h"
 #include "startup_action.h"
+#include "save_queue.h"
+#include "postprocessing.h"
 
 #define OPTIONS_DEFAULT_VERBOSE false
 #define OPTIONS_DEFAULT_VERBOSE_RAYLIB false
@@ -37,6 +39,7 @@
 #define OPTIONS_DEFAULT_ANIMATE_WIN true
 #define OPTIONS_DEFAULT_USE_PHYSICS true
 #define OPTIONS_DEFAULT_USE_POSTPROCESSING true
+#define OPTIONS_DEFAULT_POSTPROCESSING_QUALITY POSTPROCESSING_QUALITY_FULL
 #define OPTIONS_DEFAULT_USE_SOLVE_TIMER false
 #define OPTIONS_DEFAULT_USE_TWO_CLICK_DND false
 #define OPTIONS_DEFAULT_SHOW_LEVEL_PREVIEWS true
@@ -44,6 +47,17 @@
 #define OPTIONS_DEFAULT_LOG_FINISHED_LEVELS true
 #define OPTIONS_DEFAULT_COMPRESS_FINISHED_LEVELS_DAT true
 #define OPTIONS_DEFAULT_EXTRA_RAINBOWS false
+#define OPTIONS_DEFAULT_ASYNC_SAVE true
+#define OPTIONS_DEFAULT_BATCH_TILE_DRAW false
+#define OPTIONS_DEFAULT_CACHE_BOARD false
+#define OPTIONS_DEFAULT_INSTANCE_TILES false
+#define OPTIONS_DEFAULT_SDF_TILES false
+#define OPTIONS_DEFAULT_PROCEDURAL_BG false
+#define OPTIONS_DEFAULT_AUTO_QUALITY false
+#define OPTIONS_DEFAULT_LAZY_REDRAW false
+#define OPTIONS_DEFAULT_SAVE_DURABILITY SAVE_DURABILITY_FILE
+#define OPTIONS_DEFAULT_LOAD_THREADS 0
+#define OPTIONS_MAX_LOAD_THREADS 64
 #define OPTIONS_DEFAULT_FPS 30
 #define OPTIONS_DEFAULT_MAX_FPS 30
 #define OPTIONS_DEFAULT_INITIAL_WINDOW_WIDTH  800
@@ -108,6 +122,7 @@ struct options {
     bool animate_win;
     bool use_physics;
     bool use_postprocessing;
+    postprocessing_quality_t postprocessing_quality;
     bool use_solve_timer;
     bool use_two_click_dnd;
     bool show_level_previews;
@@ -115,10 +130,21 @@ struct options {
     bool log_finished_levels;
     bool compress_finished_levels_dat;
     bool extra_rainbows;
+    bool batch_tile_draw;
+    bool cache_board;
+    bool instance_tiles;
+    bool sdf_tiles;
+    bool procedural_bg;
+    bool auto_quality;
+    bool lazy_redraw;
+    bool async_save;
+    save_durability_t save_durability;
+    int load_threads;
     bool load_state_animate_bg;
     bool load_state_animate_win;
     bool load_state_use_physics;
     bool load_state_use_postprocessing;
+    bool load_state_postprocessing_quality;
     bool load_state_use_solve_timer;
     bool load_state_use_two_click_dnd;
     bool load_state_show_level_previews;
@@ -134,6 +160,7 @@ struct options {
     long max_win_radius;
 
     char *nvdata_dir;
+    char *trace_file;
 
     /* action */
     startup_action_t startup_action;
@@ -24,6 +24,7 @@
 #include "level.h"
 #include "win_anim.h"
 #include "physics.h"
+#include "quality_governor.h"
 
 //#define DEBUG_TRACE_PHYICS_ALLOC
 
@@ -42,7 +43,8 @@ void init_physics(physics_t *physics, struct level *level)
 
     physics->state = PHYSICS_STOP;
 
-    memset(physics->tiles, 0, sizeof(physics->tiles));
+    physics->tiles = NULL;
+    physics->num_tiles = 0;
 
     physics->time = 0.0;
     physics->time_step = 1.0 / options->max_fps;
@@ -52,7 +54,7 @@ void init_physics(physics_t *physics, struct level *level)
 
     physics->space = cpSpaceNew();
 
-    cpSpaceSetIterations(physics->space, 20);
+    cpSpaceSetIterations(physics->space, quality_governor_physics_iterations());
 
     Vector2 size = window_center;
     size = Vector2Scale(size, 1.0);
@@ -134,10 +136,15 @@ void cleanup_physics(physics_t *physics)
         printf("cleanup_physics() level->name=\"%s\"\n", physics->level->name);
 #endif
 
-        for (int i=0; i<LEVEL_MAXTILES; i++) {
-            physics_tile_t *pt = &(physics->tiles[i]);
-            cleanup_phyics_tile(physics, pt);
+        if (physics->tiles) {
+            for (int i=0; i<physics->num_tiles; i++) {
+                physics_tile_t *pt = &(physics->tiles[i]);
+                cleanup_phyics_tile(physics, pt);
+            }
+            SAFEFREE(physics->tiles);
         }
+        physics->num_tiles = 0;
+        physics->tiles_ready = false;
 
         for (int i=0; i<4; i++) {
             if (physics->wall[i]) {
@@ -359,6 +366,8 @@ void physics_build_tiles(physics_t *physics)
     //tile_pos_t *center = level_get_center_tile_pos(level);
 
     physics->num_tiles = level_get_enabled_tiles(level);
+    SAFEFREE(physics->tiles);
+    physics->tiles = calloc(physics->num_tiles, sizeof(physics_tile_t));
 
     for (int i=0; i<physics->num_tiles; i++) {
         tile_t *tile = level->enabled_tiles[i];
@@ -542,5 +551,6 @@ void physics_update(physics_t *physics, float activation)
 
     fade_in_factor = physics->level->win_anim->fade[3];
     physics->time += physics->time_step;
+    cpSpaceSetIterations(physics->space, quality_governor_physics_iterations());
     cpSpaceStep(physics->space, physics->time_step * activation);
 }
@@ -71,8 +71,9 @@ struct physics {
 
     cpShape *wall[4];
 
+    /* one per enabled tile, allocated by physics_build_tiles() */
     int num_tiles;
-    physics_tile_t tiles[LEVEL_MAXTILES];
+    physics_tile_t *tiles;
     bool tiles_ready;
 
     cpFloat time_step;
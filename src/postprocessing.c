@@ -0,0 +1,244 @@
+/****************************************************************************
+ *                                                                          *
+ * postprocessing.c                                                         *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "options.h"
+#include "shader.h"
+#include "postprocessing.h"
+#include "quality_governor.h"
+
+/* the tap spacing of the box blur in postprocessing.frag.glsl, which
+ * is in texture coordinates and so doesn't depend on the resolution */
+#define BLUR_STEP_X (2.5f / 800.0f)
+#define BLUR_STEP_Y (2.5f / 450.0f)
+
+struct postprocessing_targets {
+    bool ready;
+    postprocessing_quality_t quality;
+
+    /* the window size the targets were made for */
+    int width;
+    int height;
+
+    /* only used at quarter quality, so each step only halves */
+    RenderTexture2D half;
+
+    /* the last frame at the reduced size, which is also what
+     * draw_feedback_bg() draws behind the next frame */
+    RenderTexture2D reduced;
+    bool have_frame;
+
+    RenderTexture2D blur_tmp;
+    RenderTexture2D bloom;
+};
+typedef struct postprocessing_targets postprocessing_targets_t;
+
+static postprocessing_targets_t targets;
+
+static const char *postprocessing_quality_names[] = {
+    [POSTPROCESSING_QUALITY_FULL]    = "full",
+    [POSTPROCESSING_QUALITY_HALF]    = "half",
+    [POSTPROCESSING_QUALITY_QUARTER] = "quarter"
+};
+
+const char *postprocessing_quality_name(postprocessing_quality_t quality)
+{
+    if ((quality < POSTPROCESSING_QUALITY_MIN) || (quality > POSTPROCESSING_QUALITY_MAX)) {
+        return "(invalid)";
+    }
+    return postprocessing_quality_names[quality];
+}
+
+bool postprocessing_quality_from_name(const char *name, postprocessing_quality_t *quality)
+{
+    assert_not_null(name);
+    assert_not_null(quality);
+
+    for (int i = POSTPROCESSING_QUALITY_MIN; i <= POSTPROCESSING_QUALITY_MAX; i++) {
+        if (0 == strcmp(name, postprocessing_quality_names[i])) {
+            *quality = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool postprocessing_reduced(void)
+{
+    static int ready = -1;
+    if (ready < 0) {
+        ready = (postprocessing_blur_shader.id > 0)
+            && (postprocessing_blur_shader.id != rlGetShaderIdDefault())
+            && (postprocessing_blur_shader_loc.blur_step >= 0)
+            && (postprocessing_shader_loc.bloom_texture >= 0);
+        if (!ready) {
+            warnmsg("the postprocessing blur shader didn't load; postprocessing at full resolution");
+        }
+    }
+
+    postprocessing_quality_t quality =
+        quality_governor_postprocessing_quality(options->postprocessing_quality);
+
+    return (quality != POSTPROCESSING_QUALITY_FULL) && ready;
+}
+
+static RenderTexture2D load_reduced_target(int width, int height)
+{
+    RenderTexture2D target = LoadRenderTexture(MAX(1, width), MAX(1, height));
+    SetTextureFilter(target.texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(target.texture, TEXTURE_WRAP_MIRROR_REPEAT);
+    return target;
+}
+
+static void unload_reduced_target(RenderTexture2D *target)
+{
+    if (IsRenderTextureReady(*target)) {
+        UnloadRenderTexture(*target);
+    }
+}
+
+static void unload_targets(void)
+{
+    unload_reduced_target(&targets.half);
+    unload_reduced_target(&targets.reduced);
+    unload_reduced_target(&targets.blur_tmp);
+    unload_reduced_target(&targets.bloom);
+
+    memset(&targets, 0, sizeof(targets));
+}
+
+static void update_targets(void)
+{
+    postprocessing_quality_t quality =
+        quality_governor_postprocessing_quality(options->postprocessing_quality);
+
+    if (targets.ready
+        && (targets.quality == quality)
+        && (targets.width   == window_size.x)
+        && (targets.height  == window_size.y)) {
+        return;
+    }
+
+    unload_targets();
+
+    int divisor = (quality == POSTPROCESSING_QUALITY_QUARTER) ? 4 : 2;
+    int width   = window_size.x / divisor;
+    int height  = window_size.y / divisor;
+
+    if (quality == POSTPROCESSING_QUALITY_QUARTER) {
+        targets.half = load_reduced_target(window_size.x / 2, window_size.y / 2);
+    }
+    targets.reduced  = load_reduced_target(width, height);
+    targets.blur_tmp = load_reduced_target(width, height);
+    targets.bloom    = load_reduced_target(width, height);
+
+    targets.quality = quality;
+    targets.width   = window_size.x;
+    targets.height  = window_size.y;
+    targets.ready   = true;
+
+    infomsg("Postprocessing at %s resolution (%d x %d)",
+            postprocessing_quality_name(quality), width, height);
+}
+
+static void resample(RenderTexture2D *dst, Texture2D src)
+{
+    Rectangle src_rect = {
+        .x      = 0.0f,
+        .y      = 0.0f,
+        .width  = (float) src.width,
+        .height = (float)-src.height
+    };
+    Rectangle dst_rect = {
+        .x      = 0.0f,
+        .y      = 0.0f,
+        .width  = (float)dst->texture.width,
+        .height = (float)dst->texture.height
+    };
+
+    BeginTextureMode(*dst);
+    {
+        ClearBackground(BLACK);
+        DrawTexturePro(src, src_rect, dst_rect, VEC2_ZERO, 0.0f, WHITE);
+    }
+    EndTextureMode();
+}
+
+static void blur_pass(RenderTexture2D *dst, Texture2D src, Vector2 step)
+{
+    SetShaderValue(postprocessing_blur_shader, postprocessing_blur_shader_loc.blur_step, &step, SHADER_UNIFORM_VEC2);
+
+    BeginShaderMode(postprocessing_blur_shader);
+    {
+        resample(dst, src);
+    }
+    EndShaderMode();
+}
+
+/* after the scene is drawn, and before the final postprocessing pass */
+void postprocessing_prepare(RenderTexture2D *scene)
+{
+    assert_not_null(scene);
+
+    update_targets();
+
+    /* bilinear filtering averages each 2x2 block while halving */
+    SetTextureFilter(scene->texture, TEXTURE_FILTER_BILINEAR);
+    if (targets.quality == POSTPROCESSING_QUALITY_QUARTER) {
+        resample(&targets.half, scene->texture);
+        resample(&targets.reduced, targets.half.texture);
+    } else {
+        resample(&targets.reduced, scene->texture);
+    }
+    SetTextureFilter(scene->texture, TEXTURE_FILTER_POINT);
+
+    blur_pass(&targets.blur_tmp, targets.reduced.texture,  (Vector2){ BLUR_STEP_X, 0.0f });
+    blur_pass(&targets.bloom,    targets.blur_tmp.texture, (Vector2){ 0.0f, BLUR_STEP_Y });
+
+    targets.have_frame = true;
+}
+
+/* NULL unless the reduced copy of the last frame is usable */
+Texture2D *postprocessing_feedback_texture(void)
+{
+    if (postprocessing_reduced() && targets.ready && targets.have_frame) {
+        return &targets.reduced.texture;
+    } else {
+        return NULL;
+    }
+}
+
+/* inside BeginShaderMode(postprocessing_shader) */
+void postprocessing_set_uniforms(void)
+{
+    int reduced = (postprocessing_reduced() && targets.ready && targets.have_frame) ? 1 : 0;
+    SetShaderValue(postprocessing_shader, postprocessing_shader_loc.reduced, &reduced, SHADER_UNIFORM_INT);
+
+    if (reduced) {
+        SetShaderValueTexture(postprocessing_shader, postprocessing_shader_loc.bloom_texture, targets.bloom.texture);
+    }
+}
+
+void cleanup_postprocessing(void)
+{
+    unload_targets();
+}
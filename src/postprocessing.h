@@ -0,0 +1,52 @@
+/****************************************************************************
+ *                                                                          *
+ * postprocessing.h                                                         *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef POSTPROCESSING_H
+#define POSTPROCESSING_H
+
+/*
+ * Below full quality, the bloom blur and the feedback copy of the
+ * last frame are kept at a fraction of the window's resolution. The
+ * blur runs as two separable passes there, and the final
+ * postprocessing pass upsamples the result when it samples it.
+ */
+
+enum postprocessing_quality {
+    POSTPROCESSING_QUALITY_FULL = 0,
+    POSTPROCESSING_QUALITY_HALF,
+    POSTPROCESSING_QUALITY_QUARTER
+};
+typedef enum postprocessing_quality postprocessing_quality_t;
+
+#define POSTPROCESSING_QUALITY_MIN POSTPROCESSING_QUALITY_FULL
+#define POSTPROCESSING_QUALITY_MAX POSTPROCESSING_QUALITY_QUARTER
+
+const char *postprocessing_quality_name(postprocessing_quality_t quality);
+bool postprocessing_quality_from_name(const char *name, postprocessing_quality_t *quality);
+
+bool postprocessing_reduced(void);
+void postprocessing_prepare(RenderTexture2D *scene);
+Texture2D *postprocessing_feedback_texture(void);
+void postprocessing_set_uniforms(void);
+
+void cleanup_postprocessing(void);
+
+#endif /*POSTPROCESSING_H*/
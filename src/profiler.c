@@ -0,0 +1,330 @@
+/****************************************************************************
+ *                                                                          *
+ * profiler.c                                                               *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <errno.h>
+
+#include "options.h"
+#include "profiler.h"
+
+#define PROFILE_MAX_DEPTH        16
+#define PROFILE_HISTORY_FRAMES   240
+#define PROFILE_TRACE_MAX_EVENTS (1 << 22)
+
+/* the part of the frame time no phase accounts for */
+#define PROFILE_OTHER   PROFILE_PHASE_COUNT
+#define PROFILE_COLUMNS (PROFILE_PHASE_COUNT + 1)
+
+#define PROFILE_GRAPH_BAR_WIDTH   2
+#define PROFILE_GRAPH_HEIGHT      120
+#define PROFILE_LEGEND_FONT_SIZE  16
+#define PROFILE_LEGEND_ROW_HEIGHT 18
+
+static const char *profile_phase_names[PROFILE_COLUMNS] = {
+    [PROFILE_PHASE_FRAME_SETUP]   = "frame setup",
+    [PROFILE_PHASE_HANDLE_EVENTS] = "handle events",
+    [PROFILE_PHASE_SOLVER]        = "solver",
+    [PROFILE_PHASE_WIN_ANIM]      = "win animation",
+    [PROFILE_PHASE_PHYSICS]       = "physics",
+    [PROFILE_PHASE_BACKGROUND]    = "background",
+    [PROFILE_PHASE_LEVEL]         = "level",
+    [PROFILE_PHASE_GUI]           = "gui",
+    [PROFILE_PHASE_END_DRAWING]   = "EndDrawing",
+    [PROFILE_OTHER]               = "other"
+};
+
+static const Color profile_phase_colors[PROFILE_COLUMNS] = {
+    [PROFILE_PHASE_FRAME_SETUP]   = { 230,  41,  55, 255 }, // RED
+    [PROFILE_PHASE_HANDLE_EVENTS] = { 255, 161,   0, 255 }, // ORANGE
+    [PROFILE_PHASE_SOLVER]        = { 253, 249,   0, 255 }, // YELLOW
+    [PROFILE_PHASE_WIN_ANIM]      = {   0, 228,  48, 255 }, // GREEN
+    [PROFILE_PHASE_PHYSICS]       = {   0, 117,  44, 255 }, // DARKGREEN
+    [PROFILE_PHASE_BACKGROUND]    = { 102, 191, 255, 255 }, // SKYBLUE
+    [PROFILE_PHASE_LEVEL]         = {   0, 121, 241, 255 }, // BLUE
+    [PROFILE_PHASE_GUI]           = { 200, 122, 255, 255 }, // PURPLE
+    [PROFILE_PHASE_END_DRAWING]   = { 255,   0, 255, 255 }, // MAGENTA
+    [PROFILE_OTHER]               = { 130, 130, 130, 255 }  // GRAY
+};
+
+struct profile_scope {
+    profile_phase_t phase;
+    double start;
+    double children;
+};
+typedef struct profile_scope profile_scope_t;
+
+struct trace_event {
+    const char *name;
+    double start;
+    double duration;
+};
+typedef struct trace_event trace_event_t;
+
+struct profiler {
+    bool tracing;
+    double epoch;
+
+    bool in_frame;
+    double frame_start;
+
+    profile_scope_t stack[PROFILE_MAX_DEPTH];
+    int depth;
+
+    double self[PROFILE_PHASE_COUNT];
+
+    /* milliseconds per column for the last frames that were drawn */
+    float history[PROFILE_HISTORY_FRAMES][PROFILE_COLUMNS];
+    int history_head;
+    int history_filled;
+
+    trace_event_t *events;
+    int event_count;
+    int event_alloc;
+    bool trace_full;
+};
+typedef struct profiler profiler_t;
+
+bool show_profiler = false;
+
+static profiler_t profiler;
+
+static bool profiler_active(void)
+{
+    return show_profiler || profiler.tracing;
+}
+
+static void trace_add(const char *name, double start, double duration)
+{
+    if (!profiler.tracing || profiler.trace_full) {
+        return;
+    }
+
+    if (profiler.event_count == profiler.event_alloc) {
+        if (profiler.event_alloc >= PROFILE_TRACE_MAX_EVENTS) {
+            warnmsg("Trace is full (%d events); not recording any more", profiler.event_count);
+            profiler.trace_full = true;
+            return;
+        }
+
+        profiler.event_alloc = profiler.event_alloc ? (profiler.event_alloc * 2) : 4096;
+        profiler.events = realloc(profiler.events, profiler.event_alloc * sizeof(trace_event_t));
+    }
+
+    trace_event_t *event = &(profiler.events[profiler.event_count++]);
+    event->name     = name;
+    event->start    = start - profiler.epoch;
+    event->duration = duration;
+}
+
+static void write_trace_file(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (NULL == f) {
+        errmsg("Could not open \"%s\" for writing: %s", path, strerror(errno));
+        return;
+    }
+
+    fputs("{\"traceEvents\":[\n", f);
+    fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}", f);
+
+    for (int i=0; i<profiler.event_count; i++) {
+        trace_event_t *event = &(profiler.events[i]);
+        fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":1}",
+                event->name,
+                event->start    * 1000000.0,
+                event->duration * 1000000.0);
+    }
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+
+    if (fclose(f)) {
+        errmsg("Error writing \"%s\": %s", path, strerror(errno));
+        return;
+    }
+
+    infomsg("Wrote %d trace events to \"%s\"", profiler.event_count, path);
+}
+
+void init_profiler(void)
+{
+    memset(&profiler, 0, sizeof(profiler_t));
+
+    profiler.tracing = (NULL != options->trace_file);
+    profiler.epoch = GetTime();
+}
+
+void cleanup_profiler(void)
+{
+    if (profiler.tracing) {
+        write_trace_file(options->trace_file);
+    }
+
+    SAFEFREE(profiler.events);
+    profiler.event_count = 0;
+    profiler.event_alloc = 0;
+    profiler.tracing = false;
+}
+
+void profile_frame_begin(void)
+{
+    if (!profiler_active()) {
+        profiler.in_frame = false;
+        return;
+    }
+
+    profiler.in_frame = true;
+    profiler.depth = 0;
+    memset(profiler.self, 0, sizeof(profiler.self));
+
+    profiler.frame_start = GetTime();
+}
+
+void profile_frame_end(bool drawn)
+{
+    if (!profiler.in_frame) {
+        return;
+    }
+
+    profiler.in_frame = false;
+
+    double duration = GetTime() - profiler.frame_start;
+
+    trace_add(drawn ? "frame" : "skipped frame", profiler.frame_start, duration);
+
+    if (!drawn) {
+        return;
+    }
+
+    float *row = profiler.history[profiler.history_head];
+    double other = duration;
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        row[phase] = (float)(profiler.self[phase] * 1000.0);
+        other -= profiler.self[phase];
+    }
+    row[PROFILE_OTHER] = (float)(MAX(other, 0.0) * 1000.0);
+
+    profiler.history_head = (profiler.history_head + 1) % PROFILE_HISTORY_FRAMES;
+    if (profiler.history_filled < PROFILE_HISTORY_FRAMES) {
+        profiler.history_filled++;
+    }
+}
+
+void profile_begin(profile_phase_t phase)
+{
+    if (!profiler.in_frame) {
+        return;
+    }
+
+    /* too deep to record, but still counted so profile_end() matches */
+    if (profiler.depth < PROFILE_MAX_DEPTH) {
+        profile_scope_t *scope = &(profiler.stack[profiler.depth]);
+        scope->phase    = phase;
+        scope->start    = GetTime();
+        scope->children = 0.0;
+    }
+
+    profiler.depth++;
+}
+
+void profile_end(profile_phase_t phase)
+{
+    if (!profiler.in_frame || (profiler.depth < 1)) {
+        return;
+    }
+
+    profiler.depth--;
+    if (profiler.depth >= PROFILE_MAX_DEPTH) {
+        return;
+    }
+
+    profile_scope_t *scope = &(profiler.stack[profiler.depth]);
+    assert(scope->phase == phase);
+
+    double duration = GetTime() - scope->start;
+    profiler.self[phase] += duration - scope->children;
+    if (profiler.depth > 0) {
+        profiler.stack[profiler.depth - 1].children += duration;
+    }
+
+    trace_add(profile_phase_names[phase], scope->start, duration);
+}
+
+/* a bar per frame, two frame budgets tall, with the budget marked;
+ * the legend lists the average and worst time of each phase */
+void draw_profiler_graph(Vector2 position)
+{
+    if (!show_profiler) {
+        return;
+    }
+
+    float budget_ms = 1000.0f / MAX(1, options->max_fps);
+    float scale = PROFILE_GRAPH_HEIGHT / (2.0f * budget_ms);
+
+    Rectangle bounds = {
+        .x      = position.x,
+        .y      = position.y,
+        .width  = PROFILE_HISTORY_FRAMES * PROFILE_GRAPH_BAR_WIDTH,
+        .height = PROFILE_GRAPH_HEIGHT
+    };
+    float bottom = bounds.y + bounds.height;
+
+    DrawRectangleRec(bounds, ColorAlpha(BLACK, 0.6f));
+
+    float total[PROFILE_COLUMNS] = {0};
+    float worst[PROFILE_COLUMNS] = {0};
+
+    for (int i=0; i<profiler.history_filled; i++) {
+        int idx = (profiler.history_head - profiler.history_filled + i + PROFILE_HISTORY_FRAMES) % PROFILE_HISTORY_FRAMES;
+        float *row = profiler.history[idx];
+        float x = bounds.x + (i * PROFILE_GRAPH_BAR_WIDTH);
+        float y = bottom;
+
+        for (int column = 0; column < PROFILE_COLUMNS; column++) {
+            total[column] += row[column];
+            worst[column] = MAX(worst[column], row[column]);
+
+            float height = MIN(row[column] * scale, y - bounds.y);
+            if (height > 0.0f) {
+                y -= height;
+                DrawRectangleRec((Rectangle){ x, y, PROFILE_GRAPH_BAR_WIDTH, height },
+                                 profile_phase_colors[column]);
+            }
+        }
+    }
+
+    float budget_y = bottom - (budget_ms * scale);
+    DrawLineEx((Vector2){ bounds.x, budget_y },
+               (Vector2){ bounds.x + bounds.width, budget_y },
+               1.0f, ColorAlpha(WHITE, 0.7f));
+
+    float y = bottom + 4.0f;
+    int frames = MAX(1, profiler.history_filled);
+    for (int column = 0; column < PROFILE_COLUMNS; column++) {
+        DrawRectangleRec((Rectangle){ bounds.x, y + 3, 10, 10 }, profile_phase_colors[column]);
+        DrawTextShadow(TextFormat("%-13s %6.2f ms avg %6.2f ms max",
+                                  profile_phase_names[column],
+                                  total[column] / frames,
+                                  worst[column]),
+                       bounds.x + 16, y, PROFILE_LEGEND_FONT_SIZE, WHITE);
+        y += PROFILE_LEGEND_ROW_HEIGHT;
+    }
+}
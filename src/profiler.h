@@ -0,0 +1,64 @@
+/****************************************************************************
+ *                                                                          *
+ * profiler.h                                                               *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/*
+ * Times the parts of each frame. profile_begin()/profile_end() pairs
+ * may nest; the graph shows each phase's own time, without the
+ * phases nested inside it.
+ *
+ * Nothing is measured unless the frame time graph is showing or
+ * --trace-file was given. The trace is written when the program
+ * exits, in the Chrome trace event format (chrome://tracing or
+ * https://ui.perfetto.dev can open it).
+ */
+
+enum profile_phase {
+    PROFILE_PHASE_FRAME_SETUP = 0,
+    PROFILE_PHASE_HANDLE_EVENTS,
+    PROFILE_PHASE_SOLVER,
+    PROFILE_PHASE_WIN_ANIM,
+    PROFILE_PHASE_PHYSICS,
+    PROFILE_PHASE_BACKGROUND,
+    PROFILE_PHASE_LEVEL,
+    PROFILE_PHASE_GUI,
+    PROFILE_PHASE_END_DRAWING
+};
+typedef enum profile_phase profile_phase_t;
+
+#define PROFILE_PHASE_COUNT (PROFILE_PHASE_END_DRAWING + 1)
+
+extern bool show_profiler;
+
+void init_profiler(void);
+void cleanup_profiler(void);
+
+void profile_frame_begin(void);
+void profile_frame_end(bool drawn);
+
+void profile_begin(profile_phase_t phase);
+void profile_end(profile_phase_t phase);
+
+void draw_profiler_graph(Vector2 position);
+
+#endif /*PROFILER_H*/
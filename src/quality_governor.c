@@ -0,0 +1,326 @@
+/****************************************************************************
+ *                                                                          *
+ * quality_governor.c                                                       *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "options.h"
+#include "quality_governor.h"
+#include "redraw.h"
+
+/* frame times are counted in buckets this wide; the last bucket
+ * also counts anything slower */
+#define GOVERNOR_BUCKET_SECONDS 0.0005
+#define GOVERNOR_BUCKETS        128
+
+/* how much recent history the percentiles look at */
+#define GOVERNOR_WINDOW_SECONDS 2.0
+#define GOVERNOR_MIN_WINDOW     16
+#define GOVERNOR_MAX_WINDOW     512
+
+/* step down when this many frames miss the target by the ratio... */
+#define GOVERNOR_SLOW_PERCENTILE 0.90
+#define GOVERNOR_SLOW_RATIO      1.15
+
+/* ...and up when this many frames are on time and only keep the CPU
+ * busy for a fraction of the budget, for long enough */
+#define GOVERNOR_FAST_PERCENTILE 0.95
+#define GOVERNOR_ON_TIME_RATIO   1.05
+#define GOVERNOR_BUSY_RATIO      0.50
+#define GOVERNOR_FAST_SECONDS    5.0
+
+/* a step up that had to be undone this soon makes the next one wait
+ * twice as long, up to the limit */
+#define GOVERNOR_UNDO_SECONDS    10.0
+#define GOVERNOR_MAX_BACKOFF     8
+
+/* frames right after a change still show the old level's cost */
+#define GOVERNOR_SETTLE_SECONDS  1.0
+
+/* loading a collection or dragging the window says nothing about
+ * how expensive the effects are */
+#define GOVERNOR_HITCH_SECONDS   0.25
+
+struct quality_governor_level {
+    postprocessing_quality_t postprocessing_quality;
+    bool postprocessing;
+    background_detail_t background;
+    win_anim_detail_t win_anim;
+    int physics_iterations;
+};
+typedef struct quality_governor_level quality_governor_level_t;
+
+/* ordered from the best looking to the cheapest */
+static const quality_governor_level_t governor_levels[] = {
+    { POSTPROCESSING_QUALITY_FULL,    true,  BACKGROUND_DETAIL_FULL,    WIN_ANIM_DETAIL_FULL,       20 },
+    { POSTPROCESSING_QUALITY_HALF,    true,  BACKGROUND_DETAIL_FULL,    WIN_ANIM_DETAIL_FULL,       20 },
+    { POSTPROCESSING_QUALITY_QUARTER, true,  BACKGROUND_DETAIL_FULL,    WIN_ANIM_DETAIL_FULL,       12 },
+    { POSTPROCESSING_QUALITY_QUARTER, true,  BACKGROUND_DETAIL_NO_GLOW, WIN_ANIM_DETAIL_FULL,        8 },
+    { POSTPROCESSING_QUALITY_QUARTER, true,  BACKGROUND_DETAIL_NO_GLOW, WIN_ANIM_DETAIL_NO_PHYSICS,  8 },
+    { POSTPROCESSING_QUALITY_QUARTER, false, BACKGROUND_DETAIL_STATIC,  WIN_ANIM_DETAIL_SIMPLE,      8 }
+};
+#define GOVERNOR_LEVEL_COUNT ((int)NUM_ELEMENTS(quality_governor_level_t, governor_levels))
+
+static const char *background_detail_names[] = {
+    [BACKGROUND_DETAIL_FULL]    = "full",
+    [BACKGROUND_DETAIL_NO_GLOW] = "no glow",
+    [BACKGROUND_DETAIL_STATIC]  = "static"
+};
+
+static const char *win_anim_detail_names[] = {
+    [WIN_ANIM_DETAIL_FULL]       = "full",
+    [WIN_ANIM_DETAIL_NO_PHYSICS] = "no physics",
+    [WIN_ANIM_DETAIL_SIMPLE]     = "simple"
+};
+
+struct frame_histogram {
+    uint8_t samples[GOVERNOR_MAX_WINDOW];
+    int count[GOVERNOR_BUCKETS];
+    int head;
+    int filled;
+};
+typedef struct frame_histogram frame_histogram_t;
+
+struct quality_governor {
+    int fps;
+    int level;
+    int window;
+    double budget;
+
+    double frame_start;
+    double settle_until;
+
+    frame_histogram_t interval;
+    frame_histogram_t busy;
+
+    double fast_since;
+    int backoff;
+    double last_step_up;
+};
+typedef struct quality_governor quality_governor_t;
+
+static quality_governor_t governor;
+
+static void histogram_reset(frame_histogram_t *hist)
+{
+    memset(hist, 0, sizeof(frame_histogram_t));
+}
+
+static void histogram_add(frame_histogram_t *hist, int window, double seconds)
+{
+    int bucket = (int)(seconds / GOVERNOR_BUCKET_SECONDS);
+    CLAMPVAR(bucket, 0, GOVERNOR_BUCKETS - 1);
+
+    if (hist->filled == window) {
+        hist->count[hist->samples[hist->head]]--;
+    } else {
+        hist->filled++;
+    }
+
+    hist->samples[hist->head] = (uint8_t)bucket;
+    hist->count[bucket]++;
+    hist->head = (hist->head + 1) % window;
+}
+
+/* the upper edge of the bucket the percentile falls in */
+static double histogram_percentile(frame_histogram_t *hist, double percentile)
+{
+    int wanted = (int)ceil(percentile * hist->filled);
+    int seen = 0;
+
+    for (int bucket = 0; bucket < GOVERNOR_BUCKETS; bucket++) {
+        seen += hist->count[bucket];
+        if (seen >= wanted) {
+            return (bucket + 1) * GOVERNOR_BUCKET_SECONDS;
+        }
+    }
+
+    return GOVERNOR_BUCKETS * GOVERNOR_BUCKET_SECONDS;
+}
+
+/* called again whenever the FPS limit changes */
+static void governor_init(void)
+{
+    int fps = MAX(1, options->max_fps);
+
+    /* with vsync, frames can't come faster than the monitor refreshes */
+    int refresh_rate = GetMonitorRefreshRate(GetCurrentMonitor());
+    if (refresh_rate > 0) {
+        fps = MIN(fps, refresh_rate);
+    }
+
+    histogram_reset(&governor.interval);
+    histogram_reset(&governor.busy);
+    governor.fast_since = 0.0;
+
+    governor.fps = options->max_fps;
+    governor.window = (int)(GOVERNOR_WINDOW_SECONDS * fps);
+    CLAMPVAR(governor.window, GOVERNOR_MIN_WINDOW, GOVERNOR_MAX_WINDOW);
+    governor.budget  = 1.0 / fps;
+    governor.backoff = 1;
+}
+
+static bool governor_active(void)
+{
+    /* waiting for events makes frame times meaningless */
+    return options->auto_quality && !options->wait_events;
+}
+
+static const quality_governor_level_t *current_level_settings(void)
+{
+    int level = governor_active() ? governor.level : 0;
+    return &(governor_levels[level]);
+}
+
+static void log_level_change(int old_level, const char *why, double seconds)
+{
+    if (!options->verbose) {
+        return;
+    }
+
+    const quality_governor_level_t *l = &(governor_levels[governor.level]);
+
+    infomsg("Quality governor: %s %.1f ms (budget %.1f ms), level %d -> %d: "
+            "postprocessing %s, background %s, win animation %s, physics iterations %d",
+            why,
+            seconds * 1000.0,
+            governor.budget * 1000.0,
+            old_level,
+            governor.level,
+            l->postprocessing ? postprocessing_quality_name(l->postprocessing_quality) : "off",
+            background_detail_names[l->background],
+            win_anim_detail_names[l->win_anim],
+            l->physics_iterations);
+}
+
+static void set_level(int level, double now, const char *why, double seconds)
+{
+    int old_level = governor.level;
+
+    governor.level = level;
+    governor.settle_until = now + GOVERNOR_SETTLE_SECONDS;
+    governor.fast_since = 0.0;
+
+    histogram_reset(&governor.interval);
+    histogram_reset(&governor.busy);
+
+    log_level_change(old_level, why, seconds);
+}
+
+static void governor_decide(double now)
+{
+    if (governor.interval.filled < governor.window) {
+        return;
+    }
+
+    double slow = histogram_percentile(&governor.interval, GOVERNOR_SLOW_PERCENTILE);
+    if (slow > (governor.budget * GOVERNOR_SLOW_RATIO)) {
+        if (governor.level < (GOVERNOR_LEVEL_COUNT - 1)) {
+            if ((now - governor.last_step_up) < GOVERNOR_UNDO_SECONDS) {
+                governor.backoff = MIN(governor.backoff * 2, GOVERNOR_MAX_BACKOFF);
+            }
+            set_level(governor.level + 1, now, "slow frames at", slow);
+        }
+        return;
+    }
+
+    double on_time = histogram_percentile(&governor.interval, GOVERNOR_FAST_PERCENTILE);
+    double busy    = histogram_percentile(&governor.busy,     GOVERNOR_FAST_PERCENTILE);
+    bool fast = (on_time <= (governor.budget * GOVERNOR_ON_TIME_RATIO))
+        && (busy < (governor.budget * GOVERNOR_BUSY_RATIO));
+
+    if (!fast || (governor.level == 0)) {
+        governor.fast_since = 0.0;
+        return;
+    }
+
+    if (governor.fast_since == 0.0) {
+        governor.fast_since = now;
+    } else if ((now - governor.fast_since) >= (GOVERNOR_FAST_SECONDS * governor.backoff)) {
+        governor.last_step_up = now;
+        set_level(governor.level - 1, now, "frames only busy for", busy);
+    }
+}
+
+void quality_governor_frame_begin(void)
+{
+    governor.frame_start = GetTime();
+}
+
+/* just before EndDrawing(), so the busy time leaves out the wait
+ * for the next frame */
+void quality_governor_frame_end(void)
+{
+    if (!governor_active()) {
+        return;
+    }
+
+    if (governor.fps != options->max_fps) {
+        governor_init();
+    }
+
+    double now = GetTime();
+    double busy = now - governor.frame_start;
+    double interval = GetFrameTime();
+
+    /* the frame time after a skipped frame includes the idle time */
+    if ((now < governor.settle_until)
+        || (redraw_consecutive_frames() < 2)
+        || (interval <= 0.0)
+        || (interval > GOVERNOR_HITCH_SECONDS)
+        || IsWindowMinimized()
+        || !IsWindowFocused()) {
+        return;
+    }
+
+    histogram_add(&governor.interval, governor.window, interval);
+    histogram_add(&governor.busy,     governor.window, busy);
+
+    governor_decide(now);
+}
+
+int quality_governor_level(void)
+{
+    return governor_active() ? governor.level : 0;
+}
+
+postprocessing_quality_t quality_governor_postprocessing_quality(postprocessing_quality_t wanted)
+{
+    return MAX(wanted, current_level_settings()->postprocessing_quality);
+}
+
+bool quality_governor_allow_postprocessing(void)
+{
+    return current_level_settings()->postprocessing;
+}
+
+background_detail_t quality_governor_background_detail(void)
+{
+    return current_level_settings()->background;
+}
+
+win_anim_detail_t quality_governor_win_anim_detail(void)
+{
+    return current_level_settings()->win_anim;
+}
+
+int quality_governor_physics_iterations(void)
+{
+    return current_level_settings()->physics_iterations;
+}
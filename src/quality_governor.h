@@ -0,0 +1,59 @@
+/****************************************************************************
+ *                                                                          *
+ * quality_governor.h                                                       *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include "postprocessing.h"
+
+/*
+ * Watches how long frames take and steps the expensive effects down
+ * one level at a time when the frame rate can't keep up with
+ * options->max_fps, then back up once there is plenty of headroom
+ * again. The user's options are never changed; each effect asks the
+ * governor how far it has been limited.
+ */
+
+enum background_detail {
+    BACKGROUND_DETAIL_FULL = 0,
+    BACKGROUND_DETAIL_NO_GLOW,
+    BACKGROUND_DETAIL_STATIC
+};
+typedef enum background_detail background_detail_t;
+
+enum win_anim_detail {
+    WIN_ANIM_DETAIL_FULL = 0,
+    WIN_ANIM_DETAIL_NO_PHYSICS,
+    WIN_ANIM_DETAIL_SIMPLE
+};
+typedef enum win_anim_detail win_anim_detail_t;
+
+void quality_governor_frame_begin(void);
+void quality_governor_frame_end(void);
+
+int quality_governor_level(void);
+postprocessing_quality_t quality_governor_postprocessing_quality(postprocessing_quality_t wanted);
+bool quality_governor_allow_postprocessing(void);
+background_detail_t quality_governor_background_detail(void);
+win_anim_detail_t quality_governor_win_anim_detail(void);
+int quality_governor_physics_iterations(void);
+
+#endif /*QUALITY_GOVERNOR_H*/
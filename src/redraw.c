@@ -0,0 +1,254 @@
+/****************************************************************************
+ *                                                                          *
+ * redraw.c                                                                 *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "options.h"
+#include "redraw.h"
+
+/* what one redraw_animate() call is worth; covers the gap until the
+ * animation asks again during the next frame */
+#define REDRAW_ANIMATE_FRAMES 2
+
+/* decorative animation is drawn at this rate instead of max_fps... */
+#define REDRAW_AMBIENT_FPS 30
+/* ...and stops after this long without input */
+#define REDRAW_AMBIENT_IDLE_TIMEOUT 30.0
+
+/* once nothing has happened for a while, skipped frames look for
+ * input at this rate instead of max_fps */
+#define REDRAW_IDLE_POLL_FPS 20
+#define REDRAW_IDLE_POLL_DELAY 1.0
+
+struct redraw_state {
+    /* something asked for a frame since the last one was drawn */
+    bool dirty;
+    /* the last frame was asked for, so the one after it is drawn too;
+     * immediate mode GUI changes often only show up a frame later */
+    bool follow_up;
+
+    double animate_until;
+    double wake_at;
+
+    double last_input_time;
+    /* when the last drawn frame started */
+    double last_frame_time;
+
+    bool was_focused;
+
+    int consecutive_frames;
+    long frames_rendered;
+    long frames_skipped;
+};
+typedef struct redraw_state redraw_state_t;
+
+static redraw_state_t redraw = {
+    .dirty = true
+};
+
+static double redraw_frame_seconds(void)
+{
+    return 1.0 / MAX(1, options->max_fps);
+}
+
+static bool redraw_lazy(void)
+{
+    return options->lazy_redraw && !options->wait_events;
+}
+
+void redraw_request(void)
+{
+    redraw.dirty = true;
+}
+
+void redraw_animate_until(double deadline)
+{
+    redraw.animate_until = MAX(redraw.animate_until, deadline);
+}
+
+void redraw_animate(void)
+{
+    redraw_animate_until(GetTime() + (REDRAW_ANIMATE_FRAMES * redraw_frame_seconds()));
+}
+
+void redraw_ambient(void)
+{
+    if (!IsWindowFocused() || IsWindowMinimized()) {
+        return;
+    }
+
+    if ((GetTime() - redraw.last_input_time) > REDRAW_AMBIENT_IDLE_TIMEOUT) {
+        return;
+    }
+
+    redraw_wake_at(redraw.last_frame_time + (1.0 / REDRAW_AMBIENT_FPS));
+}
+
+void redraw_wake_at(double when)
+{
+    if ((redraw.wake_at <= 0.0) || (when < redraw.wake_at)) {
+        redraw.wake_at = when;
+    }
+}
+
+/* raylib has no "did anything happen" query, so look at the state
+ * that the last PollInputEvents() left behind */
+static bool redraw_input_activity(void)
+{
+    Vector2 mouse_delta = GetMouseDelta();
+    if ((mouse_delta.x != 0.0f) || (mouse_delta.y != 0.0f)) {
+        return true;
+    }
+
+    Vector2 wheel = GetMouseWheelMoveV();
+    if ((wheel.x != 0.0f) || (wheel.y != 0.0f)) {
+        return true;
+    }
+
+    for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_BACK; button++) {
+        if (IsMouseButtonDown(button) || IsMouseButtonReleased(button)) {
+            return true;
+        }
+    }
+
+    for (int key = KEY_SPACE; key <= KEY_KB_MENU; key++) {
+        if (IsKeyDown(key) || IsKeyReleased(key)) {
+            return true;
+        }
+    }
+
+    if (GetTouchPointCount() > 0) {
+        return true;
+    }
+
+    if (IsWindowResized() || IsFileDropped()) {
+        return true;
+    }
+
+    bool focused = IsWindowFocused();
+    if (focused != redraw.was_focused) {
+        redraw.was_focused = focused;
+        return true;
+    }
+
+    return false;
+}
+
+/* called once per main loop iteration, after input was handled */
+bool redraw_frame_needed(void)
+{
+    if (!redraw_lazy()) {
+        return true;
+    }
+
+    double now = GetTime();
+
+    if (redraw_input_activity()) {
+        redraw.last_input_time = now;
+        redraw.dirty = true;
+    }
+
+    bool needed = redraw.dirty
+        || redraw.follow_up
+        || (now < redraw.animate_until);
+
+    if ((redraw.wake_at > 0.0) && (now >= redraw.wake_at)) {
+        redraw.wake_at = 0.0;
+        needed = true;
+    }
+
+    redraw.follow_up = false;
+
+    if (needed) {
+        redraw.last_frame_time = now;
+    }
+
+    return needed;
+}
+
+/* called just before EndDrawing(); returns true when the next frame
+ * is already known to be needed */
+bool redraw_frame_end(void)
+{
+    bool again = redraw.dirty || (GetTime() < redraw.animate_until);
+
+    redraw.follow_up = redraw.dirty;
+    redraw.dirty = false;
+
+    redraw.frames_rendered++;
+    redraw.consecutive_frames++;
+
+    return again;
+}
+
+/* stands in for EndDrawing() on a frame that wasn't drawn: wait like
+ * it would have, without swapping buffers, then look for input */
+void redraw_skip_frame(void)
+{
+    double now = GetTime();
+    double wait = redraw_frame_seconds();
+
+    if ((now - MAX(redraw.last_input_time, redraw.last_frame_time)) > REDRAW_IDLE_POLL_DELAY) {
+        wait = MAX(wait, 1.0 / REDRAW_IDLE_POLL_FPS);
+    }
+
+    if (redraw.wake_at > 0.0) {
+        wait = MIN(wait, redraw.wake_at - now);
+    }
+
+    if (wait > 0.0) {
+        WaitTime(wait);
+    }
+
+    PollInputEvents();
+
+    redraw.frames_skipped++;
+    redraw.consecutive_frames = 0;
+}
+
+/* how many frames in a row have been drawn; raylib's frame time
+ * includes any skipped frames until the second one */
+int redraw_consecutive_frames(void)
+{
+    return redraw.consecutive_frames;
+}
+
+long redraw_frames_rendered(void)
+{
+    return redraw.frames_rendered;
+}
+
+long redraw_frames_skipped(void)
+{
+    return redraw.frames_skipped;
+}
+
+void redraw_log_stats(void)
+{
+    long total = redraw.frames_rendered + redraw.frames_skipped;
+    if (total < 1) {
+        return;
+    }
+
+    infomsg("Frames rendered: %ld, skipped: %ld (%.1f%% skipped)",
+            redraw.frames_rendered,
+            redraw.frames_skipped,
+            100.0 * ((double)redraw.frames_skipped) / ((double)total));
+}
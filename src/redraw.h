@@ -0,0 +1,58 @@
+/****************************************************************************
+ *                                                                          *
+ * redraw.h                                                                 *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef REDRAW_H
+#define REDRAW_H
+
+/*
+ * Decides which frames need to be drawn. Anything that changes what
+ * is on screen says so with redraw_request(); anything that moves
+ * keeps calling redraw_animate() (or redraw_animate_until()) for as
+ * long as it moves, and anything that only changes at a known time
+ * asks for redraw_wake_at(). Input always gets a frame.
+ *
+ * When none of those want a frame, the main loop skips drawing and
+ * sleeps until the next wake time, checking for input at the frame
+ * rate, or less often once nothing has happened for a second.
+ * Decorative animation that never ends (the background, the title)
+ * uses redraw_ambient(), which asks for frames at a reduced rate while
+ * the window has focus and stops after a while without input.
+ *
+ * With --no-lazy-redraw or --wait-events every frame is drawn, and the
+ * requests only keep --wait-events from blocking.
+ */
+
+void redraw_request(void);
+void redraw_animate(void);
+void redraw_animate_until(double deadline);
+void redraw_ambient(void);
+void redraw_wake_at(double when);
+
+bool redraw_frame_needed(void);
+bool redraw_frame_end(void);
+void redraw_skip_frame(void);
+
+int redraw_consecutive_frames(void);
+long redraw_frames_rendered(void);
+long redraw_frames_skipped(void);
+void redraw_log_stats(void);
+
+#endif /*REDRAW_H*/
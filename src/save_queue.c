@@ -0,0 +1,453 @@
+/****************************************************************************
+ *                                                                          *
+ * save_queue.c                                                             *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <fcntl.h>
+#include <libgen.h>
+
+#if defined(PLATFORM_DESKTOP)
+# include <pthread.h>
+# define SAVE_QUEUE_USE_THREAD
+#endif
+
+#include "options.h"
+#include "save_queue.h"
+
+struct save_job {
+    char *path;
+    unsigned char *data;
+    size_t size;
+    bool ok;
+
+    save_job_done_cb_t done_cb;
+    void *done_data;
+
+    /* older jobs for the same path that this one replaced */
+    struct save_job *coalesced;
+
+    struct save_job *next;
+};
+typedef struct save_job save_job_t;
+
+static const char *save_durability_names[] = {
+    [SAVE_DURABILITY_NONE] = "none",
+    [SAVE_DURABILITY_FILE] = "file",
+    [SAVE_DURABILITY_FULL] = "full"
+};
+
+const char *save_durability_name(save_durability_t durability)
+{
+    if ((durability < SAVE_DURABILITY_NONE) || (durability > SAVE_DURABILITY_FULL)) {
+        return "(invalid)";
+    }
+    return save_durability_names[durability];
+}
+
+bool save_durability_from_name(const char *name, save_durability_t *durability)
+{
+    assert_not_null(name);
+    assert_not_null(durability);
+
+    for (int i = SAVE_DURABILITY_NONE; i <= SAVE_DURABILITY_FULL; i++) {
+        if (0 == strcmp(name, save_durability_names[i])) {
+            *durability = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*** writing ***/
+
+static bool fsync_dir_of(const char *path)
+{
+    char *dirc = strdup(path);
+    int fd = open(dirname(dirc), O_RDONLY);
+    bool rv = (fd != -1) && (0 == fsync(fd));
+    if (fd != -1) {
+        close(fd);
+    }
+    free(dirc);
+    return rv;
+}
+
+bool write_file_atomic(const char *path, const void *data, size_t size)
+{
+    assert_not_null(path);
+
+    save_durability_t durability = options ? options->save_durability : SAVE_DURABILITY_FILE;
+
+    bool rv = false;
+    char *tmpname = NULL;
+    safe_asprintf(&tmpname, "%s.tmp", path);
+
+    int fd = open(tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (-1 == fd) {
+        errmsg("Could not open \"%s\" for writing: %s", tmpname, strerror(errno));
+        goto write_cleanup;
+    }
+
+    const unsigned char *p = data;
+    size_t remaining = size;
+    while (remaining > 0) {
+        ssize_t n = write(fd, p, remaining);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            errmsg("Error writing \"%s\": %s", tmpname, strerror(errno));
+            close(fd);
+            goto write_remove_tmp;
+        }
+        p += n;
+        remaining -= n;
+    }
+
+    if ((durability >= SAVE_DURABILITY_FILE) && (0 != fsync(fd))) {
+        errmsg("Error syncing \"%s\": %s", tmpname, strerror(errno));
+        close(fd);
+        goto write_remove_tmp;
+    }
+
+    if (0 != close(fd)) {
+        errmsg("Error closing \"%s\": %s", tmpname, strerror(errno));
+        goto write_remove_tmp;
+    }
+
+    if (-1 == rename(tmpname, path)) {
+        errmsg("Error trying to rename \"%s\" to \"%s\": %s",
+               tmpname, path, strerror(errno));
+        goto write_remove_tmp;
+    }
+
+    if ((durability >= SAVE_DURABILITY_FULL) && !fsync_dir_of(path)) {
+        warnmsg("Error syncing the directory of \"%s\": %s", path, strerror(errno));
+    }
+
+    rv = true;
+    goto write_cleanup;
+
+  write_remove_tmp:
+    unlink(tmpname);
+
+  write_cleanup:
+    free(tmpname);
+    return rv;
+}
+
+/*** jobs ***/
+
+static save_job_t *create_save_job(const char *path, void *data, size_t size, save_job_done_cb_t done_cb, void *done_data)
+{
+    save_job_t *job = calloc(1, sizeof(save_job_t));
+    job->path      = strdup(path);
+    job->data      = data;
+    job->size      = size;
+    job->done_cb   = done_cb;
+    job->done_data = done_data;
+    return job;
+}
+
+/* whether a newer job in the chain already reported to the same callback */
+static bool save_job_callback_done(save_job_t *newest, save_job_t *job)
+{
+    for (save_job_t *newer = newest; newer != job; newer = newer->coalesced) {
+        if ((newer->done_cb == job->done_cb) && (newer->done_data == job->done_data)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void finish_save_job(save_job_t *job)
+{
+    /* the replaced jobs were never written; their data went out
+     * (or failed to) with the newest job's write, which is reported
+     * once to each distinct callback */
+    bool ok = job ? job->ok : false;
+
+    for (save_job_t *j = job; j; j = j->coalesced) {
+        if (j->done_cb && !save_job_callback_done(job, j)) {
+            j->done_cb(j->path, ok, j->done_data);
+        }
+    }
+
+    while (job) {
+        save_job_t *older = job->coalesced;
+
+        SAFEFREE(job->data);
+        SAFEFREE(job->path);
+        SAFEFREE(job);
+
+        job = older;
+    }
+}
+
+#if defined(SAVE_QUEUE_USE_THREAD)
+
+static pthread_t writer_thread;
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  queue_cond  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  done_cond   = PTHREAD_COND_INITIALIZER;
+
+static bool writer_running = false;
+static bool writer_stop = false;
+
+/* all protected by queue_mutex */
+static save_job_t *pending_head = NULL;
+static save_job_t *pending_tail = NULL;
+static save_job_t *active_job = NULL;
+static save_job_t *done_head = NULL;
+static save_job_t *done_tail = NULL;
+
+static void *writer_thread_main(UNUSED void *arg)
+{
+    pthread_mutex_lock(&queue_mutex);
+
+    for (;;) {
+        while (!pending_head && !writer_stop) {
+            pthread_cond_wait(&queue_cond, &queue_mutex);
+        }
+
+        if (!pending_head) {
+            break;
+        }
+
+        save_job_t *job = pending_head;
+        pending_head = job->next;
+        if (!pending_head) {
+            pending_tail = NULL;
+        }
+        job->next = NULL;
+        active_job = job;
+
+        pthread_mutex_unlock(&queue_mutex);
+        job->ok = write_file_atomic(job->path, job->data, job->size);
+        pthread_mutex_lock(&queue_mutex);
+
+        /* the data isn't needed anymore; free it early */
+        SAFEFREE(job->data);
+
+        active_job = NULL;
+        if (done_tail) {
+            done_tail->next = job;
+        } else {
+            done_head = job;
+        }
+        done_tail = job;
+
+        pthread_cond_broadcast(&done_cond);
+    }
+
+    pthread_mutex_unlock(&queue_mutex);
+    return NULL;
+}
+
+static bool job_busy_with_path(const char *path)
+{
+    if (active_job && (0 == strcmp(active_job->path, path))) {
+        return true;
+    }
+    for (save_job_t *job = pending_head; job; job = job->next) {
+        if (0 == strcmp(job->path, path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void init_save_queue(void)
+{
+    if (writer_running || !options->async_save) {
+        return;
+    }
+
+    writer_stop = false;
+    if (0 != pthread_create(&writer_thread, NULL, writer_thread_main, NULL)) {
+        errmsg("Could not start the save thread; saving synchronously");
+        return;
+    }
+
+    writer_running = true;
+
+    if (options->verbose) {
+        infomsg("Started the save thread (durability: %s)",
+                save_durability_name(options->save_durability));
+    }
+}
+
+void cleanup_save_queue(void)
+{
+    if (!writer_running) {
+        return;
+    }
+
+    save_queue_flush();
+
+    pthread_mutex_lock(&queue_mutex);
+    writer_stop = true;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
+
+    pthread_join(writer_thread, NULL);
+    writer_running = false;
+
+    save_queue_poll();
+}
+
+bool save_queue_submit(const char *path, void *data, size_t size, save_job_done_cb_t done_cb, void *done_data)
+{
+    assert_not_null(path);
+    assert_not_null(data);
+
+    save_job_t *job = create_save_job(path, data, size, done_cb, done_data);
+
+    if (!writer_running) {
+        job->ok = write_file_atomic(job->path, job->data, job->size);
+        bool ok = job->ok;
+        finish_save_job(job);
+        return ok;
+    }
+
+    pthread_mutex_lock(&queue_mutex);
+
+    save_job_t *prev = NULL;
+    save_job_t *old = pending_head;
+    while (old && strcmp(old->path, path)) {
+        prev = old;
+        old = old->next;
+    }
+
+    if (old) {
+        /* take over the older job's place in the queue */
+        job->next = old->next;
+        if (prev) {
+            prev->next = job;
+        } else {
+            pending_head = job;
+        }
+        if (pending_tail == old) {
+            pending_tail = job;
+        }
+
+        SAFEFREE(old->data);
+        old->next = NULL;
+        job->coalesced = old;
+
+        if (options->verbose) {
+            infomsg("Coalesced queued save of \"%s\"", path);
+        }
+    } else {
+        if (pending_tail) {
+            pending_tail->next = job;
+        } else {
+            pending_head = job;
+        }
+        pending_tail = job;
+    }
+
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
+
+    return true;
+}
+
+void save_queue_poll(void)
+{
+    pthread_mutex_lock(&queue_mutex);
+    save_job_t *job = done_head;
+    done_head = NULL;
+    done_tail = NULL;
+    pthread_mutex_unlock(&queue_mutex);
+
+    while (job) {
+        save_job_t *next = job->next;
+        finish_save_job(job);
+        job = next;
+    }
+}
+
+void save_queue_flush(void)
+{
+    if (writer_running) {
+        pthread_mutex_lock(&queue_mutex);
+        while (pending_head || active_job) {
+            pthread_cond_wait(&done_cond, &queue_mutex);
+        }
+        pthread_mutex_unlock(&queue_mutex);
+    }
+
+    save_queue_poll();
+}
+
+void save_queue_wait_for_path(const char *path)
+{
+    assert_not_null(path);
+
+    if (!writer_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&queue_mutex);
+    while (job_busy_with_path(path)) {
+        pthread_cond_wait(&done_cond, &queue_mutex);
+    }
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+#else /* !SAVE_QUEUE_USE_THREAD */
+
+void init_save_queue(void)
+{
+}
+
+void cleanup_save_queue(void)
+{
+}
+
+bool save_queue_submit(const char *path, void *data, size_t size, save_job_done_cb_t done_cb, void *done_data)
+{
+    assert_not_null(path);
+    assert_not_null(data);
+
+    save_job_t *job = create_save_job(path, data, size, done_cb, done_data);
+    job->ok = write_file_atomic(job->path, job->data, job->size);
+    bool ok = job->ok;
+    finish_save_job(job);
+    return ok;
+}
+
+void save_queue_poll(void)
+{
+}
+
+void save_queue_flush(void)
+{
+}
+
+void save_queue_wait_for_path(UNUSED const char *path)
+{
+}
+
+#endif /* SAVE_QUEUE_USE_THREAD */
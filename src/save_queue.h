@@ -0,0 +1,64 @@
+/****************************************************************************
+ *                                                                          *
+ * save_queue.h                                                             *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef SAVE_QUEUE_H
+#define SAVE_QUEUE_H
+
+/*
+ * Background file writer. Callers serialize their data on the main
+ * thread and hand the finished buffer to save_queue_submit(); the
+ * writer thread does the write/fsync/rename. A file is always written
+ * to "<path>.tmp" and renamed into place, so readers only ever see
+ * the old or the new version.
+ *
+ * A job that is still waiting in the queue is replaced (coalesced)
+ * when the same path is submitted again. Completion callbacks run on
+ * the main thread from save_queue_poll() or save_queue_flush().
+ *
+ * When the writer thread isn't running (before init_save_queue(), with
+ * --no-async-save, or on platforms without threads) jobs are written
+ * immediately instead.
+ */
+
+enum save_durability {
+    SAVE_DURABILITY_NONE = 0,   /* write and rename */
+    SAVE_DURABILITY_FILE,       /* fsync() the file before the rename */
+    SAVE_DURABILITY_FULL        /* also fsync() the directory after the rename */
+};
+typedef enum save_durability save_durability_t;
+
+typedef void (*save_job_done_cb_t)(const char *path, bool ok, void *data);
+
+const char *save_durability_name(save_durability_t durability);
+bool save_durability_from_name(const char *name, save_durability_t *durability);
+
+bool write_file_atomic(const char *path, const void *data, size_t size);
+
+void init_save_queue(void);
+void cleanup_save_queue(void);
+
+bool save_queue_submit(const char *path, void *data, size_t size, save_job_done_cb_t done_cb, void *done_data);
+void save_queue_poll(void);
+void save_queue_flush(void);
+void save_queue_wait_for_path(const char *path);
+
+#endif /*SAVE_QUEUE_H*/
+
@@ -33,11 +33,51 @@ Shader postprocessing_shader;
 postprocessing_shader_loc_t postprocessing_shader_loc;
 char *postprocessing_shader_src;
 
+Shader postprocessing_blur_shader;
+postprocessing_blur_shader_loc_t postprocessing_blur_shader_loc;
+char *postprocessing_blur_shader_src;
+
 Shader background_shader;
 background_shader_loc_t background_shader_loc;
 char *background_shader_vert_src;
 char *background_shader_frag_src;
 
+Shader tile_sdf_shader;
+tile_sdf_shader_loc_t tile_sdf_shader_loc;
+char *tile_sdf_shader_src;
+
+#if defined(GRAPHICS_API_OPENGL_33)
+Shader tile_instance_shader;
+tile_instance_shader_loc_t tile_instance_shader_loc;
+char *tile_instance_shader_vert_src;
+char *tile_instance_shader_frag_src;
+
+static void load_tile_instance_shader(void)
+{
+    tile_instance_shader_vert_src = strdup_xxd_include(
+        shaders_tile_instance_vert_glsl,
+        shaders_tile_instance_vert_glsl_len);
+
+    tile_instance_shader_frag_src = strdup_xxd_include(
+        shaders_tile_instance_frag_glsl,
+        shaders_tile_instance_frag_glsl_len);
+
+    tile_instance_shader = LoadShaderFromMemory(tile_instance_shader_vert_src, tile_instance_shader_frag_src);
+    tile_instance_shader_loc.mvp            = GetShaderLocation(tile_instance_shader, "mvp");
+    tile_instance_shader_loc.bg_color       = GetShaderLocation(tile_instance_shader, "bgColor");
+    tile_instance_shader_loc.bg_hover_color = GetShaderLocation(tile_instance_shader, "bgHoverColor");
+    tile_instance_shader_loc.center_color   = GetShaderLocation(tile_instance_shader, "centerColor");
+
+    tile_instance_shader_loc.position  = GetShaderLocationAttrib(tile_instance_shader, "vertexPosition");
+    tile_instance_shader_loc.part      = GetShaderLocationAttrib(tile_instance_shader, "vertexPart");
+    tile_instance_shader_loc.transform = GetShaderLocationAttrib(tile_instance_shader, "instanceTransform");
+    tile_instance_shader_loc.flags     = GetShaderLocationAttrib(tile_instance_shader, "instanceFlags");
+    for (int i=0; i<6; i++) {
+        tile_instance_shader_loc.path[i] = GetShaderLocationAttrib(tile_instance_shader, TextFormat("instancePath%d", i));
+    }
+}
+#endif
+
 void load_shaders(void)
 {
     win_border_shader_src = strdup_xxd_include(
@@ -71,6 +111,15 @@ void load_shaders(void)
     postprocessing_shader_loc.time           = GetShaderLocation(postprocessing_shader, "time");
     postprocessing_shader_loc.effect_amount1 = GetShaderLocation(postprocessing_shader, "effect_amount1");
     postprocessing_shader_loc.effect_amount2 = GetShaderLocation(postprocessing_shader, "effect_amount2");
+    postprocessing_shader_loc.reduced        = GetShaderLocation(postprocessing_shader, "reduced");
+    postprocessing_shader_loc.bloom_texture  = GetShaderLocation(postprocessing_shader, "bloom_texture");
+
+    postprocessing_blur_shader_src = strdup_xxd_include(
+        shaders_postprocessing_blur_frag_glsl,
+        shaders_postprocessing_blur_frag_glsl_len);
+
+    postprocessing_blur_shader = LoadShaderFromMemory(0, postprocessing_blur_shader_src);
+    postprocessing_blur_shader_loc.blur_step = GetShaderLocation(postprocessing_blur_shader, "blur_step");
 
     background_shader_vert_src = strdup_xxd_include(
         shaders_background_vert_glsl,
@@ -86,6 +135,34 @@ void load_shaders(void)
     background_shader_loc.warp           = GetShaderLocation(background_shader, "warp");
     background_shader_loc.effect_amount1 = GetShaderLocation(background_shader, "effect_amount1");
     background_shader_loc.effect_amount2 = GetShaderLocation(background_shader, "effect_amount2");
+    background_shader_loc.procedural     = GetShaderLocation(background_shader, "procedural");
+    background_shader_loc.grid_clock     = GetShaderLocation(background_shader, "grid_clock");
+    background_shader_loc.grid_rotate    = GetShaderLocation(background_shader, "grid_rotate");
+    background_shader_loc.bloom          = GetShaderLocation(background_shader, "bloom");
+    background_shader_loc.minor_color    = GetShaderLocation(background_shader, "minor_color");
+    background_shader_loc.hmajor_color   = GetShaderLocation(background_shader, "hmajor_color");
+    background_shader_loc.vmajor_color   = GetShaderLocation(background_shader, "vmajor_color");
+
+    tile_sdf_shader_src = strdup_xxd_include(
+        shaders_tile_sdf_frag_glsl,
+        shaders_tile_sdf_frag_glsl_len);
+
+    tile_sdf_shader = LoadShaderFromMemory(0, tile_sdf_shader_src);
+    tile_sdf_shader_loc.tile_size       = GetShaderLocation(tile_sdf_shader, "tile_size");
+    tile_sdf_shader_loc.line_width      = GetShaderLocation(tile_sdf_shader, "line_width");
+    tile_sdf_shader_loc.border_width    = GetShaderLocation(tile_sdf_shader, "border_width");
+    tile_sdf_shader_loc.highlight_width = GetShaderLocation(tile_sdf_shader, "highlight_width");
+    tile_sdf_shader_loc.center_radius   = GetShaderLocation(tile_sdf_shader, "center_radius");
+    tile_sdf_shader_loc.arm_end         = GetShaderLocation(tile_sdf_shader, "arm_end");
+    tile_sdf_shader_loc.bg_color        = GetShaderLocation(tile_sdf_shader, "bg_color");
+    tile_sdf_shader_loc.edge_color      = GetShaderLocation(tile_sdf_shader, "edge_color");
+    tile_sdf_shader_loc.center_color    = GetShaderLocation(tile_sdf_shader, "center_color");
+    tile_sdf_shader_loc.path_color      = GetShaderLocation(tile_sdf_shader, "path_color");
+    tile_sdf_shader_loc.highlight_color = GetShaderLocation(tile_sdf_shader, "highlight_color");
+
+#if defined(GRAPHICS_API_OPENGL_33)
+    load_tile_instance_shader();
+#endif
 }
 
 void unload_shaders(void)
@@ -96,7 +173,19 @@ void unload_shaders(void)
     UnloadShader(postprocessing_shader);
     FREE(postprocessing_shader_src);
 
+    UnloadShader(postprocessing_blur_shader);
+    FREE(postprocessing_blur_shader_src);
+
     UnloadShader(background_shader);
     FREE(background_shader_vert_src);
     FREE(background_shader_frag_src);
+
+    UnloadShader(tile_sdf_shader);
+    FREE(tile_sdf_shader_src);
+
+#if defined(GRAPHICS_API_OPENGL_33)
+    UnloadShader(tile_instance_shader);
+    FREE(tile_instance_shader_vert_src);
+    FREE(tile_instance_shader_frag_src);
+#endif
 }
@@ -38,9 +38,17 @@ typedef struct postprocessing_shader_loc {
     int time;
     int effect_amount1;
     int effect_amount2;
+    int reduced;
+    int bloom_texture;
 } postprocessing_shader_loc_t;
 extern postprocessing_shader_loc_t postprocessing_shader_loc;
 
+extern Shader postprocessing_blur_shader;
+typedef struct postprocessing_blur_shader_loc {
+    int blur_step;
+} postprocessing_blur_shader_loc_t;
+extern postprocessing_blur_shader_loc_t postprocessing_blur_shader_loc;
+
 extern Shader background_shader;
 typedef struct background_shader_loc {
     int resolution;
@@ -48,9 +56,50 @@ typedef struct background_shader_loc {
     int warp;
     int effect_amount1;
     int effect_amount2;
+    int procedural;
+    int grid_clock;
+    int grid_rotate;
+    int bloom;
+    int minor_color;
+    int hmajor_color;
+    int vmajor_color;
 } background_shader_loc_t;
 extern background_shader_loc_t background_shader_loc;
 
+extern Shader tile_sdf_shader;
+typedef struct tile_sdf_shader_loc {
+    int tile_size;
+    int line_width;
+    int border_width;
+    int highlight_width;
+    int center_radius;
+    int arm_end;
+    int bg_color;
+    int edge_color;
+    int center_color;
+    int path_color;
+    int highlight_color;
+} tile_sdf_shader_loc_t;
+extern tile_sdf_shader_loc_t tile_sdf_shader_loc;
+
+#if defined(GRAPHICS_API_OPENGL_33)
+extern Shader tile_instance_shader;
+typedef struct tile_instance_shader_loc {
+    int mvp;
+    int bg_color;
+    int bg_hover_color;
+    int center_color;
+
+    /* vertex attributes */
+    int position;
+    int part;
+    int transform;
+    int flags;
+    int path[6];
+} tile_instance_shader_loc_t;
+extern tile_instance_shader_loc_t tile_instance_shader_loc;
+#endif
+
 void load_shaders(void);
 void unload_shaders(void);
 
@@ -26,6 +26,8 @@
 #include "tile_pos.h"
 #include "level.h"
 #include "solver.h"
+#include "hex_grid.h"
+#include "redraw.h"
 
 //#define DEBUG_SOLVER
 
@@ -58,6 +60,10 @@ solver_t *create_solver(struct level *level)
     solver_t *solver = calloc(1, sizeof(solver_t));
 
     solver->level = level;
+
+    solver->saved_position_count = level->grid->maxtiles;
+    solver->saved_positions = calloc(solver->saved_position_count, sizeof(saved_position_t));
+
     solver->state = SOLVER_STATE_IDLE;
     solver->tile_index   = 0;
     solver->solved_index = 0;
@@ -76,7 +82,10 @@ solver_t *create_or_use_solver(struct level *level)
 
 void destroy_solver(solver_t *solver)
 {
-    SAFEFREE(solver);
+    if (solver) {
+        SAFEFREE(solver->saved_positions);
+        SAFEFREE(solver);
+    }
 }
 
 void solver_set_state(solver_t *solver, solver_state_t new_state)
@@ -151,7 +160,7 @@ void solver_set_state(solver_t *solver, solver_state_t new_state)
     solver->state = new_state;
 
     if (new_state != SOLVER_STATE_IDLE) {
-        render_next_frame_no_waiting = true;
+        redraw_request();
     }
 }
 
@@ -328,7 +337,7 @@ static bool update_move_anim(solver_t *solver)
     printf("solver: anim_progress = %f, cur_pos = <%d, %d>\n", solver->anim_progress, icur_pos.x, icur_pos.y);
 #endif
 
-    render_next_frame_no_waiting = true;
+    redraw_request();
 
     if (solver->anim_progress >= 1.0) {
         stop_move_anim(solver);
@@ -341,7 +350,7 @@ static bool update_move_anim(solver_t *solver)
 static bool next_tile_index(solver_t *solver)
 {
     int next_tile_index = solver->tile_index + 1;
-    if (next_tile_index >= LEVEL_MAXTILES) {
+    if (next_tile_index >= solver->saved_position_count) {
         solver_set_state(solver, SOLVER_STATE_IDLE);
         return true;
     } else {
@@ -42,7 +42,10 @@ typedef struct saved_position saved_position_t;
 
 struct solver {
     struct level *level;
-    saved_position_t saved_positions[LEVEL_MAXTILES];
+
+    /* one per tile slot of the level's grid */
+    int saved_position_count;
+    saved_position_t *saved_positions;
 
     IVector2 saved_mouse_position;
 
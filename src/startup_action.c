@@ -26,6 +26,12 @@
 #include "gui_random.h"
 #include "startup_action.h"
 #include "generate_level.h"
+#include "nvdata.h"
+#include "nvdata_finished.h"
+#include "history_bench.h"
+#include "json_bench.h"
+#include "thumbnail.h"
+#include "thread_pool.h"
 
 bool startup_action_ok = false;
 
@@ -181,6 +187,68 @@ void action_unpack_collection(void)
     startup_action_ok = true;
 }
 
+static bool load_history_for_action(void)
+{
+    init_nvdata();
+
+    if (!nvdata_state_finished_levels_file_path) {
+        errmsg("Couldn't find the finished level history");
+        return false;
+    }
+
+    load_nvdata_finished_levels();
+    return true;
+}
+
+void action_export_history(void)
+{
+    infomsg("ACTION: export history");
+
+    if (options->extra_argc != 1) {
+        errmsg("--export-history needs exactly one output file");
+        return;
+    }
+
+    char *filename = options->extra_argv[0];
+    if (!options->force && FileExists(filename)) {
+        errmsg("File already exists: \"%s\"", filename);
+        return;
+    }
+
+    if (load_history_for_action()) {
+        infomsg("EXPORT: %d finished levels -> \"%s\"", finished_levels.count, filename);
+        startup_action_ok = nvdata_finished_export_json(filename);
+    }
+
+    cleanup_nvdata();
+}
+
+void action_import_history(void)
+{
+    infomsg("ACTION: import history");
+
+    if (load_history_for_action()) {
+        startup_action_ok = true;
+
+        for (int arg=0; arg < options->extra_argc; arg++) {
+            char *filename = options->extra_argv[arg];
+            infomsg("IMPORT: \"%s\"", filename);
+
+            if (!nvdata_finished_import_json(filename)) {
+                errmsg("Couldn't import finished level history \"%s\"", filename);
+                startup_action_ok = false;
+                break;
+            }
+        }
+
+        if (startup_action_ok) {
+            force_save_nvdata_finished_levels();
+        }
+    }
+
+    cleanup_nvdata();
+}
+
 bool run_startup_action(void)
 {
 #if 0
@@ -194,6 +262,8 @@ bool run_startup_action(void)
         fallthrough;
     case STARTUP_ACTION_DEMO_WIN_ANIM:
         fallthrough;
+    case STARTUP_ACTION_BENCHMARK_BOARD:
+        fallthrough;
     case STARTUP_ACTION_PLAY:
         fallthrough;
     case STARTUP_ACTION_RANDOM:
@@ -206,13 +276,37 @@ bool run_startup_action(void)
         return true;
 
     case STARTUP_ACTION_PACK_COLLECTION:
+        init_thread_pool();
         action_pack_collection();
+        cleanup_thread_pool();
         return true;
 
     case STARTUP_ACTION_UNPACK_COLLECTION:
         action_unpack_collection();
         return true;
 
+    case STARTUP_ACTION_EXPORT_HISTORY:
+        action_export_history();
+        return true;
+
+    case STARTUP_ACTION_IMPORT_HISTORY:
+        action_import_history();
+        return true;
+
+    case STARTUP_ACTION_BENCHMARK_HISTORY:
+        startup_action_ok = run_history_benchmark();
+        return true;
+
+    case STARTUP_ACTION_BENCHMARK_JSON:
+        startup_action_ok = run_json_benchmark();
+        return true;
+
+    case STARTUP_ACTION_EXPORT_THUMBNAILS:
+        init_thread_pool();
+        startup_action_ok = run_thumbnail_export();
+        cleanup_thread_pool();
+        return true;
+
     case STARTUP_ACTION_NONE:
         fallthrough;
     default:
@@ -31,7 +31,13 @@ enum startup_action {
     STARTUP_ACTION_PACK_COLLECTION,
     STARTUP_ACTION_UNPACK_COLLECTION,
     STARTUP_ACTION_DEMO_SOLVE,
-    STARTUP_ACTION_DEMO_WIN_ANIM
+    STARTUP_ACTION_DEMO_WIN_ANIM,
+    STARTUP_ACTION_BENCHMARK_BOARD,
+    STARTUP_ACTION_EXPORT_HISTORY,
+    STARTUP_ACTION_IMPORT_HISTORY,
+    STARTUP_ACTION_BENCHMARK_HISTORY,
+    STARTUP_ACTION_BENCHMARK_JSON,
+    STARTUP_ACTION_EXPORT_THUMBNAILS
 };
 typedef enum startup_action startup_action_t;
 
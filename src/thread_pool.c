@@ -0,0 +1,318 @@
+/****************************************************************************
+ *                                                                          *
+ * thread_pool.c                                                            *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#if defined(PLATFORM_DESKTOP)
+# include <pthread.h>
+# define THREAD_POOL_USE_THREADS
+#endif
+
+#include "options.h"
+#include "thread_pool.h"
+
+#define THREAD_POOL_MIN_AUTO_THREADS 4
+#define THREAD_POOL_MAX_AUTO_THREADS 16
+
+#if defined(THREAD_POOL_USE_THREADS)
+
+struct pool_task {
+    /* either a single background job... */
+    thread_pool_job_fn_t job_fn;
+
+    /* ...or a loop that every worker takes indices from */
+    thread_pool_for_fn_t for_fn;
+    int count;
+    int next_index;
+    int remaining;
+
+    void *data;
+
+    struct pool_task *next;
+};
+typedef struct pool_task pool_task_t;
+
+static pthread_t *workers = NULL;
+static int worker_count = 0;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  pool_cond  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  done_cond  = PTHREAD_COND_INITIALIZER;
+
+/* protected by pool_mutex */
+static pool_task_t *task_head = NULL;
+static pool_task_t *task_tail = NULL;
+static bool pool_stop = false;
+
+static int auto_thread_count(void)
+{
+    /* the work is mostly waiting on the disk (or the network), so
+     * use more threads than there are CPUs */
+    int count = 2 * (int)sysconf(_SC_NPROCESSORS_ONLN);
+    CLAMPVAR(count, THREAD_POOL_MIN_AUTO_THREADS, THREAD_POOL_MAX_AUTO_THREADS);
+    return count;
+}
+
+static void push_task(pool_task_t *task)
+{
+    task->next = NULL;
+    if (task_tail) {
+        task_tail->next = task;
+    } else {
+        task_head = task;
+    }
+    task_tail = task;
+}
+
+static void remove_task(pool_task_t *task)
+{
+    pool_task_t *prev = NULL;
+    for (pool_task_t *t = task_head; t; prev = t, t = t->next) {
+        if (t == task) {
+            if (prev) {
+                prev->next = t->next;
+            } else {
+                task_head = t->next;
+            }
+            if (task_tail == t) {
+                task_tail = prev;
+            }
+            t->next = NULL;
+            return;
+        }
+    }
+}
+
+/* called with pool_mutex held; returns -1 when the loop has no more indices */
+static int claim_index(pool_task_t *task)
+{
+    if (task->next_index >= task->count) {
+        return -1;
+    }
+
+    int index = task->next_index++;
+    if (task->next_index >= task->count) {
+        /* every index is taken; nobody else needs to find it */
+        remove_task(task);
+    }
+    return index;
+}
+
+/* called with pool_mutex held, which is released while the index runs */
+static void run_index(pool_task_t *task, int index)
+{
+    pthread_mutex_unlock(&pool_mutex);
+    task->for_fn(task->data, index);
+    pthread_mutex_lock(&pool_mutex);
+
+    /* the caller owns the task; it may be gone as soon as this hits 0 */
+    task->remaining--;
+    if (task->remaining == 0) {
+        pthread_cond_broadcast(&done_cond);
+    }
+}
+
+static void *worker_main(UNUSED void *arg)
+{
+    pthread_mutex_lock(&pool_mutex);
+
+    for (;;) {
+        while (!task_head && !pool_stop) {
+            pthread_cond_wait(&pool_cond, &pool_mutex);
+        }
+
+        if (!task_head) {
+            break;
+        }
+
+        pool_task_t *task = task_head;
+
+        if (task->for_fn) {
+            int index = claim_index(task);
+            assert(index >= 0);
+            run_index(task, index);
+        } else {
+            remove_task(task);
+            pthread_mutex_unlock(&pool_mutex);
+            task->job_fn(task->data);
+            free(task);
+            pthread_mutex_lock(&pool_mutex);
+        }
+    }
+
+    pthread_mutex_unlock(&pool_mutex);
+    return NULL;
+}
+
+void init_thread_pool(void)
+{
+    if (workers) {
+        return;
+    }
+
+    int count = options->load_threads;
+    if (count < 1) {
+        count = auto_thread_count();
+    }
+
+    if (count < 2) {
+        /* run everything on the calling thread */
+        return;
+    }
+
+    pool_stop = false;
+    workers = calloc(count, sizeof(pthread_t));
+    for (worker_count = 0; worker_count < count; worker_count++) {
+        if (0 != pthread_create(&workers[worker_count], NULL, worker_main, NULL)) {
+            errmsg("Could only start %d of %d worker threads", worker_count, count);
+            break;
+        }
+    }
+
+    if (worker_count == 0) {
+        SAFEFREE(workers);
+        return;
+    }
+
+    if (options->verbose) {
+        infomsg("Started %d worker threads", worker_count);
+    }
+}
+
+void cleanup_thread_pool(void)
+{
+    if (!workers) {
+        return;
+    }
+
+    /* the workers finish any queued jobs before they see the stop flag */
+    pthread_mutex_lock(&pool_mutex);
+    pool_stop = true;
+    pthread_cond_broadcast(&pool_cond);
+    pthread_mutex_unlock(&pool_mutex);
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    SAFEFREE(workers);
+    worker_count = 0;
+}
+
+int thread_pool_size(void)
+{
+    return workers ? worker_count : 1;
+}
+
+bool thread_pool_running(void)
+{
+    return !!workers;
+}
+
+void thread_pool_run(thread_pool_job_fn_t fn, void *data)
+{
+    assert_not_null(fn);
+
+    if (!workers) {
+        fn(data);
+        return;
+    }
+
+    pool_task_t *task = calloc(1, sizeof(pool_task_t));
+    task->job_fn = fn;
+    task->data   = data;
+
+    pthread_mutex_lock(&pool_mutex);
+    push_task(task);
+    pthread_cond_signal(&pool_cond);
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+void thread_pool_for(thread_pool_for_fn_t fn, void *data, int count)
+{
+    assert_not_null(fn);
+
+    if (!workers || (count < 2)) {
+        for (int i = 0; i < count; i++) {
+            fn(data, i);
+        }
+        return;
+    }
+
+    pool_task_t task = {
+        .for_fn     = fn,
+        .data       = data,
+        .count      = count,
+        .next_index = 0,
+        .remaining  = count
+    };
+
+    pthread_mutex_lock(&pool_mutex);
+    push_task(&task);
+    pthread_cond_broadcast(&pool_cond);
+
+    /* help out instead of just waiting */
+    int index;
+    while ((index = claim_index(&task)) >= 0) {
+        run_index(&task, index);
+    }
+
+    while (task.remaining > 0) {
+        pthread_cond_wait(&done_cond, &pool_mutex);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+#else /* !THREAD_POOL_USE_THREADS */
+
+void init_thread_pool(void)
+{
+}
+
+void cleanup_thread_pool(void)
+{
+}
+
+int thread_pool_size(void)
+{
+    return 1;
+}
+
+bool thread_pool_running(void)
+{
+    return false;
+}
+
+void thread_pool_run(thread_pool_job_fn_t fn, void *data)
+{
+    assert_not_null(fn);
+    fn(data);
+}
+
+void thread_pool_for(thread_pool_for_fn_t fn, void *data, int count)
+{
+    assert_not_null(fn);
+    for (int i = 0; i < count; i++) {
+        fn(data, i);
+    }
+}
+
+#endif /* THREAD_POOL_USE_THREADS */
@@ -0,0 +1,52 @@
+/****************************************************************************
+ *                                                                          *
+ * thread_pool.h                                                            *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/*
+ * Worker threads for slow, independent work such as reading and
+ * parsing level files. thread_pool_for() splits a loop across the
+ * workers and the calling thread and returns when every index is
+ * done; thread_pool_run() starts a background job and returns
+ * immediately.
+ *
+ * The jobs must not touch raylib's GPU state or the GUI; they hand
+ * their results back to the main thread, which merges them.
+ *
+ * Without a running pool (before init_thread_pool(), with
+ * --load-threads=1, or on platforms without threads) both functions
+ * run the work on the calling thread before returning.
+ */
+
+typedef void (*thread_pool_job_fn_t)(void *data);
+typedef void (*thread_pool_for_fn_t)(void *data, int index);
+
+void init_thread_pool(void);
+void cleanup_thread_pool(void);
+
+int thread_pool_size(void);
+bool thread_pool_running(void);
+
+void thread_pool_run(thread_pool_job_fn_t fn, void *data);
+void thread_pool_for(thread_pool_for_fn_t fn, void *data, int count);
+
+#endif /*THREAD_POOL_H*/
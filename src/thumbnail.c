@@ -0,0 +1,552 @@
+/****************************************************************************
+ *                                                                          *
+ * thumbnail.c                                                              *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <float.h>
+#include <time.h>
+
+#include "options.h"
+#include "color.h"
+#include "path.h"
+#include "hex.h"
+#include "hex_grid.h"
+#include "level.h"
+#include "collection.h"
+#include "thread_pool.h"
+#include "thumbnail.h"
+
+#define THUMBNAIL_SIZE   256
+#define THUMBNAIL_MARGIN 0.9f
+
+/* levels decoded on the main thread before each parallel render */
+#define THUMBNAIL_BATCH 256
+
+/* same as tile_sdf.c */
+#define THUMBNAIL_BORDER_WIDTH    2.0f
+#define THUMBNAIL_HIGHLIGHT_WIDTH 1.5f
+#define THUMBNAIL_FLAG_FIXED      0x40
+#define THUMBNAIL_FLAG_CENTER     0x80
+
+/* premultiplied RGBA */
+struct thumbnail_rgba {
+    float r, g, b, a;
+};
+typedef struct thumbnail_rgba thumbnail_rgba_t;
+
+/* what the renderer needs from a tile, packed like tile_sdf_pack() */
+struct thumbnail_tile {
+    hex_axial_t position;
+    unsigned char path[6];
+    unsigned char flags;
+};
+typedef struct thumbnail_tile thumbnail_tile_t;
+
+/*
+ * A copy of the level's unsolved layout, so the workers never touch
+ * the level itself: materializing levels isn't thread safe, and a
+ * later level_materialize() may dematerialize this one again.
+ */
+struct thumbnail_job {
+    char *filename;
+    int radius;
+    int tile_count;
+    thumbnail_tile_t *tiles;
+
+    /* encoded by the worker, written by the calling thread */
+    unsigned char *png;
+    int png_size;
+};
+typedef struct thumbnail_job thumbnail_job_t;
+
+struct thumbnail_palette {
+    thumbnail_rgba_t bg;
+    thumbnail_rgba_t edge;
+    thumbnail_rgba_t center;
+    thumbnail_rgba_t path[PATH_TYPE_COUNT];
+    thumbnail_rgba_t highlight[PATH_TYPE_COUNT];
+};
+typedef struct thumbnail_palette thumbnail_palette_t;
+
+static thumbnail_palette_t palette;
+
+static int thumbnail_count;
+static int thumbnail_failed;
+static double thumbnail_render_time;
+
+static double thumbnail_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+/* straight alpha, as the shader's uniforms are */
+static thumbnail_rgba_t thumbnail_color(Color color)
+{
+    Vector4 v = ColorNormalize(color);
+    return (thumbnail_rgba_t) { v.x, v.y, v.z, v.w };
+}
+
+static void thumbnail_prepare_palette(void)
+{
+    palette.bg     = thumbnail_color(tile_bg_color);
+    palette.edge   = thumbnail_color(tile_edge_color);
+    palette.center = thumbnail_color(tile_center_color);
+
+    for (path_type_t type = PATH_TYPE_MIN; type < PATH_TYPE_COUNT; type++) {
+        palette.path[type]      = thumbnail_color(path_type_color(type));
+        palette.highlight[type] = thumbnail_color(ColorLerp(path_type_highlight_color(type), WHITE, 0.4));
+    }
+}
+
+/*** rasterizer: a CPU port of shaders/tile_sdf.frag.glsl with one pixel per unit ***/
+
+static inline thumbnail_rgba_t over(thumbnail_rgba_t dst, thumbnail_rgba_t color, float dist)
+{
+    float coverage = Clamp(0.5f - dist, 0.0f, 1.0f);
+    float a = color.a * coverage;
+    float keep = 1.0f - a;
+
+    return (thumbnail_rgba_t) {
+        .r = (color.r * a) + (dst.r * keep),
+        .g = (color.g * a) + (dst.g * keep),
+        .b = (color.b * a) + (dst.b * keep),
+        .a = a + (dst.a * keep)
+    };
+}
+
+static inline float sd_hex(float px, float py, float inner_radius)
+{
+    const float kx = -0.866025404f;
+    const float ky =  0.5f;
+    const float kz =  0.577350269f;
+
+    px = fabsf(px);
+    py = fabsf(py);
+
+    float d = 2.0f * fminf((kx * px) + (ky * py), 0.0f);
+    px -= d * kx;
+    py -= d * ky;
+
+    px -= Clamp(px, -kz * inner_radius, kz * inner_radius);
+    py -= inner_radius;
+
+    float len = sqrtf((px * px) + (py * py));
+    return (py < 0.0f) ? -len : len;
+}
+
+static inline float sd_strip(float qx, float qy, float start, float end, float offset, float width)
+{
+    return fmaxf(fmaxf(start - qx, qx - end), fabsf(qy - offset) - (0.5f * width));
+}
+
+struct thumbnail_geometry {
+    float size;
+    float line_width;
+    float center_radius;
+    float arm_len[6];
+    Vector2 arm_unit[6];
+};
+typedef struct thumbnail_geometry thumbnail_geometry_t;
+
+/* the same sizes tile_pos_rebuild() gives a tile */
+static void thumbnail_geometry_init(thumbnail_geometry_t *geom, float size)
+{
+    Vector2 corners[7];
+    hex_pixel_corners_r(Vector2Zero(), size, corners);
+    corners[6] = corners[0];
+
+    geom->size          = size;
+    geom->line_width    = size / 6.0f;
+    geom->center_radius = size / 4.0f;
+
+    each_direction {
+        Vector2 arm_end = Vector2Lerp(corners[dir], corners[dir + 1], 0.5f);
+        geom->arm_len[dir]  = Vector2Length(arm_end);
+        geom->arm_unit[dir] = Vector2Scale(arm_end, 1.0f / geom->arm_len[dir]);
+    }
+}
+
+static thumbnail_rgba_t thumbnail_shade(thumbnail_geometry_t *geom, thumbnail_tile_t *tile, float px, float py)
+{
+    bool fixed  = tile->flags & THUMBNAIL_FLAG_FIXED;
+    bool center = tile->flags & THUMBNAIL_FLAG_CENTER;
+
+    float hex = sd_hex(px, py, geom->size * 0.866025404f);
+
+    thumbnail_rgba_t color = {0};
+
+    /* every layer is inside the hex, so nothing covers this pixel */
+    if (hex >= 0.5f) {
+        return color;
+    }
+
+    if (!fixed) {
+        color = over(color, palette.bg, hex);
+    }
+
+    each_direction {
+        if (tile->path[dir] != PATH_TYPE_NONE) {
+            Vector2 u = geom->arm_unit[dir];
+            float qx = (px * u.x) + (py * u.y);
+            float qy = (px * u.y) - (py * u.x);
+            color = over(color, palette.path[tile->path[dir]],
+                         sd_strip(qx, qy, 0.0f, geom->arm_len[dir], 0.0f, geom->line_width));
+        }
+    }
+
+    each_direction {
+        if (tile->flags & (1 << dir)) {
+            Vector2 u = geom->arm_unit[dir];
+            float qx = (px * u.x) + (py * u.y);
+            float qy = (px * u.y) - (py * u.x);
+            float len = geom->arm_len[dir];
+            float start = fminf(geom->center_radius, len);
+            float offset = 0.5f * geom->line_width;
+            float d = fminf(sd_strip(qx, qy, start, len,  offset, THUMBNAIL_HIGHLIGHT_WIDTH),
+                            sd_strip(qx, qy, start, len, -offset, THUMBNAIL_HIGHLIGHT_WIDTH));
+            color = over(color, palette.highlight[tile->path[dir]], d);
+        }
+    }
+
+    if (!fixed) {
+        color = over(color, palette.edge, fmaxf(hex, -(hex + THUMBNAIL_BORDER_WIDTH)));
+    }
+
+    if (center) {
+        color = over(color, palette.center, sqrtf((px * px) + (py * py)) - geom->center_radius);
+    }
+
+    return color;
+}
+
+static void thumbnail_draw_tile(thumbnail_rgba_t *pixels, thumbnail_geometry_t *geom,
+                                thumbnail_tile_t *tile, Vector2 center)
+{
+    /* the hex's bounding box with room for antialiasing */
+    float extent_x = geom->size + 1.0f;
+    float extent_y = (geom->size * SQRT_3_2) + 1.0f;
+
+    int x0 = MAX((int)floorf(center.x - extent_x), 0);
+    int y0 = MAX((int)floorf(center.y - extent_y), 0);
+    int x1 = MIN((int)ceilf(center.x + extent_x), THUMBNAIL_SIZE - 1);
+    int y1 = MIN((int)ceilf(center.y + extent_y), THUMBNAIL_SIZE - 1);
+
+    for (int y = y0; y <= y1; y++) {
+        float py = ((float)y + 0.5f) - center.y;
+        thumbnail_rgba_t *row = &(pixels[y * THUMBNAIL_SIZE]);
+
+        for (int x = x0; x <= x1; x++) {
+            float px = ((float)x + 0.5f) - center.x;
+
+            thumbnail_rgba_t src = thumbnail_shade(geom, tile, px, py);
+            if (src.a <= 0.0f) {
+                continue;
+            }
+
+            thumbnail_rgba_t *dst = &(row[x]);
+            float keep = 1.0f - src.a;
+            dst->r = src.r + (dst->r * keep);
+            dst->g = src.g + (dst->g * keep);
+            dst->b = src.b + (dst->b * keep);
+            dst->a = src.a + (dst->a * keep);
+        }
+    }
+}
+
+static inline unsigned char thumbnail_channel(float value)
+{
+    return (unsigned char)((Clamp(value, 0.0f, 1.0f) * 255.0f) + 0.5f);
+}
+
+/*
+ * ExportImage() isn't thread safe: IsFileExtension() splits the
+ * filename in raylib's static TextSplit() buffers. Encoding to memory
+ * only compares the file type, so the workers do that part and leave
+ * SaveFileData() to the calling thread.
+ */
+static unsigned char *thumbnail_encode_png(thumbnail_rgba_t *pixels, int *png_size)
+{
+    int count = THUMBNAIL_SIZE * THUMBNAIL_SIZE;
+    unsigned char *data = calloc(count, 4);
+
+    for (int i=0; i<count; i++) {
+        thumbnail_rgba_t *p = &(pixels[i]);
+        unsigned char *out = &(data[i * 4]);
+        if (p->a > 0.0f) {
+            out[0] = thumbnail_channel(p->r / p->a);
+            out[1] = thumbnail_channel(p->g / p->a);
+            out[2] = thumbnail_channel(p->b / p->a);
+            out[3] = thumbnail_channel(p->a);
+        }
+    }
+
+    Image image = {
+        .data    = data,
+        .width   = THUMBNAIL_SIZE,
+        .height  = THUMBNAIL_SIZE,
+        .mipmaps = 1,
+        .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+
+    unsigned char *png = ExportImageToMemory(image, ".png", png_size);
+    free(data);
+
+    return png;
+}
+
+/* runs on the thread pool */
+static void thumbnail_render_job(void *data, int index)
+{
+    thumbnail_job_t *job = &(((thumbnail_job_t *)data)[index]);
+
+    /* fit the level like level_resize() fits it to the window */
+    float max_level_size = THUMBNAIL_SIZE * THUMBNAIL_MARGIN;
+    int level_width_in_hex_radii = 2 + (3 * job->radius);
+    int level_height = (2 * job->radius) + 1;
+    float size = MIN(max_level_size / (float)level_width_in_hex_radii,
+                     (max_level_size / (float)level_height) * INV_SQRT_3);
+
+    thumbnail_geometry_t geom;
+    thumbnail_geometry_init(&geom, size);
+
+    Vector2 px_min = {  FLT_MAX,  FLT_MAX };
+    Vector2 px_max = { -FLT_MAX, -FLT_MAX };
+    Vector2 half_extent = { size, size * SQRT_3_2 };
+
+    for (int i=0; i<job->tile_count; i++) {
+        Vector2 center = hex_axial_to_pixel(job->tiles[i].position, size);
+        px_min.x = fminf(px_min.x, center.x - half_extent.x);
+        px_min.y = fminf(px_min.y, center.y - half_extent.y);
+        px_max.x = fmaxf(px_max.x, center.x + half_extent.x);
+        px_max.y = fmaxf(px_max.y, center.y + half_extent.y);
+    }
+
+    Vector2 offset = Vector2Zero();
+    if (job->tile_count > 0) {
+        offset.x = ((THUMBNAIL_SIZE - (px_max.x - px_min.x)) / 2.0f) - px_min.x;
+        offset.y = ((THUMBNAIL_SIZE - (px_max.y - px_min.y)) / 2.0f) - px_min.y;
+    }
+
+    thumbnail_rgba_t *pixels = calloc(THUMBNAIL_SIZE * THUMBNAIL_SIZE, sizeof(thumbnail_rgba_t));
+
+    for (int i=0; i<job->tile_count; i++) {
+        thumbnail_tile_t *tile = &(job->tiles[i]);
+        Vector2 center = Vector2Add(hex_axial_to_pixel(tile->position, size), offset);
+        thumbnail_draw_tile(pixels, &geom, tile, center);
+    }
+
+    job->png = thumbnail_encode_png(pixels, &job->png_size);
+
+    free(pixels);
+}
+
+/*** jobs ***/
+
+/* the tiles _level_preview() shows: the unsolved layout */
+static void thumbnail_job_from_level(thumbnail_job_t *job, level_t *level)
+{
+    int maxtiles = level->grid->maxtiles;
+
+    job->radius = level->radius;
+    job->tile_count = 0;
+    job->tiles = calloc(maxtiles, sizeof(thumbnail_tile_t));
+
+    for (int i=0; i<maxtiles; i++) {
+        tile_pos_t *pos = &(level->unsolved_positions[i]);
+        tile_t *tile = pos->tile;
+
+        if (!tile || !tile->enabled || tile->hidden) {
+            continue;
+        }
+
+        thumbnail_tile_t *out = &(job->tiles[job->tile_count++]);
+        out->position = pos->position;
+        out->flags = 0;
+
+        each_direction {
+            out->path[dir] = tile->path[dir];
+
+            if (tile->path[dir] != PATH_TYPE_NONE) {
+                tile_pos_t *neighbor = pos->neighbors[dir];
+                if (neighbor && (neighbor->tile->path[hex_opposite_direction(dir)] == tile->path[dir])) {
+                    out->flags |= 1 << dir;
+                }
+            }
+        }
+
+        if (tile->fixed) {
+            out->flags |= THUMBNAIL_FLAG_FIXED;
+        }
+        if (tile->path_count > 0) {
+            out->flags |= THUMBNAIL_FLAG_CENTER;
+        }
+    }
+}
+
+static void thumbnail_run_batch(thumbnail_job_t *jobs, int count)
+{
+    double start = thumbnail_time();
+    thread_pool_for(thumbnail_render_job, jobs, count);
+    thumbnail_render_time += thumbnail_time() - start;
+
+    for (int i=0; i<count; i++) {
+        thumbnail_job_t *job = &(jobs[i]);
+
+        if (job->png && SaveFileData(job->filename, job->png, job->png_size)) {
+            thumbnail_count++;
+            if (options->verbose) {
+                infomsg("THUMBNAIL: \"%s\"", job->filename);
+            }
+        } else {
+            errmsg("THUMBNAIL: couldn't write \"%s\"", job->filename);
+            thumbnail_failed++;
+        }
+
+        if (job->png) {
+            MemFree(job->png);
+            job->png = NULL;
+        }
+
+        SAFEFREE(job->filename);
+        SAFEFREE(job->tiles);
+    }
+}
+
+static bool thumbnail_export_path(const char *path)
+{
+    char *outdir = NULL;
+    safe_asprintf(&outdir, "%s-thumbnails",
+                  GetFileNameWithoutExt(directory_without_end_separator(path)));
+
+    infomsg("THUMBNAILS: \"%s\" -> \"%s\"", path, outdir);
+
+    if (DirectoryExists(outdir)) {
+        if (options->force) {
+            warnmsg("Writing thumbnails into existing directory: \"%s\"", outdir);
+        } else {
+            errmsg("Directory already exists: \"%s\"", outdir);
+            free(outdir);
+            return false;
+        }
+    } else if (FileExists(outdir)) {
+        errmsg("Existing file is blocking destination directory \"%s\"", outdir);
+        free(outdir);
+        return false;
+    }
+
+    collection_t *collection = load_collection_path(path);
+    if (!collection) {
+        errmsg("Couldn't load \"%s\" as a collection", path);
+        free(outdir);
+        return false;
+    }
+
+#if defined(PLATFORM_DESKTOP)
+    if (-1 == mkdir_p(outdir, CREATE_DIR_MODE)) {
+        errmsg("Error creating \"%s\" in mkdir(2): %s", outdir, strerror(errno));
+        destroy_collection(collection);
+        free(outdir);
+        return false;
+    }
+#endif
+
+    thumbnail_job_t *jobs = calloc(THUMBNAIL_BATCH, sizeof(thumbnail_job_t));
+    int count = 0;
+    int index = 0;
+
+    for (level_t *level = collection->levels; level; level = level->next, index++) {
+        if (!level_materialize(level)) {
+            errmsg("THUMBNAIL: couldn't decode level \"%s\"", level->name);
+            thumbnail_failed++;
+            continue;
+        }
+
+        thumbnail_job_t *job = &(jobs[count++]);
+        if (level->filename) {
+            safe_asprintf(&job->filename, "%s/%s.png", outdir, GetFileNameWithoutExt(level->filename));
+        } else {
+            safe_asprintf(&job->filename, "%s/level-%d.png", outdir, index);
+        }
+        thumbnail_job_from_level(job, level);
+
+        if (count == THUMBNAIL_BATCH) {
+            thumbnail_run_batch(jobs, count);
+            count = 0;
+        }
+    }
+
+    if (count) {
+        thumbnail_run_batch(jobs, count);
+    }
+
+    free(jobs);
+    destroy_collection(collection);
+    free(outdir);
+
+    return true;
+}
+
+bool run_thumbnail_export(void)
+{
+    if (!options->extra_argc) {
+        errmsg("--export-thumbnails needs at least one pack or directory");
+        return false;
+    }
+
+    /* SaveFileData() logs every file it writes at LOG_INFO */
+    if (!options->verbose_raylib) {
+        SetTraceLogLevel(LOG_WARNING);
+    }
+
+    thumbnail_prepare_palette();
+
+    thumbnail_count = 0;
+    thumbnail_failed = 0;
+    thumbnail_render_time = 0.0;
+
+    bool rv = true;
+    double start = thumbnail_time();
+
+    for (int arg=0; arg < options->extra_argc; arg++) {
+        if (!thumbnail_export_path(options->extra_argv[arg])) {
+            rv = false;
+        }
+    }
+
+    double elapsed = thumbnail_time() - start;
+
+    infomsg("THUMBNAILS: %d written in %.3f s: %.1f thumbnails/s (%.1f/s rendering on %d threads)",
+            thumbnail_count, elapsed,
+            (double)thumbnail_count / MAX(elapsed, 1e-9),
+            (double)thumbnail_count / MAX(thumbnail_render_time, 1e-9),
+            MAX(thread_pool_size(), 1));
+
+    if (thumbnail_failed) {
+        errmsg("THUMBNAILS: %d levels failed", thumbnail_failed);
+        rv = false;
+    }
+
+    return rv;
+}
@@ -0,0 +1,34 @@
+/****************************************************************************
+ *                                                                          *
+ * thumbnail.h                                                              *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+/*
+ * Renders a PNG thumbnail of every level in the packs and directories
+ * given on the command line (--export-thumbnails). The tiles are
+ * rasterized on the CPU with the same shapes as the tile SDF shader,
+ * so this runs before the window is opened and needs no display or
+ * GPU. Levels are rendered in parallel on the thread pool.
+ */
+bool run_thumbnail_export(void);
+
+#endif /*THUMBNAIL_H*/
@@ -26,6 +26,7 @@
 #include "tile.h"
 #include "tile_pos.h"
 #include "level.h"
+#include "json_reader.h"
 
 char *tile_flag_string(tile_t *tile)
 {
@@ -180,9 +181,6 @@ int compare_tiles(const void *p1, const void *p2)
         return -1;
     }
 
-    //assert(t1->id < LEVEL_MAXTILES);
-    //assert(t2->id < LEVEL_MAXTILES);
-
     //BCMP(enabled);
     BCMP(hidden);
     BCMP(fixed);
@@ -393,6 +391,21 @@ void tile_set_positions(tile_t *tile, level_t *level, hex_axial_t solved_addr, h
     tile->unsolved_pos->tile = tile;
 }
 
+/* false if either address is outside the level's grid */
+static bool tile_place(tile_t *tile, level_t *level, hex_axial_t solved_addr, hex_axial_t unsolved_addr)
+{
+    if (!level_get_solved_tile_pos(level, solved_addr) ||
+        !level_get_unsolved_tile_pos(level, unsolved_addr)) {
+        return false;
+    }
+
+    tile_set_positions(tile, level, solved_addr, unsolved_addr);
+
+    tile_update_path_count(tile);
+
+    return true;
+}
+
 bool tile_from_json_addr(cJSON *json, hex_axial_t *addr)
 {
     addr->q = 0;
@@ -486,13 +499,159 @@ bool tile_from_json(tile_t *tile, level_t *level, cJSON *json)
     tile->hidden  = cJSON_IsTrue(hidden_json);
     tile->fixed   = cJSON_IsTrue(fixed_json);
 
-    tile_set_positions(tile, level, solved_addr, unsolved_addr);
-
-    tile_update_path_count(tile);
+    if (!tile_place(tile, level, solved_addr, unsolved_addr)) {
+        errmsg("Error parsing tile JSON: address is outside the level's grid");
+        return false;
+    }
 
     return true;
 }
 
+/*
+ * Sparse level JSON stores each enabled tile's paths and flags as one
+ * string: a digit per direction, then 'h' if hidden and 'f' if fixed.
+ */
+void tile_to_packed_string(tile_t *tile, char *buf)
+{
+    char *p = buf;
+
+    each_direction {
+        *p++ = '0' + tile->path[dir];
+    }
+    if (tile->hidden) {
+        *p++ = 'h';
+    }
+    if (tile->fixed) {
+        *p++ = 'f';
+    }
+    *p = '\0';
+}
+
+/*
+ * Sets an enabled tile from its packed string, or a blank disabled
+ * tile if packed is NULL, and places it at the given addresses.
+ */
+bool tile_from_packed_string(tile_t *tile, level_t *level, hex_axial_t solved_addr, hex_axial_t unsolved_addr, const char *packed)
+{
+    tile->enabled = (packed != NULL);
+    tile->hidden  = false;
+    tile->fixed   = false;
+
+    if (packed) {
+        each_direction {
+            if ((packed[dir] < ('0' + PATH_TYPE_MIN)) || (packed[dir] > ('0' + PATH_TYPE_MAX))) {
+                return false;
+            }
+            tile->path[dir] = packed[dir] - '0';
+        }
+
+        for (const char *p = packed + 6; *p; p++) {
+            switch (*p) {
+            case 'h':
+                tile->hidden = true;
+                break;
+            case 'f':
+                tile->fixed = true;
+                break;
+            default:
+                return false;
+            }
+        }
+    } else {
+        each_direction {
+            tile->path[dir] = PATH_TYPE_NONE;
+        }
+    }
+
+    return tile_place(tile, level, solved_addr, unsolved_addr);
+}
+
+static bool tile_read_json_addr(json_reader_t *r, hex_axial_t *addr)
+{
+    bool have_q = false;
+    bool have_r = false;
+    const char *key;
+
+    if (!json_reader_begin_object(r)) {
+        return false;
+    }
+
+    while (json_reader_next_key(r, &key)) {
+        if (!have_q && (0 == strcasecmp(key, "q"))) {
+            have_q = json_reader_int(r, &addr->q);
+        } else if (!have_r && (0 == strcasecmp(key, "r"))) {
+            have_r = json_reader_int(r, &addr->r);
+        } else {
+            json_reader_skip(r);
+        }
+    }
+
+    return r->ok && have_q && have_r;
+}
+
+/*
+ * Same as tile_from_json(), read straight from the level's JSON text.
+ * Fails quietly so the caller can fall back to the cJSON path, which
+ * says what is wrong.
+ */
+bool tile_read_json(tile_t *tile, level_t *level, json_reader_t *r)
+{
+    hex_axial_t solved_addr, unsolved_addr;
+    bool have_solved  = false;
+    bool have_unsolved = false;
+    bool have_path    = false;
+    bool have_enabled = false;
+    bool have_hidden  = false;
+    bool have_fixed   = false;
+    const char *key;
+
+    if (!json_reader_begin_object(r)) {
+        return false;
+    }
+
+    while (json_reader_next_key(r, &key)) {
+        if (!have_solved && (0 == strcasecmp(key, "solved"))) {
+            have_solved = tile_read_json_addr(r, &solved_addr);
+        } else if (!have_unsolved && (0 == strcasecmp(key, "unsolved"))) {
+            have_unsolved = tile_read_json_addr(r, &unsolved_addr);
+        } else if (!have_path && (0 == strcasecmp(key, "path"))) {
+            int n = 0;
+            if (!json_reader_begin_array(r)) {
+                return false;
+            }
+            while (json_reader_next_item(r)) {
+                if (n < 6) {
+                    int value;
+                    if (!json_reader_int(r, &value)) {
+                        return false;
+                    }
+                    tile->path[n] = value;
+                } else {
+                    json_reader_skip(r);
+                }
+                n++;
+            }
+            have_path = (n >= 6);
+        } else if (!have_enabled && (0 == strcasecmp(key, "enabled"))) {
+            have_enabled = json_reader_bool(r, &tile->enabled);
+        } else if (!have_hidden && (0 == strcasecmp(key, "hidden"))) {
+            have_hidden = json_reader_bool(r, &tile->hidden);
+        } else if (!have_fixed && (0 == strcasecmp(key, "fixed"))) {
+            have_fixed = json_reader_bool(r, &tile->fixed);
+        } else {
+            json_reader_skip(r);
+        }
+    }
+
+    if (!r->ok ||
+        !have_solved || !have_unsolved || !have_path ||
+        !have_enabled || !have_hidden || !have_fixed) {
+        return false;
+    }
+
+    return tile_place(tile, level, solved_addr, unsolved_addr);
+}
+
 static cJSON *tile_to_json_addr(hex_axial_t addr)
 {
     cJSON *json = cJSON_CreateObject();
@@ -30,10 +30,14 @@
 
 struct tile_pos;
 struct level;
+struct json_reader;
 #ifdef USE_PHYSICS
 struct physics_tile;
 #endif
 
+/* six path digits, then up to two flag letters */
+#define TILE_PACKED_STRING_MAXLEN (6 + 2 + 1)
+
 struct tile_flags {
     bool enabled;
     bool fixed;
@@ -122,6 +126,9 @@ bool tile_is_blank(tile_t *tile);
 bool tile_is_empty(tile_t *tile);
 
 bool tile_from_json(tile_t *tile, struct level *level, cJSON *json);
+bool tile_read_json(tile_t *tile, struct level *level, struct json_reader *r);
+void tile_to_packed_string(tile_t *tile, char *buf);
+bool tile_from_packed_string(tile_t *tile, struct level *level, hex_axial_t solved_addr, hex_axial_t unsolved_addr, const char *packed);
 cJSON *tile_to_json(tile_t *tile);
 
 static inline bool tile_dragable(tile_t *tile)
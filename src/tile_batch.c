@@ -0,0 +1,253 @@
+/****************************************************************************
+ *                                                                          *
+ * tile_batch.c                                                             *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include "tile_batch.h"
+
+#define TILE_BATCH_INITIAL_VERTEX_COUNT 4096
+
+/* DrawCircleV() always asks DrawCircleSector() for 36 segments */
+#define TILE_BATCH_CIRCLE_SEGMENTS 36
+
+static bool unit_tables_ready = false;
+static Vector2 unit_hex[6 + 1];
+static Vector2 unit_circle[TILE_BATCH_CIRCLE_SEGMENTS + 1];
+
+static void init_unit_tables(void)
+{
+    if (unit_tables_ready) {
+        return;
+    }
+
+    /* computed the same way as DrawPoly() and DrawCircleSector() */
+    float angle = 0.0f;
+    float step = 360.0f/6.0f*DEG2RAD;
+    for (int i=0; i<=6; i++) {
+        unit_hex[i] = (Vector2){ cosf(angle), sinf(angle) };
+        angle += step;
+    }
+
+    for (int i=0; i<=TILE_BATCH_CIRCLE_SEGMENTS; i++) {
+        float deg = (360.0f/(float)TILE_BATCH_CIRCLE_SEGMENTS)*(float)i;
+        unit_circle[i] = (Vector2){ cosf(DEG2RAD*deg), sinf(DEG2RAD*deg) };
+    }
+
+    unit_tables_ready = true;
+}
+
+void init_tile_batch(tile_batch_t *batch)
+{
+    assert_not_null(batch);
+
+    init_unit_tables();
+
+    batch->alloc_count = TILE_BATCH_INITIAL_VERTEX_COUNT;
+    batch->positions   = calloc(batch->alloc_count, sizeof(Vector2));
+    batch->colors      = calloc(batch->alloc_count, sizeof(Color));
+    batch->count       = 0;
+
+    tile_batch_set_transform(batch, VEC2_ZERO, 0.0f);
+}
+
+void cleanup_tile_batch(tile_batch_t *batch)
+{
+    if (batch) {
+        SAFEFREE(batch->positions);
+        SAFEFREE(batch->colors);
+        batch->count = 0;
+        batch->alloc_count = 0;
+    }
+}
+
+void tile_batch_begin(tile_batch_t *batch)
+{
+    assert_not_null(batch);
+
+    batch->count = 0;
+    tile_batch_set_transform(batch, VEC2_ZERO, 0.0f);
+}
+
+void tile_batch_draw(tile_batch_t *batch)
+{
+    assert_not_null(batch);
+
+    if (!batch->count) {
+        return;
+    }
+
+    rlBegin(RL_TRIANGLES);
+    {
+        Color color = batch->colors[0];
+        rlColor4ub(color.r, color.g, color.b, color.a);
+
+        for (int i=0; i<batch->count; i++) {
+            Color c = batch->colors[i];
+            if ((c.r != color.r) || (c.g != color.g) || (c.b != color.b) || (c.a != color.a)) {
+                color = c;
+                rlColor4ub(color.r, color.g, color.b, color.a);
+            }
+
+            rlVertex2f(batch->positions[i].x, batch->positions[i].y);
+        }
+    }
+    rlEnd();
+
+    batch->count = 0;
+}
+
+/* like rlTranslatef(translate) followed by rlRotatef(rotate) */
+void tile_batch_set_transform(tile_batch_t *batch, Vector2 translate, float rotate)
+{
+    assert_not_null(batch);
+
+    batch->translate  = translate;
+    batch->rotate_cos = cosf(rotate);
+    batch->rotate_sin = sinf(rotate);
+}
+
+static void tile_batch_reserve(tile_batch_t *batch, int count)
+{
+    if (batch->count + count <= batch->alloc_count) {
+        return;
+    }
+
+    while (batch->count + count > batch->alloc_count) {
+        batch->alloc_count *= 2;
+    }
+
+    batch->positions = realloc(batch->positions, batch->alloc_count * sizeof(Vector2));
+    batch->colors    = realloc(batch->colors,    batch->alloc_count * sizeof(Color));
+}
+
+static inline void tile_batch_vertex(tile_batch_t *batch, Vector2 v, Color color)
+{
+    Vector2 *p = &batch->positions[batch->count];
+    p->x = batch->translate.x + (v.x * batch->rotate_cos) - (v.y * batch->rotate_sin);
+    p->y = batch->translate.y + (v.x * batch->rotate_sin) + (v.y * batch->rotate_cos);
+
+    batch->colors[batch->count] = color;
+    batch->count++;
+}
+
+static inline Vector2 unit_point(Vector2 center, Vector2 unit, float radius)
+{
+    return (Vector2){ center.x + (unit.x * radius), center.y + (unit.y * radius) };
+}
+
+void tile_batch_triangle(tile_batch_t *batch, Vector2 v1, Vector2 v2, Vector2 v3, Color color)
+{
+    assert_not_null(batch);
+
+    tile_batch_reserve(batch, 3);
+
+    tile_batch_vertex(batch, v1, color);
+    tile_batch_vertex(batch, v2, color);
+    tile_batch_vertex(batch, v3, color);
+}
+
+/* DrawLineEx() */
+void tile_batch_line(tile_batch_t *batch, Vector2 start, Vector2 end, float thick, Color color)
+{
+    assert_not_null(batch);
+
+    Vector2 delta = { end.x - start.x, end.y - start.y };
+    float length = sqrtf(delta.x*delta.x + delta.y*delta.y);
+
+    if ((length <= 0) || (thick <= 0)) {
+        return;
+    }
+
+    float scale = thick/(2*length);
+    Vector2 radius = { -scale*delta.y, scale*delta.x };
+    Vector2 strip[4] = {
+        { start.x - radius.x, start.y - radius.y },
+        { start.x + radius.x, start.y + radius.y },
+        {   end.x - radius.x,   end.y - radius.y },
+        {   end.x + radius.x,   end.y + radius.y }
+    };
+
+    /* DrawTriangleStrip() */
+    tile_batch_reserve(batch, 6);
+    tile_batch_vertex(batch, strip[2], color);
+    tile_batch_vertex(batch, strip[0], color);
+    tile_batch_vertex(batch, strip[1], color);
+    tile_batch_vertex(batch, strip[3], color);
+    tile_batch_vertex(batch, strip[2], color);
+    tile_batch_vertex(batch, strip[1], color);
+}
+
+/* DrawPoly(center, 6, radius, 0.0f, color) */
+void tile_batch_hex(tile_batch_t *batch, Vector2 center, float radius, Color color)
+{
+    assert_not_null(batch);
+
+    tile_batch_reserve(batch, 6 * 3);
+
+    for (int i=0; i<6; i++) {
+        tile_batch_vertex(batch, center, color);
+        tile_batch_vertex(batch, unit_point(center, unit_hex[i + 1], radius), color);
+        tile_batch_vertex(batch, unit_point(center, unit_hex[i],     radius), color);
+    }
+}
+
+/* DrawPolyLinesEx(center, 6, radius, 0.0f, thick, color) */
+void tile_batch_hex_lines(tile_batch_t *batch, Vector2 center, float radius, float thick, Color color)
+{
+    assert_not_null(batch);
+
+    float inner_radius = radius - (thick * cosf(DEG2RAD * (360.0f/6.0f*DEG2RAD) / 2.0f));
+
+    tile_batch_reserve(batch, 6 * 6);
+
+    for (int i=0; i<6; i++) {
+        Vector2 outer_cur  = unit_point(center, unit_hex[i],     radius);
+        Vector2 outer_next = unit_point(center, unit_hex[i + 1], radius);
+        Vector2 inner_cur  = unit_point(center, unit_hex[i],     inner_radius);
+        Vector2 inner_next = unit_point(center, unit_hex[i + 1], inner_radius);
+
+        tile_batch_vertex(batch, outer_next, color);
+        tile_batch_vertex(batch, outer_cur,  color);
+        tile_batch_vertex(batch, inner_cur,  color);
+
+        tile_batch_vertex(batch, inner_cur,  color);
+        tile_batch_vertex(batch, inner_next, color);
+        tile_batch_vertex(batch, outer_next, color);
+    }
+}
+
+/* DrawCircleV() */
+void tile_batch_circle(tile_batch_t *batch, Vector2 center, float radius, Color color)
+{
+    assert_not_null(batch);
+
+    if (radius <= 0.0f) {
+        radius = 0.1f;
+    }
+
+    tile_batch_reserve(batch, TILE_BATCH_CIRCLE_SEGMENTS * 3);
+
+    for (int i=0; i<TILE_BATCH_CIRCLE_SEGMENTS; i++) {
+        tile_batch_vertex(batch, center, color);
+        tile_batch_vertex(batch, unit_point(center, unit_circle[i + 1], radius), color);
+        tile_batch_vertex(batch, unit_point(center, unit_circle[i],     radius), color);
+    }
+}
@@ -0,0 +1,68 @@
+/****************************************************************************
+ *                                                                          *
+ * tile_batch.h                                                             *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef TILE_BATCH_H
+#define TILE_BATCH_H
+
+/*
+ * Collects the triangles of every tile drawn in a frame into one
+ * vertex array, then hands them to rlgl as a single RL_TRIANGLES run.
+ *
+ * Drawing each tile with raylib's shape functions switches between
+ * RL_QUADS and RL_TRIANGLES several times per tile, and each switch
+ * starts a new draw call. A level with a few hundred tiles hit
+ * RL_DEFAULT_BATCH_DRAWCALLS and flushed the render batch several
+ * times per frame. Each tile's transform is applied here on the CPU,
+ * so the whole board is one draw call unless rlgl's vertex buffer
+ * fills up.
+ *
+ * The primitives emit the same triangles, in the same order and
+ * winding, as the raylib functions they replace.
+ */
+
+struct tile_batch {
+    Vector2 *positions;
+    Color *colors;
+    int count;
+    int alloc_count;
+
+    /* applied to every vertex until the next tile_batch_set_transform() */
+    Vector2 translate;
+    float rotate_cos;
+    float rotate_sin;
+};
+typedef struct tile_batch tile_batch_t;
+
+void init_tile_batch(tile_batch_t *batch);
+void cleanup_tile_batch(tile_batch_t *batch);
+
+void tile_batch_begin(tile_batch_t *batch);
+void tile_batch_draw(tile_batch_t *batch);
+
+void tile_batch_set_transform(tile_batch_t *batch, Vector2 translate, float rotate);
+
+void tile_batch_triangle(tile_batch_t *batch, Vector2 v1, Vector2 v2, Vector2 v3, Color color);
+void tile_batch_line(tile_batch_t *batch, Vector2 start, Vector2 end, float thick, Color color);
+void tile_batch_hex(tile_batch_t *batch, Vector2 center, float radius, Color color);
+void tile_batch_hex_lines(tile_batch_t *batch, Vector2 center, float radius, float thick, Color color);
+void tile_batch_circle(tile_batch_t *batch, Vector2 center, float radius, Color color);
+
+#endif /*TILE_BATCH_H*/
@@ -26,6 +26,7 @@
 #include "tile.h"
 #include "tile_pos.h"
 #include "tile_draw.h"
+#include "tile_batch.h"
 #include "level.h"
 #include "win_anim.h"
 #ifdef USE_PHYSICS
@@ -36,6 +37,54 @@
 
 extern Shader win_border_shader;
 
+/* set while tile_draw_batched() is running */
+static tile_batch_t *draw_batch = NULL;
+
+static void draw_triangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color)
+{
+    if (draw_batch) {
+        tile_batch_triangle(draw_batch, v1, v2, v3, color);
+    } else {
+        DrawTriangle(v1, v2, v3, color);
+    }
+}
+
+static void draw_line(Vector2 start, Vector2 end, float thick, Color color)
+{
+    if (draw_batch) {
+        tile_batch_line(draw_batch, start, end, thick, color);
+    } else {
+        DrawLineEx(start, end, thick, color);
+    }
+}
+
+static void draw_hex(Vector2 center, float radius, Color color)
+{
+    if (draw_batch) {
+        tile_batch_hex(draw_batch, center, radius, color);
+    } else {
+        DrawPoly(center, 6, radius, 0.0f, color);
+    }
+}
+
+static void draw_hex_lines(Vector2 center, float radius, float thick, Color color)
+{
+    if (draw_batch) {
+        tile_batch_hex_lines(draw_batch, center, radius, thick, color);
+    } else {
+        DrawPolyLinesEx(center, 6, radius, 0.0f, thick, color);
+    }
+}
+
+static void draw_circle(Vector2 center, float radius, Color color)
+{
+    if (draw_batch) {
+        tile_batch_circle(draw_batch, center, radius, color);
+    } else {
+        DrawCircleV(center, radius, color);
+    }
+}
+
 static bool either_self_or_adjacent_is_hidden(tile_pos_t *pos)
 {
     return pos->tile->hidden || (pos->hover_adjacent && pos->hover_adjacent->tile->hidden);
@@ -51,7 +100,7 @@ static void draw_adjacency_highlight(tile_pos_t *pos)
     tile_section_t sec = pos->rel.sections[pos->hover_section];
     Vector2 c0 = Vector2Lerp(sec.corners[0], mid, 0.35);
     Vector2 c1 = Vector2Lerp(sec.corners[1], mid, 0.35);
-    DrawTriangle(c0, c1, sec.corners[2], tile_bg_highlight_color_dim);
+    draw_triangle(c0, c1, sec.corners[2], tile_bg_highlight_color_dim);
 }
 
 extern bool edit_tool_cycle;
@@ -83,7 +132,7 @@ void tile_draw_path(tile_pos_t *pos, bool finished)
                 pcolor = ColorAlpha(pcolor, 0.666);
             }
 
-            DrawLineEx(pos->rel.center, mid, pos->line_width, pcolor);
+            draw_line(pos->rel.center, mid, pos->line_width, pcolor);
 #if 0
             float absx= fabs(pos->rel.center.x - mid.x);
             float absy= fabs(pos->rel.center.y - mid.y);
@@ -125,7 +174,7 @@ void tile_draw_path_ghost(tile_pos_t *pos)
         if (!ColorEq(pcolor, path_color_none)) {
             pcolor = ColorAlpha(pcolor, 0.666);
 
-            DrawLineEx(pos->rel.center, mid, pos->line_width, pcolor);
+            draw_line(pos->rel.center, mid, pos->line_width, pcolor);
 #if 0
             float absx= fabs(pos->rel.center.x - mid.x);
             float absy= fabs(pos->rel.center.y - mid.y);
@@ -174,14 +223,36 @@ void tile_draw_path_highlight(tile_pos_t *pos, bool finished, Color finished_col
                     Vector2 e2 = Vector2Add(mid,           shift);
 
                     highlight_color = ColorLerp(highlight_color, WHITE, 0.4);
-                    DrawLineEx(s1, e1, line_width, highlight_color);
-                    DrawLineEx(s2, e2, line_width, highlight_color);
+                    draw_line(s1, e1, line_width, highlight_color);
+                    draw_line(s2, e2, line_width, highlight_color);
                 }
             }
         }
     }
 }
 
+/* the background of a finished tile slowly pulses */
+Color tile_finished_bg_color(Color bgcolor, float finished_fade_in)
+{
+    float alpha = (1.0f + sinf(current_time * 0.666)) / 2.0f;
+    alpha = (alpha * 0.7) + 0.3;
+    Color new_bgcolor = ColorAlpha(bgcolor, alpha);
+    return ColorLerp(bgcolor, new_bgcolor, finished_fade_in);
+}
+
+Color tile_finished_center_color(Color finished_color)
+{
+    float fade = 1.0;
+    if (current_level && current_level->win_anim) {
+        fade = current_level->win_anim->fade[2];
+    }
+
+    float cent_color_fade = current_level ? fade : 0.5;
+    float darken = -0.75 * fade;
+    Color cent_color = ColorLerp(tile_center_color, finished_color, cent_color_fade);
+    return ColorBrightness(cent_color, darken);
+}
+
 void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color finished_color, float finished_fade_in)
 {
     assert_not_null(pos);
@@ -193,11 +264,6 @@ void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color fi
         return;
     }
 
-    float fade = 1.0;
-    if (current_level && current_level->win_anim) {
-        fade = current_level->win_anim->fade[2];
-    }
-
     bool drag = (pos == drag_target) && !edit_mode_solved;
     bool dragged_over = false;
 
@@ -210,11 +276,11 @@ void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color fi
     if (tile->hidden) {
         if (edit_mode) {
             float hiddensize = pos->size - (pos->size * 0.08);
-            DrawPoly(pos->rel.center, 6, hiddensize, 0.0f,
+            draw_hex(pos->rel.center, hiddensize,
                      dragged_over
                      ? tile_bg_hover_color
                      : tile_bg_hidden_color);
-            DrawPolyLinesEx(pos->rel.center, 6, hiddensize, 0.0f, 2.0f,
+            draw_hex_lines(pos->rel.center, hiddensize, 2.0f,
                             dragged_over
                             ? tile_edge_hover_color
                             : tile_edge_hidden_color);
@@ -242,10 +308,7 @@ void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color fi
 #endif
 
         if (finished) {
-            float alpha = (1.0f + sinf(current_time * 0.666)) / 2.0f;
-            alpha = (alpha * 0.7) + 0.3;
-            Color new_bgcolor = ColorAlpha(bgcolor, alpha);
-            bgcolor = ColorLerp(bgcolor, new_bgcolor, finished_fade_in);
+            bgcolor = tile_finished_bg_color(bgcolor, finished_fade_in);
         }
 
 #ifdef DEBUG_ID_AND_DIR
@@ -254,7 +317,7 @@ void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color fi
         }
 #endif
 
-        DrawPoly(pos->rel.center, 6, pos->size, 0.0f, bgcolor);
+        draw_hex(pos->rel.center, pos->size, bgcolor);
     }
 
     bool edit_solved_not_center = edit_mode_solved && !pos->hover_center;
@@ -284,7 +347,7 @@ void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color fi
         if (next_path == PATH_TYPE_NONE) {
             next_color = tile_bg_color;
         }
-        DrawLineEx(pos->rel.center, mid, thickness, next_color);
+        draw_line(pos->rel.center, mid, thickness, next_color);
     }
 
     if (!tile->fixed) {
@@ -307,22 +370,18 @@ void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color fi
         if (finished) {
             /* skip */
         } else {
-            DrawPolyLinesEx(pos->rel.center, 6, pos->size, 0.0f, line_width, border_color);
+            draw_hex_lines(pos->rel.center, pos->size, line_width, border_color);
         }
     }
 
     if ((tile->path_count > 0) || edit_mode_solved) {
         if (finished) {
-            float cent_color_fade = current_level ? fade : 0.5;
-            float darken = -0.75 * fade;
-            Color cent_color = ColorLerp(tile_center_color, finished_color, cent_color_fade);
-            cent_color = ColorBrightness(cent_color, darken);
-            DrawCircleV(pos->rel.center, pos->center_circle_draw_radius, cent_color);
+            draw_circle(pos->rel.center, pos->center_circle_draw_radius, tile_finished_center_color(finished_color));
         } else {
-            DrawCircleV(pos->rel.center, pos->center_circle_draw_radius, tile_center_color);
+            draw_circle(pos->rel.center, pos->center_circle_draw_radius, tile_center_color);
 
             if (edit_mode_solved && pos->hover_center) {
-                DrawCircleV(pos->rel.center, pos->center_circle_draw_radius, tile_bg_highlight_color);
+                draw_circle(pos->rel.center, pos->center_circle_draw_radius, tile_bg_highlight_color);
             }
         }
     }
@@ -378,7 +437,7 @@ void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color fi
     DrawTextDropShadow(coord_text2, pos->rel.center.x - (text_size2.x/2), pos->rel.center.y + yoffset + text_size1.y + sep, font_size, WHITE, BLACK);
     DrawTextDropShadow(coord_text3, pos->rel.center.x - (text_size3.x/2), pos->rel.center.y + yoffset - text_size1.y - sep, font_size, WHITE, BLACK);
     //Vector2 lineend = Vector2Add(pos->rel.center, (Vector2) { .x = -pp.x, -pp.y });
-    //DrawLineEx(pos->rel.center, lineend, 3.0, PINK);
+    //draw_line(pos->rel.center, lineend, 3.0, PINK);
 #endif
 #endif
 #endif
@@ -387,6 +446,17 @@ void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color fi
 #endif
 }
 
+/* same as tile_draw(), but adds the tile's triangles to the batch
+ * using the batch's current transform */
+void tile_draw_batched(tile_batch_t *batch, tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color finished_color, float finished_fade_in)
+{
+    assert_not_null(batch);
+
+    draw_batch = batch;
+    tile_draw(pos, drag_target, finished, finished_color, finished_fade_in);
+    draw_batch = NULL;
+}
+
 void tile_draw_ghost(tile_pos_t *pos)
 {
     DrawPoly(pos->rel.center, 6, pos->size, 0.0f, ColorAlpha(tile_bg_color, 0.4));
@@ -26,8 +26,13 @@
 #include "tile_pos.h"
 #include "level.h"
 #include "win_anim.h"
+#include "tile_batch.h"
+
+Color tile_finished_bg_color(Color bgcolor, float finished_fade_in);
+Color tile_finished_center_color(Color finished_color);
 
 void tile_draw(tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color finished_color, float finished_fade_in);
+void tile_draw_batched(tile_batch_t *batch, tile_pos_t *pos, tile_pos_t *drag_target, bool finished, Color finished_color, float finished_fade_in);
 void tile_draw_ghost(tile_pos_t *pos);
 void tile_draw_win_anim(tile_pos_t *pos);
 void tile_draw_corner_connections(tile_pos_t *pos, win_anim_mode_t win_mode);
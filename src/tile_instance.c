@@ -0,0 +1,336 @@
+/****************************************************************************
+ *                                                                          *
+ * tile_instance.c                                                          *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "options.h"
+#include "path.h"
+#include "tile.h"
+#include "tile_batch.h"
+#include "tile_instance.h"
+#include "shader.h"
+
+#define TILE_INSTANCE_INITIAL_COUNT 256
+
+#define TILE_INSTANCE_FLAG_BG     0
+#define TILE_INSTANCE_FLAG_CENTER 1
+#define TILE_INSTANCE_FLAG_HOVER  2
+
+#if defined(GRAPHICS_API_OPENGL_33)
+static bool tile_instance_shader_ready(void)
+{
+    tile_instance_shader_loc_t *loc = &tile_instance_shader_loc;
+
+    if ((tile_instance_shader.id == 0) ||
+        (tile_instance_shader.id == rlGetShaderIdDefault())) {
+        return false;
+    }
+
+    if ((loc->position < 0) || (loc->part < 0) || (loc->transform < 0) || (loc->flags < 0)) {
+        return false;
+    }
+
+    each_direction {
+        if (loc->path[dir] < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+bool tile_instances_available(void)
+{
+#if defined(GRAPHICS_API_OPENGL_33)
+    static int ready = -1;
+    if (ready < 0) {
+        ready = tile_instance_shader_ready();
+        if (!ready) {
+            warnmsg("the tile instance shader didn't load; drawing finished tiles without instancing");
+        }
+    }
+
+    return options->instance_tiles && ready;
+#else
+    return false;
+#endif
+}
+
+void init_tile_instances(tile_instances_t *ti)
+{
+    assert_not_null(ti);
+
+    ti->alloc_count = TILE_INSTANCE_INITIAL_COUNT;
+    ti->instances   = calloc(ti->alloc_count, sizeof(tile_instance_t));
+    ti->count       = 0;
+
+    ti->have_template = false;
+    ti->vao = 0;
+    ti->mesh_vbo = 0;
+    ti->instance_vbo = 0;
+    ti->instance_vbo_count = 0;
+}
+
+static void tile_instances_unload_buffers(tile_instances_t *ti)
+{
+    if (ti->vao) {
+        rlUnloadVertexArray(ti->vao);
+        ti->vao = 0;
+    }
+    if (ti->mesh_vbo) {
+        rlUnloadVertexBuffer(ti->mesh_vbo);
+        ti->mesh_vbo = 0;
+    }
+    if (ti->instance_vbo) {
+        rlUnloadVertexBuffer(ti->instance_vbo);
+        ti->instance_vbo = 0;
+    }
+    ti->instance_vbo_count = 0;
+}
+
+void cleanup_tile_instances(tile_instances_t *ti)
+{
+    if (ti) {
+        tile_instances_unload_buffers(ti);
+        SAFEFREE(ti->instances);
+        ti->count = 0;
+        ti->alloc_count = 0;
+        ti->have_template = false;
+    }
+}
+
+void tile_instances_begin(tile_instances_t *ti)
+{
+    assert_not_null(ti);
+
+    ti->count = 0;
+}
+
+static bool tile_instances_template_matches(tile_instances_t *ti, tile_pos_t *pos)
+{
+    if (!ti->have_template) {
+        return false;
+    }
+
+    if ((ti->template_size          != pos->size) ||
+        (ti->template_line_width    != pos->line_width) ||
+        (ti->template_center_radius != pos->center_circle_draw_radius)) {
+        return false;
+    }
+
+    each_direction {
+        if (!Vector2Equals(ti->template_midpoints[dir], pos->rel.midpoints[dir])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#if defined(GRAPHICS_API_OPENGL_33)
+/* (re)creates the per-instance buffer with room for alloc_count tiles */
+static void tile_instances_load_instance_buffer(tile_instances_t *ti)
+{
+    tile_instance_shader_loc_t *loc = &tile_instance_shader_loc;
+
+    rlEnableVertexArray(ti->vao);
+
+    if (ti->instance_vbo) {
+        rlUnloadVertexBuffer(ti->instance_vbo);
+    }
+
+    ti->instance_vbo_count = ti->alloc_count;
+    ti->instance_vbo = rlLoadVertexBuffer(NULL, ti->instance_vbo_count * sizeof(tile_instance_t), true);
+
+    int stride = sizeof(tile_instance_t);
+    rlSetVertexAttribute(loc->transform, 3, RL_FLOAT, false, stride, (void *)offsetof(tile_instance_t, translate_x));
+    rlEnableVertexAttribute(loc->transform);
+    rlSetVertexAttributeDivisor(loc->transform, 1);
+
+    rlSetVertexAttribute(loc->flags, 4, RL_UNSIGNED_BYTE, false, stride, (void *)offsetof(tile_instance_t, flags));
+    rlEnableVertexAttribute(loc->flags);
+    rlSetVertexAttributeDivisor(loc->flags, 1);
+
+    each_direction {
+        rlSetVertexAttribute(loc->path[dir], 4, RL_UNSIGNED_BYTE, true, stride,
+                             (void *)(offsetof(tile_instance_t, path) + (dir * sizeof(Color))));
+        rlEnableVertexAttribute(loc->path[dir]);
+        rlSetVertexAttributeDivisor(loc->path[dir], 1);
+    }
+
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+}
+#endif
+
+/*
+ * The template is drawn with the same primitives and in the same order
+ * as tile_draw() draws a finished tile. Each vertex's part is stored
+ * in the red channel while the batch collects them.
+ */
+static void tile_instances_build_template(tile_instances_t *ti, tile_pos_t *pos)
+{
+    tile_batch_t batch;
+    init_tile_batch(&batch);
+    tile_batch_begin(&batch);
+
+    tile_batch_hex(&batch, pos->rel.center, pos->size, (Color){ TILE_INSTANCE_PART_BG, 0, 0, 0 });
+
+    each_direction {
+        tile_batch_line(&batch, pos->rel.center, pos->rel.midpoints[dir], pos->line_width,
+                        (Color){ TILE_INSTANCE_PART_PATH0 + dir, 0, 0, 0 });
+    }
+
+    tile_batch_circle(&batch, pos->rel.center, pos->center_circle_draw_radius,
+                      (Color){ TILE_INSTANCE_PART_CENTER, 0, 0, 0 });
+
+    /* x, y, part */
+    float *vertices = calloc(batch.count * 3, sizeof(float));
+    for (int i=0; i<batch.count; i++) {
+        vertices[(i * 3) + 0] = batch.positions[i].x;
+        vertices[(i * 3) + 1] = batch.positions[i].y;
+        vertices[(i * 3) + 2] = (float)batch.colors[i].r;
+    }
+
+    tile_instances_unload_buffers(ti);
+
+#if defined(GRAPHICS_API_OPENGL_33)
+    tile_instance_shader_loc_t *loc = &tile_instance_shader_loc;
+
+    ti->vao = rlLoadVertexArray();
+    rlEnableVertexArray(ti->vao);
+
+    ti->mesh_vbo = rlLoadVertexBuffer(vertices, batch.count * 3 * sizeof(float), false);
+    rlSetVertexAttribute(loc->position, 2, RL_FLOAT, false, 3 * sizeof(float), (void *)0);
+    rlEnableVertexAttribute(loc->position);
+    rlSetVertexAttribute(loc->part, 1, RL_FLOAT, false, 3 * sizeof(float), (void *)(2 * sizeof(float)));
+    rlEnableVertexAttribute(loc->part);
+
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+
+    tile_instances_load_instance_buffer(ti);
+#endif
+
+    ti->template_vertex_count  = batch.count;
+    ti->template_size          = pos->size;
+    ti->template_line_width    = pos->line_width;
+    ti->template_center_radius = pos->center_circle_draw_radius;
+    each_direction {
+        ti->template_midpoints[dir] = pos->rel.midpoints[dir];
+    }
+    ti->have_template = true;
+
+    free(vertices);
+    cleanup_tile_batch(&batch);
+}
+
+/* a finished tile as tile_draw() would draw it, outside of edit mode */
+void tile_instances_add(tile_instances_t *ti, tile_pos_t *pos, Vector2 translate, float rotate)
+{
+    assert_not_null(ti);
+    assert_not_null(pos);
+
+    tile_t *tile = pos->tile;
+
+    if (!tile->enabled || tile->hidden) {
+        return;
+    }
+
+    if (!tile_instances_template_matches(ti, pos)) {
+        tile_instances_build_template(ti, pos);
+    }
+
+    if (ti->count >= ti->alloc_count) {
+        ti->alloc_count *= 2;
+        ti->instances = realloc(ti->instances, ti->alloc_count * sizeof(tile_instance_t));
+    }
+
+    tile_instance_t *inst = &ti->instances[ti->count++];
+
+    inst->translate_x = translate.x;
+    inst->translate_y = translate.y;
+    inst->rotate      = rotate;
+
+    inst->flags[TILE_INSTANCE_FLAG_BG]     = !tile->fixed;
+    inst->flags[TILE_INSTANCE_FLAG_CENTER] = tile->path_count > 0;
+    inst->flags[TILE_INSTANCE_FLAG_HOVER]  = pos->hover;
+    inst->flags[3] = 0;
+
+    tile_t *path_tile = pos->swap_target ? pos->swap_target->tile : pos->tile;
+    each_direction {
+        Color pcolor = path_type_color(path_tile->path[dir]);
+        if (ColorEq(pcolor, path_color_none)) {
+            inst->path[dir] = BLANK;
+        } else {
+            inst->path[dir] = ColorAlpha(pcolor, 0.666);
+        }
+    }
+}
+
+static void set_color_uniform(int loc, Color color)
+{
+    Vector4 v = ColorNormalize(color);
+    rlSetUniform(loc, &v, RL_SHADER_UNIFORM_VEC4, 1);
+}
+
+void tile_instances_draw(tile_instances_t *ti, Color bg_color, Color bg_hover_color, Color center_color)
+{
+    assert_not_null(ti);
+
+    if (!ti->count || !ti->have_template) {
+        return;
+    }
+
+#if defined(GRAPHICS_API_OPENGL_33)
+    if (ti->count > ti->instance_vbo_count) {
+        tile_instances_load_instance_buffer(ti);
+    }
+
+    /* anything already in the render batch is drawn first */
+    rlDrawRenderBatchActive();
+
+    tile_instance_shader_loc_t *loc = &tile_instance_shader_loc;
+
+    rlEnableShader(tile_instance_shader.id);
+
+    Matrix mvp = MatrixMultiply(MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview()),
+                                rlGetMatrixProjection());
+    rlSetUniformMatrix(loc->mvp, mvp);
+    set_color_uniform(loc->bg_color,       bg_color);
+    set_color_uniform(loc->bg_hover_color, bg_hover_color);
+    set_color_uniform(loc->center_color,   center_color);
+
+    rlUpdateVertexBuffer(ti->instance_vbo, ti->instances, ti->count * sizeof(tile_instance_t), 0);
+
+    rlEnableVertexArray(ti->vao);
+    rlDrawVertexArrayInstanced(0, ti->template_vertex_count, ti->count);
+    rlDisableVertexArray();
+
+    rlDisableShader();
+#else
+    (void)bg_color;
+    (void)bg_hover_color;
+    (void)center_color;
+#endif
+
+    ti->count = 0;
+}
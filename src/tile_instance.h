@@ -0,0 +1,87 @@
+/****************************************************************************
+ *                                                                          *
+ * tile_instance.h                                                          *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef TILE_INSTANCE_H
+#define TILE_INSTANCE_H
+
+/*
+ * Draws finished tiles as instances of one template tile mesh.
+ *
+ * The win animations move and rotate every tile each frame, so the
+ * batched path has to transform every vertex of every tile on the
+ * CPU. Here each tile is a small record with its transform, path
+ * colors and a few flags. The vertex shader picks each vertex's
+ * color from the record and applies the transform, so the whole
+ * board is one instanced draw call.
+ *
+ * Only available with OpenGL 3.3. Anything other than a plain
+ * finished tile still uses tile_draw().
+ */
+
+#include "tile_pos.h"
+
+/* which part of the tile a template vertex belongs to */
+enum tile_instance_part {
+    TILE_INSTANCE_PART_BG     = 0,
+    TILE_INSTANCE_PART_PATH0  = 1,   /* + direction */
+    TILE_INSTANCE_PART_CENTER = 7
+};
+typedef enum tile_instance_part tile_instance_part_t;
+
+struct tile_instance {
+    float translate_x;
+    float translate_y;
+    float rotate;
+    unsigned char flags[4];    /* draw bg, draw center, hover, unused */
+    Color path[6];
+};
+typedef struct tile_instance tile_instance_t;
+
+struct tile_instances {
+    tile_instance_t *instances;
+    int count;
+    int alloc_count;
+
+    /* template mesh, built from the first tile added */
+    bool have_template;
+    float template_size;
+    float template_line_width;
+    float template_center_radius;
+    Vector2 template_midpoints[6];
+    int template_vertex_count;
+
+    unsigned int vao;
+    unsigned int mesh_vbo;
+    unsigned int instance_vbo;
+    int instance_vbo_count;
+};
+typedef struct tile_instances tile_instances_t;
+
+bool tile_instances_available(void);
+
+void init_tile_instances(tile_instances_t *ti);
+void cleanup_tile_instances(tile_instances_t *ti);
+
+void tile_instances_begin(tile_instances_t *ti);
+void tile_instances_add(tile_instances_t *ti, tile_pos_t *pos, Vector2 translate, float rotate);
+void tile_instances_draw(tile_instances_t *ti, Color bg_color, Color bg_hover_color, Color center_color);
+
+#endif /*TILE_INSTANCE_H*/
@@ -316,7 +316,7 @@ void tile_pos_rebuild(tile_pos_t *pos)
 {
     assert_not_null(pos);
 
-    pos->ring_radius = hex_axial_distance(pos->position, LEVEL_CENTER_POSITION);
+    pos->ring_radius = pos->center_distance;
 
     pos->extra_rotate = 0.0f;
     pos->extra_rotate_magnitude = 0.0f;
@@ -334,8 +334,7 @@ void tile_pos_rebuild(tile_pos_t *pos)
 
     pos->rel.center = Vector2Zero();
 
-    Vector2 *corners = hex_pixel_corners(pos->win.center, pos->size);
-    memcpy(pos->win.corners, corners, 7 * sizeof(Vector2));
+    hex_pixel_corners_r(pos->win.center, pos->size, pos->win.corners);
 
     each_direction {
         Vector2 c0 = pos->win.corners[dir];
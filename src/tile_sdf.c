@@ -0,0 +1,188 @@
+/****************************************************************************
+ *                                                                          *
+ * tile_sdf.c                                                               *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "common.h"
+#include "options.h"
+#include "color.h"
+#include "path.h"
+#include "tile.h"
+#include "tile_pos.h"
+#include "tile_sdf.h"
+#include "shader.h"
+#include "game_mode.h"
+
+/* same as tile_draw() */
+#define TILE_SDF_BORDER_WIDTH    2.0f
+#define TILE_SDF_HIGHLIGHT_WIDTH 1.5f
+
+/* room around the hex for antialiasing */
+#define TILE_SDF_QUAD_MARGIN 2.0f
+
+/* packed into the vertex alpha above the six highlight bits */
+#define TILE_SDF_FLAG_FIXED  0x40
+#define TILE_SDF_FLAG_CENTER 0x80
+
+static float template_size;
+static float template_line_width;
+static float template_center_radius;
+static float quad_extent;
+
+bool tile_sdf_available(void)
+{
+    static int ready = -1;
+    if (ready < 0) {
+        ready = (tile_sdf_shader.id > 0)
+            && (tile_sdf_shader.id != rlGetShaderIdDefault())
+            && (tile_sdf_shader_loc.tile_size >= 0);
+        if (!ready) {
+            warnmsg("the tile SDF shader didn't load; drawing tiles with triangles");
+        }
+    }
+
+    return options->sdf_tiles && ready;
+}
+
+/* tiles that tile_draw() would draw with nothing but the plain parts */
+bool tile_sdf_can_draw(tile_pos_t *pos)
+{
+    tile_t *tile = pos->tile;
+
+    return tile->enabled
+        && !tile->hidden
+        && !pos->hover
+        && !pos->hover_adjacent
+        && !pos->swap_target
+        && !edit_mode;
+}
+
+static void set_color_uniform(int loc, Color color)
+{
+    Vector4 v = ColorNormalize(color);
+    SetShaderValue(tile_sdf_shader, loc, &v, SHADER_UNIFORM_VEC4);
+}
+
+/* every tile drawn until tile_sdf_end() has to match template_pos's size */
+void tile_sdf_begin(tile_pos_t *template_pos)
+{
+    assert_not_null(template_pos);
+
+    tile_sdf_shader_loc_t *loc = &tile_sdf_shader_loc;
+
+    template_size          = template_pos->size;
+    template_line_width    = template_pos->line_width;
+    template_center_radius = template_pos->center_circle_draw_radius;
+    quad_extent            = template_size + TILE_SDF_QUAD_MARGIN;
+
+    BeginShaderMode(tile_sdf_shader);
+
+    float border_width    = TILE_SDF_BORDER_WIDTH;
+    float highlight_width = TILE_SDF_HIGHLIGHT_WIDTH;
+    SetShaderValue(tile_sdf_shader, loc->tile_size,       &template_size,          SHADER_UNIFORM_FLOAT);
+    SetShaderValue(tile_sdf_shader, loc->line_width,      &template_line_width,    SHADER_UNIFORM_FLOAT);
+    SetShaderValue(tile_sdf_shader, loc->border_width,    &border_width,           SHADER_UNIFORM_FLOAT);
+    SetShaderValue(tile_sdf_shader, loc->highlight_width, &highlight_width,        SHADER_UNIFORM_FLOAT);
+    SetShaderValue(tile_sdf_shader, loc->center_radius,   &template_center_radius, SHADER_UNIFORM_FLOAT);
+    SetShaderValueV(tile_sdf_shader, loc->arm_end, template_pos->rel.midpoints, SHADER_UNIFORM_VEC2, 6);
+
+    set_color_uniform(loc->bg_color,     tile_bg_color);
+    set_color_uniform(loc->edge_color,   tile_edge_color);
+    set_color_uniform(loc->center_color, tile_center_color);
+
+    Vector4 path_color[PATH_TYPE_COUNT];
+    Vector4 highlight_color[PATH_TYPE_COUNT];
+    for (path_type_t type = PATH_TYPE_MIN; type < PATH_TYPE_COUNT; type++) {
+        path_color[type] = ColorNormalize(path_type_color(type));
+        highlight_color[type] = ColorNormalize(ColorLerp(path_type_highlight_color(type), WHITE, 0.4));
+    }
+    SetShaderValueV(tile_sdf_shader, loc->path_color,      path_color,      SHADER_UNIFORM_VEC4, PATH_TYPE_COUNT);
+    SetShaderValueV(tile_sdf_shader, loc->highlight_color, highlight_color, SHADER_UNIFORM_VEC4, PATH_TYPE_COUNT);
+
+    rlBegin(RL_QUADS);
+}
+
+bool tile_sdf_matches_template(tile_pos_t *pos)
+{
+    return (pos->size                      == template_size)
+        && (pos->line_width                == template_line_width)
+        && (pos->center_circle_draw_radius == template_center_radius);
+}
+
+static Color tile_sdf_pack(tile_pos_t *pos)
+{
+    tile_t *tile = pos->tile;
+
+    unsigned char highlight = 0;
+    each_direction {
+        if (tile->path[dir] != PATH_TYPE_NONE) {
+            tile_pos_t *neighbor = pos->neighbors[dir];
+            if (neighbor && (neighbor->tile->path[hex_opposite_direction(dir)] == tile->path[dir])) {
+                highlight |= 1 << dir;
+            }
+        }
+    }
+
+    if (tile->fixed) {
+        highlight |= TILE_SDF_FLAG_FIXED;
+    }
+    if (tile->path_count > 0) {
+        highlight |= TILE_SDF_FLAG_CENTER;
+    }
+
+    return (Color) {
+        .r = tile->path[0] | (tile->path[1] << 4),
+        .g = tile->path[2] | (tile->path[3] << 4),
+        .b = tile->path[4] | (tile->path[5] << 4),
+        .a = highlight
+    };
+}
+
+void tile_sdf_draw(tile_pos_t *pos, Vector2 translate, float rotate)
+{
+    assert_not_null(pos);
+
+    Color data = tile_sdf_pack(pos);
+    rlColor4ub(data.r, data.g, data.b, data.a);
+
+    float c = cosf(rotate);
+    float s = sinf(rotate);
+    float e = quad_extent;
+
+    /* same corner order as DrawRectanglePro() */
+    Vector2 corners[4] = {
+        { -e, -e },
+        { -e,  e },
+        {  e,  e },
+        {  e, -e }
+    };
+
+    for (int i=0; i<4; i++) {
+        Vector2 v = corners[i];
+        rlTexCoord2f(v.x, v.y);
+        rlVertex2f(translate.x + (v.x * c) - (v.y * s),
+                   translate.y + (v.x * s) + (v.y * c));
+    }
+}
+
+void tile_sdf_end(void)
+{
+    rlEnd();
+    EndShaderMode();
+}
@@ -0,0 +1,47 @@
+/****************************************************************************
+ *                                                                          *
+ * tile_sdf.h                                                               *
+ *                                                                          *
+ * This file is part of hexpuzzle.                                          *
+ *                                                                          *
+ * hexpuzzle is free software: you can redistribute it and/or               *
+ * modify it under the terms of the GNU General Public License as published *
+ * by the Free Software Foundation, either version 3 of the License,        *
+ * or (at your option) any later version.                                   *
+ *                                                                          *
+ * hexpuzzle is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General *
+ * Public License for more details.                                         *
+ *                                                                          *
+ * You should have received a copy of the GNU General Public License along  *
+ * with hexpuzzle. If not, see <https://www.gnu.org/licenses/>.             *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef TILE_SDF_H
+#define TILE_SDF_H
+
+/*
+ * Draws a whole tile (background, border, paths, path highlights and
+ * the center circle) as one quad. The tile's path types and flags are
+ * packed into the quad's vertex color, and a fragment shader
+ * evaluates the signed distance of each part.
+ *
+ * Four vertices replace the few hundred that tile_draw() emits, and
+ * the edges stay sharp and antialiased at any scale, which matters
+ * most in the small level previews. Tiles that are hovered, dragged,
+ * hidden, finished or being edited still use tile_draw().
+ */
+
+#include "tile_pos.h"
+
+bool tile_sdf_available(void);
+bool tile_sdf_can_draw(tile_pos_t *pos);
+
+void tile_sdf_begin(tile_pos_t *template_pos);
+bool tile_sdf_matches_template(tile_pos_t *pos);
+void tile_sdf_draw(tile_pos_t *pos, Vector2 translate, float rotate);
+void tile_sdf_end(void);
+
+#endif /*TILE_SDF_H*/
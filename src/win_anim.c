@@ -22,8 +22,12 @@
 #include "common.h"
 #include "options.h"
 #include "level.h"
+#include "hex_grid.h"
 #include "win_anim.h"
 #include "shader.h"
+#include "quality_governor.h"
+#include "redraw.h"
+#include "profiler.h"
 #ifdef USE_PHYSICS
 #include "physics.h"
 #endif
@@ -237,11 +241,12 @@ static void win_anim_update_pops(win_anim_t *win_anim)
     tile_pos_t *center_pos = level_get_center_tile_pos(level);
 
     float phase = fmodf(current_time * 3.0f, TAU);
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
-        tile_t *tile = &(win_anim->level->tiles[i]);
+    hex_grid_t *grid = win_anim->level->grid;
+    int spiral_count = hex_grid_spiral_count(grid, win_anim->level->radius);
+    for (int i=0; i<spiral_count; i++) {
+        tile_pos_t *pos = &(win_anim->level->unsolved_positions[grid->spiral[i]]);
 
-        if (tile->enabled) {
-            tile_pos_t *pos = tile->unsolved_pos;
+        if (pos->tile->enabled) {
 
             float ring_phase = fmod(phase + pos->radial_angle, TAU);
             if (pos->ring_radius & 0x00000001) {
@@ -292,7 +297,7 @@ static void win_anim_update_pops(win_anim_t *win_anim)
                                                    1.666);
 
 #if 0
-            if (i==LEVEL_MAXTILES/2+7) {
+            if (i==spiral_count/2+7) {
                 printf("[%d] pop_out_phase = %f, prev_ring_phase = %f\n", i, pos->pop_out_phase, pos->prev_ring_phase);
                 printf("[%d]  pop_in_phase = %f,      ring_phase = %f\n", i, pos->pop_in_phase, ring_phase);
                 printf("[%d] pop_magnitude = %f,       extra_mag = %f\n--\n", i, pos->pop_magnitude, mag);
@@ -328,11 +333,12 @@ static void win_anim_update_waves(win_anim_t *win_anim)
     float global_theta = fmodf(WAVES_FREQ_SCALE * current_time, TAU);
     float bloom_theta = fmodf(WAVES_BLOOM_FREQ_SCALE * current_time, TAU);
 
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
-        tile_t *tile = &(win_anim->level->tiles[i]);
+    hex_grid_t *grid = win_anim->level->grid;
+    int spiral_count = hex_grid_spiral_count(grid, win_anim->level->radius);
+    for (int i=0; i<spiral_count; i++) {
+        tile_pos_t *pos = &(win_anim->level->unsolved_positions[grid->spiral[i]]);
 
-        if (tile->enabled) {
-            tile_pos_t *pos = tile->unsolved_pos;
+        if (pos->tile->enabled) {
 
             float theta = global_theta + pos->radial_angle;
 
@@ -370,11 +376,12 @@ static void win_anim_update_spin(win_anim_t *win_anim)
 
     float fade_magnitude = win_anim->fade[2];
 
-    for (int i=0; i<LEVEL_MAXTILES; i++) {
-        tile_t *tile = &(win_anim->level->tiles[i]);
+    hex_grid_t *grid = win_anim->level->grid;
+    int spiral_count = hex_grid_spiral_count(grid, win_anim->level->radius);
+    for (int i=0; i<spiral_count; i++) {
+        tile_pos_t *pos = &(win_anim->level->unsolved_positions[grid->spiral[i]]);
 
-        if (tile->enabled) {
-            tile_pos_t *pos = tile->unsolved_pos;
+        if (pos->tile->enabled) {
 
             float theta = pos->radial_angle;
 
@@ -436,24 +443,67 @@ void init_win_anim(win_anim_t *win_anim, level_t *level)
     }
 }
 
-void win_anim_select_random_mode(win_anim_t *win_anim, bool animated)
+static bool win_anim_mode_is_physics(win_anim_mode_t mode)
 {
-#ifdef DEBUG_TRACE_WIN_ANIM
-    win_anim_mode_t old_mode = win_anim->mode;
+#ifdef USE_PHYSICS
+    return (mode == WIN_ANIM_MODE_PHYSICS_FALL)
+        || (mode == WIN_ANIM_MODE_PHYSICS_SWIRL);
+#else
+    (void)mode;
+    return false;
 #endif
+}
 
-    win_anim->total_mode_chances[animated] = 0;
+/* the quality governor drops the expensive modes while frames are slow */
+static bool win_anim_mode_allowed(win_anim_mode_t mode, win_anim_detail_t detail)
+{
+    if (!win_anim_mode_config[mode].enabled) {
+        return false;
+    }
+
+    switch (detail) {
+    case WIN_ANIM_DETAIL_NO_PHYSICS:
+        return !win_anim_mode_is_physics(mode);
+
+    case WIN_ANIM_DETAIL_SIMPLE:
+        return (mode == WIN_ANIM_MODE_NULL)
+            || (mode == WIN_ANIM_MODE_SIMPLE);
+
+    default:
+        return true;
+    }
+}
+
+static void win_anim_count_mode_chances(win_anim_t *win_anim, win_anim_detail_t detail)
+{
+    win_anim->total_mode_chances[0] = 0;
+    win_anim->total_mode_chances[1] = 0;
     for (win_anim_mode_t mode = 0; mode < WIN_ANIM_MODE_COUNT; mode++) {
-        if (win_anim_mode_config[mode].enabled) {
+        if (win_anim_mode_allowed(mode, detail)) {
             win_anim->total_mode_chances[win_anim_mode_config[mode].animated] +=
                 win_anim_mode_config[mode].chances;
         }
     }
+}
+
+void win_anim_select_random_mode(win_anim_t *win_anim, bool animated)
+{
+#ifdef DEBUG_TRACE_WIN_ANIM
+    win_anim_mode_t old_mode = win_anim->mode;
+#endif
+
+    win_anim_detail_t detail = quality_governor_win_anim_detail();
+    win_anim_count_mode_chances(win_anim, detail);
+    if (win_anim->total_mode_chances[animated] == 0) {
+        /* nothing cheap enough is enabled */
+        detail = WIN_ANIM_DETAIL_FULL;
+        win_anim_count_mode_chances(win_anim, detail);
+    }
 
     int roll = global_rng_get(win_anim->total_mode_chances[animated]);
     for (win_anim_mode_t mode = 0; mode < WIN_ANIM_MODE_COUNT; mode++) {
         assert(roll >= 0);
-        if (win_anim_mode_config[mode].enabled &&
+        if (win_anim_mode_allowed(mode, detail) &&
             (win_anim_mode_config[mode].animated == animated)) {
             if (roll <= win_anim_mode_config[mode].chances) {
                 win_anim->mode = mode;
@@ -571,6 +621,8 @@ void win_anim_update(win_anim_t *win_anim)
         break;
     }
 
+    redraw_animate();
+
     win_anim->run_time = current_time - win_anim->start_time;
 
     win_anim->fade[0] = fmodf(win_anim->run_time, 10.0f);
@@ -628,7 +680,9 @@ void win_anim_update(win_anim_t *win_anim)
     case WIN_ANIM_MODE_PHYSICS_FALL:
         fallthrough;
     case WIN_ANIM_MODE_PHYSICS_SWIRL:
+        profile_begin(PROFILE_PHASE_PHYSICS);
         physics_update(&win_anim->physics, win_anim->activation);
+        profile_end(PROFILE_PHASE_PHYSICS);
         win_anim_update_physics(win_anim);
         break;
 #endif